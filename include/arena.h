@@ -0,0 +1,37 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// the build turns every malloc, calloc, realloc and free of the compiler and of
+// lvec into the functions below, see CMakeLists.txt. a block is made in the
+// arena that is current on its thread, or in none, and stays in it when it is
+// reallocated or freed elsewhere. freeing an arena frees everything still in
+// it, which is how a compile releases its tokens, syntax trees and ir at once
+typedef struct Arena Arena;
+
+Arena* arena_new( void );
+
+// frees the blocks of the arena, which stays usable
+void arena_clear( Arena* arena );
+
+void arena_free( Arena* arena );
+
+// makes `arena` current on this thread, null for none, and returns the one that
+// was current before
+Arena* arena_make_current( Arena* arena );
+Arena* arena_get_current( void );
+
+// moves the blocks of `from` into `to`, for the arenas of threads that worked
+// for another. `from` is left empty
+void arena_adopt( Arena* to, Arena* from );
+
+void* arena_malloc( size_t size );
+void* arena_calloc( size_t count, size_t size );
+void* arena_realloc( void* pointer, size_t size );
+void arena_release( void* pointer );
+
+// frees memory that the C library allocated itself, e.g. the result of realpath
+void arena_free_system( void* pointer );
+
+#endif
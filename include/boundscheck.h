@@ -0,0 +1,16 @@
+#ifndef BOUNDSCHECK_H
+#define BOUNDSCHECK_H
+
+#include "parser.h"
+
+typedef struct BoundsCheckStats
+{
+    int checked_count;
+    int eliminated_count;
+} BoundsCheckStats;
+
+// marks every array subscript in the program as bounds checked unless its index
+// can be proven to be within the bounds of the array
+BoundsCheckStats annotate_bounds_checks( Expression* program );
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "codebuffer.h"
+
+// compiled objects stored under a hash of everything they were built from
+typedef struct ObjectCache
+{
+    char* directory;
+    uint64_t configuration_hash; // compiler, flags and runtime header
+} ObjectCache;
+
+// where the cache is without a directory given, null if there is no home
+// directory. it is not created
+char* object_cache_get_default_directory( void );
+
+// `directory` can be NULL to use the default location, returns false if the
+// cache directory cannot be created
+bool object_cache_open( ObjectCache* cache, char* directory, char* runtime_header_path );
+void object_cache_close( ObjectCache* cache );
+
+// the path the object compiled from `translation_unit` is stored at
+char* object_cache_get_path( ObjectCache* cache, CodeBuffer* translation_unit );
+
+// the path the shared object of a whole program is stored at, `program_hash`
+// has to cover everything the program is generated from
+char* object_cache_get_program_path( ObjectCache* cache, uint64_t program_hash );
+
+// continues `hash` with the size and modification time of a file, which is
+// much cheaper than hashing its contents
+uint64_t object_cache_hash_file_stamp( uint64_t hash, char* path );
+
+// where to compile an object before it is inserted
+char* object_cache_get_temporary_path( char* object_path );
+
+bool object_cache_contains( char* object_path );
+
+// moves a freshly compiled object into the cache, `temporary_path` has to be in
+// the cache directory so that this is a rename that other builds never see
+// half-done
+bool object_cache_insert( char* temporary_path, char* object_path );
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef CODEBUFFER_H
+#define CODEBUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// growable in-memory buffer the generated code is written into
+typedef struct CodeBuffer
+{
+    char* data;
+    size_t length;
+    size_t capacity;
+
+    // when set, the buffer is written to the sink whenever it fills up instead
+    // of growing
+    FILE* sink;
+    bool has_sink_failed;
+} CodeBuffer;
+
+void code_buffer_initialize( CodeBuffer* buffer );
+void code_buffer_free( CodeBuffer* buffer );
+void code_buffer_set_sink( CodeBuffer* buffer, FILE* sink );
+
+// writes out what is left in the buffer to the sink, returns false if any write
+// to the sink failed
+bool code_buffer_flush( CodeBuffer* buffer );
+
+void code_buffer_append_data( CodeBuffer* buffer, const char* data, size_t length );
+void code_buffer_append_string( CodeBuffer* buffer, const char* string );
+void code_buffer_append_char( CodeBuffer* buffer, char character );
+void code_buffer_append_integer( CodeBuffer* buffer, int64_t integer );
+void code_buffer_append_unsigned( CodeBuffer* buffer, uint64_t integer );
+
+// appends the shortest C literal that reads back as exactly `floating`
+void code_buffer_append_float( CodeBuffer* buffer, double floating );
+
+// appends the characters a C string literal with the escape sequences in
+// `escaped` stands for, without a terminator
+void code_buffer_append_unescaped( CodeBuffer* buffer, const char* escaped );
+
+// writes the whole buffer at once, returns false on failure
+bool code_buffer_write( CodeBuffer* buffer, FILE* file );
+
+#endif
@@ -1,10 +1,52 @@
 #ifndef CODEGEN_H
 #define CODEGEN_H
 
-#include <stdio.h>
+#include "codebuffer.h"
 #include "parser.h"
 #include "semantic.h"
 
-void generate_code( FILE* file, SemanticContext* context, Expression* program );
+// generates the whole program as a single translation unit
+void generate_program( CodeBuffer* buffer, SemanticContext* context, Expression* program );
+
+// assigns every function of `program` to one of `shard_count` shards based on
+// its name, returns the shard index of every top-level statement
+int* partition_program( Expression* program, int shard_count );
+
+// generates a translation unit with the declarations of the whole program and
+// the definitions that were assigned to `shard_index`
+void generate_shard( CodeBuffer* buffer, SemanticContext* context, Expression* program,
+                     int* shard_indices, int shard_index );
+
+// the function a process that loads the program as a shared object calls, it
+// takes the arguments of a c main and returns the exit code
+#define RUN_ENTRY_NAME "octo_run_main"
+typedef int ( *RunEntry )( int argc, char** argv );
+
+// generates the run entry, which calls the main of the program
+void generate_run_entry( CodeBuffer* buffer, Expression* program );
+
+// hot reloading calls every function through a table of function pointers
+// that the host of the program swaps while it runs. each function is defined
+// under this prefix, and its plain name is a stub that calls the table
+#define HOT_RELOAD_PREFIX "octo_hot_"
+
+// whether calls of `function` go through the table, variadic functions do not
+bool is_hot_reloadable( Expression* function );
+
+// generates what every unit of a hot reloaded program shares: the types, the
+// extern functions and the globals as extern declarations. when this changes,
+// the running program cannot take the new code
+void generate_hot_reload_layout( CodeBuffer* buffer, SemanticContext* context, Expression* program );
+
+// generates the prototype and the definition of `function` separately, which
+// tells whether its callers or only its body changed
+void generate_hot_reload_function( CodeBuffer* signature, CodeBuffer* definition, SemanticContext* context,
+                                   Expression* function );
+
+// generates a unit that calls every function through `slots`, indexed by
+// statement like the shard indices. only the functions where `is_defined` is
+// set are defined, and the globals only with `defines_globals`
+void generate_hot_reload_unit( CodeBuffer* buffer, SemanticContext* context, Expression* program, int* slots,
+                               bool* is_defined, bool defines_globals );
 
 #endif
@@ -0,0 +1,62 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "boundscheck.h"
+#include "error.h"
+#include "parser.h"
+#include "semantic.h"
+
+typedef struct FrontEndOptions
+{
+    bool bounds_checks;
+    bool report_purity;
+    int inline_threshold;
+    bool use_ir;
+} FrontEndOptions;
+
+// tokenizes, parses and checks `source_code` and runs the passes the backends
+// depend on. returns null if the program has errors, which were reported. the
+// context refers to the source for as long as the program is used
+Expression* analyze_program( SourceCode* source_code, SemanticContext* context, FrontEndOptions* options,
+                             BoundsCheckStats* out_bounds_check_stats );
+
+// analyzes a program of several files. they are tokenized and parsed on up to
+// `thread_count` threads and then checked as one program in the order they
+// are given, so a file sees what the files before it declare. the context
+// refers to the first file and has the modules the program is and imports
+Expression* analyze_files( SourceCode* sources, int source_count, int thread_count, SemanticContext* context,
+                           FrontEndOptions* options, BoundsCheckStats* out_bounds_check_stats );
+
+// a session compiles one program from memory to c for programs that embed the
+// compiler. nothing is printed or read from files, besides the interfaces of
+// imported modules, and sessions share no state, so each thread can compile
+// with its own session. the c compiler driver, the object cache and the
+// backends besides c are not part of this
+
+typedef struct CompilerSession CompilerSession;
+
+CompilerSession* compiler_session_new( void );
+
+// frees the session and everything its compiles allocated
+void compiler_session_free( CompilerSession* session );
+
+// takes a copy of `code` and frees the source before, with everything its
+// compile allocated. `path` is only used in diagnostics and the messages of
+// failed bounds checks
+void compiler_session_load_source( CompilerSession* session, char* path, const char* code, size_t length );
+
+// runs the front end on the source. returns false if the program has errors,
+// which are in the diagnostics. `report_purity` is ignored
+bool compiler_session_check( CompilerSession* session, FrontEndOptions* options );
+
+// generates the c of the checked program. the runtime header picks how bounds
+// checks fail by the OCTO_CHECKS macro the c is compiled with
+void compiler_session_generate( CompilerSession* session );
+
+// both are terminated and stay valid until the next source is loaded
+const char* compiler_session_get_diagnostics( CompilerSession* session, size_t* out_length );
+const char* compiler_session_get_c( CompilerSession* session, size_t* out_length );
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "codebuffer.h"
+
+#if !defined( _WIN32 )
+#include <sys/types.h>
+#endif
+
+// the optimization flags that the generated code is compiled with
+typedef enum BuildProfile
+{
+    BUILDPROFILE_DEBUG,
+    BUILDPROFILE_RELEASE,
+    BUILDPROFILE_SIZE,
+} BuildProfile;
+
+typedef enum ProfileGuidance
+{
+    PROFILEGUIDANCE_NONE,
+    PROFILEGUIDANCE_GENERATE, // instrument the executable to record a profile
+    PROFILEGUIDANCE_USE,      // optimize with a recorded profile
+} ProfileGuidance;
+
+// what subscripts that are checked at runtime do with an index that is out of
+// bounds
+typedef enum CheckMode
+{
+    CHECKMODE_DIAGNOSTIC, // abort with the location in the octo source
+    CHECKMODE_TRAP,       // stop with a trap instruction, which is less code
+} CheckMode;
+
+// what the C compiler makes of a translation unit
+typedef enum CCompilerOutput
+{
+    CCOMPILEROUTPUT_EXECUTABLE,
+    CCOMPILEROUTPUT_OBJECT,
+    CCOMPILEROUTPUT_SHAREDOBJECT, // position-independent, for dlopen()
+} CCompilerOutput;
+
+// a running C compiler building an executable or an object file from
+// generated code
+typedef struct CCompiler
+{
+    char** arguments;
+    char* include_flag;
+    CodeBuffer* buffer;
+
+#if defined( _WIN32 )
+    char* c_path;
+    bool is_successful;
+#else
+    pid_t process_id;
+    FILE* input; // the compiler's stdin
+#endif
+} CCompiler;
+
+// sets the flags of every following compilation and link. `profile_directory`
+// is where the profile is recorded to and read from, it should be absolute
+void c_compiler_configure( BuildProfile profile, ProfileGuidance guidance, char* profile_directory );
+
+// sets how the following compilations handle failed bounds checks
+void c_compiler_set_check_mode( CheckMode mode );
+
+// sets the object files that the following executables are linked with, the
+// paths have to stay valid
+void c_compiler_set_link_objects( char** object_paths, int object_count );
+
+// starts the C compiler reading a translation unit from its stdin, everything
+// that is appended to `buffer` from now on is streamed to it
+bool c_compiler_start( CCompiler* compiler, CodeBuffer* buffer, char* output_path,
+                       char* include_directory, CCompilerOutput output );
+
+// sends the rest of the translation unit, the compiler keeps running
+void c_compiler_end_input( CCompiler* compiler );
+
+// waits for the compiler, returns true if it succeeded
+bool c_compiler_wait( CCompiler* compiler );
+
+// c_compiler_end_input() and c_compiler_wait() in one
+bool c_compiler_finish( CCompiler* compiler );
+
+// compiles a C file that is already on disk, returns true if it succeeded
+bool c_compiler_compile_file( char* c_path, char* output_path, char* include_directory );
+
+// links object files into an executable, returns true if it succeeded
+bool c_compiler_link( char** object_paths, int object_count, char* output_path );
+
+// continues `hash` with the compiler and flags that objects are built with.
+// what -march=native resolves to is kept in `cache_directory`, which can be
+// null
+uint64_t c_compiler_hash_configuration( uint64_t hash, char* cache_directory );
+
+#endif
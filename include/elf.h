@@ -0,0 +1,92 @@
+#ifndef ELF_H
+#define ELF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "codebuffer.h"
+
+// a relocatable x86-64 elf object that is built up in memory and written out
+// in one go, for the system linker to link like any object gcc produces
+
+typedef enum ElfSection
+{
+    ELFSECTION_TEXT,
+    ELFSECTION_RODATA,
+    ELFSECTION_DATA,
+    ELFSECTION_BSS,
+    ELFSECTION_UNDEFINED, // symbols defined by another object
+} ElfSection;
+
+#define ELFSECTION_COUNT ELFSECTION_UNDEFINED
+
+typedef enum ElfSymbolKind
+{
+    ELFSYMBOLKIND_NONE,
+    ELFSYMBOLKIND_OBJECT,
+    ELFSYMBOLKIND_FUNCTION,
+    ELFSYMBOLKIND_SECTION,
+} ElfSymbolKind;
+
+typedef enum ElfRelocationKind
+{
+    ELFRELOCATIONKIND_ABSOLUTE64, // the address of the symbol
+    ELFRELOCATIONKIND_PC32,       // relative to the relocated field
+    ELFRELOCATIONKIND_PLT32,      // like pc32, but can go through the plt
+} ElfRelocationKind;
+
+typedef struct ElfSymbol
+{
+    char* name;
+    ElfSection section;
+    ElfSymbolKind kind;
+    uint64_t value; // offset in its section
+    uint64_t size;
+    bool is_global;
+} ElfSymbol;
+
+typedef struct ElfRelocation
+{
+    ElfSection section; // the section the relocated field is in
+    uint64_t offset;
+    int symbol;
+    ElfRelocationKind kind;
+    int64_t addend;
+} ElfRelocation;
+
+typedef struct ElfObject
+{
+    CodeBuffer sections[ ELFSECTION_COUNT ]; // the one for .bss stays empty
+    uint64_t bss_size;
+
+    ElfSymbol* symbols; // the symbol of each section first, in the order of ElfSection
+    ElfRelocation* relocations;
+
+    // open addressing over the indices of the named symbols, -1 if empty
+    int* symbol_buckets;
+    size_t bucket_count;
+} ElfObject;
+
+void elf_object_initialize( ElfObject* object );
+void elf_object_free( ElfObject* object );
+
+// the symbol for `name`, added as an undefined global if it is not known yet
+int elf_object_get_symbol( ElfObject* object, char* name );
+
+// places a symbol returned by elf_object_get_symbol()
+void elf_object_define_symbol( ElfObject* object, int symbol, ElfSection section, ElfSymbolKind kind,
+                               uint64_t value, uint64_t size, bool is_global );
+
+// the symbol that stands for the start of `section`
+int elf_object_get_section_symbol( ElfSection section );
+
+void elf_object_add_relocation( ElfObject* object, ElfSection section, uint64_t offset, int symbol,
+                                ElfRelocationKind kind, int64_t addend );
+
+// pads `section` with zeroes up to a multiple of `alignment`, returns the new
+// length
+uint64_t elf_object_align( ElfObject* object, ElfSection section, uint64_t alignment );
+
+// returns false after printing a message if the file could not be written
+bool elf_object_write( ElfObject* object, char* path );
+
+#endif
@@ -45,18 +45,19 @@ typedef enum ErrorKind
     ERRORKIND_MULTIPLEMEMBERINITIALIZEDUNION,
     ERRORKIND_NONPOINTERDEREFERENCE,
     ERRORKIND_VOIDPOINTERDEREFERENCE,
+    ERRORKIND_UNKNOWNATTRIBUTE,
+    ERRORKIND_INVALIDATTRIBUTE,
+    ERRORKIND_CONFLICTINGATTRIBUTES,
+
+    // module errors
+    ERRORKIND_MODULENOTATTOPLEVEL,
+    ERRORKIND_MULTIPLEMODULES,
+    ERRORKIND_MISSINGMODULE,
+    ERRORKIND_INVALIDMODULEINTERFACE,
+    ERRORKIND_SELFIMPORT,
+    ERRORKIND_MAININMODULE,
 } ErrorKind;
 
-typedef struct SourceCode
-{
-    char* code;
-    char* path;
-    int length;
-
-    // array of indexes to the first character after a newline
-    int* line_indexes;
-} SourceCode;
-
 typedef struct Error
 {
     ErrorKind kind;
@@ -108,12 +109,40 @@ typedef struct Error
         {
             Type parent_type;
         } missing_member;
+
+        struct
+        {
+            const char* reason; // completes "attribute 'x' ..."
+        } invalid_attribute;
+
+        struct
+        {
+            Token other_attribute_token;
+        } conflicting_attributes;
+
+        struct
+        {
+            Token other_module_token;
+        } multiple_modules;
+
+        struct
+        {
+            char* interface_path;
+        } missing_module; // also for invalid interfaces
     };
 } Error;
 
-SourceCode source_code_load( char* path );
+// returns false if the file cannot be read
+bool source_code_load( SourceCode* source_code, char* path );
+
+// takes a copy of `code`, which does not have to be terminated
+void source_code_initialize( SourceCode* source_code, char* path, const char* code, int length );
+void source_code_free( SourceCode* source_code );
 void source_code_print_line( SourceCode source_code, int line );
 
-void report_error( Error error );
+void report_error( SourceCode* source_code, Error error );
+
+// formats like printf to the diagnostics of the source, or stdout without them
+void report_message( SourceCode* source_code, const char* format, ... );
 
 #endif
@@ -0,0 +1,11 @@
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include "parser.h"
+
+// decides the storage of every array literal inside a function body based on
+// whether its data can outlive the function, whether it is ever written to and
+// how large it is
+void annotate_array_storage( Expression* program );
+
+#endif
@@ -1,6 +0,0 @@
-#ifndef GLOBALS_H
-#define GLOBALS_H
-
-extern SourceCode g_source_code;
-
-#endif
@@ -0,0 +1,14 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// FNV-1a, pass HASH_INITIAL as `hash` to start a new hash or a previous result
+// to continue it
+#define HASH_INITIAL 0xcbf29ce484222325ull
+
+uint64_t hash_bytes( uint64_t hash, const void* data, size_t length );
+uint64_t hash_string( uint64_t hash, const char* string );
+
+#endif
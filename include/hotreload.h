@@ -0,0 +1,28 @@
+#ifndef HOTRELOAD_H
+#define HOTRELOAD_H
+
+#include "parser.h"
+#include "semantic.h"
+
+// hot reloading runs a program inside the compiler from shared objects and
+// keeps a table with the current code of every function. when the source
+// changes, only the functions that changed are compiled into a new object and
+// swapped into the table, while the globals and the heap of the program stay
+
+typedef struct HotReload HotReload;
+
+// builds the whole program into the first object, which also has the
+// globals, and loads it. returns null after printing why if that failed
+HotReload* hot_reload_load( SemanticContext* context, Expression* program, char* include_directory,
+                            char* object_directory );
+
+// calls the main of the program with the arguments of a c main and returns
+// its exit code
+int hot_reload_run( HotReload* reload, int argc, char** argv );
+
+// builds the functions that changed since the last build and swaps them in
+// all at once. if the types, externs, globals or the parameters of a function
+// changed, or the build fails, the program keeps running its current code
+void hot_reload_update( HotReload* reload, SemanticContext* context, Expression* program );
+
+#endif
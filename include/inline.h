@@ -0,0 +1,15 @@
+#ifndef INLINE_H
+#define INLINE_H
+
+#include "parser.h"
+
+// the largest function body, in expressions, that is inlined by default
+#define DEFAULT_INLINE_THRESHOLD 16
+
+// marks the calls to small, non-recursive functions to be inlined by codegen.
+// a function is small if its body, with the calls in it that are inlined
+// themselves, has at most `threshold` expressions. functions with #[inline] are
+// always inlined and functions with #[noinline] never are
+void annotate_inline_calls( Expression* program, int threshold );
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef IR_H
+#define IR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "codebuffer.h"
+#include "parser.h"
+#include "semantic.h"
+#include "type.h"
+
+// the mid-level representation functions are optimized in. every value is
+// defined once, by the instruction that computes it, and values that depend on
+// control flow are merged by phis at the start of blocks. locals whose address
+// is taken live in memory and are accessed through explicit loads and stores
+
+typedef enum IrOpcode
+{
+    IROPCODE_CONSTANT,     // integer, float, bool, char or null pointer
+    IROPCODE_STRING,       // address of a string literal
+    IROPCODE_PARAM,
+    IROPCODE_PHI,          // one operand per predecessor of its block, in order
+    IROPCODE_COPY,
+    IROPCODE_CONVERT,      // to the type of the instruction
+
+    IROPCODE_ADD,
+    IROPCODE_SUBTRACT,
+    IROPCODE_MULTIPLY,
+    IROPCODE_DIVIDE,
+    IROPCODE_MODULO,
+    IROPCODE_EQUAL,
+    IROPCODE_NOTEQUAL,
+    IROPCODE_LESS,
+    IROPCODE_LESSEQUAL,
+    IROPCODE_GREATER,
+    IROPCODE_GREATEREQUAL,
+    IROPCODE_NEGATE,
+    IROPCODE_NOT,
+
+    IROPCODE_SLOT,         // address of a local that lives in memory
+    IROPCODE_GLOBAL,       // address of a global variable
+    IROPCODE_LOAD,         // operands: address
+    IROPCODE_STORE,        // operands: address, value
+    IROPCODE_ARRAYLITERAL, // operands: the initialized elements
+    IROPCODE_ARRAYLENGTH,  // operands: array
+    IROPCODE_ELEMENT,      // address of an element, operands: array, index
+    IROPCODE_CALL,         // operands: the arguments
+
+    // every block ends with exactly one of these
+    IROPCODE_JUMP,
+    IROPCODE_BRANCH,       // operands: condition
+    IROPCODE_RETURN,       // operands: the value, if any
+} IrOpcode;
+
+typedef struct IrInstruction
+{
+    IrOpcode opcode;
+    Type type; // of the value, void if there is none
+    int index; // unique in the function
+    struct IrBlock* block;
+    struct IrInstruction** operands;
+
+    union
+    {
+        uint64_t integer; // sign-extended for signed types, also bools and chars
+        double floating;
+        char* string; // already escaped
+        char* identifier; // of globals
+        int param_index;
+
+        struct
+        {
+            Type type;
+            ArrayStorage storage;
+        } array_literal;
+
+        struct
+        {
+            bool is_bounds_checked;
+            Token location_token;
+        } element;
+
+        struct
+        {
+            Expression* function;
+            bool is_tail_call; // returned right away, without growing the stack
+        } call;
+
+        // the jump target, or the targets for a true and a false condition
+        struct IrBlock* targets[ 2 ];
+    };
+} IrInstruction;
+
+typedef struct IrBlock
+{
+    int index;
+    IrInstruction** instructions; // phis first, the terminator last
+    struct IrBlock** predecessors;
+
+    // filled in by ir_compute_dominators
+    struct IrBlock* immediate_dominator;
+    int order; // in reverse postorder, -1 if unreachable
+
+    bool is_sealed; // used while the function is lowered
+} IrBlock;
+
+typedef struct IrFunction
+{
+    Expression* declaration;
+    IrBlock** blocks; // the entry block first
+    int instruction_count; // next free instruction index
+    int block_count; // next free block index
+} IrFunction;
+
+// ir.c
+IrBlock* ir_block_new( IrFunction* function );
+IrInstruction* ir_instruction_new( IrFunction* function, IrOpcode opcode, Type type );
+void ir_instruction_free( IrInstruction* instruction );
+void ir_function_free( IrFunction* function );
+
+bool ir_is_terminator( IrInstruction* instruction );
+bool ir_has_side_effects( IrInstruction* instruction );
+IrInstruction* ir_block_get_terminator( IrBlock* block );
+int ir_block_get_successor_count( IrBlock* block );
+IrBlock* ir_block_get_successor( IrBlock* block, int i );
+
+void ir_block_insert( IrBlock* block, IrInstruction* instruction, size_t position );
+void ir_block_insert_before_terminator( IrBlock* block, IrInstruction* instruction );
+void ir_block_remove( IrBlock* block, IrInstruction* instruction );
+void ir_add_edge( IrBlock* from, IrBlock* to );
+void ir_remove_edge( IrBlock* from, IrBlock* to ); // also drops the operands of phis in `to`
+void ir_replace_uses( IrFunction* function, IrInstruction* old_value, IrInstruction* new_value );
+
+// puts the reachable blocks in reverse postorder and drops the others
+void ir_remove_unreachable_blocks( IrFunction* function );
+void ir_compute_dominators( IrFunction* function );
+bool ir_dominates( IrBlock* dominator, IrBlock* block );
+
+// facts about the c types the ir values have
+Type ir_get_type_definition( Type type );
+bool ir_type_is_integer( Type type ); // includes bools and chars
+bool ir_type_is_float( Type type );
+bool ir_type_is_signed( Type type );
+int ir_type_get_bit_count( Type type );
+bool ir_type_equals( Type t1, Type t2 );
+
+// the bits of a constant, with floats as their ieee representation and f32s in
+// the low half
+uint64_t ir_get_constant_bits( IrInstruction* constant );
+
+// whether a global is initialized with something that needs no code to run,
+// and the bits it is then initialized with
+bool ir_is_literal_initializer( Expression* rvalue );
+uint64_t ir_get_literal_bits( Expression* rvalue, Type type );
+
+void ir_print_function( CodeBuffer* buffer, IrFunction* function );
+
+// irlower.c
+// returns null if the body of `function` uses something the ir cannot express,
+// codegen then works from the ast
+IrFunction* ir_lower_function( SemanticContext* context, Expression* program, Expression* function );
+
+// lowers and optimizes every reachable function of the program that the ir
+// can express, the result is kept in the declaration of the function
+void ir_lower_program( SemanticContext* context, Expression* program );
+
+// iroptimize.c
+void ir_propagate_copies( IrFunction* function );
+void ir_propagate_constants( IrFunction* function );
+void ir_number_values( IrFunction* function );
+void ir_hoist_loop_invariants( IrFunction* function );
+void ir_eliminate_dead_stores( IrFunction* function );
+void ir_eliminate_dead_code( IrFunction* function );
+void ir_optimize( IrFunction* function );
+
+#endif
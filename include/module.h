@@ -0,0 +1,30 @@
+#ifndef MODULE_H
+#define MODULE_H
+
+#include <stdbool.h>
+#include "parser.h"
+#include "semantic.h"
+
+// a program that starts with `module name;` is built into `name.o` and the
+// interface `name.octoi` next to its first file. the interface holds the
+// types and the signatures of the functions the module declares, so that a
+// program with `import name;` reads those instead of the source of the module.
+// modules are imported from the directory of the file that imports them
+
+#define MODULE_INTERFACE_EXTENSION ".octoi"
+
+// takes the `module` and `import` declarations out of the top level of
+// `program` and puts the declarations of each imported module, and of the
+// modules it imports, where it is imported. returns false after reporting
+// errors
+bool resolve_modules( SemanticContext* context, Expression* program );
+
+// writes the interface of a checked module. the file is left alone if it would
+// not change, so that whatever depends on it stays current. returns false after
+// printing why
+bool write_module_interface( SemanticContext* context, Expression* program );
+
+// the object file that belongs to the interface at `interface_path`
+char* get_module_object_path( char* interface_path );
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <stdbool.h>
+#include "driver.h"
+#include "parser.h"
+
+// the native backend writes x86-64 machine code for the ir of the program
+// straight into an elf object, which skips the C compiler for debug builds
+
+// returns false after printing why if the program uses something the native
+// backend cannot generate. every reachable function has to be lowered to the
+// ir, and globals can only be initialized with literals
+bool native_can_generate( Expression* program );
+
+// writes the program as a relocatable object to `object_path`, which is linked
+// like any other object. returns false if it could not be written
+bool generate_native_object( Expression* program, char* object_path, CheckMode check_mode, char* source_path );
+
+#endif
@@ -38,6 +38,15 @@ typedef enum UnaryOperation
     UNARYOPERATION_DEREFERENCE,
 } UnaryOperation;
 
+// where the data of an array literal lives, decided by escape analysis
+typedef enum ArrayStorage
+{
+    ARRAYSTORAGE_AUTOMATIC,  // compound literal on the stack
+    ARRAYSTORAGE_STATIC,     // constant data that is initialized once
+    ARRAYSTORAGE_HEAP,       // allocated, outlives the function that created it
+    ARRAYSTORAGE_SCOPEDHEAP, // allocated, freed when its variable goes out of scope
+} ArrayStorage;
+
 typedef enum ExpressionKind
 {
     // rvalues
@@ -67,6 +76,8 @@ typedef enum ExpressionKind
     EXPRESSIONKIND_CONDITIONAL, // if statements and while-loops
     EXPRESSIONKIND_FORLOOP,
     EXPRESSIONKIND_TYPEDECLARATION,
+    EXPRESSIONKIND_MODULE,
+    EXPRESSIONKIND_IMPORT, // replaced by what the module declares before semantic analysis
 
     // type rvalues
     EXPRESSIONKIND_TYPEIDENTIFIER,
@@ -75,6 +86,60 @@ typedef enum ExpressionKind
     EXPRESSIONKIND_COMPOUNDDEFINITION,
 } ExpressionKind;
 
+// what the attributes of a function declaration ask for, filled in during
+// semantic analysis
+typedef enum FunctionAttribute
+{
+    FUNCTIONATTRIBUTE_INLINE    = 1 << 0,
+    FUNCTIONATTRIBUTE_NOINLINE  = 1 << 1,
+    FUNCTIONATTRIBUTE_HOT       = 1 << 2,
+    FUNCTIONATTRIBUTE_COLD      = 1 << 3,
+    FUNCTIONATTRIBUTE_FLATTEN   = 1 << 4,
+    FUNCTIONATTRIBUTE_PURE      = 1 << 5,
+    FUNCTIONATTRIBUTE_CONST     = 1 << 6,
+    FUNCTIONATTRIBUTE_FASTMATH  = 1 << 7,
+    FUNCTIONATTRIBUTE_NORETURN  = 1 << 8,
+} FunctionAttribute;
+
+// what the attributes of a while or for loop ask for
+typedef enum LoopAttribute
+{
+    LOOPATTRIBUTE_UNROLL      = 1 << 0,
+    LOOPATTRIBUTE_VECTORIZE   = 1 << 1,
+    LOOPATTRIBUTE_NOVECTORIZE = 1 << 2,
+    LOOPATTRIBUTE_IVDEP       = 1 << 3,
+} LoopAttribute;
+
+typedef struct LoopAttributes
+{
+    int flags; // LOOPATTRIBUTE_*
+    int unroll_count;
+} LoopAttributes;
+
+// what a function can do besides computing its result, filled in by purity
+// analysis. weaker classes come later
+typedef enum Purity
+{
+    PURITY_CONST,       // only reads its arguments
+    PURITY_PURE,        // also reads memory, but writes none
+    PURITY_SIDEEFFECTS, // writes memory, allocates or calls something that does
+} Purity;
+
+// how the call in `return f(...)` can be made, filled in during semantic analysis
+typedef enum TailCall
+{
+    TAILCALL_NONE,  // an ordinary call
+    TAILCALL_SELF,  // the function calls itself, the call becomes a jump
+    TAILCALL_OTHER, // a call to a function with the same signature
+} TailCall;
+
+// `#[identifier]` or `#[identifier(argument)]` written in front of a statement
+typedef struct Attribute
+{
+    Token identifier_token;
+    struct Expression* argument; // NULL if there is none
+} Attribute;
+
 typedef struct Expression
 {
     ExpressionKind kind;
@@ -85,6 +150,9 @@ typedef struct Expression
     // for everything else
     Token starting_token;
 
+    // written in front of the statement, NULL if there are none
+    Attribute* attributes;
+
     union
     {
         // base cases
@@ -139,6 +207,9 @@ typedef struct Expression
 
             struct Expression* args; // array of expressions
             size_t arg_count;
+
+            // to be filled in by the inliner, null if the call is not inlined
+            struct Expression* inlined_function;
         } function_call;
 
         struct
@@ -171,11 +242,20 @@ typedef struct Expression
             // to be filled in during semantic analysis
             Type return_type;
             Type* param_types;
+            int attributes; // FUNCTIONATTRIBUTE_* flags
+            bool has_self_tail_call;
+            Purity purity; // to be filled in by purity analysis
+            bool is_reachable; // to be filled in by dead code elimination
+
+            // to be filled in by ir lowering, null if the body is generated
+            // from the ast
+            struct IrFunction* ir;
         } function_declaration;
 
         struct
         {
             struct Expression* rvalue;
+            TailCall tail_call; // to be filled in during semantic analysis
         } return_expression;
 
         struct
@@ -199,6 +279,8 @@ typedef struct Expression
             // will be null if there is no 'else' in if statements
             // will be null in while loops
             struct Expression* false_body;
+
+            LoopAttributes loop_attributes; // to be filled in during semantic analysis
         } conditional;
 
         struct
@@ -207,13 +289,18 @@ typedef struct Expression
             struct Expression* base_type_rvalue;
             int count_initialized; // number of values initialized in the array literal
             struct Expression* initialized_rvalues;
+            ArrayStorage storage; // to be filled in by escape analysis
         } array_literal;
 
         struct
         {
             Type element_type; // to be filled in during semantic analysis
+            int array_length; // to be filled in during semantic analysis, -1 if unknown
             struct Expression* lvalue;
             struct Expression* index_rvalue;
+
+            // to be filled in by the bounds check analysis
+            bool is_bounds_checked;
         } array_subscript;
 
         struct
@@ -226,6 +313,8 @@ typedef struct Expression
             Token iterator_token;
             struct Expression* iterable_rvalue;
             struct Expression* body;
+
+            LoopAttributes loop_attributes; // to be filled in during semantic analysis
         } for_loop;
 
         struct
@@ -233,8 +322,15 @@ typedef struct Expression
             Token identifier_token;
             struct Expression* rvalue;
             Type type; // to be filled in during semantic analysis
+            bool is_reachable; // to be filled in by dead code elimination
         } type_declaration;
 
+        // for both `module name;` and `import name;`
+        struct
+        {
+            Token identifier_token;
+        } module_declaration;
+
         struct
         {
             struct Expression* lvalue;
@@ -263,15 +359,22 @@ typedef struct Expression
 typedef struct Parser
 {
     Token* tokens;
+    SourceCode* source_code;
     int current_token_index;
     Token current_token;
     Token next_token;
 } Parser;
 
-void parser_initialize( Parser* parser, Token* _tokens );
+void parser_initialize( Parser* parser, Token* _tokens, SourceCode* source_code );
 
 Expression* parse( Parser* parser );
 
 void expression_print( Expression* expression );
 
+// calls `visit` on every rvalue and statement directly contained in `expression`
+// (type rvalues are not visited)
+void expression_visit_children( Expression* expression,
+                                void ( *visit )( Expression* child, void* data ),
+                                void* data );
+
 #endif
@@ -0,0 +1,14 @@
+#ifndef PURITY_H
+#define PURITY_H
+
+#include "parser.h"
+
+// classifies every function as const, pure or side-effecting from what its body
+// reads, writes and calls, and adds the matching attribute to the functions that
+// return a value. extern functions have side effects unless they are annotated
+void annotate_purity( Expression* program );
+
+// prints the class of every function
+void print_purity_report( Expression* program );
+
+#endif
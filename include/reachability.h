@@ -0,0 +1,12 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include "parser.h"
+#include "semantic.h"
+
+// marks the functions, externs and type declarations that can be reached from
+// `main` and the globals, and drops the pointer and array instantiations that
+// nothing reachable uses, so that codegen only emits what the program needs
+void eliminate_dead_code( SemanticContext* context, Expression* program );
+
+#endif
@@ -6,11 +6,34 @@
 
 typedef struct SemanticContext
 {
+    SourceCode* source_code; // what errors are reported in
     SymbolTable symbol_table;
     Type* return_type_stack;
+    Expression** function_stack; // the functions being checked, innermost last
+
+    // filled in by resolve_modules()
+    char* module_name;               // null if the program is not a module
+    char* module_interface_path;     // where the interface of the module is written
+    char** imported_module_names;    // every module the program imports, also indirectly
+    char** imported_interface_paths; // the interface each of them was read from
+
+    // the primitive types, which every context declares for itself
+    Type void_type;
+    Type char_type;
+    Type bool_type;
+    Type i8_type;
+    Type i16_type;
+    Type i32_type;
+    Type i64_type;
+    Type u8_type;
+    Type u16_type;
+    Type u32_type;
+    Type u64_type;
+    Type f32_type;
+    Type f64_type;
 } SemanticContext;
 
-void semantic_context_initialize( SemanticContext* context );
+void semantic_context_initialize( SemanticContext* context, SourceCode* source_code );
 bool check_semantics( SemanticContext* context, Expression* expression );
 
 #endif
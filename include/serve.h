@@ -0,0 +1,36 @@
+#ifndef SERVE_H
+#define SERVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// `octo serve` keeps one compiler process running that takes the command
+// lines of `octo build` over a unix domain socket. the client sends its working
+// directory and its stdout and stderr along, so a build prints the same
+// messages either way. requests are read one at a time, and each build
+// continues in a child process once the front end is done, which lets the
+// server hold on to whatever the front end produced
+
+typedef struct ServeRequest ServeRequest;
+
+// runs the command line of a request in the working directory of the client
+// and with its output, returns the exit code for the client
+typedef int ( *ServeHandler )( int argc, char** argv, ServeRequest* request, void* data );
+
+// takes requests on `socket_path` until the process is stopped or a client
+// with a different `version` shows up, which means octo was rebuilt. returns
+// false after printing why if nothing could be served
+bool serve_requests( char* socket_path, uint64_t version, ServeHandler handler, void* data );
+
+// finishes the request in a child process so that the server can take the
+// next one. returns true in the child, which goes on with the request, and
+// false in the server, which has to return from the handler right away.
+// without a server `request` is null and this just returns true
+bool serve_detach( ServeRequest* request );
+
+// runs a command line on the server at `socket_path`. returns false if there
+// is no server or it is a different version, then the command has to run in
+// this process
+bool serve_forward( char* socket_path, uint64_t version, int argc, char** argv, int* out_exit_code );
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "codebuffer.h"
 
 #define GET_TOKENKIND_GROUP_COUNT( ... )\
     ( sizeof( ( TokenKind[] ){ __VA_ARGS__ } ) / sizeof( TokenKind ) )
@@ -39,7 +40,8 @@
 #define TOKENKIND_EXPRESSION_STARTERS\
     TOKENKIND_LET, TOKENKIND_LEFTBRACE, TOKENKIND_FUNC, TOKENKIND_IDENTIFIER,\
     TOKENKIND_RETURN, TOKENKIND_EXTERN, TOKENKIND_IF, TOKENKIND_WHILE,\
-    TOKENKIND_FOR, TOKENKIND_STAR, TOKENKIND_TYPE
+    TOKENKIND_FOR, TOKENKIND_STAR, TOKENKIND_TYPE, TOKENKIND_HASH,\
+    TOKENKIND_MODULE, TOKENKIND_IMPORT
 
 /* #define TOKENKIND_TYPE_STARTERS\ */
 /*     TOKENKIND_IDENTIFIER, TOKENKIND_AMPERSAND, TOKENKIND_LEFTBRACKET */
@@ -75,6 +77,8 @@ typedef enum TokenKind
     TOKENKIND_TYPE,
     TOKENKIND_STRUCT,
     TOKENKIND_UNION,
+    TOKENKIND_MODULE,
+    TOKENKIND_IMPORT,
 
     TOKENKIND_INTEGER,
     TOKENKIND_FLOAT,
@@ -102,16 +106,20 @@ typedef enum TokenKind
     TOKENKIND_LEFTBRACKET,
     TOKENKIND_RIGHTBRACKET,
     TOKENKIND_AMPERSAND,
+    TOKENKIND_HASH,
 
     TOKENKIND_EOF,
 } TokenKind;
 
+typedef struct SourceCode SourceCode;
+
 typedef struct Token
 {
     TokenKind kind;
     int line;
     int column;
     char* as_string;
+    SourceCode* source_code; // null for tokens the compiler made up
 
     union
     {
@@ -135,8 +143,22 @@ typedef enum TokenizerState
     TOKENIZERSTATE_FLOAT     = 0x60,
 } TokenizerState;
 
+struct SourceCode
+{
+    char* code;
+    char* path;
+    int length;
+
+    // array of indexes to the first character after a newline
+    int* line_indexes;
+
+    // where errors are written, they are printed if this is null
+    CodeBuffer* diagnostics;
+};
+
 typedef struct Tokenizer
 {
+    SourceCode* source_code;
     int current_character_index;
     char character;
     char next_character;
@@ -150,7 +172,7 @@ typedef struct Tokenizer
     bool in_character;
 } Tokenizer;
 
-Token* tokenize();
+Token* tokenize( SourceCode* source_code );
 
 // helper functions
 bool _is_token_kind_in_group( TokenKind kind, TokenKind* group, size_t count );
@@ -0,0 +1,28 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver.h"
+#include "parser.h"
+
+// the interpreter compiles the ir of a program to register bytecode and runs
+// it right away, without a c compiler. every value of a function gets its own
+// register, arrays get two
+
+typedef struct Vm Vm;
+
+// returns null after printing why if the program uses something the
+// interpreter cannot run
+Vm* vm_compile( Expression* program, CheckMode check_mode, char* source_path );
+void vm_free( Vm* vm );
+
+// the index of the function called `identifier`, -1 if there is none
+int vm_find_function( Vm* vm, char* identifier );
+
+// calls a function with one word per argument and two for arrays, integers
+// extended to 64 bits and floats as their bits. returns the first word of the
+// result
+uint64_t vm_call( Vm* vm, int function, uint64_t* arguments );
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+// waits for a source file to change. on linux the directory of the file is
+// watched with inotify, because editors often save by replacing the file, and
+// elsewhere the file is read again a few times a second
+
+typedef struct SourceWatcher SourceWatcher;
+
+// the file does not have to exist yet. if its directory cannot be watched,
+// this says so and the file is read again a few times a second instead
+SourceWatcher* source_watcher_open( char* path );
+void source_watcher_close( SourceWatcher* watcher );
+
+// blocks until the content of the file differs from when this last returned,
+// or from when the watcher was opened. saving a file unchanged is not a change
+void source_watcher_wait( SourceWatcher* watcher );
+
+#endif
@@ -1,13 +1,109 @@
 #pragma once
 
+// the runtime cannot include the standard headers because the declarations in
+// them would conflict with the `extern` declarations in octo programs, so libc
+// functions are bound under reserved names instead
+#define OCTO_STRINGIFY_( x ) #x
+#define OCTO_STRINGIFY( x ) OCTO_STRINGIFY_( x )
+
+#if defined( _WIN32 )
+#define OCTO_RUNTIME_ERROR( ... ) ( __builtin_printf( __VA_ARGS__ ), __builtin_abort() )
+#else
+extern int octo_runtime_dprintf( int fd, const char* format, ... )
+    __asm__( OCTO_STRINGIFY( __USER_LABEL_PREFIX__ ) "dprintf" );
+#define OCTO_RUNTIME_ERROR( ... ) ( octo_runtime_dprintf( 2, __VA_ARGS__ ), __builtin_abort() )
+#endif
+
+extern void* octo_runtime_calloc( __SIZE_TYPE__ count, __SIZE_TYPE__ size )
+    __asm__( OCTO_STRINGIFY( __USER_LABEL_PREFIX__ ) "calloc" );
+extern void octo_runtime_free( void* pointer )
+    __asm__( OCTO_STRINGIFY( __USER_LABEL_PREFIX__ ) "free" );
+
+// the helpers are small enough that a call costs more than their body, release
+// builds make sure that they are always inlined
+#if defined( OCTO_ALWAYS_INLINE )
+#define OCTO_INLINE static inline __attribute__(( always_inline ))
+#else
+#define OCTO_INLINE static inline
+#endif
+
+// makes the call in a return statement a guaranteed tail call, where the
+// compiler supports it
+#if defined( __has_attribute )
+#if __has_attribute( musttail )
+#define OCTO_MUSTTAIL __attribute__(( musttail ))
+#endif
+#endif
+#if !defined( OCTO_MUSTTAIL )
+#define OCTO_MUSTTAIL
+#endif
+
+// what a checked subscript does with an index that is out of bounds
+#define OCTO_CHECKS_NONE       0 // nothing, the subscript is not checked after all
+#define OCTO_CHECKS_TRAP       1 // stops the program with a trap instruction
+#define OCTO_CHECKS_DIAGNOSTIC 2 // prints the location in the octo source and aborts
+#if !defined( OCTO_CHECKS )
+#define OCTO_CHECKS OCTO_CHECKS_DIAGNOSTIC
+#endif
+
+#if OCTO_CHECKS == OCTO_CHECKS_NONE
+#define OCTO_CHECK_INDEX( index, length, location ) ( ( void )( location ) )
+#elif OCTO_CHECKS == OCTO_CHECKS_TRAP
+#define OCTO_CHECK_INDEX( index, length, location )\
+    ( ( void )( location ), __builtin_expect( ( index ) >= ( length ), 0 ) ? __builtin_trap() : ( void )0 )
+#else
+#define OCTO_CHECK_INDEX( index, length, location )\
+    ( __builtin_expect( ( index ) >= ( length ), 0 )\
+        ? OCTO_RUNTIME_ERROR( "%s: index %llu is out of bounds for array of length %llu\n",\
+                              location, index, length )\
+        : ( void )0 )
+#endif
+
+// with OCTO_HOT_RELOAD every function is called through a table that the
+// process hosting the program replaces while it runs. the host owns the table
+// and hands every loaded unit the address of its current version, a call sees
+// either the old or the new table as a whole
+#if defined( OCTO_HOT_RELOAD )
+typedef void ( *OctoHotFunction )( void );
+static OctoHotFunction* const* octo_hot_table;
+__attribute__(( visibility( "default" ) )) void octo_hot_attach( OctoHotFunction* const* table )
+{
+    octo_hot_table = table;
+}
+#define OCTO_HOT_FUNCTION( slot ) ( __atomic_load_n( octo_hot_table, __ATOMIC_ACQUIRE )[ slot ] )
+#endif
+
+// storage for array literals that cannot live on the stack
+OCTO_INLINE void* octo_array_allocate( __SIZE_TYPE__ length, __SIZE_TYPE__ element_size )
+{
+    void* data = octo_runtime_calloc( length, element_size );
+    if( data == 0 )
+    {
+        OCTO_RUNTIME_ERROR( "out of memory allocating an array of length %llu\n",
+                            ( unsigned long long )length );
+    }
+    return data;
+}
+
+// used as a cleanup function, receives a pointer to the owning variable
+OCTO_INLINE void octo_array_release( void* owner )
+{
+    octo_runtime_free( *( void** )owner );
+}
+
 #define OCTO_DEFINE_ARRAY( T )\
     typedef struct OctoArray_##T\
     {\
         u64 length;\
         typeof( T )* data;\
     } OctoArray_##T;\
-    T* OctoArray_##T##_at(OctoArray_##T octo_array, u64 index)\
+    OCTO_INLINE T* OctoArray_##T##_at(OctoArray_##T octo_array, u64 index)\
+    {\
+        return octo_array.data + index;\
+    }\
+    OCTO_INLINE T* OctoArray_##T##_at_checked(OctoArray_##T octo_array, u64 index, const char* location)\
     {\
+        OCTO_CHECK_INDEX( index, octo_array.length, location );\
         return octo_array.data + index;\
     }
 
@@ -22,6 +118,9 @@ typedef unsigned int       u32;
 typedef unsigned long long u64;
 typedef float              f32;
 typedef double             f64;
+typedef _Bool              bool;
+#define true  1
+#define false 0
 
 // ( OctoArray_T ){
 //     .length = <length>,
@@ -0,0 +1,208 @@
+// this is the one file that uses the allocator of the C library
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "arena.h"
+#include "debug.h"
+
+#if defined( _MSC_VER )
+#define THREAD_LOCAL __declspec( thread )
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+// every block starts with a header that links it into the ring of its arena.
+// a block made without an arena is a ring of its own
+typedef union BlockHeader
+{
+    struct
+    {
+        union BlockHeader* previous;
+        union BlockHeader* next;
+    } links;
+    max_align_t alignment;
+} BlockHeader;
+
+struct Arena
+{
+    BlockHeader ring; // not a block, only links the first and the last one
+};
+
+static THREAD_LOCAL Arena* current_arena = NULL;
+
+static void make_ring( BlockHeader* header )
+{
+    header->links.previous = header;
+    header->links.next = header;
+}
+
+static void link_block( BlockHeader* header, Arena* arena )
+{
+    if( arena == NULL )
+    {
+        make_ring( header );
+        return;
+    }
+
+    header->links.previous = arena->ring.links.previous;
+    header->links.next = &arena->ring;
+    arena->ring.links.previous->links.next = header;
+    arena->ring.links.previous = header;
+}
+
+static void unlink_block( BlockHeader* header )
+{
+    header->links.previous->links.next = header->links.next;
+    header->links.next->links.previous = header->links.previous;
+}
+
+Arena* arena_new( void )
+{
+    Arena* arena = malloc( sizeof( Arena ) );
+    if( arena == NULL ) ALLOC_ERROR();
+
+    make_ring( &arena->ring );
+    return arena;
+}
+
+void arena_clear( Arena* arena )
+{
+    BlockHeader* header = arena->ring.links.next;
+    while( header != &arena->ring )
+    {
+        BlockHeader* next = header->links.next;
+        free( header );
+        header = next;
+    }
+
+    make_ring( &arena->ring );
+}
+
+void arena_free( Arena* arena )
+{
+    if( current_arena == arena )
+    {
+        current_arena = NULL;
+    }
+
+    arena_clear( arena );
+    free( arena );
+}
+
+Arena* arena_make_current( Arena* arena )
+{
+    Arena* previous = current_arena;
+    current_arena = arena;
+    return previous;
+}
+
+Arena* arena_get_current( void )
+{
+    return current_arena;
+}
+
+void arena_adopt( Arena* to, Arena* from )
+{
+    if( from->ring.links.next == &from->ring )
+    {
+        return;
+    }
+
+    BlockHeader* first = from->ring.links.next;
+    BlockHeader* last = from->ring.links.previous;
+    first->links.previous = to->ring.links.previous;
+    last->links.next = &to->ring;
+    to->ring.links.previous->links.next = first;
+    to->ring.links.previous = last;
+
+    make_ring( &from->ring );
+}
+
+void* arena_malloc( size_t size )
+{
+    if( size > SIZE_MAX - sizeof( BlockHeader ) )
+    {
+        return NULL;
+    }
+
+    BlockHeader* header = malloc( sizeof( BlockHeader ) + size );
+    if( header == NULL )
+    {
+        return NULL;
+    }
+
+    link_block( header, current_arena );
+    return header + 1;
+}
+
+void* arena_calloc( size_t count, size_t size )
+{
+    if( size != 0 && count > ( SIZE_MAX - sizeof( BlockHeader ) ) / size )
+    {
+        return NULL;
+    }
+
+    BlockHeader* header = calloc( 1, sizeof( BlockHeader ) + count * size );
+    if( header == NULL )
+    {
+        return NULL;
+    }
+
+    link_block( header, current_arena );
+    return header + 1;
+}
+
+void* arena_realloc( void* pointer, size_t size )
+{
+    if( pointer == NULL )
+    {
+        return arena_malloc( size );
+    }
+
+    if( size > SIZE_MAX - sizeof( BlockHeader ) )
+    {
+        return NULL;
+    }
+
+    // the neighbours of a moved block are pointed at its new place
+    BlockHeader* header = ( BlockHeader* )pointer - 1;
+    bool is_alone = header->links.next == header;
+    BlockHeader* moved = realloc( header, sizeof( BlockHeader ) + size );
+    if( moved == NULL )
+    {
+        return NULL;
+    }
+
+    if( is_alone )
+    {
+        make_ring( moved );
+    }
+    else
+    {
+        moved->links.previous->links.next = moved;
+        moved->links.next->links.previous = moved;
+    }
+    return moved + 1;
+}
+
+void arena_release( void* pointer )
+{
+    if( pointer == NULL )
+    {
+        return;
+    }
+
+    BlockHeader* header = ( BlockHeader* )pointer - 1;
+    unlink_block( header );
+    free( header );
+}
+
+void arena_free_system( void* pointer )
+{
+    free( pointer );
+}
@@ -0,0 +1,484 @@
+#include <stdint.h>
+#include <string.h>
+#include "boundscheck.h"
+#include "lvec.h"
+#include "parser.h"
+
+// a fact of the form `identifier < upper_bound` that holds at the current point
+// of the analysis
+typedef struct RangeFact
+{
+    char* identifier;
+    uint64_t upper_bound; // exclusive
+    bool is_valid; // false once the identifier has been reassigned
+} RangeFact;
+
+typedef struct BoundsCheckAnalysis
+{
+    RangeFact* facts;
+
+    // only locals of the current function whose address is never taken can have
+    // facts about them, everything else could be changed behind our back
+    char** local_identifiers;
+    char** address_taken_identifiers;
+
+    BoundsCheckStats stats;
+} BoundsCheckAnalysis;
+
+static bool contains_identifier( char** identifiers, char* identifier )
+{
+    size_t length = lvec_get_length( identifiers );
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( strcmp( identifiers[ i ], identifier ) == 0 )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void collect_local_identifiers( Expression* expression, void* data )
+{
+    char*** identifiers = data;
+
+    if( expression->kind == EXPRESSIONKIND_VARIABLEDECLARATION )
+    {
+        lvec_append( *identifiers, expression->variable_declaration.identifier_token.as_string );
+    }
+
+    // nested functions have their own locals
+    if( expression->kind != EXPRESSIONKIND_FUNCTIONDECLARATION )
+    {
+        expression_visit_children( expression, collect_local_identifiers, data );
+    }
+}
+
+static void collect_address_taken_identifiers( Expression* expression, void* data )
+{
+    char*** identifiers = data;
+
+    if( expression->kind == EXPRESSIONKIND_UNARY &&
+        expression->unary.operation == UNARYOPERATION_ADDRESSOF &&
+        expression->unary.operand->kind == EXPRESSIONKIND_IDENTIFIER )
+    {
+        lvec_append( *identifiers, expression->unary.operand->identifier.as_string );
+    }
+
+    expression_visit_children( expression, collect_address_taken_identifiers, data );
+}
+
+static void collect_assigned_identifiers( Expression* expression, void* data )
+{
+    char*** identifiers = data;
+
+    if( expression->kind == EXPRESSIONKIND_ASSIGNMENT &&
+        expression->assignment.lvalue->kind == EXPRESSIONKIND_IDENTIFIER )
+    {
+        lvec_append( *identifiers, expression->assignment.lvalue->identifier.as_string );
+    }
+
+    expression_visit_children( expression, collect_assigned_identifiers, data );
+}
+
+static void kill_facts( BoundsCheckAnalysis* analysis, char* identifier )
+{
+    size_t length = lvec_get_length( analysis->facts );
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( strcmp( analysis->facts[ i ].identifier, identifier ) == 0 )
+        {
+            analysis->facts[ i ].is_valid = false;
+        }
+    }
+}
+
+// invalidates the facts about every identifier that is assigned to somewhere
+// inside `loop` because they only hold on the first iteration
+static void kill_facts_assigned_in( BoundsCheckAnalysis* analysis, Expression* loop )
+{
+    char** assigned_identifiers = lvec_new( char* );
+    collect_assigned_identifiers( loop, &assigned_identifiers );
+
+    size_t length = lvec_get_length( assigned_identifiers );
+    for( size_t i = 0; i < length; i++ )
+    {
+        kill_facts( analysis, assigned_identifiers[ i ] );
+    }
+
+    lvec_free( assigned_identifiers );
+}
+
+static void truncate_facts( BoundsCheckAnalysis* analysis, size_t length )
+{
+    while( lvec_get_length( analysis->facts ) > length )
+    {
+        lvec_remove_last( analysis->facts );
+    }
+}
+
+static bool can_have_facts( BoundsCheckAnalysis* analysis, Expression* expression )
+{
+    if( expression->kind != EXPRESSIONKIND_IDENTIFIER )
+    {
+        return false;
+    }
+
+    // references (for-loop iterators) point into memory that can change
+    if( expression->identifier.type.kind == TYPEKIND_REFERENCE )
+    {
+        return false;
+    }
+
+    char* identifier = expression->identifier.as_string;
+    return contains_identifier( analysis->local_identifiers, identifier ) &&
+        !contains_identifier( analysis->address_taken_identifiers, identifier );
+}
+
+static void push_fact( BoundsCheckAnalysis* analysis, Expression* identifier, uint64_t upper_bound )
+{
+    RangeFact fact = {
+        .identifier = identifier->identifier.as_string,
+        .upper_bound = upper_bound,
+        .is_valid = true,
+    };
+    lvec_append_aggregate( analysis->facts, fact );
+}
+
+// adds the facts that hold when `condition` is true
+static void push_condition_facts( BoundsCheckAnalysis* analysis, Expression* condition )
+{
+    if( condition->kind != EXPRESSIONKIND_BINARY )
+    {
+        return;
+    }
+
+    Expression* left = condition->binary.left;
+    Expression* right = condition->binary.right;
+
+    switch( condition->binary.operation )
+    {
+        case BINARYOPERATION_AND:
+        {
+            push_condition_facts( analysis, left );
+            push_condition_facts( analysis, right );
+            break;
+        }
+
+        // i < n, i <= n
+        case BINARYOPERATION_LESS:
+        case BINARYOPERATION_LESSEQUAL:
+        {
+            if( can_have_facts( analysis, left ) && right->kind == EXPRESSIONKIND_INTEGER )
+            {
+                bool is_inclusive = condition->binary.operation == BINARYOPERATION_LESSEQUAL;
+                if( is_inclusive && right->integer == UINT64_MAX )
+                {
+                    break;
+                }
+                push_fact( analysis, left, right->integer + is_inclusive );
+            }
+            break;
+        }
+
+        // n > i, n >= i
+        case BINARYOPERATION_GREATER:
+        case BINARYOPERATION_GREATEREQUAL:
+        {
+            if( can_have_facts( analysis, right ) && left->kind == EXPRESSIONKIND_INTEGER )
+            {
+                bool is_inclusive = condition->binary.operation == BINARYOPERATION_GREATEREQUAL;
+                if( is_inclusive && left->integer == UINT64_MAX )
+                {
+                    break;
+                }
+                push_fact( analysis, right, left->integer + is_inclusive );
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+
+static bool get_upper_bound( BoundsCheckAnalysis* analysis, Expression* expression, uint64_t* out_upper_bound )
+{
+    if( !can_have_facts( analysis, expression ) )
+    {
+        return false;
+    }
+
+    bool is_found = false;
+    size_t length = lvec_get_length( analysis->facts );
+    for( size_t i = 0; i < length; i++ )
+    {
+        RangeFact fact = analysis->facts[ i ];
+        if( !fact.is_valid || strcmp( fact.identifier, expression->identifier.as_string ) != 0 )
+        {
+            continue;
+        }
+
+        if( !is_found || fact.upper_bound < *out_upper_bound )
+        {
+            *out_upper_bound = fact.upper_bound;
+            is_found = true;
+        }
+    }
+
+    return is_found;
+}
+
+// indexes can only be negative when they are made up of literals only, e.g.
+// `-1` or `0 - 1`, so anything built without those is known to be unsigned
+static bool is_index_nonnegative( Expression* expression )
+{
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_INTEGER:
+        case EXPRESSIONKIND_IDENTIFIER:
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        case EXPRESSIONKIND_MEMBERACCESS:
+        {
+            return true;
+        }
+
+        case EXPRESSIONKIND_BINARY:
+        {
+            switch( expression->binary.operation )
+            {
+                case BINARYOPERATION_ADD:
+                case BINARYOPERATION_MULTIPLY:
+                case BINARYOPERATION_DIVIDE:
+                case BINARYOPERATION_MODULO:
+                {
+                    return is_index_nonnegative( expression->binary.left ) &&
+                        is_index_nonnegative( expression->binary.right );
+                }
+
+                default:
+                {
+                    return false;
+                }
+            }
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+static bool is_index_in_range( BoundsCheckAnalysis* analysis, Expression* index, int array_length )
+{
+    if( array_length < 0 )
+    {
+        return false;
+    }
+
+    uint64_t length = array_length;
+    uint64_t upper_bound;
+
+    switch( index->kind )
+    {
+        // arr[3]
+        case EXPRESSIONKIND_INTEGER:
+        {
+            return index->integer < length;
+        }
+
+        // arr[i] where i < n
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            return get_upper_bound( analysis, index, &upper_bound ) && upper_bound <= length;
+        }
+
+        case EXPRESSIONKIND_BINARY:
+        {
+            Expression* left = index->binary.left;
+            Expression* right = index->binary.right;
+
+            switch( index->binary.operation )
+            {
+                // arr[i + c] where i < n
+                case BINARYOPERATION_ADD:
+                {
+                    if( left->kind == EXPRESSIONKIND_INTEGER )
+                    {
+                        Expression* temp = left;
+                        left = right;
+                        right = temp;
+                    }
+
+                    if( right->kind != EXPRESSIONKIND_INTEGER ||
+                        !get_upper_bound( analysis, left, &upper_bound ) )
+                    {
+                        return false;
+                    }
+
+                    return right->integer <= length &&
+                        upper_bound <= length - right->integer;
+                }
+
+                // arr[x % c] where c <= n
+                case BINARYOPERATION_MODULO:
+                {
+                    return right->kind == EXPRESSIONKIND_INTEGER &&
+                        right->integer > 0 &&
+                        right->integer <= length &&
+                        is_index_nonnegative( left );
+                }
+
+                default:
+                {
+                    return false;
+                }
+            }
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+static void analyze_expression( Expression* expression, void* data )
+{
+    BoundsCheckAnalysis* analysis = data;
+
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_FUNCTIONDECLARATION:
+        {
+            Expression* body = expression->function_declaration.body;
+            if( body == NULL )
+            {
+                break;
+            }
+
+            BoundsCheckAnalysis function_analysis = {
+                .facts = lvec_new( RangeFact ),
+                .local_identifiers = lvec_new( char* ),
+                .address_taken_identifiers = lvec_new( char* ),
+            };
+
+            int param_count = expression->function_declaration.param_count;
+            for( int i = 0; i < param_count; i++ )
+            {
+                char* param_identifier = expression->function_declaration.param_identifiers_tokens[ i ].as_string;
+                lvec_append( function_analysis.local_identifiers, param_identifier );
+            }
+            collect_local_identifiers( body, &function_analysis.local_identifiers );
+            collect_address_taken_identifiers( body, &function_analysis.address_taken_identifiers );
+
+            analyze_expression( body, &function_analysis );
+
+            analysis->stats.checked_count += function_analysis.stats.checked_count;
+            analysis->stats.eliminated_count += function_analysis.stats.eliminated_count;
+
+            lvec_free( function_analysis.facts );
+            lvec_free( function_analysis.local_identifiers );
+            lvec_free( function_analysis.address_taken_identifiers );
+            break;
+        }
+
+        case EXPRESSIONKIND_COMPOUND:
+        {
+            size_t facts_length = lvec_get_length( analysis->facts );
+            expression_visit_children( expression, analyze_expression, analysis );
+            truncate_facts( analysis, facts_length );
+            break;
+        }
+
+        case EXPRESSIONKIND_ASSIGNMENT:
+        {
+            expression_visit_children( expression, analyze_expression, analysis );
+
+            Expression* lvalue = expression->assignment.lvalue;
+            if( lvalue->kind == EXPRESSIONKIND_IDENTIFIER )
+            {
+                kill_facts( analysis, lvalue->identifier.as_string );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_CONDITIONAL:
+        {
+            if( expression->conditional.is_loop )
+            {
+                kill_facts_assigned_in( analysis, expression );
+            }
+
+            Expression* condition = expression->conditional.condition;
+            analyze_expression( condition, analysis );
+
+            size_t facts_length = lvec_get_length( analysis->facts );
+            push_condition_facts( analysis, condition );
+            analyze_expression( expression->conditional.true_body, analysis );
+            truncate_facts( analysis, facts_length );
+
+            Expression* false_body = expression->conditional.false_body;
+            if( false_body != NULL )
+            {
+                analyze_expression( false_body, analysis );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_FORLOOP:
+        {
+            analyze_expression( expression->for_loop.iterable_rvalue, analysis );
+            kill_facts_assigned_in( analysis, expression->for_loop.body );
+            analyze_expression( expression->for_loop.body, analysis );
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            expression_visit_children( expression, analyze_expression, analysis );
+
+            Expression* index_rvalue = expression->array_subscript.index_rvalue;
+            int array_length = expression->array_subscript.array_length;
+            if( is_index_in_range( analysis, index_rvalue, array_length ) )
+            {
+                expression->array_subscript.is_bounds_checked = false;
+                analysis->stats.eliminated_count++;
+            }
+            else
+            {
+                expression->array_subscript.is_bounds_checked = true;
+                analysis->stats.checked_count++;
+            }
+            break;
+        }
+
+        default:
+        {
+            expression_visit_children( expression, analyze_expression, analysis );
+            break;
+        }
+    }
+}
+
+BoundsCheckStats annotate_bounds_checks( Expression* program )
+{
+    BoundsCheckAnalysis analysis = {
+        .facts = lvec_new( RangeFact ),
+        .local_identifiers = lvec_new( char* ),
+        .address_taken_identifiers = lvec_new( char* ),
+    };
+
+    analyze_expression( program, &analysis );
+
+    lvec_free( analysis.facts );
+    lvec_free( analysis.local_identifiers );
+    lvec_free( analysis.address_taken_identifiers );
+
+    return analysis.stats;
+}
@@ -0,0 +1,200 @@
+// for getpid and mkdir
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "codebuffer.h"
+#include "debug.h"
+#include "driver.h"
+#include "hash.h"
+
+#if defined( _WIN32 )
+#include <direct.h>
+#include <process.h>
+#define make_directory( path ) _mkdir( path )
+#define get_process_id() _getpid()
+#define S_ISDIR( mode ) ( ( ( mode ) & _S_IFMT ) == _S_IFDIR )
+#else
+#include <unistd.h>
+#define make_directory( path ) mkdir( path, 0755 )
+#define get_process_id() getpid()
+#endif
+
+// bump whenever the way objects are generated changes without the generated
+// code itself changing
+#define CACHE_VERSION "1"
+
+static char* join_path( const char* directory, const char* name )
+{
+    char* path = malloc( strlen( directory ) + strlen( name ) + 2 );
+    if( path == NULL ) ALLOC_ERROR();
+
+    sprintf( path, "%s/%s", directory, name );
+    return path;
+}
+
+static bool is_directory( char* path )
+{
+    struct stat path_stat;
+    return stat( path, &path_stat ) == 0 && S_ISDIR( path_stat.st_mode );
+}
+
+// like `mkdir -p`
+static bool make_directories( char* path )
+{
+    for( char* c = path + 1; *c != '\0'; c++ )
+    {
+        if( *c != '/' && *c != '\\' )
+        {
+            continue;
+        }
+
+        char separator = *c;
+        *c = '\0';
+        bool is_made = make_directory( path ) == 0 || is_directory( path );
+        *c = separator;
+
+        if( !is_made )
+        {
+            return false;
+        }
+    }
+
+    return make_directory( path ) == 0 || is_directory( path );
+}
+
+// $XDG_CACHE_HOME/octo, ~/.cache/octo or %LOCALAPPDATA%/octo
+char* object_cache_get_default_directory( void )
+{
+    char* xdg_cache_home = getenv( "XDG_CACHE_HOME" );
+    if( xdg_cache_home != NULL && *xdg_cache_home != '\0' )
+    {
+        return join_path( xdg_cache_home, "octo" );
+    }
+
+    char* home = getenv( "HOME" );
+    if( home != NULL && *home != '\0' )
+    {
+        return join_path( home, ".cache/octo" );
+    }
+
+    char* local_app_data = getenv( "LOCALAPPDATA" );
+    if( local_app_data != NULL && *local_app_data != '\0' )
+    {
+        return join_path( local_app_data, "octo" );
+    }
+
+    return NULL;
+}
+
+static uint64_t hash_file( uint64_t hash, char* path )
+{
+    FILE* file = fopen( path, "rb" );
+    if( file == NULL )
+    {
+        return hash_string( hash, "" );
+    }
+
+    char chunk[ 4096 ];
+    size_t length;
+    while( ( length = fread( chunk, 1, sizeof( chunk ), file ) ) > 0 )
+    {
+        hash = hash_bytes( hash, chunk, length );
+    }
+    fclose( file );
+
+    return hash;
+}
+
+bool object_cache_open( ObjectCache* cache, char* directory, char* runtime_header_path )
+{
+    if( directory != NULL )
+    {
+        cache->directory = malloc( strlen( directory ) + 1 );
+        if( cache->directory == NULL ) ALLOC_ERROR();
+        strcpy( cache->directory, directory );
+    }
+    else
+    {
+        cache->directory = object_cache_get_default_directory();
+    }
+
+    if( cache->directory == NULL || !make_directories( cache->directory ) )
+    {
+        printf( "Could not create the cache directory '%s'.\n",
+                cache->directory != NULL ? cache->directory : "" );
+        free( cache->directory );
+        return false;
+    }
+
+    uint64_t hash = hash_string( HASH_INITIAL, CACHE_VERSION );
+    hash = c_compiler_hash_configuration( hash, cache->directory );
+    cache->configuration_hash = hash_file( hash, runtime_header_path );
+
+    return true;
+}
+
+void object_cache_close( ObjectCache* cache )
+{
+    free( cache->directory );
+}
+
+char* object_cache_get_path( ObjectCache* cache, CodeBuffer* translation_unit )
+{
+    uint64_t hash = hash_bytes( cache->configuration_hash, translation_unit->data, translation_unit->length );
+
+    char name[ 32 ];
+    sprintf( name, "%016llx.o", ( unsigned long long )hash );
+    return join_path( cache->directory, name );
+}
+
+char* object_cache_get_program_path( ObjectCache* cache, uint64_t program_hash )
+{
+    uint64_t hash = hash_bytes( cache->configuration_hash, &program_hash, sizeof( program_hash ) );
+
+    char name[ 32 ];
+    sprintf( name, "%016llx.so", ( unsigned long long )hash );
+    return join_path( cache->directory, name );
+}
+
+uint64_t object_cache_hash_file_stamp( uint64_t hash, char* path )
+{
+    struct stat file_stat;
+    if( stat( path, &file_stat ) != 0 )
+    {
+        return hash_string( hash, "" );
+    }
+
+    int64_t stamp[ 2 ] = { ( int64_t )file_stat.st_size, ( int64_t )file_stat.st_mtime };
+    return hash_bytes( hash, stamp, sizeof( stamp ) );
+}
+
+char* object_cache_get_temporary_path( char* object_path )
+{
+    char* temporary_path = malloc( strlen( object_path ) + 32 );
+    if( temporary_path == NULL ) ALLOC_ERROR();
+
+    sprintf( temporary_path, "%s.%d.tmp", object_path, ( int )get_process_id() );
+    return temporary_path;
+}
+
+bool object_cache_contains( char* object_path )
+{
+    struct stat object_stat;
+    return stat( object_path, &object_stat ) == 0;
+}
+
+bool object_cache_insert( char* temporary_path, char* object_path )
+{
+    if( rename( temporary_path, object_path ) != 0 )
+    {
+        // someone else already put the same object there
+        remove( temporary_path );
+        return object_cache_contains( object_path );
+    }
+
+    return true;
+}
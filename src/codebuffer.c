@@ -0,0 +1,256 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codebuffer.h"
+#include "debug.h"
+
+#define INITIAL_CAPACITY ( 64 * 1024 )
+
+// two digits at a time halves the number of divisions
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+void code_buffer_initialize( CodeBuffer* buffer )
+{
+    buffer->data = malloc( INITIAL_CAPACITY );
+    if( buffer->data == NULL ) ALLOC_ERROR();
+
+    buffer->length = 0;
+    buffer->capacity = INITIAL_CAPACITY;
+    buffer->sink = NULL;
+    buffer->has_sink_failed = false;
+}
+
+void code_buffer_free( CodeBuffer* buffer )
+{
+    free( buffer->data );
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+void code_buffer_set_sink( CodeBuffer* buffer, FILE* sink )
+{
+    buffer->sink = sink;
+    buffer->has_sink_failed = false;
+}
+
+bool code_buffer_flush( CodeBuffer* buffer )
+{
+    if( buffer->sink == NULL )
+    {
+        return true;
+    }
+
+    // after a failed write the rest of the code is dropped, the reader is gone
+    if( !buffer->has_sink_failed && !code_buffer_write( buffer, buffer->sink ) )
+    {
+        buffer->has_sink_failed = true;
+    }
+    buffer->length = 0;
+
+    return !buffer->has_sink_failed;
+}
+
+static void reserve( CodeBuffer* buffer, size_t extra_length )
+{
+    if( buffer->length + extra_length <= buffer->capacity )
+    {
+        return;
+    }
+
+    if( buffer->sink != NULL )
+    {
+        code_buffer_flush( buffer );
+        if( extra_length <= buffer->capacity )
+        {
+            return;
+        }
+    }
+
+    size_t new_capacity = buffer->capacity * 2;
+    while( new_capacity < buffer->length + extra_length )
+    {
+        new_capacity *= 2;
+    }
+
+    buffer->data = realloc( buffer->data, new_capacity );
+    if( buffer->data == NULL ) ALLOC_ERROR();
+
+    buffer->capacity = new_capacity;
+}
+
+void code_buffer_append_data( CodeBuffer* buffer, const char* data, size_t length )
+{
+    reserve( buffer, length );
+    memcpy( buffer->data + buffer->length, data, length );
+    buffer->length += length;
+}
+
+void code_buffer_append_string( CodeBuffer* buffer, const char* string )
+{
+    code_buffer_append_data( buffer, string, strlen( string ) );
+}
+
+void code_buffer_append_char( CodeBuffer* buffer, char character )
+{
+    reserve( buffer, 1 );
+    buffer->data[ buffer->length ] = character;
+    buffer->length++;
+}
+
+void code_buffer_append_unsigned( CodeBuffer* buffer, uint64_t integer )
+{
+    // digits are written from the back of the scratch space
+    char digits[ 20 ];
+    char* start = digits + sizeof( digits );
+
+    while( integer >= 100 )
+    {
+        int pair = ( integer % 100 ) * 2;
+        integer /= 100;
+        start -= 2;
+        start[ 0 ] = digit_pairs[ pair ];
+        start[ 1 ] = digit_pairs[ pair + 1 ];
+    }
+
+    if( integer >= 10 )
+    {
+        int pair = integer * 2;
+        start -= 2;
+        start[ 0 ] = digit_pairs[ pair ];
+        start[ 1 ] = digit_pairs[ pair + 1 ];
+    }
+    else
+    {
+        start--;
+        *start = '0' + integer;
+    }
+
+    code_buffer_append_data( buffer, start, digits + sizeof( digits ) - start );
+}
+
+void code_buffer_append_integer( CodeBuffer* buffer, int64_t integer )
+{
+    if( integer < 0 )
+    {
+        code_buffer_append_char( buffer, '-' );
+        code_buffer_append_unsigned( buffer, -( uint64_t )integer );
+        return;
+    }
+
+    code_buffer_append_unsigned( buffer, integer );
+}
+
+void code_buffer_append_float( CodeBuffer* buffer, double floating )
+{
+    if( isinf( floating ) )
+    {
+        code_buffer_append_string( buffer, floating < 0 ? "-__builtin_inf()" : "__builtin_inf()" );
+        return;
+    }
+
+    if( isnan( floating ) )
+    {
+        code_buffer_append_string( buffer, "__builtin_nan(\"\")" );
+        return;
+    }
+
+    // 17 significant digits always round-trip, but fewer usually do
+    char digits[ 32 ];
+    for( int precision = 1; precision <= 17; precision++ )
+    {
+        snprintf( digits, sizeof( digits ), "%.*g", precision, floating );
+        if( strtod( digits, NULL ) == floating )
+        {
+            break;
+        }
+    }
+
+    code_buffer_append_string( buffer, digits );
+
+    // keep it a floating-point literal, `1` would be an int in C
+    if( strpbrk( digits, ".e" ) == NULL )
+    {
+        code_buffer_append_string( buffer, ".0" );
+    }
+}
+
+bool code_buffer_write( CodeBuffer* buffer, FILE* file )
+{
+    return fwrite( buffer->data, 1, buffer->length, file ) == buffer->length;
+}
+
+static int get_hex_digit( char c )
+{
+    if( c >= '0' && c <= '9' ) return c - '0';
+    if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+    if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+    return -1;
+}
+
+void code_buffer_append_unescaped( CodeBuffer* buffer, const char* escaped )
+{
+    for( const char* c = escaped; *c != '\0'; c++ )
+    {
+        if( *c != '\\' || c[ 1 ] == '\0' )
+        {
+            code_buffer_append_char( buffer, *c );
+            continue;
+        }
+
+        c++;
+        switch( *c )
+        {
+            case 'n': code_buffer_append_char( buffer, '\n' ); break;
+            case 't': code_buffer_append_char( buffer, '\t' ); break;
+            case 'r': code_buffer_append_char( buffer, '\r' ); break;
+            case 'a': code_buffer_append_char( buffer, '\a' ); break;
+            case 'b': code_buffer_append_char( buffer, '\b' ); break;
+            case 'f': code_buffer_append_char( buffer, '\f' ); break;
+            case 'v': code_buffer_append_char( buffer, '\v' ); break;
+            case 'e': code_buffer_append_char( buffer, 27 ); break;
+
+            case 'x':
+            {
+                int value = 0;
+                while( get_hex_digit( c[ 1 ] ) != -1 )
+                {
+                    value = value * 16 + get_hex_digit( c[ 1 ] );
+                    c++;
+                }
+                code_buffer_append_char( buffer, ( char )value );
+                break;
+            }
+
+            default:
+            {
+                if( *c >= '0' && *c <= '7' )
+                {
+                    int value = *c - '0';
+                    for( int i = 0; i < 2 && c[ 1 ] >= '0' && c[ 1 ] <= '7'; i++ )
+                    {
+                        value = value * 8 + ( c[ 1 ] - '0' );
+                        c++;
+                    }
+                    code_buffer_append_char( buffer, ( char )value );
+                }
+                else
+                {
+                    code_buffer_append_char( buffer, *c ); // \\, \', \" and \?
+                }
+                break;
+            }
+        }
+    }
+}
@@ -1,7 +1,12 @@
-#include <stdarg.h>
-#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codebuffer.h"
 #include "codegen.h"
 #include "debug.h"
+#include "error.h"
+#include "hash.h"
+#include "ir.h"
 #include "parser.h"
 #include "lvec.h"
 #include "semantic.h"
@@ -12,50 +17,105 @@
 
 #define MAX(a,b) ( ( ( a ) > ( b ) ) ? ( a ) : ( b ) )
 
-static int depth = 0;
-static void append( FILE* file, const char* format, ... )
+// a call whose callee's body is being generated in place of the call
+typedef struct InlineFrame
 {
-    va_list args;
-    va_start( args, format );
-    vfprintf( file, format, args );
-    va_end( args );
+    char** local_identifiers; // params and locals, renamed to stay apart from the caller's
+    int index; // makes the names of the frame unique in the function
+    bool has_jump_to_end; // set by the returns of the body, which need the end label
+    struct InlineFrame* enclosing_frame;
+} InlineFrame;
+
+// the state of generating one translation unit
+typedef struct Generator
+{
+    SemanticContext* context;
+    Expression* current_function; // the function whose body is being generated
+    InlineFrame* current_inline_frame;
+    int inline_count; // in the function being generated
+    int depth;
+
+    // hot reloading defines functions under a prefixed name, the plain name is
+    // a stub that calls whatever the table holds
+    char* function_name_prefix;
+} Generator;
+
+static void initialize_generator( Generator* generator, SemanticContext* context )
+{
+    *generator = ( Generator ){
+        .context = context,
+        .function_name_prefix = "",
+    };
+}
+
+static void append( CodeBuffer* buffer, const char* string )
+{
+    code_buffer_append_string( buffer, string );
+}
+
+static void append_integer( CodeBuffer* buffer, int64_t integer )
+{
+    code_buffer_append_integer( buffer, integer );
+}
+
+// locals of inlined functions are prefixed with the index of their frame
+static void generate_local_identifier( CodeBuffer* buffer, Generator* generator, char* identifier )
+{
+    if( generator->current_inline_frame != NULL )
+    {
+        char** local_identifiers = generator->current_inline_frame->local_identifiers;
+        size_t length = lvec_get_length( local_identifiers );
+        for( size_t i = 0; i < length; i++ )
+        {
+            if( strcmp( local_identifiers[ i ], identifier ) == 0 )
+            {
+                append( buffer, "octo_inline_" );
+                append_integer( buffer, generator->current_inline_frame->index );
+                append( buffer, "_" );
+                break;
+            }
+        }
+    }
+
+    append( buffer, identifier );
 }
 
-static void generate_compound( FILE* file, SemanticContext* context, Expression* expression )
+static void generate_statement( CodeBuffer* buffer, Generator* generator, Expression* expression );
+static void generate_compound( CodeBuffer* buffer, Generator* generator, Expression* expression )
 {
-    if( depth != 0 )
+    if( generator->depth != 0 )
     {
-        append( file, "{\n" );
+        append( buffer, "{\n" );
     }
-    depth++;
+    generator->depth++;
 
     size_t length = lvec_get_length( expression->compound.expressions );
     for( size_t i = 0; i < length; i++ )
     {
         Expression* e = expression->compound.expressions[ i ];
-        generate_code( file, context, e );
+        generate_statement( buffer, generator, e );
     }
 
-    depth--;
-    if( depth != 0)
+    generator->depth--;
+    if( generator->depth != 0)
     {
-        append( file, "}\n" );
+        append( buffer, "}\n" );
     }
 }
 
-static void generate_type( FILE* file, Type type )
+static void generate_type( CodeBuffer* buffer, Type type )
 {
     switch( type.kind )
     {
         case TYPEKIND_NAMED:
         {
-            append( file, "%s", type.named.as_string );
+            append( buffer, type.named.as_string );
             break;
         }
 
         case TYPEKIND_COMPOUND:
         {
-            append( file, "%s { ", type.compound.is_struct ? "struct" : "union" );
+            append( buffer, type.compound.is_struct ? "struct { " : "union { " );
 
             Symbol* member_symbols = type.compound.member_symbol_table->symbols;
             int member_count = type.compound.member_symbol_table->length;
@@ -64,10 +124,12 @@ static void generate_type( FILE* file, Type type )
                 char* member_identifier = member_symbols[ i ].token.as_string;
                 Type member_type = member_symbols[ i ].type;
 
-                generate_type( file, member_type );
-                append( file, " %s; ", member_identifier );
+                generate_type( buffer, member_type );
+                append( buffer, " " );
+                append( buffer, member_identifier );
+                append( buffer, "; " );
             }
-            append( file, "}" );
+            append( buffer, "}" );
             break;
         }
 
@@ -79,22 +141,22 @@ static void generate_type( FILE* file, Type type )
 
         case TYPEKIND_POINTER:
         {
-            append( file, "OctoPtr_" );
-            generate_type( file, *type.pointer.base_type );
+            append( buffer, "OctoPtr_" );
+            generate_type( buffer, *type.pointer.base_type );
             break;
         }
 
         case TYPEKIND_ARRAY:
         {
-            append( file, "OctoArray_" );
-            generate_type( file, *type.array.base_type );
+            append( buffer, "OctoArray_" );
+            generate_type( buffer, *type.array.base_type );
             break;
         }
 
         case TYPEKIND_REFERENCE:
         {
-            generate_type( file, *type.reference.base_type );
-            append( file, "*" );
+            generate_type( buffer, *type.reference.base_type );
+            append( buffer, "*" );
             break;
         }
 
@@ -107,41 +169,156 @@ static void generate_type( FILE* file, Type type )
     }
 }
 
-static void generate_rvalue( FILE* file, SemanticContext* context, Expression* expression );
-static void generate_array_literal( FILE* file, SemanticContext* context, Expression* expression )
+// for strings that do not come from octo string literals (which are already
+// escaped in the source)
+static void generate_escaped_string( CodeBuffer* buffer, const char* string )
 {
-    // result:
-    /* ( OctoArray_T ){ */
-    /*     .length = <length>, */
-    /*     .data = ( T[<length>] ){ */
-    /*         <rvalues> */
-    /*     } */
-    /* }; */
-
-    append( file,  "(" );
-    generate_type( file, expression->array_literal.type );
-    append( file, "){\n" );
+    for( const char* c = string; *c != '\0'; c++ )
+    {
+        if( *c == '\\' || *c == '\"' )
+        {
+            append( buffer, "\\" );
+        }
+        code_buffer_append_char( buffer, *c );
+    }
+}
 
-    int length = expression->array_literal.type.array.length;
-    append( file, ".length = %d,\n", length );
-    append( file, ".data = (" );
+// generates the `i`th initialized element of an array literal
+typedef void ( *ElementGenerator )( CodeBuffer* buffer, Generator* generator, void* data, int i );
 
-    Type base_type = *expression->array_literal.type.array.base_type;
-    generate_type( file, base_type );
-    append( file, "[%d]){", length );
+static void generate_array_storage( CodeBuffer* buffer, Generator* generator, Type type, ArrayStorage storage, int count_initialized,
+                                    ElementGenerator generate_element, void* data )
+{
+    Type base_type = *type.array.base_type;
+    int length = type.array.length;
 
-    int count_initialized = expression->array_literal.count_initialized;
-    for( int i = 0; i < count_initialized; i++ )
+    switch( storage )
     {
-        Expression* e = &expression->array_literal.initialized_rvalues[ i ];
-        generate_rvalue( file, context, e );
-        append( file, ", " );
+        case ARRAYSTORAGE_AUTOMATIC:
+        {
+            // result:
+            /* ( OctoArray_T ){ */
+            /*     .length = <length>, */
+            /*     .data = ( T[<length>] ){ */
+            /*         <rvalues> */
+            /*     } */
+            /* }; */
+
+            append( buffer,  "(" );
+            generate_type( buffer, type );
+            append( buffer, "){\n" );
+            append( buffer, ".length = " );
+            append_integer( buffer, length );
+            append( buffer, ",\n" );
+            append( buffer, ".data = (" );
+            generate_type( buffer, base_type );
+            append( buffer, "[" );
+            append_integer( buffer, length );
+            append( buffer, "]){" );
+
+            for( int i = 0; i < count_initialized; i++ )
+            {
+                generate_element( buffer, generator, data, i );
+                append( buffer, ", " );
+            }
+            append( buffer, "}\n" );
+            append( buffer, "}" );
+            break;
+        }
+
+        case ARRAYSTORAGE_STATIC:
+        {
+            // result:
+            /* ({ */
+            /*     static const T octo_array_data[<length>] = { <rvalues> }; */
+            /*     ( OctoArray_T ){ .length = <length>, .data = ( T* )octo_array_data }; */
+            /* }) */
+
+            append( buffer, "({\nstatic const " );
+            generate_type( buffer, base_type );
+            append( buffer, " octo_array_data[" );
+            append_integer( buffer, length );
+            append( buffer, "] = {" );
+
+            for( int i = 0; i < count_initialized; i++ )
+            {
+                generate_element( buffer, generator, data, i );
+                append( buffer, ", " );
+            }
+            append( buffer, "};\n(" );
+            generate_type( buffer, type );
+            append( buffer, "){ .length = " );
+            append_integer( buffer, length );
+            append( buffer, ", .data = (" );
+            generate_type( buffer, base_type );
+            append( buffer, "*)octo_array_data };\n})" );
+            break;
+        }
+
+        case ARRAYSTORAGE_HEAP:
+        case ARRAYSTORAGE_SCOPEDHEAP:
+        {
+            // result:
+            /* ({ */
+            /*     T* octo_array_data = octo_array_allocate( <length>, sizeof( T ) ); */
+            /*     octo_array_data[ 0 ] = <rvalue>; */
+            /*     ... */
+            /*     ( OctoArray_T ){ .length = <length>, .data = octo_array_data }; */
+            /* }) */
+
+            append( buffer, "({\n" );
+            generate_type( buffer, base_type );
+            append( buffer, "* octo_array_data = octo_array_allocate(" );
+            append_integer( buffer, length );
+            append( buffer, ", sizeof(" );
+            generate_type( buffer, base_type );
+            append( buffer, "));\n" );
+
+            for( int i = 0; i < count_initialized; i++ )
+            {
+                append( buffer, "octo_array_data[" );
+                append_integer( buffer, i );
+                append( buffer, "] = " );
+                generate_element( buffer, generator, data, i );
+                append( buffer, ";\n" );
+            }
+            append( buffer, "(" );
+            generate_type( buffer, type );
+            append( buffer, "){ .length = " );
+            append_integer( buffer, length );
+            append( buffer, ", .data = octo_array_data };\n})" );
+            break;
+        }
     }
-    append( file, "}\n" );
-    append( file, "}" );
 }
 
-static void generate_array_subscript( FILE* file, SemanticContext* context, Expression* expression )
+static void generate_rvalue( CodeBuffer* buffer, Generator* generator, Expression* expression );
+static void generate_array_literal_element( CodeBuffer* buffer, Generator* generator, void* data, int i )
+{
+    Expression* expression = data;
+    generate_rvalue( buffer, generator, &expression->array_literal.initialized_rvalues[ i ] );
+}
+
+static void generate_array_literal( CodeBuffer* buffer, Generator* generator, Expression* expression )
+{
+    generate_array_storage( buffer, generator, expression->array_literal.type, expression->array_literal.storage,
+                            expression->array_literal.count_initialized, generate_array_literal_element, expression );
+}
+
+// "path:line:column", for runtime errors
+static void generate_source_location( CodeBuffer* buffer, Generator* generator, Token token )
+{
+    SourceCode* source_code = token.source_code != NULL ? token.source_code : generator->context->source_code;
+    append( buffer, "\"" );
+    generate_escaped_string( buffer, source_code->path );
+    append( buffer, ":" );
+    append_integer( buffer, token.line );
+    append( buffer, ":" );
+    append_integer( buffer, token.column );
+    append( buffer, "\"" );
+}
+
+static void generate_array_subscript( CodeBuffer* buffer, Generator* generator, Expression* expression )
 {
     Type type = expression->array_subscript.element_type;
     Expression* lvalue = expression->array_subscript.lvalue;
@@ -149,59 +326,79 @@ static void generate_array_subscript( FILE* file, SemanticContext* context, Expr
 
     // example: hello[10]
     //          *OctoArray_i32_at(hello, 10)
+    //          *OctoArray_i32_at_checked(hello, 10, "main.octo:3:5")
+
+    bool is_bounds_checked = expression->array_subscript.is_bounds_checked;
+
+    append( buffer, "*OctoArray_" );
+    generate_type( buffer, type );
+    append( buffer, is_bounds_checked ? "_at_checked(" : "_at(" );
+    generate_rvalue( buffer, generator, lvalue );
+    append( buffer, ", " );
+    generate_rvalue( buffer, generator, index_rvalue );
+
+    if( is_bounds_checked )
+    {
+        append( buffer, ", " );
+        generate_source_location( buffer, generator, expression->starting_token );
+    }
 
-    append( file, "*OctoArray_" );
-    generate_type( file, type );
-    append( file, "_at(" );
-    generate_rvalue( file, context, lvalue );
-    append( file, ", " );
-    generate_rvalue( file, context, index_rvalue );
-    append( file, ")" );
+    append( buffer, ")" );
 }
 
-static void generate_member_access( FILE* file, SemanticContext* context, Expression* expression )
+static void generate_member_access( CodeBuffer* buffer, Generator* generator, Expression* expression )
 {
     Expression* lvalue = expression->member_access.lvalue;
-    generate_rvalue( file, context, lvalue );
+    generate_rvalue( buffer, generator, lvalue );
 
     char* member_identifier = expression->member_access.member_identifier_token.as_string;
-    append( file, ".%s", member_identifier );
+    append( buffer, "." );
+    append( buffer, member_identifier );
 }
 
-static void generate_compound_literal( FILE* file, SemanticContext* context, Expression* expression )
+static void generate_compound_literal( CodeBuffer* buffer, Generator* generator, Expression* expression )
 {
     char* type_identifier = expression->compound_literal.type_identifier_token.as_string;
-    append( file, "(%s){\n", type_identifier );
+    append( buffer, "(" );
+    append( buffer, type_identifier );
+    append( buffer, "){\n" );
 
     int initialized_count = expression->compound_literal.initialized_count;
     for( int i = 0; i < initialized_count; i++ )
     {
         char* member_identifier = expression->compound_literal.member_identifier_tokens[ i ].as_string;
-        append( file, ".%s = ", member_identifier );
+        append( buffer, "." );
+        append( buffer, member_identifier );
+        append( buffer, " = " );
 
         Expression initialized_member_rvalue = expression->compound_literal.initialized_member_rvalues[ i ];
-        generate_rvalue( file, context, &initialized_member_rvalue );
+        generate_rvalue( buffer, generator, &initialized_member_rvalue );
 
-        append( file, ",\n" );
+        append( buffer, ",\n" );
     }
 
-    append( file, "}" );
+    append( buffer, "}" );
 }
 
-static void generate_function_call( FILE* file, SemanticContext* context, Expression* expression );
-static void generate_rvalue( FILE* file, SemanticContext* context, Expression* expression )
+static void generate_function_call( CodeBuffer* buffer, Generator* generator, Expression* expression );
+static void generate_rvalue( CodeBuffer* buffer, Generator* generator, Expression* expression )
 {
     switch( expression->kind )
     {
         case EXPRESSIONKIND_INTEGER:
         {
-            append( file, "%lld", expression->integer );
+            // beyond INT64_MAX the literal would not fit any signed C type
+            code_buffer_append_unsigned( buffer, expression->integer );
+            if( expression->integer > INT64_MAX )
+            {
+                append( buffer, "ULL" );
+            }
             break;
         }
 
         case EXPRESSIONKIND_FLOAT:
         {
-            append( file, "%lf", expression->floating );
+            code_buffer_append_float( buffer, expression->floating );
             break;
         }
 
@@ -209,101 +406,105 @@ static void generate_rvalue( FILE* file, SemanticContext* context, Expression* e
         {
             if( expression->identifier.type.kind == TYPEKIND_REFERENCE )
             {
-                append( file, "*" );
+                append( buffer, "*" );
             }
-            append( file, "%s", expression->identifier.as_string );
+            generate_local_identifier( buffer, generator, expression->identifier.as_string );
             break;
         }
 
         case EXPRESSIONKIND_STRING:
         {
-            append( file, "\"%s\"", expression->string );
+            append( buffer, "\"" );
+            append( buffer, expression->string );
+            append( buffer, "\"" );
             break;
         }
 
         case EXPRESSIONKIND_CHARACTER:
         {
-            append( file, "\'%c\'", expression->character );
+            append( buffer, "\'" );
+            code_buffer_append_char( buffer, expression->character );
+            append( buffer, "\'" );
             break;
         }
 
         case EXPRESSIONKIND_BOOLEAN:
         {
-            append( file, "%s", expression->associated_token.as_string );
+            append( buffer, expression->associated_token.as_string );
             break;
         }
 
         case EXPRESSIONKIND_BINARY:
         {
-            append( file, "(" );
-            generate_rvalue( file, context, expression->binary.left );
+            append( buffer, "(" );
+            generate_rvalue( buffer, generator, expression->binary.left );
 
             switch( expression->binary.operation )
             {
-                case BINARYOPERATION_ADD:          append( file, " + " ); break;
-                case BINARYOPERATION_SUBTRACT:     append( file, " - " ); break;
-                case BINARYOPERATION_MULTIPLY:     append( file, " * " ); break;
-                case BINARYOPERATION_DIVIDE:       append( file, " / " ); break;
-                case BINARYOPERATION_MODULO:       append( file, " % " ); break;
-                case BINARYOPERATION_EQUAL:        append( file, " == " ); break;
-                case BINARYOPERATION_GREATER:      append( file, " > " ); break;
-                case BINARYOPERATION_LESS:         append( file, " < " ); break;
-                case BINARYOPERATION_NOTEQUAL:     append( file, " != " ); break;
-                case BINARYOPERATION_GREATEREQUAL: append( file, " >= " ); break;
-                case BINARYOPERATION_LESSEQUAL:    append( file, " <= " ); break;
-                case BINARYOPERATION_AND:          append( file, " && " ); break;
-                case BINARYOPERATION_OR:           append( file, " || " ); break;
+                case BINARYOPERATION_ADD:          append( buffer, " + " ); break;
+                case BINARYOPERATION_SUBTRACT:     append( buffer, " - " ); break;
+                case BINARYOPERATION_MULTIPLY:     append( buffer, " * " ); break;
+                case BINARYOPERATION_DIVIDE:       append( buffer, " / " ); break;
+                case BINARYOPERATION_MODULO:       append( buffer, " % " ); break;
+                case BINARYOPERATION_EQUAL:        append( buffer, " == " ); break;
+                case BINARYOPERATION_GREATER:      append( buffer, " > " ); break;
+                case BINARYOPERATION_LESS:         append( buffer, " < " ); break;
+                case BINARYOPERATION_NOTEQUAL:     append( buffer, " != " ); break;
+                case BINARYOPERATION_GREATEREQUAL: append( buffer, " >= " ); break;
+                case BINARYOPERATION_LESSEQUAL:    append( buffer, " <= " ); break;
+                case BINARYOPERATION_AND:          append( buffer, " && " ); break;
+                case BINARYOPERATION_OR:           append( buffer, " || " ); break;
             }
 
-            generate_rvalue( file, context, expression->binary.right );
-            append( file, ")" );
+            generate_rvalue( buffer, generator, expression->binary.right );
+            append( buffer, ")" );
 
             break;
         }
 
         case EXPRESSIONKIND_UNARY:
         {
-            append( file, "(" );
+            append( buffer, "(" );
             switch( expression->unary.operation )
             {
-                case UNARYOPERATION_NEGATIVE:    append( file, "-" ); break;
-                case UNARYOPERATION_NOT:         append( file, "!" ); break;
-                case UNARYOPERATION_ADDRESSOF:   append( file, "&" ); break;
-                case UNARYOPERATION_DEREFERENCE: append( file, "*" ); break;
+                case UNARYOPERATION_NEGATIVE:    append( buffer, "-" ); break;
+                case UNARYOPERATION_NOT:         append( buffer, "!" ); break;
+                case UNARYOPERATION_ADDRESSOF:   append( buffer, "&" ); break;
+                case UNARYOPERATION_DEREFERENCE: append( buffer, "*" ); break;
             }
-            generate_rvalue( file, context, expression->unary.operand );
-            append( file, ")" );
+            generate_rvalue( buffer, generator, expression->unary.operand );
+            append( buffer, ")" );
 
             break;
         }
 
         case EXPRESSIONKIND_FUNCTIONCALL:
         {
-            generate_function_call( file, context, expression );
+            generate_function_call( buffer, generator, expression );
             break;
         }
 
         case EXPRESSIONKIND_ARRAYLITERAL:
         {
-            generate_array_literal( file, context, expression );
+            generate_array_literal( buffer, generator, expression );
             break;
         }
 
         case EXPRESSIONKIND_ARRAYSUBSCRIPT:
         {
-            generate_array_subscript( file, context, expression );
+            generate_array_subscript( buffer, generator, expression );
             break;
         }
 
         case EXPRESSIONKIND_MEMBERACCESS:
         {
-            generate_member_access( file, context, expression );
+            generate_member_access( buffer, generator, expression );
             break;
         }
 
         case EXPRESSIONKIND_COMPOUNDLITERAL:
         {
-            generate_compound_literal( file, context, expression );
+            generate_compound_literal( buffer, generator, expression );
             break;
         }
 
@@ -315,19 +516,20 @@ static void generate_rvalue( FILE* file, SemanticContext* context, Expression* e
     }
 }
 
-static void generate_variable_declaration( FILE* file, SemanticContext* context, Expression* expression )
+static void generate_variable_declaration( CodeBuffer* buffer, Generator* generator, Expression* expression )
 {
     Type type = expression->variable_declaration.variable_type;
     char* identifier = expression->variable_declaration.identifier_token.as_string;
     Expression* rvalue = expression->variable_declaration.rvalue;
 
-    generate_type( file, type );
-    append( file, " %s", identifier );
+    generate_type( buffer, type );
+    append( buffer, " " );
+    generate_local_identifier( buffer, generator, identifier );
 
     if( rvalue != NULL )
     {
-        append( file, " = " );
-        generate_rvalue( file, context, rvalue );
+        append( buffer, " = " );
+        generate_rvalue( buffer, generator, rvalue );
     }
     else if( type.kind == TYPEKIND_ARRAY && rvalue == NULL )
     {
@@ -340,20 +542,89 @@ static void generate_variable_declaration( FILE* file, SemanticContext* context,
             },
         };
 
-        append( file, " = " );
-        generate_array_literal( file, context, &right_side );
+        append( buffer, " = " );
+        generate_array_literal( buffer, generator, &right_side );
+    }
+
+    append( buffer, ";\n" );
+
+    // frees the array when the variable goes out of scope, the data pointer is
+    // kept on the side because the variable itself can be reassigned
+    if( rvalue != NULL && rvalue->kind == EXPRESSIONKIND_ARRAYLITERAL &&
+        rvalue->array_literal.storage == ARRAYSTORAGE_SCOPEDHEAP )
+    {
+        append( buffer, "__attribute__((cleanup(octo_array_release))) void* octo_array_owner_" );
+        generate_local_identifier( buffer, generator, identifier );
+        append( buffer, " = " );
+        generate_local_identifier( buffer, generator, identifier );
+        append( buffer, ".data;\n" );
+    }
+}
+
+static void generate_function_attributes( CodeBuffer* buffer, Expression* expression, bool is_definition )
+{
+    static const struct
+    {
+        FunctionAttribute flag;
+        char* gcc_attribute;
+    } gcc_attributes[] = {
+        { FUNCTIONATTRIBUTE_INLINE,   "always_inline" },
+        { FUNCTIONATTRIBUTE_NOINLINE, "noinline" },
+        { FUNCTIONATTRIBUTE_HOT,      "hot" },
+        { FUNCTIONATTRIBUTE_COLD,     "cold" },
+        { FUNCTIONATTRIBUTE_FLATTEN,  "flatten" },
+        { FUNCTIONATTRIBUTE_PURE,     "pure" },
+        { FUNCTIONATTRIBUTE_CONST,    "const" },
+        { FUNCTIONATTRIBUTE_FASTMATH, "optimize(\"fast-math\")" },
+        { FUNCTIONATTRIBUTE_NORETURN, "noreturn" },
+    };
+
+    // gcc refuses to always inline a function whose body is in another shard,
+    // there it is left to -flto
+    int attributes = expression->function_declaration.attributes;
+    if( !is_definition && expression->function_declaration.body != NULL )
+    {
+        attributes &= ~FUNCTIONATTRIBUTE_INLINE;
+    }
+
+    if( attributes == 0 )
+    {
+        return;
+    }
+
+    append( buffer, "__attribute__((" );
+    bool is_first = true;
+    for( size_t i = 0; i < sizeof( gcc_attributes ) / sizeof( gcc_attributes[ 0 ] ); i++ )
+    {
+        if( attributes & gcc_attributes[ i ].flag )
+        {
+            append( buffer, is_first ? "" : ", " );
+            append( buffer, gcc_attributes[ i ].gcc_attribute );
+            is_first = false;
+        }
     }
+    append( buffer, ")) " );
 
-    append( file, ";\n" );
+    // with c99 inline semantics an `extern inline` definition can be inlined
+    // and is still emitted for calls from other shards
+    if( ( attributes & FUNCTIONATTRIBUTE_INLINE ) && is_definition )
+    {
+        append( buffer, "extern inline " );
+    }
 }
 
-static void generate_function_declaration( FILE* file, SemanticContext* context,  Expression* expression )
+static void generate_function_signature( CodeBuffer* buffer, Generator* generator, Expression* expression, bool is_definition )
 {
+    generate_function_attributes( buffer, expression, is_definition );
+
     Type return_type = expression->function_declaration.return_type;
-    generate_type( file, return_type );
+    generate_type( buffer, return_type );
 
     char* identifier = expression->function_declaration.identifier_token.as_string;
-    append( file, " %s(", identifier );
+    append( buffer, " " );
+    append( buffer, generator->function_name_prefix );
+    append( buffer, identifier );
+    append( buffer, "(" );
 
     int param_count = expression->function_declaration.param_count;
     bool is_variadic = expression->function_declaration.is_variadic;
@@ -364,8 +635,9 @@ static void generate_function_declaration( FILE* file, SemanticContext* context,
         // append the first param
         Type param_type = param_types[ 0 ];
         char* param_identifier = param_identifiers_tokens[ 0 ].as_string;
-        generate_type( file, param_type );
-        append( file, " %s", param_identifier );
+        generate_type( buffer, param_type );
+        append( buffer, " " );
+        append( buffer, param_identifier );
 
         // the rest of the params
         for( int i = 1; i < param_count; i++ )
@@ -373,315 +645,371 @@ static void generate_function_declaration( FILE* file, SemanticContext* context,
             Type param_type = param_types[ i ];
             char* param_identifier = param_identifiers_tokens[ i ].as_string;
 
-            append( file, ", " );
-            generate_type( file, param_type );
-            append( file, " %s", param_identifier );
+            append( buffer, ", " );
+            generate_type( buffer, param_type );
+            append( buffer, " " );
+            append( buffer, param_identifier );
         }
     }
 
     if( is_variadic )
     {
-        append( file, ", ..." );
+        append( buffer, ", ..." );
     }
 
-    append( file, ")"  );
-
-    Expression* function_body = expression->function_declaration.body;
-    if( function_body != NULL )
-    {
-        append( file, "\n" );
-        generate_compound( file, context, function_body );
-    }
-    else
-    {
-        append( file, ";\n" );
-    }
+    append( buffer, ")"  );
 }
 
-static void generate_return( FILE* file, SemanticContext* context, Expression* expression )
+// values that are generated where they are used instead of being kept in a
+// variable
+static bool is_ir_value_inline( IrInstruction* instruction )
 {
-    append( file, "return " );
-
-    Expression* rvalue = expression->return_expression.rvalue;
-    if ( rvalue != NULL )
+    switch( instruction->opcode )
     {
-        generate_rvalue( file, context, rvalue );
-    }
-
-    append( file, ";\n" );
-}
-
-static void generate_assignment( FILE* file, SemanticContext* context, Expression* expression )
-{
-    generate_rvalue( file, context, expression->assignment.lvalue );
-    append( file, " = ", expression->assignment.lvalue );
-    generate_rvalue( file, context, expression->assignment.rvalue );
-    append( file, ";\n" );
-}
-
-static void generate_function_call( FILE* file, SemanticContext* context, Expression* expression )
-{
-    append( file, "%s(", expression->function_call.identifier_token.as_string );
+        case IROPCODE_CONSTANT:
+        case IROPCODE_STRING:
+        case IROPCODE_PARAM:
+        case IROPCODE_SLOT:
+        case IROPCODE_GLOBAL:
+        {
+            return true;
+        }
 
-    for( size_t i = 0; i < expression->function_call.arg_count; i++ )
-    {
-        Expression arg = expression->function_call.args[ i ];
-        generate_rvalue( file, context, &arg );
-        if( i < expression->function_call.arg_count - 1 )
+        default:
         {
-            append( file, ", " );
+            return false;
         }
     }
-    append( file, ")" );
 }
 
-static void generate_conditional( FILE* file, SemanticContext* context, Expression* expression )
+static void generate_ir_constant( CodeBuffer* buffer, IrInstruction* constant )
 {
-    append( file, "%s (", expression->conditional.is_loop ? "while" : "if" );
-    generate_rvalue( file, context, expression->conditional.condition );
-    append( file, ")\n" );
-    generate_code( file, context, expression->conditional.true_body );
-
-    if( expression->conditional.false_body != NULL )
+    Type type = constant->type;
+    if( type.kind == TYPEKIND_ARRAY )
     {
-        append( file, "else " );
-        generate_code( file, context, expression->conditional.false_body );
+        append( buffer, "((" );
+        generate_type( buffer, type );
+        append( buffer, "){0})" );
+        return;
     }
-}
-
-static void generate_for_loop( FILE* file, SemanticContext* context, Expression* expression )
-{
-    Expression* iterable_rvalue = expression->for_loop.iterable_rvalue;
-    Token iterator_token = expression->for_loop.iterator_token;
-    Type iterator_type = expression->for_loop.iterator_type;
-
-    append( file, "for (u64 octo_index = 0; octo_index < ");
-    generate_rvalue( file, context, iterable_rvalue );
-    append( file, ".length; octo_index++)\n{\n");
-    generate_type( file, iterator_type );
-    append( file, " %s = ", iterator_token.identifier);
-    generate_rvalue( file, context, iterable_rvalue );
-    append( file, ".data + octo_index;\n");
-
-    Expression* body = expression->for_loop.body;
 
-    size_t length = lvec_get_length( body->compound.expressions );
-    for( size_t i = 0; i < length; i++ )
+    // plain literals are already doubles and ints, the others are cast
+    bool is_double = ir_type_is_float( type ) && ir_type_get_bit_count( type ) == 64;
+    bool is_int = ir_get_type_definition( type ).kind == TYPEKIND_INTEGER && ir_type_is_signed( type ) &&
+                  ir_type_get_bit_count( type ) == 32;
+    bool needs_cast = !is_double && !is_int;
+    bool is_negative = ir_type_is_float( type ) ? constant->floating < 0.0
+                                                : ir_type_is_signed( type ) && ( int64_t )constant->integer < 0;
+    append( buffer, needs_cast ? "((" : is_negative ? "(" : "" );
+    if( needs_cast )
     {
-        Expression* e = body->compound.expressions[ i ];
-        generate_code( file, context, e );
+        generate_type( buffer, type );
+        append( buffer, ")" );
     }
 
-    append( file, "}\n");
-}
-
-static void generate_pointer_type_definition( FILE* file, Type base_type )
-{
-    append( file, "#define OctoPtr_" );
-    generate_type( file, base_type );
-    append( file, " ");
-    generate_type( file, base_type );
-    append( file, "*\n");
-}
-
-static void generate_array_type_definition( FILE* file, Type base_type )
-{
-    append( file, "OCTO_DEFINE_ARRAY(" );
-    generate_type( file, base_type );
-    append( file, ")\n" );
-}
-
-static void generate_type_rvalue( FILE* file, Expression* type_rvalue );
-static void generate_compound_definition( FILE* file,  Expression* expression )
-{
-    bool is_struct = expression->compound_definition.is_struct;
-    append( file, "%s {\n", is_struct ? "struct" : "union" );
-
-    /* SymbolTable* member_symbol_table = type_definition.definition.info->compound.member_symbol_table; */
-    int member_count = expression->compound_definition.member_count;
-    for( int i = 0; i < member_count; i++ )
+    if( ir_type_is_float( type ) )
     {
-        char* member_identifier = expression->compound_definition.member_identifier_tokens[ i ].as_string;
-        Type member_type = expression->compound_definition.member_types[ i ];
-        generate_type( file, member_type );
-        append( file, " %s;\n", member_identifier );
+        code_buffer_append_float( buffer, constant->floating );
+    }
+    else if( !ir_type_is_integer( type ) )
+    {
+        append( buffer, "0" ); // null pointer
+    }
+    else if( !ir_type_is_signed( type ) )
+    {
+        code_buffer_append_unsigned( buffer, constant->integer );
+        append( buffer, constant->integer > UINT32_MAX ? "ULL" : "" );
+    }
+    // the literals would overflow before they are negated
+    else if( ( int64_t )constant->integer == INT64_MIN )
+    {
+        append( buffer, "-9223372036854775807LL - 1" );
+    }
+    else if( ( int64_t )constant->integer == INT32_MIN )
+    {
+        append( buffer, "-2147483647 - 1" );
+    }
+    else
+    {
+        int64_t integer = ( int64_t )constant->integer;
+        append_integer( buffer, integer );
+        append( buffer, integer < INT32_MIN || integer > INT32_MAX ? "LL" : "" );
     }
-    append( file, "}" );
+
+    append( buffer, needs_cast || is_negative ? ")" : "" );
 }
 
-static void generate_type_rvalue( FILE* file, Expression* type_rvalue )
+static void generate_ir_value( CodeBuffer* buffer, Generator* generator, IrInstruction* value )
 {
-    switch( type_rvalue->kind )
+    switch( value->opcode )
     {
-        case EXPRESSIONKIND_COMPOUNDDEFINITION:
+        case IROPCODE_CONSTANT:
         {
-            generate_compound_definition( file, type_rvalue );
+            generate_ir_constant( buffer, value );
             break;
         }
 
-        case EXPRESSIONKIND_TYPEIDENTIFIER:
+        case IROPCODE_STRING:
         {
-            append( file, "%s", type_rvalue->type_identifier.token.as_string );
+            append( buffer, "\"" );
+            append( buffer, value->string );
+            append( buffer, "\"" );
             break;
         }
 
-        case EXPRESSIONKIND_POINTERTYPE:
+        case IROPCODE_PARAM:
         {
-            append( file, "OctoPtr_" );
-            generate_type_rvalue( file, type_rvalue->pointer_type.base_type_rvalue );
+            append( buffer, generator->current_function->function_declaration.param_identifiers_tokens[ value->param_index ].as_string );
             break;
         }
 
-        case EXPRESSIONKIND_ARRAYTYPE:
+        case IROPCODE_SLOT:
         {
-            append( file, "OctoArray_" );
-            generate_type_rvalue( file, type_rvalue->array_type.base_type_rvalue );
+            append( buffer, "(&octo_slot_" );
+            append_integer( buffer, value->index );
+            append( buffer, ")" );
+            break;
+        }
+
+        case IROPCODE_GLOBAL:
+        {
+            append( buffer, "(&" );
+            append( buffer, value->identifier );
+            append( buffer, ")" );
             break;
         }
 
         default:
         {
-            UNREACHABLE();
+            append( buffer, "octo_v" );
+            append_integer( buffer, value->index );
+            break;
         }
     }
 }
 
-static void generate_type_declaration( FILE* file, SemanticContext* context, Expression* expression )
+static void generate_ir_element( CodeBuffer* buffer, Generator* generator, void* data, int i )
 {
-    char* type_identifier = expression->type_declaration.identifier_token.as_string;
-    Type type_definition = *symbol_table_lookup( context->symbol_table, type_identifier )->type.type.info;
-
-    append( file, "typedef " );
-
-    Expression* type_rvalue = expression->type_declaration.rvalue;
-    generate_type_rvalue( file, type_rvalue );
-    append( file, " %s;\n", type_definition.named.as_string );
-
-
-    // generate all pointer and array types associated with the declared type
-    Type* pointer_types = type_definition.named.pointer_types;
-    int pointer_types_length = lvec_get_length( pointer_types );
-    for( int j = pointer_types_length - 1; j >= 0; j-- )
-    {
-        Type base_type = pointer_types[ j ];
-        generate_pointer_type_definition( file, base_type );
-    }
+    IrInstruction* array_literal = data;
+    generate_ir_value( buffer, generator, array_literal->operands[ i ] );
+}
 
-    // generate typedefs for arrays
-    Type* array_types = type_definition.named.array_types;
-    int array_types_length = lvec_get_length( array_types );
-    for( int j = array_types_length - 1; j >= 0; j-- )
+static void generate_ir_call( CodeBuffer* buffer, Generator* generator, IrInstruction* call )
+{
+    append( buffer, call->call.function->function_declaration.identifier_token.as_string );
+    append( buffer, "(" );
+    size_t operand_count = lvec_get_length( call->operands );
+    for( size_t i = 0; i < operand_count; i++ )
     {
-        Type base_type = array_types[ j ];
-        generate_array_type_definition( file, base_type );
+        append( buffer, i == 0 ? "" : ", " );
+        generate_ir_value( buffer, generator, call->operands[ i ] );
     }
+    append( buffer, ")" );
 }
 
-void generate_code( FILE* file, SemanticContext* context, Expression* expression )
+// what a value computed by `instruction` is assigned
+static void generate_ir_expression( CodeBuffer* buffer, Generator* generator, IrInstruction* instruction )
 {
-    // temporary
-    static bool first = true;
-    if( first )
+    IrInstruction** operands = instruction->operands;
+    switch( instruction->opcode )
     {
-        first = false;
-
-        append( file, "#include \"octoruntime/types.h\"\n" );
-
-        // generate code for pointers and arrays for primitive types
-        for( int i = 0; i < context->symbol_table.length; i++ )
+        case IROPCODE_COPY:
         {
-            Type type = context->symbol_table.symbols[ i ].type;
-            if( type.kind != TYPEKIND_TYPE )
-            {
-                continue;
-            }
-
-            if( type.type.info->kind != TYPEKIND_NAMED )
-            {
-                continue;
-            }
+            generate_ir_value( buffer, generator, operands[ 0 ] );
+            break;
+        }
 
-            // generate typedefs for pointers
-            Type* pointer_types = type.type.info->named.pointer_types;
-            int pointer_types_length = lvec_get_length( pointer_types );
-            for( int j = pointer_types_length - 1; j >= 0; j-- )
-            {
-                Type base_type = pointer_types[ j ];
-                generate_pointer_type_definition( file, base_type );
-            }
+        case IROPCODE_CONVERT:
+        {
+            append( buffer, "(" );
+            generate_type( buffer, instruction->type );
+            append( buffer, ")" );
+            generate_ir_value( buffer, generator, operands[ 0 ] );
+            break;
+        }
 
-            // generate typedefs for arrays
-            Type* array_types = type.type.info->named.array_types;
-            int array_types_length = lvec_get_length( array_types );
-            for( int j = array_types_length - 1; j >= 0; j-- )
+        case IROPCODE_ADD:
+        case IROPCODE_SUBTRACT:
+        case IROPCODE_MULTIPLY:
+        case IROPCODE_DIVIDE:
+        case IROPCODE_MODULO:
+        case IROPCODE_EQUAL:
+        case IROPCODE_NOTEQUAL:
+        case IROPCODE_LESS:
+        case IROPCODE_LESSEQUAL:
+        case IROPCODE_GREATER:
+        case IROPCODE_GREATEREQUAL:
+        {
+            generate_ir_value( buffer, generator, operands[ 0 ] );
+            switch( instruction->opcode )
             {
-                Type base_type = array_types[ j ];
-                generate_array_type_definition( file, base_type );
+                case IROPCODE_ADD:          append( buffer, " + " ); break;
+                case IROPCODE_SUBTRACT:     append( buffer, " - " ); break;
+                case IROPCODE_MULTIPLY:     append( buffer, " * " ); break;
+                case IROPCODE_DIVIDE:       append( buffer, " / " ); break;
+                case IROPCODE_MODULO:       append( buffer, " % " ); break;
+                case IROPCODE_EQUAL:        append( buffer, " == " ); break;
+                case IROPCODE_NOTEQUAL:     append( buffer, " != " ); break;
+                case IROPCODE_LESS:         append( buffer, " < " ); break;
+                case IROPCODE_LESSEQUAL:    append( buffer, " <= " ); break;
+                case IROPCODE_GREATER:      append( buffer, " > " ); break;
+                case IROPCODE_GREATEREQUAL: append( buffer, " >= " ); break;
+                default:                    UNREACHABLE();
             }
+            generate_ir_value( buffer, generator, operands[ 1 ] );
+            break;
         }
-    }
 
-    switch( expression->kind )
-    {
-        case EXPRESSIONKIND_VARIABLEDECLARATION:
+        case IROPCODE_NEGATE:
         {
-            generate_variable_declaration( file, context, expression );
+            append( buffer, "-" );
+            generate_ir_value( buffer, generator, operands[ 0 ] );
             break;
         }
 
-        case EXPRESSIONKIND_COMPOUND:
+        case IROPCODE_NOT:
         {
-            generate_compound( file, context, expression );
+            append( buffer, "!" );
+            generate_ir_value( buffer, generator, operands[ 0 ] );
             break;
         }
 
-        case EXPRESSIONKIND_FUNCTIONDECLARATION:
+        case IROPCODE_LOAD:
         {
-            generate_function_declaration( file, context, expression );
+            append( buffer, "*" );
+            generate_ir_value( buffer, generator, operands[ 0 ] );
             break;
         }
 
-        case EXPRESSIONKIND_RETURN:
+        case IROPCODE_ARRAYLITERAL:
         {
-            generate_return( file, context, expression );
+            generate_array_storage( buffer, generator, instruction->array_literal.type, instruction->array_literal.storage,
+                                    ( int )lvec_get_length( operands ), generate_ir_element, instruction );
             break;
         }
 
-        case EXPRESSIONKIND_ASSIGNMENT:
+        case IROPCODE_ARRAYLENGTH:
         {
-            generate_assignment( file, context, expression );
+            generate_ir_value( buffer, generator, operands[ 0 ] );
+            append( buffer, ".length" );
             break;
         }
 
-        case EXPRESSIONKIND_FUNCTIONCALL:
+        case IROPCODE_ELEMENT:
         {
-            generate_function_call( file, context, expression );
-            append( file, ";\n" );
+            bool is_bounds_checked = instruction->element.is_bounds_checked;
+            append( buffer, "OctoArray_" );
+            generate_type( buffer, *instruction->type.reference.base_type );
+            append( buffer, is_bounds_checked ? "_at_checked(" : "_at(" );
+            generate_ir_value( buffer, generator, operands[ 0 ] );
+            append( buffer, ", " );
+            generate_ir_value( buffer, generator, operands[ 1 ] );
+            if( is_bounds_checked )
+            {
+                append( buffer, ", " );
+                generate_source_location( buffer, generator, instruction->element.location_token );
+            }
+            append( buffer, ")" );
             break;
         }
 
-        case EXPRESSIONKIND_EXTERN:
+        case IROPCODE_CALL:
         {
-            generate_function_declaration( file, context, expression->extern_expression.function );
+            generate_ir_call( buffer, generator, instruction );
             break;
         }
 
-        case EXPRESSIONKIND_CONDITIONAL:
+        default:
         {
-            generate_conditional( file, context, expression );
-            break;
+            UNREACHABLE();
+        }
+    }
+}
+
+// the phis of `successor` are assigned what they get from `block`, through a
+// second variable so that phis can read each other's previous values
+static void generate_ir_phi_inputs( CodeBuffer* buffer, Generator* generator, IrBlock* block, IrBlock* successor )
+{
+    size_t predecessor_index = 0;
+    while( successor->predecessors[ predecessor_index ] != block )
+    {
+        predecessor_index++;
+    }
+
+    size_t length = lvec_get_length( successor->instructions );
+    for( size_t i = 0; i < length && successor->instructions[ i ]->opcode == IROPCODE_PHI; i++ )
+    {
+        IrInstruction* phi = successor->instructions[ i ];
+        append( buffer, "octo_v" );
+        append_integer( buffer, phi->index );
+        append( buffer, "_in = " );
+        generate_ir_value( buffer, generator, phi->operands[ predecessor_index ] );
+        append( buffer, ";\n" );
+    }
+}
+
+static void generate_ir_goto( CodeBuffer* buffer, IrBlock* target )
+{
+    append( buffer, "goto octo_block_" );
+    append_integer( buffer, target->index );
+    append( buffer, ";\n" );
+}
+
+// the blocks are generated in reverse postorder, a jump to the block that
+// comes next falls through
+static IrBlock* get_next_block( IrFunction* function, size_t i )
+{
+    return i + 1 < lvec_get_length( function->blocks ) ? function->blocks[ i + 1 ] : NULL;
+}
 
+static void generate_ir_terminator( CodeBuffer* buffer, Generator* generator, IrFunction* function, size_t block_index,
+                                    IrInstruction* terminator )
+{
+    IrBlock* block = function->blocks[ block_index ];
+    IrBlock* next_block = get_next_block( function, block_index );
+
+    switch( terminator->opcode )
+    {
+        case IROPCODE_JUMP:
+        {
+            generate_ir_phi_inputs( buffer, generator, block, terminator->targets[ 0 ] );
+            if( terminator->targets[ 0 ] != next_block )
+            {
+                generate_ir_goto( buffer, terminator->targets[ 0 ] );
+            }
+            break;
         }
 
-        case EXPRESSIONKIND_FORLOOP:
+        case IROPCODE_BRANCH:
         {
-            generate_for_loop( file, context, expression );
+            IrBlock* true_target = terminator->targets[ 0 ];
+            IrBlock* false_target = terminator->targets[ 1 ];
+            generate_ir_phi_inputs( buffer, generator, block, true_target );
+            generate_ir_phi_inputs( buffer, generator, block, false_target );
+
+            bool is_negated = true_target == next_block;
+            append( buffer, is_negated ? "if (!" : "if (" );
+            generate_ir_value( buffer, generator, terminator->operands[ 0 ] );
+            append( buffer, ") " );
+            generate_ir_goto( buffer, is_negated ? false_target : true_target );
+            if( !is_negated && false_target != next_block )
+            {
+                generate_ir_goto( buffer, false_target );
+            }
             break;
         }
 
-        case EXPRESSIONKIND_TYPEDECLARATION:
+        case IROPCODE_RETURN:
         {
-            generate_type_declaration( file, context, expression );
+            if( lvec_get_length( terminator->operands ) == 0 )
+            {
+                append( buffer, "return;\n" );
+                break;
+            }
+
+            append( buffer, "return " );
+            generate_ir_value( buffer, generator, terminator->operands[ 0 ] );
+            append( buffer, ";\n" );
             break;
         }
 
@@ -691,3 +1019,1191 @@ void generate_code( FILE* file, SemanticContext* context, Expression* expression
         }
     }
 }
+
+// the blocks that are jumped to, the others do not need a label
+static bool* find_jump_targets( IrFunction* function )
+{
+    bool* is_jump_target = calloc( function->block_count, sizeof( bool ) );
+    if( is_jump_target == NULL ) ALLOC_ERROR();
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrInstruction* terminator = ir_block_get_terminator( function->blocks[ i ] );
+        IrBlock* next_block = get_next_block( function, i );
+        if( terminator->opcode == IROPCODE_JUMP && terminator->targets[ 0 ] != next_block )
+        {
+            is_jump_target[ terminator->targets[ 0 ]->index ] = true;
+        }
+        else if( terminator->opcode == IROPCODE_BRANCH )
+        {
+            bool is_negated = terminator->targets[ 0 ] == next_block;
+            is_jump_target[ terminator->targets[ is_negated ? 1 : 0 ]->index ] = true;
+            if( !is_negated && terminator->targets[ 1 ] != next_block )
+            {
+                is_jump_target[ terminator->targets[ 1 ]->index ] = true;
+            }
+        }
+    }
+
+    return is_jump_target;
+}
+
+// the body of a function that was lowered to the ir. every value that is
+// used gets a variable, declared up front because gotos cannot jump past
+// declarations
+static void generate_ir_function_body( CodeBuffer* buffer, Generator* generator, IrFunction* function )
+{
+    bool* is_used = calloc( function->instruction_count, sizeof( bool ) );
+    if( is_used == NULL ) ALLOC_ERROR();
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            size_t operand_count = lvec_get_length( instruction->operands );
+            for( size_t k = 0; k < operand_count; k++ )
+            {
+                is_used[ instruction->operands[ k ]->index ] = true;
+            }
+        }
+    }
+
+    append( buffer, "\n{\n" );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            if( instruction->opcode == IROPCODE_SLOT )
+            {
+                generate_type( buffer, *instruction->type.reference.base_type );
+                append( buffer, " octo_slot_" );
+                append_integer( buffer, instruction->index );
+                append( buffer, ";\n" );
+                continue;
+            }
+
+            bool is_tail_call = instruction->opcode == IROPCODE_CALL && instruction->call.is_tail_call;
+            if( !is_used[ instruction->index ] || is_ir_value_inline( instruction ) || is_tail_call )
+            {
+                continue;
+            }
+
+            generate_type( buffer, instruction->type );
+            append( buffer, " octo_v" );
+            append_integer( buffer, instruction->index );
+            if( instruction->opcode == IROPCODE_PHI )
+            {
+                append( buffer, ", octo_v" );
+                append_integer( buffer, instruction->index );
+                append( buffer, "_in" );
+            }
+            append( buffer, ";\n" );
+        }
+    }
+
+    bool* is_jump_target = find_jump_targets( function );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        if( is_jump_target[ block->index ] )
+        {
+            append( buffer, "octo_block_" );
+            append_integer( buffer, block->index );
+            append( buffer, ":;\n" );
+        }
+
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            if( is_ir_value_inline( instruction ) )
+            {
+                continue;
+            }
+
+            switch( instruction->opcode )
+            {
+                case IROPCODE_PHI:
+                {
+                    append( buffer, "octo_v" );
+                    append_integer( buffer, instruction->index );
+                    append( buffer, " = octo_v" );
+                    append_integer( buffer, instruction->index );
+                    append( buffer, "_in;\n" );
+                    break;
+                }
+
+                case IROPCODE_STORE:
+                {
+                    append( buffer, "*" );
+                    generate_ir_value( buffer, generator, instruction->operands[ 0 ] );
+                    append( buffer, " = " );
+                    generate_ir_value( buffer, generator, instruction->operands[ 1 ] );
+                    append( buffer, ";\n" );
+                    break;
+                }
+
+                case IROPCODE_JUMP:
+                case IROPCODE_BRANCH:
+                case IROPCODE_RETURN:
+                {
+                    generate_ir_terminator( buffer, generator, function, i, instruction );
+                    break;
+                }
+
+                case IROPCODE_CALL:
+                {
+                    // the return that follows it is part of it
+                    if( instruction->call.is_tail_call )
+                    {
+                        append( buffer, "OCTO_MUSTTAIL return " );
+                        generate_ir_call( buffer, generator, instruction );
+                        append( buffer, ";\n" );
+                        j = length;
+                        break;
+                    }
+
+                    [[ fallthrough ]];
+                }
+
+                default:
+                {
+                    if( is_used[ instruction->index ] )
+                    {
+                        append( buffer, "octo_v" );
+                        append_integer( buffer, instruction->index );
+                        append( buffer, " = " );
+                    }
+                    generate_ir_expression( buffer, generator, instruction );
+                    append( buffer, ";\n" );
+                    break;
+                }
+            }
+        }
+    }
+    append( buffer, "}\n" );
+
+    free( is_jump_target );
+    free( is_used );
+}
+
+static void generate_function_declaration( CodeBuffer* buffer, Generator* generator,  Expression* expression )
+{
+    Expression* function_body = expression->function_declaration.body;
+    generate_function_signature( buffer, generator, expression, function_body != NULL );
+
+    if( function_body != NULL )
+    {
+        Expression* enclosing_function = generator->current_function;
+        generator->current_function = expression;
+        generator->inline_count = 0;
+
+        IrFunction* ir_function = expression->function_declaration.ir;
+        if( ir_function != NULL )
+        {
+            generate_ir_function_body( buffer, generator, ir_function );
+            generator->current_function = enclosing_function;
+            return;
+        }
+
+        // calls of the function to itself in tail position jump back to the start
+        bool has_self_tail_call = expression->function_declaration.has_self_tail_call;
+        append( buffer, has_self_tail_call ? "\n{\nocto_tail_call:;\n" : "\n" );
+        generate_compound( buffer, generator, function_body );
+        if( has_self_tail_call )
+        {
+            append( buffer, "}\n" );
+        }
+
+        generator->current_function = enclosing_function;
+    }
+    else
+    {
+        append( buffer, ";\n" );
+    }
+}
+
+// `return f(a, b);` in f becomes
+//     {
+//         T octo_argument_0 = a;
+//         T octo_argument_1 = b;
+//         param_0 = octo_argument_0;
+//         param_1 = octo_argument_1;
+//         goto octo_tail_call;
+//     }
+// all arguments are evaluated before any parameter changes
+static void generate_self_tail_call( CodeBuffer* buffer, Generator* generator, Expression* function_call )
+{
+    int param_count = generator->current_function->function_declaration.param_count;
+    Type* param_types = generator->current_function->function_declaration.param_types;
+    Token* param_identifiers_tokens = generator->current_function->function_declaration.param_identifiers_tokens;
+
+    append( buffer, "{\n" );
+    for( int i = 0; i < param_count; i++ )
+    {
+        generate_type( buffer, param_types[ i ] );
+        append( buffer, " octo_argument_" );
+        append_integer( buffer, i );
+        append( buffer, " = " );
+        generate_rvalue( buffer, generator, &function_call->function_call.args[ i ] );
+        append( buffer, ";\n" );
+    }
+
+    for( int i = 0; i < param_count; i++ )
+    {
+        append( buffer, param_identifiers_tokens[ i ].as_string );
+        append( buffer, " = octo_argument_" );
+        append_integer( buffer, i );
+        append( buffer, ";\n" );
+    }
+    append( buffer, "goto octo_tail_call;\n}\n" );
+}
+
+static void generate_return( CodeBuffer* buffer, Generator* generator, Expression* expression )
+{
+    Expression* rvalue = expression->return_expression.rvalue;
+
+    // inlined functions store their result and jump past their body
+    if( generator->current_inline_frame != NULL )
+    {
+        append( buffer, "{\n" );
+        if( rvalue != NULL )
+        {
+            append( buffer, "octo_inline_" );
+            append_integer( buffer, generator->current_inline_frame->index );
+            append( buffer, "_result = " );
+            generate_rvalue( buffer, generator, rvalue );
+            append( buffer, ";\n" );
+        }
+        append( buffer, "goto octo_inline_" );
+        append_integer( buffer, generator->current_inline_frame->index );
+        append( buffer, "_end;\n}\n" );
+        generator->current_inline_frame->has_jump_to_end = true;
+        return;
+    }
+
+    switch( expression->return_expression.tail_call )
+    {
+        case TAILCALL_NONE:
+        {
+            break;
+        }
+
+        case TAILCALL_SELF:
+        {
+            generate_self_tail_call( buffer, generator, expression->return_expression.rvalue );
+            return;
+        }
+
+        case TAILCALL_OTHER:
+        {
+            append( buffer, "OCTO_MUSTTAIL " );
+            break;
+        }
+    }
+
+    append( buffer, "return " );
+
+    if ( rvalue != NULL )
+    {
+        generate_rvalue( buffer, generator, rvalue );
+    }
+
+    append( buffer, ";\n" );
+}
+
+static void generate_assignment( CodeBuffer* buffer, Generator* generator, Expression* expression )
+{
+    generate_rvalue( buffer, generator, expression->assignment.lvalue );
+    append( buffer, " = " );
+    generate_rvalue( buffer, generator, expression->assignment.rvalue );
+    append( buffer, ";\n" );
+}
+
+static void collect_local_identifiers( Expression* expression, void* data )
+{
+    char*** local_identifiers = data;
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_VARIABLEDECLARATION:
+        {
+            lvec_append( *local_identifiers, expression->variable_declaration.identifier_token.as_string );
+            break;
+        }
+
+        case EXPRESSIONKIND_FORLOOP:
+        {
+            lvec_append( *local_identifiers, expression->for_loop.iterator_token.as_string );
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    expression_visit_children( expression, collect_local_identifiers, data );
+}
+
+// `f(a, b)` with f inlined becomes
+//     ({
+//         T octo_inline_0_result;
+//         T octo_inline_0_x = a;
+//         T octo_inline_0_y = b;
+//         {
+//             <body of f, with returns stored in octo_inline_0_result>
+//         }
+//         octo_inline_0_end:;
+//         octo_inline_0_result;
+//     })
+// where x and y are the params of f. the arguments are generated in the frame
+// of the caller, and the end label is left out if no return jumps to it
+static void generate_inlined_call( CodeBuffer* buffer, Generator* generator, Expression* function_call )
+{
+    Expression* function = function_call->function_call.inlined_function;
+    int param_count = function->function_declaration.param_count;
+    Type* param_types = function->function_declaration.param_types;
+    Token* param_identifiers_tokens = function->function_declaration.param_identifiers_tokens;
+
+    InlineFrame frame = {
+        .local_identifiers = lvec_new( char* ),
+        .index = generator->inline_count,
+        .enclosing_frame = generator->current_inline_frame,
+    };
+    generator->inline_count++;
+
+    for( int i = 0; i < param_count; i++ )
+    {
+        lvec_append( frame.local_identifiers, param_identifiers_tokens[ i ].as_string );
+    }
+    expression_visit_children( function->function_declaration.body, collect_local_identifiers, &frame.local_identifiers );
+
+    append( buffer, "({\n" );
+
+    Type return_type = function->function_declaration.return_type;
+    bool returns_value = !( return_type.kind == TYPEKIND_NAMED && return_type.named.definition->kind == TYPEKIND_VOID );
+    if( returns_value )
+    {
+        generate_type( buffer, return_type );
+        append( buffer, " octo_inline_" );
+        append_integer( buffer, frame.index );
+        append( buffer, "_result;\n" );
+    }
+
+    for( int i = 0; i < param_count; i++ )
+    {
+        generate_type( buffer, param_types[ i ] );
+        append( buffer, " " );
+        generator->current_inline_frame = &frame;
+        generate_local_identifier( buffer, generator, param_identifiers_tokens[ i ].as_string );
+        generator->current_inline_frame = frame.enclosing_frame;
+        append( buffer, " = " );
+        generate_rvalue( buffer, generator, &function_call->function_call.args[ i ] );
+        append( buffer, ";\n" );
+    }
+
+    generator->current_inline_frame = &frame;
+    generate_compound( buffer, generator, function->function_declaration.body );
+    generator->current_inline_frame = frame.enclosing_frame;
+
+    if( frame.has_jump_to_end )
+    {
+        append( buffer, "octo_inline_" );
+        append_integer( buffer, frame.index );
+        append( buffer, "_end:;\n" );
+    }
+    if( returns_value )
+    {
+        append( buffer, "octo_inline_" );
+        append_integer( buffer, frame.index );
+        append( buffer, "_result;\n" );
+    }
+    append( buffer, "})" );
+
+    lvec_free( frame.local_identifiers );
+}
+
+static void generate_function_call( CodeBuffer* buffer, Generator* generator, Expression* expression )
+{
+    if( expression->function_call.inlined_function != NULL )
+    {
+        generate_inlined_call( buffer, generator, expression );
+        return;
+    }
+
+    append( buffer, expression->function_call.identifier_token.as_string );
+    append( buffer, "(" );
+
+    for( size_t i = 0; i < expression->function_call.arg_count; i++ )
+    {
+        Expression arg = expression->function_call.args[ i ];
+        generate_rvalue( buffer, generator, &arg );
+        if( i < expression->function_call.arg_count - 1 )
+        {
+            append( buffer, ", " );
+        }
+    }
+    append( buffer, ")" );
+}
+
+// has to come right before the loop
+static void generate_loop_pragmas( CodeBuffer* buffer, LoopAttributes loop_attributes )
+{
+    if( loop_attributes.flags & LOOPATTRIBUTE_UNROLL )
+    {
+        append( buffer, "#pragma GCC unroll " );
+        append_integer( buffer, loop_attributes.unroll_count );
+        append( buffer, "\n" );
+    }
+
+    if( loop_attributes.flags & LOOPATTRIBUTE_IVDEP )
+    {
+        append( buffer, "#pragma GCC ivdep\n" );
+    }
+
+    // honored because the driver passes -fopenmp-simd
+    if( loop_attributes.flags & LOOPATTRIBUTE_VECTORIZE )
+    {
+        append( buffer, "#pragma omp simd\n" );
+    }
+
+    // older versions of gcc have no way to keep a single loop from being
+    // vectorized
+    if( loop_attributes.flags & LOOPATTRIBUTE_NOVECTORIZE )
+    {
+        append( buffer, "#if __GNUC__ >= 14\n#pragma GCC novector\n#endif\n" );
+    }
+}
+
+static void generate_conditional( CodeBuffer* buffer, Generator* generator, Expression* expression )
+{
+    if( expression->conditional.is_loop )
+    {
+        generate_loop_pragmas( buffer, expression->conditional.loop_attributes );
+    }
+
+    append( buffer, expression->conditional.is_loop ? "while (" : "if (" );
+    generate_rvalue( buffer, generator, expression->conditional.condition );
+    append( buffer, ")\n" );
+    generate_statement( buffer, generator, expression->conditional.true_body );
+
+    if( expression->conditional.false_body != NULL )
+    {
+        append( buffer, "else " );
+        generate_statement( buffer, generator, expression->conditional.false_body );
+    }
+}
+
+// finds anything in a loop body that could reach memory other than through the
+// loop's iterator
+static void find_other_memory_accesses( Expression* expression, void* data )
+{
+    bool* has_other_accesses = data;
+
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        case EXPRESSIONKIND_FORLOOP:
+        {
+            *has_other_accesses = true;
+            return;
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            if( expression->unary.operation == UNARYOPERATION_DEREFERENCE ||
+                expression->unary.operation == UNARYOPERATION_ADDRESSOF )
+            {
+                *has_other_accesses = true;
+                return;
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    expression_visit_children( expression, find_other_memory_accesses, data );
+}
+
+// the data of the iterable can be `restrict` if the body only reaches it through
+// the iterator, then gcc knows that stores through the iterator do not change
+// anything else the body reads
+static bool can_restrict_iterable( Expression* for_loop )
+{
+    Type element_type = *for_loop->for_loop.iterator_type.reference.base_type;
+    if( element_type.kind == TYPEKIND_POINTER )
+    {
+        return false;
+    }
+
+    bool has_other_accesses = false;
+    expression_visit_children( for_loop->for_loop.body, find_other_memory_accesses, &has_other_accesses );
+    return !has_other_accesses;
+}
+
+static void generate_for_loop( CodeBuffer* buffer, Generator* generator, Expression* expression )
+{
+    Expression* iterable_rvalue = expression->for_loop.iterable_rvalue;
+    Token iterator_token = expression->for_loop.iterator_token;
+    Type iterator_type = expression->for_loop.iterator_type;
+    Type element_type = *iterator_type.reference.base_type;
+
+    // the iterable is only evaluated once, array literals can allocate. its
+    // length and data are kept in locals so that the loop is a plain counted
+    // loop over a pointer
+    Type iterable_type = {
+        .kind = TYPEKIND_ARRAY,
+        .array.base_type = iterator_type.reference.base_type,
+    };
+    append( buffer, "{\n" );
+    generate_type( buffer, iterable_type );
+    append( buffer, " octo_iterable = " );
+    generate_rvalue( buffer, generator, iterable_rvalue );
+    append( buffer, ";\n" );
+
+    append( buffer, "u64 octo_length = octo_iterable.length;\n" );
+    generate_type( buffer, element_type );
+    append( buffer, can_restrict_iterable( expression ) ? "* restrict" : "*" );
+    append( buffer, " octo_data = octo_iterable.data;\n" );
+
+    generate_loop_pragmas( buffer, expression->for_loop.loop_attributes );
+    append( buffer, "for (u64 octo_index = 0; octo_index < octo_length; octo_index++)\n{\n");
+    generate_type( buffer, iterator_type );
+    append( buffer, " " );
+    generate_local_identifier( buffer, generator, iterator_token.identifier );
+    append( buffer, " = octo_data + octo_index;\n" );
+
+    Expression* body = expression->for_loop.body;
+
+    size_t length = lvec_get_length( body->compound.expressions );
+    for( size_t i = 0; i < length; i++ )
+    {
+        Expression* e = body->compound.expressions[ i ];
+        generate_statement( buffer, generator, e );
+    }
+
+    append( buffer, "}\n}\n");
+}
+
+static void generate_pointer_type_definition( CodeBuffer* buffer, Type base_type )
+{
+    append( buffer, "#define OctoPtr_" );
+    generate_type( buffer, base_type );
+    append( buffer, " ");
+    generate_type( buffer, base_type );
+    append( buffer, "*\n");
+}
+
+static void generate_array_type_definition( CodeBuffer* buffer, Type base_type )
+{
+    append( buffer, "OCTO_DEFINE_ARRAY(" );
+    generate_type( buffer, base_type );
+    append( buffer, ")\n" );
+}
+
+typedef struct DerivedType
+{
+    Type base_type;
+    bool is_pointer; // if false, it is an array
+    int depth;
+    char* name; // of the base type
+} DerivedType;
+
+static int get_type_depth( Type type )
+{
+    switch( type.kind )
+    {
+        case TYPEKIND_POINTER:
+        {
+            return 1 + get_type_depth( *type.pointer.base_type );
+        }
+
+        case TYPEKIND_REFERENCE:
+        {
+            return 1 + get_type_depth( *type.reference.base_type );
+        }
+
+        case TYPEKIND_ARRAY:
+        {
+            return 1 + get_type_depth( *type.array.base_type );
+        }
+
+        default:
+        {
+            return 0;
+        }
+    }
+}
+
+// shallower types first because deeper ones are built from them, then by name
+// so that the output does not depend on the order the types were used in
+static int compare_derived_types( const void* a, const void* b )
+{
+    const DerivedType* left = a;
+    const DerivedType* right = b;
+
+    if( left->depth != right->depth )
+    {
+        return left->depth - right->depth;
+    }
+
+    if( left->is_pointer != right->is_pointer )
+    {
+        return left->is_pointer ? -1 : 1;
+    }
+
+    return strcmp( left->name, right->name );
+}
+
+static void add_derived_types( DerivedType** derived_types, Type* base_types, bool is_pointer )
+{
+    size_t length = lvec_get_length( base_types );
+    for( size_t i = 0; i < length; i++ )
+    {
+        CodeBuffer name;
+        code_buffer_initialize( &name );
+        generate_type( &name, base_types[ i ] );
+        code_buffer_append_char( &name, '\0' );
+
+        DerivedType derived_type = {
+            .base_type = base_types[ i ],
+            .is_pointer = is_pointer,
+            .depth = get_type_depth( base_types[ i ] ),
+            .name = name.data,
+        };
+        lvec_append_aggregate( *derived_types, derived_type );
+    }
+}
+
+// generates all pointer and array types built from `named_type`
+static void generate_derived_type_definitions( CodeBuffer* buffer, Type named_type )
+{
+    DerivedType* derived_types = lvec_new( DerivedType );
+    add_derived_types( &derived_types, named_type.named.pointer_types, true );
+    add_derived_types( &derived_types, named_type.named.array_types, false );
+
+    size_t length = lvec_get_length( derived_types );
+    qsort( derived_types, length, sizeof( DerivedType ), compare_derived_types );
+
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( derived_types[ i ].is_pointer )
+        {
+            generate_pointer_type_definition( buffer, derived_types[ i ].base_type );
+        }
+        else
+        {
+            generate_array_type_definition( buffer, derived_types[ i ].base_type );
+        }
+        free( derived_types[ i ].name );
+    }
+
+    lvec_free( derived_types );
+}
+
+static void generate_type_rvalue( CodeBuffer* buffer, Expression* type_rvalue );
+static void generate_compound_definition( CodeBuffer* buffer,  Expression* expression )
+{
+    bool is_struct = expression->compound_definition.is_struct;
+    append( buffer, is_struct ? "struct {\n" : "union {\n" );
+
+    /* SymbolTable* member_symbol_table = type_definition.definition.info->compound.member_symbol_table; */
+    int member_count = expression->compound_definition.member_count;
+    for( int i = 0; i < member_count; i++ )
+    {
+        char* member_identifier = expression->compound_definition.member_identifier_tokens[ i ].as_string;
+        Type member_type = expression->compound_definition.member_types[ i ];
+        generate_type( buffer, member_type );
+        append( buffer, " " );
+        append( buffer, member_identifier );
+        append( buffer, ";\n" );
+    }
+    append( buffer, "}" );
+}
+
+static void generate_type_rvalue( CodeBuffer* buffer, Expression* type_rvalue )
+{
+    switch( type_rvalue->kind )
+    {
+        case EXPRESSIONKIND_COMPOUNDDEFINITION:
+        {
+            generate_compound_definition( buffer, type_rvalue );
+            break;
+        }
+
+        case EXPRESSIONKIND_TYPEIDENTIFIER:
+        {
+            append( buffer, type_rvalue->type_identifier.token.as_string );
+            break;
+        }
+
+        case EXPRESSIONKIND_POINTERTYPE:
+        {
+            append( buffer, "OctoPtr_" );
+            generate_type_rvalue( buffer, type_rvalue->pointer_type.base_type_rvalue );
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYTYPE:
+        {
+            append( buffer, "OctoArray_" );
+            generate_type_rvalue( buffer, type_rvalue->array_type.base_type_rvalue );
+            break;
+        }
+
+        default:
+        {
+            UNREACHABLE();
+        }
+    }
+}
+
+static void generate_type_declaration( CodeBuffer* buffer, Generator* generator, Expression* expression )
+{
+    char* type_identifier = expression->type_declaration.identifier_token.as_string;
+    Type type_definition = *symbol_table_lookup( generator->context->symbol_table, type_identifier )->type.type.info;
+
+    append( buffer, "typedef " );
+
+    Expression* type_rvalue = expression->type_declaration.rvalue;
+    generate_type_rvalue( buffer, type_rvalue );
+    append( buffer, " " );
+    append( buffer, type_definition.named.as_string );
+    append( buffer, ";\n" );
+
+    // generate all pointer and array types associated with the declared type
+    generate_derived_type_definitions( buffer, type_definition );
+}
+
+static bool is_declared_type( Expression* program, char* identifier )
+{
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_TYPEDECLARATION &&
+            strcmp( statement->type_declaration.identifier_token.as_string, identifier ) == 0 )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// the runtime and the pointer and array instantiations of the primitive types
+static void generate_prelude( CodeBuffer* buffer, Generator* generator, Expression* program )
+{
+    append( buffer, "#include \"octoruntime/types.h\"\n" );
+
+    // generate code for pointers and arrays for primitive types
+    for( int i = 0; i < generator->context->symbol_table.length; i++ )
+    {
+        Symbol symbol = generator->context->symbol_table.symbols[ i ];
+        if( symbol.type.kind != TYPEKIND_TYPE )
+        {
+            continue;
+        }
+
+        if( symbol.type.type.info->kind != TYPEKIND_NAMED )
+        {
+            continue;
+        }
+
+        // declared types get theirs after their typedef
+        if( is_declared_type( program, symbol.token.as_string ) )
+        {
+            continue;
+        }
+
+        generate_derived_type_definitions( buffer, *symbol.type.type.info );
+    }
+}
+
+static void generate_statement( CodeBuffer* buffer, Generator* generator, Expression* expression )
+{
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_VARIABLEDECLARATION:
+        {
+            generate_variable_declaration( buffer, generator, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_COMPOUND:
+        {
+            generate_compound( buffer, generator, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_FUNCTIONDECLARATION:
+        {
+            if( expression->function_declaration.is_reachable )
+            {
+                generate_function_declaration( buffer, generator, expression );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_RETURN:
+        {
+            generate_return( buffer, generator, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_ASSIGNMENT:
+        {
+            generate_assignment( buffer, generator, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        {
+            generate_function_call( buffer, generator, expression );
+            append( buffer, ";\n" );
+            break;
+        }
+
+        case EXPRESSIONKIND_EXTERN:
+        {
+            Expression* function = expression->extern_expression.function;
+            if( function->function_declaration.is_reachable )
+            {
+                generate_function_declaration( buffer, generator, function );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_CONDITIONAL:
+        {
+            generate_conditional( buffer, generator, expression );
+            break;
+
+        }
+
+        case EXPRESSIONKIND_FORLOOP:
+        {
+            generate_for_loop( buffer, generator, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_TYPEDECLARATION:
+        {
+            if( expression->type_declaration.is_reachable )
+            {
+                generate_type_declaration( buffer, generator, expression );
+            }
+            break;
+        }
+
+        default:
+        {
+            UNREACHABLE();
+        }
+    }
+}
+
+void generate_program( CodeBuffer* buffer, SemanticContext* context, Expression* program )
+{
+    Generator generator;
+    initialize_generator( &generator, context );
+
+    generate_prelude( buffer, &generator, program );
+    generate_compound( buffer, &generator, program );
+}
+
+int* partition_program( Expression* program, int shard_count )
+{
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    int* shard_indices = calloc( statement_count, sizeof( int ) );
+    if( shard_indices == NULL ) ALLOC_ERROR();
+
+    // a function stays in the same shard no matter what happens to the rest of
+    // the program, so that only the shards of changed functions change
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION )
+        {
+            char* identifier = statement->function_declaration.identifier_token.as_string;
+            shard_indices[ i ] = hash_string( HASH_INITIAL, identifier ) % shard_count;
+        }
+    }
+
+    return shard_indices;
+}
+
+void generate_shard( CodeBuffer* buffer, SemanticContext* context, Expression* program,
+                     int* shard_indices, int shard_index )
+{
+    Generator generator;
+    initialize_generator( &generator, context );
+
+    generate_prelude( buffer, &generator, program );
+
+    // the declarations every shard needs, in program order
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        switch( statement->kind )
+        {
+            case EXPRESSIONKIND_TYPEDECLARATION:
+            case EXPRESSIONKIND_EXTERN:
+            {
+                generate_statement( buffer, &generator, statement );
+                break;
+            }
+
+            case EXPRESSIONKIND_FUNCTIONDECLARATION:
+            {
+                if( statement->function_declaration.is_reachable )
+                {
+                    generate_function_signature( buffer, &generator, statement, false );
+                    append( buffer, ";\n" );
+                }
+                break;
+            }
+
+            case EXPRESSIONKIND_VARIABLEDECLARATION:
+            {
+                append( buffer, "extern " );
+                generate_type( buffer, statement->variable_declaration.variable_type );
+                append( buffer, " " );
+                append( buffer, statement->variable_declaration.identifier_token.as_string );
+                append( buffer, ";\n" );
+                break;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    // the definitions that belong to this shard, globals are defined in the
+    // first one
+    generator.depth++;
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( shard_indices[ i ] != shard_index )
+        {
+            continue;
+        }
+
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION ||
+            statement->kind == EXPRESSIONKIND_VARIABLEDECLARATION )
+        {
+            generate_statement( buffer, &generator, statement );
+        }
+    }
+    generator.depth--;
+}
+
+void generate_run_entry( CodeBuffer* buffer, Expression* program )
+{
+    Expression* main_function = NULL;
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION &&
+            strcmp( statement->function_declaration.identifier_token.as_string, "main" ) == 0 )
+        {
+            main_function = statement;
+        }
+    }
+
+    if( main_function == NULL )
+    {
+        return;
+    }
+
+    append( buffer, "int " RUN_ENTRY_NAME "(int argc, char** argv) {\n" );
+    append( buffer, "(void)argc; (void)argv;\n" );
+
+    // a main with two parameters gets the arguments like a c main would
+    char* arguments = main_function->function_declaration.param_count == 2 ? "argc, (void*)argv" : "";
+    Type return_type = main_function->function_declaration.return_type;
+    bool returns_value = !( return_type.kind == TYPEKIND_NAMED && return_type.named.definition->kind == TYPEKIND_VOID );
+    if( returns_value )
+    {
+        append( buffer, "return (int)main(" );
+        append( buffer, arguments );
+        append( buffer, ");\n" );
+    }
+    else
+    {
+        append( buffer, "main(" );
+        append( buffer, arguments );
+        append( buffer, ");\nreturn 0;\n" );
+    }
+    append( buffer, "}\n" );
+}
+
+static void generate_layout( CodeBuffer* buffer, Generator* generator, Expression* program )
+{
+    append( buffer, "#define OCTO_HOT_RELOAD\n" );
+    generate_prelude( buffer, generator, program );
+
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        switch( statement->kind )
+        {
+            case EXPRESSIONKIND_TYPEDECLARATION:
+            case EXPRESSIONKIND_EXTERN:
+            {
+                generate_statement( buffer, generator, statement );
+                break;
+            }
+
+            case EXPRESSIONKIND_VARIABLEDECLARATION:
+            {
+                append( buffer, "extern " );
+                generate_type( buffer, statement->variable_declaration.variable_type );
+                append( buffer, " " );
+                append( buffer, statement->variable_declaration.identifier_token.as_string );
+                append( buffer, ";\n" );
+                break;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
+    }
+}
+
+void generate_hot_reload_layout( CodeBuffer* buffer, SemanticContext* context, Expression* program )
+{
+    Generator generator;
+    initialize_generator( &generator, context );
+
+    generate_layout( buffer, &generator, program );
+}
+
+bool is_hot_reloadable( Expression* function )
+{
+    return function->kind == EXPRESSIONKIND_FUNCTIONDECLARATION && function->function_declaration.is_reachable &&
+        function->function_declaration.body != NULL && !function->function_declaration.is_variadic;
+}
+
+// `R f(T a, U b) { return ((R (*)(T, U))OCTO_HOT_FUNCTION(slot))(a, b); }`
+static void generate_hot_reload_stub( CodeBuffer* buffer, Generator* generator, Expression* function, int slot )
+{
+    int param_count = function->function_declaration.param_count;
+    Type* param_types = function->function_declaration.param_types;
+    Token* param_identifiers_tokens = function->function_declaration.param_identifiers_tokens;
+    Type return_type = function->function_declaration.return_type;
+    bool returns_value = !( return_type.kind == TYPEKIND_NAMED && return_type.named.definition->kind == TYPEKIND_VOID );
+
+    generate_function_signature( buffer, generator, function, true );
+    append( buffer, " {\n" );
+    append( buffer, returns_value ? "return ((" : "((" );
+    generate_type( buffer, return_type );
+    append( buffer, " (*)(" );
+    for( int i = 0; i < param_count; i++ )
+    {
+        append( buffer, i > 0 ? ", " : "" );
+        generate_type( buffer, param_types[ i ] );
+    }
+    append( buffer, param_count == 0 ? "void))OCTO_HOT_FUNCTION(" : "))OCTO_HOT_FUNCTION(" );
+    append_integer( buffer, slot );
+    append( buffer, "))(" );
+    for( int i = 0; i < param_count; i++ )
+    {
+        append( buffer, i > 0 ? ", " : "" );
+        append( buffer, param_identifiers_tokens[ i ].as_string );
+    }
+    append( buffer, ");\n" );
+    if( function->function_declaration.attributes & FUNCTIONATTRIBUTE_NORETURN )
+    {
+        append( buffer, "__builtin_unreachable();\n" );
+    }
+    append( buffer, "}\n" );
+}
+
+void generate_hot_reload_function( CodeBuffer* signature, CodeBuffer* definition, SemanticContext* context,
+                                   Expression* function )
+{
+    Generator generator;
+    initialize_generator( &generator, context );
+
+    generate_function_signature( signature, &generator, function, false );
+
+    generator.function_name_prefix = HOT_RELOAD_PREFIX;
+    generator.depth++;
+    generate_function_declaration( definition, &generator, function );
+    generator.depth--;
+    generator.function_name_prefix = "";
+}
+
+void generate_hot_reload_unit( CodeBuffer* buffer, SemanticContext* context, Expression* program, int* slots,
+                               bool* is_defined, bool defines_globals )
+{
+    Generator generator;
+    initialize_generator( &generator, context );
+
+    generate_layout( buffer, &generator, program );
+
+    // the stubs go first so that every call in the definitions goes through
+    // the table
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( is_hot_reloadable( statement ) )
+        {
+            generate_hot_reload_stub( buffer, &generator, statement, slots[ i ] );
+        }
+        else if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION && statement->function_declaration.is_reachable &&
+                 statement->function_declaration.body != NULL )
+        {
+            generate_function_signature( buffer, &generator, statement, false );
+            append( buffer, ";\n" );
+        }
+    }
+
+    generator.depth++;
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_VARIABLEDECLARATION && defines_globals )
+        {
+            generate_statement( buffer, &generator, statement );
+        }
+        else if( is_hot_reloadable( statement ) && is_defined[ i ] )
+        {
+            generator.function_name_prefix = HOT_RELOAD_PREFIX;
+            generate_function_declaration( buffer, &generator, statement );
+            generator.function_name_prefix = "";
+        }
+        else if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION && statement->function_declaration.is_reachable &&
+                 !is_hot_reloadable( statement ) )
+        {
+            // variadic functions cannot be called through a stub, every unit
+            // has its own copy instead
+            generate_statement( buffer, &generator, statement );
+        }
+    }
+    generator.depth--;
+}
@@ -0,0 +1,344 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include "arena.h"
+#include "codebuffer.h"
+#include "codegen.h"
+#include "compiler.h"
+#include "debug.h"
+#include "escape.h"
+#include "inline.h"
+#include "ir.h"
+#include "lvec.h"
+#include "module.h"
+#include "purity.h"
+#include "reachability.h"
+#include "tokenizer.h"
+
+#if !defined( _WIN32 )
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+struct CompilerSession
+{
+    Arena* arena; // has the source and everything its compile allocates
+    SourceCode source_code;
+    bool has_source;
+    CodeBuffer diagnostics;
+    CodeBuffer generated_c;
+    SemanticContext context;
+    Expression* program; // null until the source was checked without errors
+};
+
+// tokenizes and parses one file, returns null if it has errors
+static Expression* parse_source( SourceCode* source_code )
+{
+    Token* tokens = tokenize( source_code );
+    if( tokens == NULL )
+    {
+        return NULL;
+    }
+
+    Parser parser;
+    parser_initialize( &parser, tokens, source_code );
+
+    Expression* program = parse( &parser );
+    if( program == NULL )
+    {
+        return NULL;
+    }
+    lvec_free( tokens );
+
+    return program;
+}
+
+#if !defined( _WIN32 )
+// the files the parsing threads share, each takes the next file that is left
+typedef struct ParseQueue
+{
+    SourceCode* sources;
+    Expression** programs;
+    CodeBuffer* diagnostics;
+    int source_count;
+    atomic_int next_source;
+} ParseQueue;
+
+// a started thread allocates in an arena of its own, which the calling thread
+// adopts after joining it, so no two threads link blocks into the same arena
+typedef struct ParseThread
+{
+    ParseQueue* queue;
+    Arena* arena;
+} ParseThread;
+
+static void* parse_queued_sources( void* argument )
+{
+    ParseThread* thread = argument;
+    ParseQueue* queue = thread->queue;
+    Arena* previous_arena = arena_make_current( thread->arena );
+    for( int i = atomic_fetch_add( &queue->next_source, 1 ); i < queue->source_count;
+         i = atomic_fetch_add( &queue->next_source, 1 ) )
+    {
+        code_buffer_initialize( &queue->diagnostics[ i ] );
+        queue->programs[ i ] = parse_source( &queue->sources[ i ] );
+    }
+    arena_make_current( previous_arena );
+
+    return NULL;
+}
+#endif
+
+// parses the files on up to `thread_count` threads. each file reports its
+// errors to a buffer of its own, which are reported in the order of the files
+static void parse_sources( SourceCode* sources, Expression** programs, int source_count, int thread_count )
+{
+    if( thread_count > source_count )
+    {
+        thread_count = source_count;
+    }
+
+#if !defined( _WIN32 )
+    if( thread_count > 1 )
+    {
+        CodeBuffer** diagnostics = malloc( source_count * sizeof( CodeBuffer* ) );
+        CodeBuffer* file_diagnostics = malloc( source_count * sizeof( CodeBuffer ) );
+        pthread_t* threads = malloc( thread_count * sizeof( pthread_t ) );
+        ParseThread* parse_threads = malloc( thread_count * sizeof( ParseThread ) );
+        if( diagnostics == NULL || file_diagnostics == NULL || threads == NULL || parse_threads == NULL )
+        {
+            ALLOC_ERROR();
+        }
+
+        // the buffers are made by the thread that parses the file
+        for( int i = 0; i < source_count; i++ )
+        {
+            diagnostics[ i ] = sources[ i ].diagnostics;
+            sources[ i ].diagnostics = &file_diagnostics[ i ];
+        }
+
+        ParseQueue queue = {
+            .sources = sources,
+            .programs = programs,
+            .diagnostics = file_diagnostics,
+            .source_count = source_count,
+        };
+        atomic_init( &queue.next_source, 0 );
+
+        // without a current arena the blocks of every thread are alone as well
+        Arena* arena = arena_get_current();
+        for( int i = 0; i < thread_count; i++ )
+        {
+            parse_threads[ i ].queue = &queue;
+            parse_threads[ i ].arena = i == 0 || arena == NULL ? arena : arena_new();
+        }
+
+        // the calling thread parses as well, also when no thread can be started
+        int started_count = 0;
+        while( started_count < thread_count - 1 &&
+               pthread_create( &threads[ started_count ], NULL, parse_queued_sources,
+                               &parse_threads[ started_count + 1 ] ) == 0 )
+        {
+            started_count++;
+        }
+        parse_queued_sources( &parse_threads[ 0 ] );
+        for( int i = 0; i < started_count; i++ )
+        {
+            pthread_join( threads[ i ], NULL );
+        }
+
+        for( int i = 1; i < thread_count && arena != NULL; i++ )
+        {
+            arena_adopt( arena, parse_threads[ i ].arena );
+            arena_free( parse_threads[ i ].arena );
+        }
+
+        for( int i = 0; i < source_count; i++ )
+        {
+            sources[ i ].diagnostics = diagnostics[ i ];
+            if( file_diagnostics[ i ].length > 0 )
+            {
+                report_message( &sources[ i ], "%.*s", ( int )file_diagnostics[ i ].length,
+                                file_diagnostics[ i ].data );
+            }
+            code_buffer_free( &file_diagnostics[ i ] );
+        }
+
+        free( parse_threads );
+        free( threads );
+        free( file_diagnostics );
+        free( diagnostics );
+        return;
+    }
+#endif
+
+    for( int i = 0; i < source_count; i++ )
+    {
+        programs[ i ] = parse_source( &sources[ i ] );
+    }
+}
+
+Expression* analyze_program( SourceCode* source_code, SemanticContext* context, FrontEndOptions* options,
+                             BoundsCheckStats* out_bounds_check_stats )
+{
+    return analyze_files( source_code, 1, 1, context, options, out_bounds_check_stats );
+}
+
+Expression* analyze_files( SourceCode* sources, int source_count, int thread_count, SemanticContext* context,
+                           FrontEndOptions* options, BoundsCheckStats* out_bounds_check_stats )
+{
+    semantic_context_initialize( context, &sources[ 0 ] );
+
+    Expression** programs = malloc( source_count * sizeof( Expression* ) );
+    if( programs == NULL ) ALLOC_ERROR();
+    parse_sources( sources, programs, source_count, thread_count );
+
+    // the statements of every file go into the first, in the order of the files
+    Expression* program = programs[ 0 ];
+    for( int i = 0; i < source_count; i++ )
+    {
+        if( programs[ i ] == NULL )
+        {
+            program = NULL;
+        }
+        else if( program != NULL && i > 0 )
+        {
+            size_t statement_count = lvec_get_length( programs[ i ]->compound.expressions );
+            for( size_t j = 0; j < statement_count; j++ )
+            {
+                lvec_append( program->compound.expressions, programs[ i ]->compound.expressions[ j ] );
+            }
+        }
+    }
+    free( programs );
+
+    if( program == NULL )
+    {
+        return NULL;
+    }
+
+    if( !resolve_modules( context, program ) )
+    {
+        return NULL;
+    }
+
+    bool is_valid = check_semantics( context, program );
+    if( !is_valid )
+    {
+        return NULL;
+    }
+
+    if( options->bounds_checks )
+    {
+        *out_bounds_check_stats = annotate_bounds_checks( program );
+    }
+
+    annotate_array_storage( program );
+    annotate_purity( program );
+    if( options->report_purity )
+    {
+        print_purity_report( program );
+    }
+
+    annotate_inline_calls( program, options->inline_threshold );
+    eliminate_dead_code( context, program );
+
+    if( options->use_ir )
+    {
+        ir_lower_program( context, program );
+    }
+
+    return program;
+}
+
+CompilerSession* compiler_session_new( void )
+{
+    // the session outlives any arena of the caller
+    Arena* previous_arena = arena_make_current( NULL );
+    CompilerSession* session = calloc( 1, sizeof( CompilerSession ) );
+    if( session == NULL ) ALLOC_ERROR();
+    session->arena = arena_new();
+    code_buffer_initialize( &session->diagnostics );
+    code_buffer_initialize( &session->generated_c );
+    arena_make_current( previous_arena );
+
+    return session;
+}
+
+void compiler_session_free( CompilerSession* session )
+{
+    arena_free( session->arena );
+    code_buffer_free( &session->diagnostics );
+    code_buffer_free( &session->generated_c );
+    free( session );
+}
+
+void compiler_session_load_source( CompilerSession* session, char* path, const char* code, size_t length )
+{
+    arena_clear( session->arena );
+
+    Arena* previous_arena = arena_make_current( session->arena );
+    source_code_initialize( &session->source_code, path, code, ( int )length );
+    arena_make_current( previous_arena );
+
+    session->source_code.diagnostics = &session->diagnostics;
+    session->has_source = true;
+    session->program = NULL;
+    session->diagnostics.length = 0;
+    session->generated_c.length = 0;
+}
+
+bool compiler_session_check( CompilerSession* session, FrontEndOptions* options )
+{
+    if( !session->has_source )
+    {
+        return false;
+    }
+
+    // the report is printed, and a session prints nothing
+    FrontEndOptions session_options = *options;
+    session_options.report_purity = false;
+
+    BoundsCheckStats bounds_check_stats;
+    Arena* previous_arena = arena_make_current( session->arena );
+    session->program = analyze_program( &session->source_code, &session->context, &session_options,
+                                        &bounds_check_stats );
+    arena_make_current( previous_arena );
+
+    return session->program != NULL;
+}
+
+void compiler_session_generate( CompilerSession* session )
+{
+    if( session->program == NULL )
+    {
+        UNREACHABLE();
+    }
+
+    session->generated_c.length = 0;
+    Arena* previous_arena = arena_make_current( session->arena );
+    generate_program( &session->generated_c, &session->context, session->program );
+    arena_make_current( previous_arena );
+}
+
+// terminates the buffer without counting the terminator
+static const char* get_terminated( CodeBuffer* buffer, size_t* out_length )
+{
+    code_buffer_append_char( buffer, '\0' );
+    buffer->length--;
+
+    if( out_length != NULL )
+    {
+        *out_length = buffer->length;
+    }
+    return buffer->data;
+}
+
+const char* compiler_session_get_diagnostics( CompilerSession* session, size_t* out_length )
+{
+    return get_terminated( &session->diagnostics, out_length );
+}
+
+const char* compiler_session_get_c( CompilerSession* session, size_t* out_length )
+{
+    return get_terminated( &session->generated_c, out_length );
+}
@@ -22,6 +22,8 @@ char* token_kind_to_string[] = {
     [ TOKENKIND_TYPE ]         = "type",
     [ TOKENKIND_STRUCT ]       = "struct",
     [ TOKENKIND_UNION ]        = "union",
+    [ TOKENKIND_MODULE ]       = "module",
+    [ TOKENKIND_IMPORT ]       = "import",
     [ TOKENKIND_AND ]          = "and",
     [ TOKENKIND_OR ]           = "or",
     [ TOKENKIND_INTEGER ]      = "INTEGER",
@@ -57,6 +59,7 @@ char* token_kind_to_string[] = {
     [ TOKENKIND_LEFTBRACKET ]  = "[",
     [ TOKENKIND_RIGHTBRACKET ] = "]",
     [ TOKENKIND_AMPERSAND ]    = "&",
+    [ TOKENKIND_HASH ]         = "#",
     [ TOKENKIND_EOF ]          = "EOF",
 };
 
@@ -81,6 +84,8 @@ char* expression_kind_to_string[] = {
     [ EXPRESSIONKIND_ARRAYSUBSCRIPT ]      = "ARRAY SUBSCRIPT",
     [ EXPRESSIONKIND_FORLOOP ]             = "FOR LOOP",
     [ EXPRESSIONKIND_TYPEDECLARATION ]     = "TYPE DECLARATION",
+    [ EXPRESSIONKIND_MODULE ]              = "MODULE",
+    [ EXPRESSIONKIND_IMPORT ]              = "IMPORT",
     [ EXPRESSIONKIND_MEMBERACCESS ]        = "MEMBER ACCESS",
     [ EXPRESSIONKIND_COMPOUNDLITERAL ]     = "COMPOUND LITERAL",
     [ EXPRESSIONKIND_COMPOUNDDEFINITION ]  = "COMPOUND DEFINITION",
@@ -599,6 +604,13 @@ void expression_print( Expression* expression )
             break;
         }
 
+        case EXPRESSIONKIND_MODULE:
+        case EXPRESSIONKIND_IMPORT:
+        {
+            printf( " %s", expression->module_declaration.identifier_token.as_string );
+            break;
+        }
+
         case EXPRESSIONKIND_COMPOUNDDEFINITION:
         {
             printf( "(%s) {\n",
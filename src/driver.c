@@ -0,0 +1,678 @@
+// for fdopen and gethostname
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "codebuffer.h"
+#include "debug.h"
+#include "driver.h"
+#include "hash.h"
+#include "lvec.h"
+
+#if defined( _WIN32 )
+#include <process.h>
+#define popen _popen
+#define pclose _pclose
+#define S_ISDIR( mode ) ( ( ( mode ) & _S_IFMT ) == _S_IFDIR )
+#define PATH_LIST_SEPARATOR ";"
+#define EXECUTABLE_SUFFIX ".exe"
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define PATH_LIST_SEPARATOR ":"
+#define EXECUTABLE_SUFFIX ""
+
+extern char** environ;
+#endif
+
+#define C_COMPILER "gcc"
+
+// -fopenmp-simd only enables `#pragma omp simd`, no openmp runtime is needed
+static char* compile_flags[] = { "-std=gnu99", "-Wall", "-Wextra", "-fopenmp-simd", NULL };
+
+// the profile flags are passed when linking as well, which -flto needs
+static char* debug_flags[] = { "-O0", "-g", NULL };
+static char* release_flags[] = { "-O2", "-march=native", "-flto", "-DOCTO_ALWAYS_INLINE", NULL };
+static char* size_flags[] = { "-Os", "-flto", "-ffunction-sections", "-fdata-sections", NULL };
+
+#if defined( __APPLE__ )
+static char* size_link_flags[] = { "-Wl,-dead_strip", NULL };
+#else
+static char* size_link_flags[] = { "-Wl,--gc-sections", NULL };
+#endif
+
+// the program's own functions and globals win over those of the process that
+// loads it, which has a `main` as well
+#if defined( __APPLE__ )
+static char* shared_object_flags[] = { "-shared", "-fPIC", NULL };
+#else
+static char* shared_object_flags[] = { "-shared", "-fPIC", "-Wl,-Bsymbolic", NULL };
+#endif
+
+static char* no_flags[] = { NULL };
+
+static BuildProfile build_profile = BUILDPROFILE_DEBUG;
+static char* profile_guidance_flags[] = { NULL, NULL, NULL };
+static char* check_mode_flags[] = { NULL, NULL };
+static char** link_object_paths = NULL;
+static int link_object_count = 0;
+
+static char* concatenate( const char* a, const char* b )
+{
+    size_t a_length = strlen( a );
+    size_t b_length = strlen( b );
+
+    char* result = malloc( a_length + b_length + 1 );
+    if( result == NULL ) ALLOC_ERROR();
+
+    memcpy( result, a, a_length );
+    memcpy( result + a_length, b, b_length + 1 );
+    return result;
+}
+
+static char** get_profile_flags( void )
+{
+    switch( build_profile )
+    {
+        case BUILDPROFILE_DEBUG:   return debug_flags;
+        case BUILDPROFILE_RELEASE: return release_flags;
+        case BUILDPROFILE_SIZE:    return size_flags;
+    }
+
+    UNREACHABLE();
+}
+
+static char** get_link_flags( void )
+{
+    return build_profile == BUILDPROFILE_SIZE ? size_link_flags : no_flags;
+}
+
+void c_compiler_configure( BuildProfile profile, ProfileGuidance guidance, char* profile_directory )
+{
+    build_profile = profile;
+
+    free( profile_guidance_flags[ 0 ] );
+    profile_guidance_flags[ 0 ] = NULL;
+    profile_guidance_flags[ 1 ] = NULL;
+
+    switch( guidance )
+    {
+        case PROFILEGUIDANCE_NONE:
+        {
+            break;
+        }
+
+        case PROFILEGUIDANCE_GENERATE:
+        {
+            profile_guidance_flags[ 0 ] = concatenate( "-fprofile-generate=", profile_directory );
+            break;
+        }
+
+        case PROFILEGUIDANCE_USE:
+        {
+            // functions the training run did not reach are optimized as usual
+            // instead of for size
+            profile_guidance_flags[ 0 ] = concatenate( "-fprofile-use=", profile_directory );
+            profile_guidance_flags[ 1 ] = "-fprofile-partial-training";
+            break;
+        }
+    }
+}
+
+void c_compiler_set_check_mode( CheckMode mode )
+{
+    switch( mode )
+    {
+        case CHECKMODE_DIAGNOSTIC: check_mode_flags[ 0 ] = NULL; break;
+        case CHECKMODE_TRAP:       check_mode_flags[ 0 ] = "-DOCTO_CHECKS=OCTO_CHECKS_TRAP"; break;
+    }
+}
+
+void c_compiler_set_link_objects( char** object_paths, int object_count )
+{
+    link_object_paths = object_paths;
+    link_object_count = object_count;
+}
+
+static char** append_link_objects( char** arguments )
+{
+    for( int i = 0; i < link_object_count; i++ )
+    {
+        lvec_append( arguments, link_object_paths[ i ] );
+    }
+
+    return arguments;
+}
+
+static char** append_flags( char** arguments, char** flags )
+{
+    for( size_t i = 0; flags[ i ] != NULL; i++ )
+    {
+        lvec_append( arguments, flags[ i ] );
+    }
+
+    return arguments;
+}
+
+static char* make_include_flag( char* include_directory )
+{
+    char* include_flag = concatenate( "-I", include_directory );
+    char* include_flag_parent = concatenate( include_flag, "/.." );
+    free( include_flag );
+    return include_flag_parent;
+}
+
+// `input_path` is "-" to read from stdin
+static char** build_arguments( char* input_path, char* output_path, char* include_flag, CCompilerOutput output )
+{
+    char** arguments = lvec_new( char* );
+    lvec_append( arguments, C_COMPILER );
+    if( output == CCOMPILEROUTPUT_OBJECT )
+    {
+        lvec_append( arguments, "-c" );
+    }
+    lvec_append( arguments, "-x" );
+    lvec_append( arguments, "c" );
+    lvec_append( arguments, input_path );
+    lvec_append( arguments, include_flag );
+    lvec_append( arguments, "-o" );
+    lvec_append( arguments, output_path );
+    arguments = append_flags( arguments, compile_flags );
+    arguments = append_flags( arguments, get_profile_flags() );
+    arguments = append_flags( arguments, profile_guidance_flags );
+    arguments = append_flags( arguments, check_mode_flags );
+    if( output == CCOMPILEROUTPUT_SHAREDOBJECT )
+    {
+        arguments = append_flags( arguments, shared_object_flags );
+    }
+    if( output != CCOMPILEROUTPUT_OBJECT )
+    {
+        arguments = append_flags( arguments, get_link_flags() );
+    }
+    if( output == CCOMPILEROUTPUT_EXECUTABLE && link_object_count > 0 )
+    {
+        // the objects are not c
+        lvec_append( arguments, "-x" );
+        lvec_append( arguments, "none" );
+        arguments = append_link_objects( arguments );
+    }
+    lvec_append( arguments, NULL );
+
+    return arguments;
+}
+
+static char** build_link_arguments( char** object_paths, int object_count, char* output_path )
+{
+    char** arguments = lvec_new( char* );
+    lvec_append( arguments, C_COMPILER );
+    lvec_append( arguments, "-o" );
+    lvec_append( arguments, output_path );
+    for( int i = 0; i < object_count; i++ )
+    {
+        lvec_append( arguments, object_paths[ i ] );
+    }
+    arguments = append_link_objects( arguments );
+    arguments = append_flags( arguments, get_profile_flags() );
+    arguments = append_flags( arguments, profile_guidance_flags );
+    arguments = append_flags( arguments, get_link_flags() );
+    lvec_append( arguments, NULL );
+
+    return arguments;
+}
+
+#if defined( _WIN32 )
+
+// windows has no posix_spawn, but it can start a program from an argv array
+static bool run( char** arguments )
+{
+    intptr_t status = _spawnvp( _P_WAIT, arguments[ 0 ], ( const char* const* )arguments );
+    if( status == -1 )
+    {
+        printf( "Could not start the C compiler '%s': %s.\n", arguments[ 0 ], strerror( errno ) );
+        return false;
+    }
+
+    if( status != 0 )
+    {
+        printf( "The C compiler exited with status %d.\n", ( int )status );
+        return false;
+    }
+
+    return true;
+}
+
+// the translation unit is collected in memory and compiled from a temporary
+// file once it is complete
+bool c_compiler_start( CCompiler* compiler, CodeBuffer* buffer, char* output_path,
+                       char* include_directory, CCompilerOutput output )
+{
+    compiler->c_path = concatenate( output_path, ".c" );
+    compiler->include_flag = make_include_flag( include_directory );
+    compiler->arguments = build_arguments( compiler->c_path, output_path, compiler->include_flag, output );
+    compiler->buffer = buffer;
+    compiler->is_successful = false;
+    return true;
+}
+
+void c_compiler_end_input( CCompiler* compiler )
+{
+    FILE* file = fopen( compiler->c_path, "wb" );
+    bool is_written = file != NULL && code_buffer_write( compiler->buffer, file );
+    if( file != NULL )
+    {
+        fclose( file );
+    }
+
+    if( is_written )
+    {
+        compiler->is_successful = run( compiler->arguments );
+    }
+    else
+    {
+        printf( "Could not write '%s'.\n", compiler->c_path );
+    }
+
+    remove( compiler->c_path );
+}
+
+bool c_compiler_wait( CCompiler* compiler )
+{
+    free( compiler->c_path );
+    free( compiler->include_flag );
+    lvec_free( compiler->arguments );
+    return compiler->is_successful;
+}
+
+bool c_compiler_compile_file( char* c_path, char* output_path, char* include_directory )
+{
+    char* include_flag = make_include_flag( include_directory );
+    char** arguments = build_arguments( c_path, output_path, include_flag, CCOMPILEROUTPUT_EXECUTABLE );
+    bool is_successful = run( arguments );
+    free( include_flag );
+    lvec_free( arguments );
+    return is_successful;
+}
+
+bool c_compiler_link( char** object_paths, int object_count, char* output_path )
+{
+    char** arguments = build_link_arguments( object_paths, object_count, output_path );
+    bool is_successful = run( arguments );
+    lvec_free( arguments );
+    return is_successful;
+}
+
+// hashes what the compiler prints to stdout. windows can only read it through a
+// shell, the arguments have no spaces to quote
+static bool hash_compiler_output( char** arguments, uint64_t* out_hash )
+{
+    char command[ 256 ] = "";
+    for( size_t i = 0; arguments[ i ] != NULL; i++ )
+    {
+        strcat( command, i == 0 ? "" : " " );
+        strcat( command, arguments[ i ] );
+    }
+
+    FILE* output = popen( command, "r" );
+    if( output == NULL )
+    {
+        return false;
+    }
+
+    uint64_t hash = HASH_INITIAL;
+    char chunk[ 4096 ];
+    size_t chunk_length;
+    while( ( chunk_length = fread( chunk, 1, sizeof( chunk ), output ) ) > 0 )
+    {
+        hash = hash_bytes( hash, chunk, chunk_length );
+    }
+
+    *out_hash = hash;
+    return pclose( output ) == 0;
+}
+
+#else
+
+// starts the compiler with `input_fd` as its stdin and `output_fd` as its
+// stdout, either is inherited if it is -1
+static bool spawn( char** arguments, int input_fd, int output_fd, pid_t* out_process_id )
+{
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init( &file_actions );
+    if( input_fd != -1 )
+    {
+        posix_spawn_file_actions_adddup2( &file_actions, input_fd, STDIN_FILENO );
+        posix_spawn_file_actions_addclose( &file_actions, input_fd );
+    }
+    if( output_fd != -1 )
+    {
+        posix_spawn_file_actions_adddup2( &file_actions, output_fd, STDOUT_FILENO );
+        posix_spawn_file_actions_addclose( &file_actions, output_fd );
+    }
+
+    int result = posix_spawnp( out_process_id, arguments[ 0 ], &file_actions, NULL, arguments, environ );
+    posix_spawn_file_actions_destroy( &file_actions );
+
+    if( result != 0 )
+    {
+        printf( "Could not start the C compiler '%s': %s.\n", arguments[ 0 ], strerror( result ) );
+        return false;
+    }
+
+    return true;
+}
+
+static bool wait_for( pid_t process_id )
+{
+    int status;
+    while( waitpid( process_id, &status, 0 ) == -1 )
+    {
+        if( errno != EINTR )
+        {
+            printf( "Could not wait for the C compiler: %s.\n", strerror( errno ) );
+            return false;
+        }
+    }
+
+    if( WIFSIGNALED( status ) )
+    {
+        printf( "The C compiler was killed by signal %d.\n", WTERMSIG( status ) );
+        return false;
+    }
+
+    if( !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 )
+    {
+        printf( "The C compiler exited with status %d.\n", WEXITSTATUS( status ) );
+        return false;
+    }
+
+    return true;
+}
+
+static bool run( char** arguments )
+{
+    pid_t process_id;
+    return spawn( arguments, -1, -1, &process_id ) && wait_for( process_id );
+}
+
+bool c_compiler_start( CCompiler* compiler, CodeBuffer* buffer, char* output_path,
+                       char* include_directory, CCompilerOutput output )
+{
+    int pipe_fds[ 2 ];
+    if( pipe( pipe_fds ) == -1 )
+    {
+        printf( "Could not create a pipe to the C compiler: %s.\n", strerror( errno ) );
+        return false;
+    }
+
+    // only the compiler should hold the read end, and only we the write end,
+    // otherwise the compiler never sees the end of its input. this also keeps
+    // compilers started later from inheriting the pipes of earlier ones
+    fcntl( pipe_fds[ 0 ], F_SETFD, FD_CLOEXEC );
+    fcntl( pipe_fds[ 1 ], F_SETFD, FD_CLOEXEC );
+
+    // if the compiler exits early the writes fail instead of killing us
+    signal( SIGPIPE, SIG_IGN );
+
+    compiler->include_flag = make_include_flag( include_directory );
+    compiler->arguments = build_arguments( "-", output_path, compiler->include_flag, output );
+    compiler->buffer = buffer;
+
+    bool is_spawned = spawn( compiler->arguments, pipe_fds[ 0 ], -1, &compiler->process_id );
+    close( pipe_fds[ 0 ] );
+    if( !is_spawned )
+    {
+        close( pipe_fds[ 1 ] );
+        free( compiler->include_flag );
+        lvec_free( compiler->arguments );
+        return false;
+    }
+
+    compiler->input = fdopen( pipe_fds[ 1 ], "wb" );
+    if( compiler->input == NULL ) ALLOC_ERROR();
+
+    code_buffer_set_sink( buffer, compiler->input );
+    return true;
+}
+
+void c_compiler_end_input( CCompiler* compiler )
+{
+    code_buffer_flush( compiler->buffer );
+    code_buffer_set_sink( compiler->buffer, NULL );
+
+    // closing our end is what tells the compiler the translation unit is over
+    fclose( compiler->input );
+}
+
+bool c_compiler_wait( CCompiler* compiler )
+{
+    bool is_successful = wait_for( compiler->process_id );
+    free( compiler->include_flag );
+    lvec_free( compiler->arguments );
+    return is_successful;
+}
+
+bool c_compiler_compile_file( char* c_path, char* output_path, char* include_directory )
+{
+    char* include_flag = make_include_flag( include_directory );
+    char** arguments = build_arguments( c_path, output_path, include_flag, CCOMPILEROUTPUT_EXECUTABLE );
+    bool is_successful = run( arguments );
+    free( include_flag );
+    lvec_free( arguments );
+    return is_successful;
+}
+
+bool c_compiler_link( char** object_paths, int object_count, char* output_path )
+{
+    char** arguments = build_link_arguments( object_paths, object_count, output_path );
+    bool is_successful = run( arguments );
+    lvec_free( arguments );
+    return is_successful;
+}
+
+// hashes what the compiler prints to stdout
+static bool hash_compiler_output( char** arguments, uint64_t* out_hash )
+{
+    int pipe_fds[ 2 ];
+    if( pipe( pipe_fds ) == -1 )
+    {
+        return false;
+    }
+    fcntl( pipe_fds[ 0 ], F_SETFD, FD_CLOEXEC );
+    fcntl( pipe_fds[ 1 ], F_SETFD, FD_CLOEXEC );
+
+    pid_t process_id;
+    bool is_spawned = spawn( arguments, -1, pipe_fds[ 1 ], &process_id );
+    close( pipe_fds[ 1 ] );
+    if( !is_spawned )
+    {
+        close( pipe_fds[ 0 ] );
+        return false;
+    }
+
+    uint64_t hash = HASH_INITIAL;
+    char chunk[ 4096 ];
+    ssize_t chunk_length;
+    while( ( chunk_length = read( pipe_fds[ 0 ], chunk, sizeof( chunk ) ) ) != 0 )
+    {
+        if( chunk_length > 0 )
+        {
+            hash = hash_bytes( hash, chunk, ( size_t )chunk_length );
+        }
+        else if( errno != EINTR )
+        {
+            break;
+        }
+    }
+    close( pipe_fds[ 0 ] );
+
+    *out_hash = hash;
+    return wait_for( process_id ) && chunk_length == 0;
+}
+
+#endif
+
+// the compiler that is started, as it is found on the path. null if it is not
+// there
+static char* find_c_compiler( void )
+{
+    char* path_list = getenv( "PATH" );
+    if( path_list == NULL )
+    {
+        return NULL;
+    }
+
+    char* candidate = malloc( strlen( path_list ) + sizeof( "/" C_COMPILER EXECUTABLE_SUFFIX ) );
+    if( candidate == NULL ) ALLOC_ERROR();
+    for( char* directory = path_list;; )
+    {
+        size_t directory_length = strcspn( directory, PATH_LIST_SEPARATOR );
+        sprintf( candidate, "%.*s/%s", ( int )directory_length, directory, C_COMPILER EXECUTABLE_SUFFIX );
+
+        struct stat candidate_stat;
+        if( directory_length > 0 && stat( candidate, &candidate_stat ) == 0 && !S_ISDIR( candidate_stat.st_mode ) )
+        {
+            return candidate;
+        }
+
+        if( directory[ directory_length ] == '\0' )
+        {
+            break;
+        }
+        directory += directory_length + 1;
+    }
+
+    free( candidate );
+    return NULL;
+}
+
+// the cache directory might be shared by machines that resolve -march=native
+// differently
+static uint64_t hash_machine_name( uint64_t hash )
+{
+#if defined( _WIN32 )
+    char* name = getenv( "COMPUTERNAME" );
+    return hash_string( hash, name != NULL ? name : "" );
+#else
+    char name[ 256 ] = { 0 };
+    gethostname( name, sizeof( name ) - 1 );
+    return hash_string( hash, name );
+#endif
+}
+
+// where the native target of this compiler on this machine is kept, null if
+// the compiler is not found
+static char* get_native_target_path( char* cache_directory )
+{
+    char* compiler_path = find_c_compiler();
+    if( compiler_path == NULL )
+    {
+        return NULL;
+    }
+
+    uint64_t key = hash_string( HASH_INITIAL, compiler_path );
+    key = object_cache_hash_file_stamp( key, compiler_path );
+    key = hash_machine_name( key );
+    free( compiler_path );
+
+    char* path = malloc( strlen( cache_directory ) + 32 );
+    if( path == NULL ) ALLOC_ERROR();
+    sprintf( path, "%s/%016llx.target", cache_directory, ( unsigned long long )key );
+    return path;
+}
+
+static bool read_native_target( char* path, uint64_t* out_hash )
+{
+    FILE* file = fopen( path, "rb" );
+    if( file == NULL )
+    {
+        return false;
+    }
+
+    unsigned long long hash;
+    bool is_read = fscanf( file, "%16llx", &hash ) == 1;
+    fclose( file );
+
+    *out_hash = hash;
+    return is_read;
+}
+
+static void write_native_target( char* path, uint64_t hash )
+{
+    char* temporary_path = object_cache_get_temporary_path( path );
+    FILE* file = fopen( temporary_path, "wb" );
+    if( file != NULL )
+    {
+        bool is_written = fprintf( file, "%016llx\n", ( unsigned long long )hash ) > 0;
+        if( fclose( file ) == 0 && is_written )
+        {
+            object_cache_insert( temporary_path, path );
+        }
+        else
+        {
+            remove( temporary_path );
+        }
+    }
+
+    free( temporary_path );
+}
+
+// -march=native means something else on every machine, so objects built with
+// it are only reused where the compiler resolves it to the same target. asking
+// the compiler takes as long as a small compile, so the answer is kept in the
+// cache directory for as long as the compiler does not change
+static uint64_t hash_native_target( uint64_t hash, char* cache_directory )
+{
+    char* target_path = cache_directory != NULL ? get_native_target_path( cache_directory ) : NULL;
+    uint64_t target_hash;
+    bool is_target_known = target_path != NULL && read_native_target( target_path, &target_hash );
+    if( !is_target_known )
+    {
+        char* arguments[] = { C_COMPILER, "-march=native", "-Q", "--help=target", NULL };
+        is_target_known = hash_compiler_output( arguments, &target_hash );
+        if( is_target_known && target_path != NULL )
+        {
+            write_native_target( target_path, target_hash );
+        }
+    }
+    free( target_path );
+
+    if( !is_target_known )
+    {
+        return hash;
+    }
+
+    return hash_bytes( hash, &target_hash, sizeof( target_hash ) );
+}
+
+uint64_t c_compiler_hash_configuration( uint64_t hash, char* cache_directory )
+{
+    hash = hash_string( hash, C_COMPILER );
+    char** flag_lists[] = { compile_flags, get_profile_flags(), profile_guidance_flags, check_mode_flags };
+    for( size_t i = 0; i < sizeof( flag_lists ) / sizeof( flag_lists[ 0 ] ); i++ )
+    {
+        for( size_t j = 0; flag_lists[ i ][ j ] != NULL; j++ )
+        {
+            hash = hash_string( hash, flag_lists[ i ][ j ] );
+            if( strcmp( flag_lists[ i ][ j ], "-march=native" ) == 0 )
+            {
+                hash = hash_native_target( hash, cache_directory );
+            }
+        }
+    }
+
+    return hash;
+}
+
+bool c_compiler_finish( CCompiler* compiler )
+{
+    c_compiler_end_input( compiler );
+    return c_compiler_wait( compiler );
+}
@@ -0,0 +1,467 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codebuffer.h"
+#include "debug.h"
+#include "elf.h"
+#include "hash.h"
+#include "lvec.h"
+
+// the sections of the file, in the order of their headers. the first four
+// are the ones of ElfSection
+typedef enum FileSection
+{
+    FILESECTION_NULL,
+    FILESECTION_TEXT,
+    FILESECTION_RODATA,
+    FILESECTION_DATA,
+    FILESECTION_BSS,
+    FILESECTION_NOTEGNUSTACK, // marks the stack as not executable
+    FILESECTION_RELATEXT,
+    FILESECTION_RELADATA,
+    FILESECTION_SYMTAB,
+    FILESECTION_STRTAB,
+    FILESECTION_SHSTRTAB,
+    FILESECTION_COUNT,
+} FileSection;
+
+static const char* file_section_names[] = {
+    [ FILESECTION_NULL ]         = "",
+    [ FILESECTION_TEXT ]         = ".text",
+    [ FILESECTION_RODATA ]       = ".rodata",
+    [ FILESECTION_DATA ]         = ".data",
+    [ FILESECTION_BSS ]          = ".bss",
+    [ FILESECTION_NOTEGNUSTACK ] = ".note.GNU-stack",
+    [ FILESECTION_RELATEXT ]     = ".rela.text",
+    [ FILESECTION_RELADATA ]     = ".rela.data",
+    [ FILESECTION_SYMTAB ]       = ".symtab",
+    [ FILESECTION_STRTAB ]       = ".strtab",
+    [ FILESECTION_SHSTRTAB ]     = ".shstrtab",
+};
+
+#define ELF_HEADER_SIZE     64
+#define SECTION_HEADER_SIZE 64
+#define SYMBOL_SIZE         24
+#define RELOCATION_SIZE     24
+
+#define SECTIONTYPE_PROGBITS 1
+#define SECTIONTYPE_SYMTAB   2
+#define SECTIONTYPE_STRTAB   3
+#define SECTIONTYPE_RELA     4
+#define SECTIONTYPE_NOBITS   8
+
+#define SECTIONFLAG_WRITE     0x1
+#define SECTIONFLAG_ALLOC     0x2
+#define SECTIONFLAG_EXECINSTR 0x4
+#define SECTIONFLAG_INFOLINK  0x40
+
+void elf_object_initialize( ElfObject* object )
+{
+    for( int i = 0; i < ELFSECTION_COUNT; i++ )
+    {
+        code_buffer_initialize( &object->sections[ i ] );
+    }
+    object->bss_size = 0;
+
+    object->symbols = lvec_new( ElfSymbol );
+    object->relocations = lvec_new( ElfRelocation );
+    for( int i = 0; i < ELFSECTION_COUNT; i++ )
+    {
+        ElfSymbol symbol = {
+            .name = "",
+            .section = ( ElfSection )i,
+            .kind = ELFSYMBOLKIND_SECTION,
+        };
+        lvec_append_aggregate( object->symbols, symbol );
+    }
+
+    object->bucket_count = 1024;
+    object->symbol_buckets = malloc( object->bucket_count * sizeof( int ) );
+    if( object->symbol_buckets == NULL ) ALLOC_ERROR();
+    memset( object->symbol_buckets, -1, object->bucket_count * sizeof( int ) );
+}
+
+void elf_object_free( ElfObject* object )
+{
+    for( int i = 0; i < ELFSECTION_COUNT; i++ )
+    {
+        code_buffer_free( &object->sections[ i ] );
+    }
+    lvec_free( object->symbols );
+    lvec_free( object->relocations );
+    free( object->symbol_buckets );
+}
+
+static size_t find_bucket( int* buckets, size_t bucket_count, ElfSymbol* symbols, char* name )
+{
+    size_t mask = bucket_count - 1;
+    size_t bucket = hash_string( HASH_INITIAL, name ) & mask;
+    while( buckets[ bucket ] != -1 && strcmp( symbols[ buckets[ bucket ] ].name, name ) != 0 )
+    {
+        bucket = ( bucket + 1 ) & mask;
+    }
+
+    return bucket;
+}
+
+// keeps the buckets at most half full
+static void grow_buckets( ElfObject* object )
+{
+    size_t bucket_count = object->bucket_count * 2;
+    int* buckets = malloc( bucket_count * sizeof( int ) );
+    if( buckets == NULL ) ALLOC_ERROR();
+    memset( buckets, -1, bucket_count * sizeof( int ) );
+
+    for( size_t i = 0; i < object->bucket_count; i++ )
+    {
+        int symbol = object->symbol_buckets[ i ];
+        if( symbol != -1 )
+        {
+            buckets[ find_bucket( buckets, bucket_count, object->symbols, object->symbols[ symbol ].name ) ] = symbol;
+        }
+    }
+
+    free( object->symbol_buckets );
+    object->symbol_buckets = buckets;
+    object->bucket_count = bucket_count;
+}
+
+int elf_object_get_symbol( ElfObject* object, char* name )
+{
+    size_t bucket = find_bucket( object->symbol_buckets, object->bucket_count, object->symbols, name );
+    if( object->symbol_buckets[ bucket ] != -1 )
+    {
+        return object->symbol_buckets[ bucket ];
+    }
+
+    int index = ( int )lvec_get_length( object->symbols );
+    ElfSymbol symbol = {
+        .name = name,
+        .section = ELFSECTION_UNDEFINED,
+        .kind = ELFSYMBOLKIND_NONE,
+        .is_global = true,
+    };
+    lvec_append_aggregate( object->symbols, symbol );
+    object->symbol_buckets[ bucket ] = index;
+
+    size_t named_count = lvec_get_length( object->symbols ) - ELFSECTION_COUNT;
+    if( named_count * 2 > object->bucket_count )
+    {
+        grow_buckets( object );
+    }
+
+    return index;
+}
+
+void elf_object_define_symbol( ElfObject* object, int symbol, ElfSection section, ElfSymbolKind kind,
+                               uint64_t value, uint64_t size, bool is_global )
+{
+    ElfSymbol* defined = &object->symbols[ symbol ];
+    defined->section = section;
+    defined->kind = kind;
+    defined->value = value;
+    defined->size = size;
+    defined->is_global = is_global;
+}
+
+int elf_object_get_section_symbol( ElfSection section )
+{
+    return ( int )section;
+}
+
+void elf_object_add_relocation( ElfObject* object, ElfSection section, uint64_t offset, int symbol,
+                                ElfRelocationKind kind, int64_t addend )
+{
+    ElfRelocation relocation = {
+        .section = section,
+        .offset = offset,
+        .symbol = symbol,
+        .kind = kind,
+        .addend = addend,
+    };
+    lvec_append_aggregate( object->relocations, relocation );
+}
+
+uint64_t elf_object_align( ElfObject* object, ElfSection section, uint64_t alignment )
+{
+    if( section == ELFSECTION_BSS )
+    {
+        object->bss_size = ( object->bss_size + alignment - 1 ) & ~( alignment - 1 );
+        return object->bss_size;
+    }
+
+    CodeBuffer* buffer = &object->sections[ section ];
+    while( buffer->length % alignment != 0 )
+    {
+        code_buffer_append_char( buffer, 0 );
+    }
+
+    return buffer->length;
+}
+
+// elf is little-endian on x86-64, written byte by byte so that the host does
+// not matter
+static void append_u8( CodeBuffer* buffer, uint8_t value )
+{
+    code_buffer_append_char( buffer, ( char )value );
+}
+
+static void append_u16( CodeBuffer* buffer, uint16_t value )
+{
+    append_u8( buffer, value & 0xff );
+    append_u8( buffer, value >> 8 );
+}
+
+static void append_u32( CodeBuffer* buffer, uint32_t value )
+{
+    append_u16( buffer, value & 0xffff );
+    append_u16( buffer, value >> 16 );
+}
+
+static void append_u64( CodeBuffer* buffer, uint64_t value )
+{
+    append_u32( buffer, value & 0xffffffff );
+    append_u32( buffer, value >> 32 );
+}
+
+typedef struct SectionHeader
+{
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t alignment;
+    uint64_t entry_size;
+} SectionHeader;
+
+static uint32_t append_name( CodeBuffer* string_table, const char* name )
+{
+    uint32_t offset = ( uint32_t )string_table->length;
+    code_buffer_append_data( string_table, name, strlen( name ) + 1 );
+    return offset;
+}
+
+static uint16_t get_section_index( ElfSection section )
+{
+    return section == ELFSECTION_UNDEFINED ? 0 : ( uint16_t )( section + FILESECTION_TEXT );
+}
+
+static void append_relocations( CodeBuffer* buffer, ElfObject* object, ElfSection section, int* symbol_indices )
+{
+    static const uint32_t relocation_types[] = {
+        [ ELFRELOCATIONKIND_ABSOLUTE64 ] = 1,
+        [ ELFRELOCATIONKIND_PC32 ]       = 2,
+        [ ELFRELOCATIONKIND_PLT32 ]      = 4,
+    };
+
+    size_t relocation_count = lvec_get_length( object->relocations );
+    for( size_t i = 0; i < relocation_count; i++ )
+    {
+        ElfRelocation relocation = object->relocations[ i ];
+        if( relocation.section != section )
+        {
+            continue;
+        }
+
+        uint64_t symbol = ( uint64_t )symbol_indices[ relocation.symbol ];
+        append_u64( buffer, relocation.offset );
+        append_u64( buffer, symbol << 32 | relocation_types[ relocation.kind ] );
+        append_u64( buffer, ( uint64_t )relocation.addend );
+    }
+}
+
+bool elf_object_write( ElfObject* object, char* path )
+{
+    // the local symbols have to come before the global ones
+    size_t symbol_count = lvec_get_length( object->symbols );
+    int* symbol_indices = malloc( symbol_count * sizeof( int ) );
+    if( symbol_indices == NULL ) ALLOC_ERROR();
+
+    CodeBuffer string_table;
+    code_buffer_initialize( &string_table );
+    append_u8( &string_table, 0 );
+
+    CodeBuffer symbol_table;
+    code_buffer_initialize( &symbol_table );
+    for( int i = 0; i < SYMBOL_SIZE; i++ )
+    {
+        append_u8( &symbol_table, 0 );
+    }
+
+    int next_index = 1;
+    int first_global_index = 0;
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        bool is_global_pass = pass == 1;
+        if( is_global_pass )
+        {
+            first_global_index = next_index;
+        }
+
+        for( size_t i = 0; i < symbol_count; i++ )
+        {
+            ElfSymbol symbol = object->symbols[ i ];
+            if( symbol.is_global != is_global_pass )
+            {
+                continue;
+            }
+
+            symbol_indices[ i ] = next_index++;
+            uint8_t binding = symbol.is_global ? 1 : 0;
+            uint8_t type = symbol.kind == ELFSYMBOLKIND_OBJECT   ? 1
+                         : symbol.kind == ELFSYMBOLKIND_FUNCTION ? 2
+                         : symbol.kind == ELFSYMBOLKIND_SECTION  ? 3
+                         : 0;
+            append_u32( &symbol_table, symbol.name[ 0 ] == '\0' ? 0 : append_name( &string_table, symbol.name ) );
+            append_u8( &symbol_table, ( uint8_t )( binding << 4 | type ) );
+            append_u8( &symbol_table, 0 );
+            append_u16( &symbol_table, get_section_index( symbol.section ) );
+            append_u64( &symbol_table, symbol.value );
+            append_u64( &symbol_table, symbol.size );
+        }
+    }
+
+    CodeBuffer text_relocations;
+    CodeBuffer data_relocations;
+    code_buffer_initialize( &text_relocations );
+    code_buffer_initialize( &data_relocations );
+    append_relocations( &text_relocations, object, ELFSECTION_TEXT, symbol_indices );
+    append_relocations( &data_relocations, object, ELFSECTION_DATA, symbol_indices );
+
+    CodeBuffer section_names;
+    code_buffer_initialize( &section_names );
+    uint32_t name_offsets[ FILESECTION_COUNT ];
+    for( int i = 0; i < FILESECTION_COUNT; i++ )
+    {
+        name_offsets[ i ] = i == 0 ? 0 : append_name( &section_names, file_section_names[ i ] );
+        if( i == 0 )
+        {
+            append_u8( &section_names, 0 );
+        }
+    }
+
+    // the contents of the sections follow the elf header, in the order of the
+    // section headers, and the section headers come last
+    CodeBuffer* contents[ FILESECTION_COUNT ] = {
+        [ FILESECTION_TEXT ]     = &object->sections[ ELFSECTION_TEXT ],
+        [ FILESECTION_RODATA ]   = &object->sections[ ELFSECTION_RODATA ],
+        [ FILESECTION_DATA ]     = &object->sections[ ELFSECTION_DATA ],
+        [ FILESECTION_RELATEXT ] = &text_relocations,
+        [ FILESECTION_RELADATA ] = &data_relocations,
+        [ FILESECTION_SYMTAB ]   = &symbol_table,
+        [ FILESECTION_STRTAB ]   = &string_table,
+        [ FILESECTION_SHSTRTAB ] = &section_names,
+    };
+
+    SectionHeader headers[ FILESECTION_COUNT ] = {
+        [ FILESECTION_TEXT ]         = { .type = SECTIONTYPE_PROGBITS, .flags = SECTIONFLAG_ALLOC | SECTIONFLAG_EXECINSTR, .alignment = 16 },
+        [ FILESECTION_RODATA ]       = { .type = SECTIONTYPE_PROGBITS, .flags = SECTIONFLAG_ALLOC, .alignment = 16 },
+        [ FILESECTION_DATA ]         = { .type = SECTIONTYPE_PROGBITS, .flags = SECTIONFLAG_ALLOC | SECTIONFLAG_WRITE, .alignment = 16 },
+        [ FILESECTION_BSS ]          = { .type = SECTIONTYPE_NOBITS, .flags = SECTIONFLAG_ALLOC | SECTIONFLAG_WRITE, .alignment = 16,
+                                         .size = object->bss_size },
+        [ FILESECTION_NOTEGNUSTACK ] = { .type = SECTIONTYPE_PROGBITS, .alignment = 1 },
+        [ FILESECTION_RELATEXT ]     = { .type = SECTIONTYPE_RELA, .flags = SECTIONFLAG_INFOLINK, .alignment = 8,
+                                         .link = FILESECTION_SYMTAB, .info = FILESECTION_TEXT, .entry_size = RELOCATION_SIZE },
+        [ FILESECTION_RELADATA ]     = { .type = SECTIONTYPE_RELA, .flags = SECTIONFLAG_INFOLINK, .alignment = 8,
+                                         .link = FILESECTION_SYMTAB, .info = FILESECTION_DATA, .entry_size = RELOCATION_SIZE },
+        [ FILESECTION_SYMTAB ]       = { .type = SECTIONTYPE_SYMTAB, .alignment = 8, .link = FILESECTION_STRTAB,
+                                         .info = ( uint32_t )first_global_index, .entry_size = SYMBOL_SIZE },
+        [ FILESECTION_STRTAB ]       = { .type = SECTIONTYPE_STRTAB, .alignment = 1 },
+        [ FILESECTION_SHSTRTAB ]     = { .type = SECTIONTYPE_STRTAB, .alignment = 1 },
+    };
+
+    CodeBuffer file;
+    code_buffer_initialize( &file );
+    for( int i = 0; i < ELF_HEADER_SIZE; i++ )
+    {
+        append_u8( &file, 0 );
+    }
+
+    for( int i = 1; i < FILESECTION_COUNT; i++ )
+    {
+        headers[ i ].name = name_offsets[ i ];
+        if( contents[ i ] == NULL )
+        {
+            headers[ i ].offset = file.length;
+            continue;
+        }
+
+        while( file.length % headers[ i ].alignment != 0 )
+        {
+            append_u8( &file, 0 );
+        }
+        headers[ i ].offset = file.length;
+        headers[ i ].size = contents[ i ]->length;
+        code_buffer_append_data( &file, contents[ i ]->data, contents[ i ]->length );
+    }
+
+    while( file.length % 8 != 0 )
+    {
+        append_u8( &file, 0 );
+    }
+    uint64_t section_headers_offset = file.length;
+    for( int i = 0; i < FILESECTION_COUNT; i++ )
+    {
+        SectionHeader header = headers[ i ];
+        append_u32( &file, header.name );
+        append_u32( &file, header.type );
+        append_u64( &file, header.flags );
+        append_u64( &file, 0 ); // address
+        append_u64( &file, header.offset );
+        append_u64( &file, header.size );
+        append_u32( &file, header.link );
+        append_u32( &file, header.info );
+        append_u64( &file, header.alignment );
+        append_u64( &file, header.entry_size );
+    }
+
+    // the elf header, now that the offset of the section headers is known
+    CodeBuffer elf_header;
+    code_buffer_initialize( &elf_header );
+    code_buffer_append_data( &elf_header, "\x7f" "ELF", 4 );
+    append_u8( &elf_header, 2 ); // 64-bit
+    append_u8( &elf_header, 1 ); // little-endian
+    append_u8( &elf_header, 1 ); // version
+    for( int i = 0; i < 9; i++ )
+    {
+        append_u8( &elf_header, 0 ); // system v abi and padding
+    }
+    append_u16( &elf_header, 1 );  // relocatable
+    append_u16( &elf_header, 62 ); // x86-64
+    append_u32( &elf_header, 1 );  // version
+    append_u64( &elf_header, 0 );  // entry
+    append_u64( &elf_header, 0 );  // program headers
+    append_u64( &elf_header, section_headers_offset );
+    append_u32( &elf_header, 0 );  // flags
+    append_u16( &elf_header, ELF_HEADER_SIZE );
+    append_u16( &elf_header, 0 );  // program header size
+    append_u16( &elf_header, 0 );  // program header count
+    append_u16( &elf_header, SECTION_HEADER_SIZE );
+    append_u16( &elf_header, FILESECTION_COUNT );
+    append_u16( &elf_header, FILESECTION_SHSTRTAB );
+    memcpy( file.data, elf_header.data, ELF_HEADER_SIZE );
+
+    FILE* object_file = fopen( path, "wb" );
+    bool is_written = object_file != NULL && code_buffer_write( &file, object_file );
+    if( object_file != NULL && fclose( object_file ) != 0 )
+    {
+        is_written = false;
+    }
+    if( !is_written )
+    {
+        printf( "Could not write '%s'.\n", path );
+    }
+
+    code_buffer_free( &elf_header );
+    code_buffer_free( &file );
+    code_buffer_free( &section_names );
+    code_buffer_free( &data_relocations );
+    code_buffer_free( &text_relocations );
+    code_buffer_free( &symbol_table );
+    code_buffer_free( &string_table );
+    free( symbol_indices );
+    return is_written;
+}
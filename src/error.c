@@ -1,8 +1,9 @@
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "error.h"
 #include "debug.h"
-#include "globals.h"
 #include "lvec.h"
 #include "parser.h"
 #include "type.h"
@@ -56,19 +57,15 @@ static char* file_to_string( const char* filename, int* length )
     return buffer;
 }
 
-SourceCode source_code_load( char* path )
+// finds where every line of the code starts
+static void index_lines( SourceCode* source_code )
 {
-    SourceCode source_code;
-    source_code.code = file_to_string( path, &source_code.length );
-    source_code.path = malloc( strlen( path ) + 1 );
-    strcpy( source_code.path, path );
-
     int line_count = 1;
 
     // get newline count
-    for( int i = 0; source_code.code[ i ] != '\0'; i++ )
+    for( int i = 0; source_code->code[ i ] != '\0'; i++ )
     {
-        char c = source_code.code[ i ];
+        char c = source_code->code[ i ];
 
         if( c == '\n' )
         {
@@ -76,22 +73,88 @@ SourceCode source_code_load( char* path )
         }
     }
 
-    source_code.line_indexes = malloc( sizeof( int* ) * line_count );
-    source_code.line_indexes[0] = 0;
+    source_code->line_indexes = malloc( sizeof( int* ) * line_count );
+    source_code->line_indexes[0] = 0;
 
     // get newline count
-    for( int i = 0, j = 1; source_code.code[ i ] != '\0'; i++ )
+    for( int i = 0, j = 1; source_code->code[ i ] != '\0'; i++ )
     {
-        char c = source_code.code[ i ];
+        char c = source_code->code[ i ];
 
         if( c == '\n' )
         {
-            source_code.line_indexes[ j ] = i;
+            source_code->line_indexes[ j ] = i;
             j++;
         }
     }
+}
 
-    return source_code;
+bool source_code_load( SourceCode* source_code, char* path )
+{
+    source_code->code = file_to_string( path, &source_code->length );
+    if( source_code->code == NULL )
+    {
+        return false;
+    }
+
+    source_code->path = malloc( strlen( path ) + 1 );
+    strcpy( source_code->path, path );
+    source_code->diagnostics = NULL;
+    index_lines( source_code );
+
+    return true;
+}
+
+void source_code_initialize( SourceCode* source_code, char* path, const char* code, int length )
+{
+    source_code->code = malloc( length + 1 );
+    source_code->path = malloc( strlen( path ) + 1 );
+    if( source_code->code == NULL || source_code->path == NULL ) ALLOC_ERROR();
+    memcpy( source_code->code, code, length );
+    source_code->code[ length ] = '\0';
+    source_code->length = length;
+    strcpy( source_code->path, path );
+    source_code->diagnostics = NULL;
+    index_lines( source_code );
+}
+
+void source_code_free( SourceCode* source_code )
+{
+    free( source_code->code );
+    free( source_code->path );
+    free( source_code->line_indexes );
+}
+
+void report_message( SourceCode* source_code, const char* format, ... )
+{
+    va_list arguments;
+    va_start( arguments, format );
+    if( source_code->diagnostics == NULL )
+    {
+        vprintf( format, arguments );
+        va_end( arguments );
+        return;
+    }
+
+    char message[ 1024 ];
+    va_list length_arguments;
+    va_copy( length_arguments, arguments );
+    int length = vsnprintf( message, sizeof( message ), format, length_arguments );
+    va_end( length_arguments );
+
+    if( length >= ( int )sizeof( message ) )
+    {
+        char* long_message = malloc( length + 1 );
+        if( long_message == NULL ) ALLOC_ERROR();
+        vsnprintf( long_message, length + 1, format, arguments );
+        code_buffer_append_data( source_code->diagnostics, long_message, length );
+        free( long_message );
+    }
+    else if( length > 0 )
+    {
+        code_buffer_append_data( source_code->diagnostics, message, length );
+    }
+    va_end( arguments );
 }
 
 void source_code_print_line( SourceCode source_code, int line )
@@ -102,14 +165,14 @@ void source_code_print_line( SourceCode source_code, int line )
         line_start_index++;
     }
 
-    printf( "%5d | ", line );
+    report_message( &source_code, "%5d | ", line );
     for( int i = line_start_index; source_code.code[ i ] != '\n' && source_code.code[ i ] != '\0'; i++ )
     {
-        printf( "%c", source_code.code[ i ] );
+        report_message( &source_code, "%c", source_code.code[ i ] );
     }
 }
 
-void print_type( Type type )
+static void print_type( SourceCode* source_code, Type type )
 {
     switch( type.kind )
     {
@@ -119,13 +182,13 @@ void print_type( Type type )
         case TYPEKIND_CHARACTER:
         case TYPEKIND_BOOLEAN:
         {
-            printf( "%s", type_kind_to_string[ type.kind ] );
+            report_message( source_code, "%s", type_kind_to_string[ type.kind ] );
             break;
         }
 
         case TYPEKIND_INTEGER:
         {
-            printf( "%c%zu",
+            report_message( source_code, "%c%zu",
                     type.integer.is_signed ? 'i' : 'u',
                     type.integer.bit_count );
             break;
@@ -133,82 +196,82 @@ void print_type( Type type )
 
         case TYPEKIND_FLOAT:
         {
-            printf( "f%zu", type.integer.bit_count );
+            report_message( source_code, "f%zu", type.integer.bit_count );
             break;
         }
 
         case TYPEKIND_FUNCTION:
         {
-            printf( "func(" );
+            report_message( source_code, "func(" );
             size_t param_count = lvec_get_length( type.function.param_types );
             for( size_t i = 0; i < param_count; i++ )
             {
                 Type param_type = type.function.param_types[ i ];
-                print_type( param_type );
+                print_type( source_code, param_type );
                 if( i < param_count - 1 )
                 {
-                    printf( ", " );
+                    report_message( source_code, ", " );
                 }
             }
-            printf( ") -> " );
-            print_type( *type.function.return_type );
+            report_message( source_code, ") -> " );
+            print_type( source_code, *type.function.return_type );
             break;
         }
 
         case TYPEKIND_COMPOUND:
         {
-            printf( "%s { ", type.compound.is_struct ? "struct" : "union" );
+            report_message( source_code, "%s { ", type.compound.is_struct ? "struct" : "union" );
             int member_count = type.compound.member_symbol_table->length;
             for( int i = 0; i < member_count; i++ )
             {
                 char* member_identifier = type.compound.member_symbol_table->symbols[ i ].token.as_string;
                 Type member_type = type.compound.member_symbol_table->symbols[ i ].type;
 
-                printf( "%s: ", member_identifier );
-                print_type( member_type );
-                printf( "; " );
+                report_message( source_code, "%s: ", member_identifier );
+                print_type( source_code, member_type );
+                report_message( source_code, "; " );
             }
-            printf( "}" );
+            report_message( source_code, "}" );
             break;
         }
 
         case TYPEKIND_POINTER:
         {
-            printf( "&" );
-            print_type( *type.pointer.base_type );
+            report_message( source_code, "&" );
+            print_type( source_code, *type.pointer.base_type );
             break;
         }
 
         case TYPEKIND_REFERENCE:
         {
             // printf( "REFERENCE " );
-            print_type( *type.reference.base_type );
+            print_type( source_code, *type.reference.base_type );
             break;
         }
 
         case TYPEKIND_ARRAY:
         {
-            printf( "[%d]", type.array.length );
-            print_type( *type.array.base_type );
+            report_message( source_code, "[%d]", type.array.length );
+            print_type( source_code, *type.array.base_type );
             break;
         }
 
         case TYPEKIND_TYPE:
         {
-            printf( "type" );
+            report_message( source_code, "type" );
             break;
         }
 
         case TYPEKIND_NAMED:
         {
-            printf("%s", type.named.as_string);
+            report_message( source_code, "%s", type.named.as_string);
             // print_type( type.named.as_string );
             break;
         }
 
         case TYPEKIND_NUMERICLITERAL:
         {
-            printf( "%s literal",
+            report_message( source_code, "%s literal",
                     type.literal.kind == TYPEKIND_INTEGER
                     ? "integer"
                     : "floating point" );
@@ -303,49 +366,55 @@ void print_type( Type type )
     /* } */
 }
 
-void report_error( Error error )
+void report_error( SourceCode* source_code, Error error )
 {
+    // in a program of several files, the error is in the file of the token
     Token offending_token = error.offending_token;
-    printf( "%s:%d:%d: error: ", g_source_code.path, offending_token.line, offending_token.column );
+    if( offending_token.source_code != NULL )
+    {
+        source_code = offending_token.source_code;
+    }
+
+    report_message( source_code, "%s:%d:%d: error: ", source_code->path, offending_token.line, offending_token.column );
     switch( error.kind )
     {
         case ERRORKIND_INVALIDSYMBOL:
         {
-            printf( "invalid symbol\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "invalid symbol\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_MISMATCHEDPARENS:
         {
-            printf( "mismatched parentheses\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "mismatched parentheses\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_UNCLOSEDPARENS:
         {
-            printf( "unclosed parentheses\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "unclosed parentheses\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_UNEXPECTEDSYMBOL:
         {
-            printf( "unexpected symbol\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "unexpected symbol\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_MULTICHARACTERCHARACTER:
         {
-            printf( "use double quotes for strings\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "use double quotes for strings\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
@@ -353,16 +422,19 @@ void report_error( Error error )
         {
             Token original_declaration_token = error.symbol_redeclaration.original_declaration_token;
 
-            printf( "redeclaration of '%s'\n", original_declaration_token.identifier );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "redeclaration of '%s'\n", original_declaration_token.identifier );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
 
             if( original_declaration_token.line != 0 )
             {
-                printf( "%s:%d:%d: note: ", g_source_code.path, original_declaration_token.line, original_declaration_token.column );
-                printf( "previous declaration here\n");
-                source_code_print_line( g_source_code, original_declaration_token.line );
-                printf( "\n        %*c\n", original_declaration_token.column, '^' );
+                SourceCode* original_source_code = original_declaration_token.source_code != NULL
+                    ? original_declaration_token.source_code
+                    : source_code;
+                report_message( source_code, "%s:%d:%d: note: ", original_source_code->path, original_declaration_token.line, original_declaration_token.column );
+                report_message( source_code, "previous declaration here\n");
+                source_code_print_line( *original_source_code, original_declaration_token.line );
+                report_message( source_code, "\n        %*c\n", original_declaration_token.column, '^' );
             }
 
             break;
@@ -374,14 +446,14 @@ void report_error( Error error )
             Type right_type = error.invalid_binary_operation.right_type;
 
             // example: invalid operation for types 'int' and 'bool'
-            printf( "invalid operation for types \'" );
-            print_type( left_type );
-            printf( "\' and \'");
-            print_type( right_type );
-            printf( "\'\n");
+            report_message( source_code, "invalid operation for types \'" );
+            print_type( source_code, left_type );
+            report_message( source_code, "\' and \'");
+            print_type( source_code, right_type );
+            report_message( source_code, "\'\n");
 
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
@@ -390,12 +462,12 @@ void report_error( Error error )
             Type operand_type = error.invalid_binary_operation.left_type;
 
             // example: invalid operation for type '&int'
-            printf( "invalid operation for type \'" );
-            print_type( operand_type );
-            printf( "\'\n");
+            report_message( source_code, "invalid operation for type \'" );
+            print_type( source_code, operand_type );
+            report_message( source_code, "\'\n");
 
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
@@ -404,14 +476,14 @@ void report_error( Error error )
             Type expected_type = error.type_mismatch.expected;
             Type found_type = error.type_mismatch.found;
 
-            printf( "expected type \'" );
-            print_type( expected_type );
-            printf( "\', found type \'" );
-            print_type( found_type );
-            printf( "\'\n" );
+            report_message( source_code, "expected type \'" );
+            print_type( source_code, expected_type );
+            report_message( source_code, "\', found type \'" );
+            print_type( source_code, found_type );
+            report_message( source_code, "\'\n" );
 
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
@@ -420,22 +492,22 @@ void report_error( Error error )
             Type to_type = error.invalid_implicit_cast.to;
             Type from_type = error.invalid_implicit_cast.from;
 
-            printf( "implicit cast from \'" );
-            print_type( from_type );
-            printf( "\' to \'" );
-            print_type( to_type );
-            printf( "\' is not allowed\n" );
+            report_message( source_code, "implicit cast from \'" );
+            print_type( source_code, from_type );
+            report_message( source_code, "\' to \'" );
+            print_type( source_code, to_type );
+            report_message( source_code, "\' is not allowed\n" );
 
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_UNDECLAREDSYMBOL:
         {
-            printf( "undeclared symbol\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "undeclared symbol\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
@@ -444,192 +516,270 @@ void report_error( Error error )
             int expected_arg_count = error.too_many_arguments.expected;
             int found_arg_count = error.too_many_arguments.found;
 
-            printf( "expected %d arguments, found %d\n",
+            report_message( source_code, "expected %d arguments, found %d\n",
                     expected_arg_count,
                     found_arg_count );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_INVALIDADDRESSOF:
         {
-            printf( "cannot get address of expression\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "cannot get address of expression\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_MISSINGFUNCTIONBODY:
         {
-            printf( "non-extern function must have a body\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "non-extern function must have a body\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_EXTERNWITHBODY:
         {
-            printf( "extern function must not have a body\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "extern function must not have a body\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_WHILEWITHELSE:
         {
-            printf( "\'while\'-loops cannot have an 'else' block\n");
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "\'while\'-loops cannot have an 'else' block\n");
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_VOIDVARIABLE:
         {
-            printf( "variable cannot be of type \'void\'\n");
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "variable cannot be of type \'void\'\n");
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_INVALIDLVALUE:
         {
-            printf( "invalid lvalue\n");
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "invalid lvalue\n");
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_ZEROLENGTHARRAY:
         {
-            printf( "zero-length arrays are not allowed\n");
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "zero-length arrays are not allowed\n");
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKING_ARRAYLENGTHMISMATCH:
         {
-            printf( "expected size %d, found %d\n",
+            report_message( source_code, "expected size %d, found %d\n",
                     error.array_length_mismatch.expected,
                     error.array_length_mismatch.found);
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_CANNOTINFERARRAYLENGTH:
         {
-            printf( "cannot infer array length\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "cannot infer array length\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_INVALIDARRAYSUBSCRIPT:
         {
-            printf( "array subscript must be an integer\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "array subscript must be an integer\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_NOTANITERATOR:
         {
-            printf( "not an iterator\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "not an iterator\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_NOTANARRAY:
         {
-            printf( "cannot subscript non-array symbol\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "cannot subscript non-array symbol\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_MISSINGMEMBER:
         {
             Type parent_type = error.missing_member.parent_type;
-            printf( "no member \'%s\' in type \'", offending_token.as_string );
-            print_type( parent_type );
-            printf( "\'\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "no member \'%s\' in type \'", offending_token.as_string );
+            print_type( source_code, parent_type );
+            report_message( source_code, "\'\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_INVALIDCOMPOUNDLITERAL:
         {
-            printf( "compound literal syntax cannot be used with non-compound type\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "compound literal syntax cannot be used with non-compound type\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_CANNOTUSETYPEASVALUE:
         {
-            printf( "cannot use type as value\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "cannot use type as value\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_NOTATYPE:
         {
-            printf( "cannot use non-type name here\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "cannot use non-type name here\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_NOTCOMPOUND:
         {
-            printf( "not a compound type\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "not a compound type\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_INVALIDANONYMOUSTYPE:
         {
-            printf( "anonymous type not allowed here\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "anonymous type not allowed here\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_UNINITIALIZEDMEMBER:
         {
-            printf( "all struct members must be initialized\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "all struct members must be initialized\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_MULTIPLEMEMBERINITIALIZEDUNION:
         {
-            printf( "union initializer must only have one member initialized\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "union initializer must only have one member initialized\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_NONPOINTERDEREFERENCE:
         {
-            printf( "cannot dereference non-pointer type\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "cannot dereference non-pointer type\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
         case ERRORKIND_VOIDPOINTERDEREFERENCE:
         {
-            printf( "cannot dereference void pointer\n" );
-            source_code_print_line( g_source_code, offending_token.line );
-            printf( "\n        %*c\n", offending_token.column, '^' );
+            report_message( source_code, "cannot dereference void pointer\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
+            break;
+        }
+
+        case ERRORKIND_UNKNOWNATTRIBUTE:
+        {
+            report_message( source_code, "unknown attribute '%s'\n", offending_token.as_string );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
+            break;
+        }
+
+        case ERRORKIND_INVALIDATTRIBUTE:
+        {
+            report_message( source_code, "attribute '%s' %s\n", offending_token.as_string, error.invalid_attribute.reason );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
+            break;
+        }
+
+        case ERRORKIND_CONFLICTINGATTRIBUTES:
+        {
+            Token other_attribute_token = error.conflicting_attributes.other_attribute_token;
+
+            report_message( source_code, "attribute '%s' conflicts with '%s'\n", offending_token.as_string, other_attribute_token.as_string );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
+            break;
+        }
+
+        case ERRORKIND_MODULENOTATTOPLEVEL:
+        {
+            report_message( source_code, "'%s' must be at the top level\n", offending_token.as_string );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
+            break;
+        }
+
+        case ERRORKIND_MULTIPLEMODULES:
+        {
+            Token other_module_token = error.multiple_modules.other_module_token;
+
+            report_message( source_code, "the program is already module '%s'\n", other_module_token.as_string );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
+            break;
+        }
+
+        case ERRORKIND_MISSINGMODULE:
+        {
+            report_message( source_code, "no interface of module '%s' at '%s', the module has to be built first\n",
+                            offending_token.as_string, error.missing_module.interface_path );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
+            break;
+        }
+
+        case ERRORKIND_INVALIDMODULEINTERFACE:
+        {
+            report_message( source_code, "'%s' is not an interface of module '%s' that this octo can read, the module has to be built again\n",
+                            error.missing_module.interface_path, offending_token.as_string );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
+            break;
+        }
+
+        case ERRORKIND_SELFIMPORT:
+        {
+            report_message( source_code, "module '%s' cannot import itself\n", offending_token.as_string );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
+            break;
+        }
+
+        case ERRORKIND_MAININMODULE:
+        {
+            report_message( source_code, "a module cannot declare 'main', the program that imports it does\n" );
+            source_code_print_line( *source_code, offending_token.line );
+            report_message( source_code, "\n        %*c\n", offending_token.column, '^' );
             break;
         }
 
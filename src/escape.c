@@ -0,0 +1,840 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "escape.h"
+#include "lvec.h"
+#include "parser.h"
+#include "symboltable.h"
+
+// array literals larger than this are not put on the stack
+#define MAX_AUTOMATIC_ARRAY_SIZE 4096 // bytes
+
+// what can happen to the data of an array after it flows somewhere
+typedef struct ArrayUse
+{
+    bool escapes; // the data can be reached after the function returns
+    bool is_mutated; // the data can be written to
+} ArrayUse;
+
+typedef struct VariableUse
+{
+    char* identifier;
+    bool is_reference; // for-loop iterators write into the array they iterate
+    ArrayUse use;
+} VariableUse;
+
+typedef struct LiteralUse
+{
+    Expression* literal;
+    Expression* variable_declaration; // the declaration the literal initializes, if any
+    ArrayUse use;
+} LiteralUse;
+
+// the local at `variable_index` holds the value of `literal`, an array or
+// compound literal, so whatever happens to the local happens to the arrays the
+// literal creates
+typedef struct LiteralBinding
+{
+    int variable_index;
+    Expression* literal;
+} LiteralBinding;
+
+// `alias` holds the same array as `target`, e.g. after `let alias = target`
+typedef struct AliasEdge
+{
+    int alias_index;
+    int target_index;
+} AliasEdge;
+
+// how a function treats the arrays passed to it
+typedef struct FunctionSummary
+{
+    char* identifier;
+    Expression* declaration;
+    bool is_extern;
+    ArrayUse* param_uses; // one per param
+} FunctionSummary;
+
+typedef struct EscapeAnalysis
+{
+    FunctionSummary* summaries;
+    VariableUse* variables;
+    LiteralUse* literals;
+    AliasEdge* alias_edges;
+    LiteralBinding* literal_bindings;
+    bool has_changed; // set when a use grows, for the propagation to know when to stop
+} EscapeAnalysis;
+
+static const ArrayUse unknown_use = { .escapes = true, .is_mutated = true };
+
+// returns true if `to` changed
+static bool merge_use( ArrayUse* to, ArrayUse from )
+{
+    ArrayUse before = *to;
+    to->escapes |= from.escapes;
+    to->is_mutated |= from.is_mutated;
+    return to->escapes != before.escapes || to->is_mutated != before.is_mutated;
+}
+
+// variables in sibling scopes can share a name, the one declared last is the
+// one that is in scope
+static int find_variable_index( EscapeAnalysis* analysis, char* identifier )
+{
+    for( int i = ( int )lvec_get_length( analysis->variables ) - 1; i >= 0; i-- )
+    {
+        if( strcmp( analysis->variables[ i ].identifier, identifier ) == 0 )
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static VariableUse* find_variable( EscapeAnalysis* analysis, char* identifier )
+{
+    int index = find_variable_index( analysis, identifier );
+    return index == -1 ? NULL : &analysis->variables[ index ];
+}
+
+static void add_variable( EscapeAnalysis* analysis, char* identifier, bool is_reference )
+{
+    VariableUse variable = {
+        .identifier = identifier,
+        .is_reference = is_reference,
+    };
+    lvec_append_aggregate( analysis->variables, variable );
+}
+
+static LiteralUse* find_literal( EscapeAnalysis* analysis, Expression* literal )
+{
+    size_t length = lvec_get_length( analysis->literals );
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( analysis->literals[ i ].literal == literal )
+        {
+            return &analysis->literals[ i ];
+        }
+    }
+
+    LiteralUse literal_use = {
+        .literal = literal,
+    };
+    lvec_append_aggregate( analysis->literals, literal_use );
+    return &analysis->literals[ length ];
+}
+
+// nested functions can share a name with functions declared elsewhere, calls
+// to a name that is declared more than once are not resolved
+static FunctionSummary* find_summary( EscapeAnalysis* analysis, char* identifier )
+{
+    FunctionSummary* found = NULL;
+    size_t length = lvec_get_length( analysis->summaries );
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( strcmp( analysis->summaries[ i ].identifier, identifier ) == 0 )
+        {
+            if( found != NULL )
+            {
+                return NULL;
+            }
+            found = &analysis->summaries[ i ];
+        }
+    }
+
+    return found;
+}
+
+// true if values of `type` can point to the data of an array
+static bool can_hold_reference( Type type )
+{
+    switch( type.kind )
+    {
+        case TYPEKIND_NAMED:
+        {
+            return can_hold_reference( *type.named.definition );
+        }
+
+        case TYPEKIND_VOID:
+        case TYPEKIND_INTEGER:
+        case TYPEKIND_FLOAT:
+        case TYPEKIND_CHARACTER:
+        case TYPEKIND_BOOLEAN:
+        case TYPEKIND_NUMERICLITERAL:
+        {
+            return false;
+        }
+
+        case TYPEKIND_COMPOUND:
+        {
+            SymbolTable* member_symbol_table = type.compound.member_symbol_table;
+            for( int i = 0; i < member_symbol_table->length; i++ )
+            {
+                if( can_hold_reference( member_symbol_table->symbols[ i ].type ) )
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        default:
+        {
+            return true;
+        }
+    }
+}
+
+// records that the array value produced by `expression` flows somewhere where
+// it is used in the way described by `use`
+static void mark_use( EscapeAnalysis* analysis, Expression* expression, ArrayUse use )
+{
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            // for-loop iterators are dereferenced when they are read
+            Type type = expression->identifier.type;
+            if( type.kind == TYPEKIND_REFERENCE )
+            {
+                type = *type.reference.base_type;
+            }
+
+            VariableUse* variable = find_variable( analysis, expression->identifier.as_string );
+            if( variable != NULL && can_hold_reference( type ) )
+            {
+                analysis->has_changed |= merge_use( &variable->use, use );
+            }
+            break;
+        }
+
+        // the arrays that a literal is built from are reachable through it
+        case EXPRESSIONKIND_ARRAYLITERAL:
+        {
+            analysis->has_changed |= merge_use( &find_literal( analysis, expression )->use, use );
+
+            int count_initialized = expression->array_literal.count_initialized;
+            for( int i = 0; i < count_initialized; i++ )
+            {
+                mark_use( analysis, &expression->array_literal.initialized_rvalues[ i ], use );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_COMPOUNDLITERAL:
+        {
+            int initialized_count = expression->compound_literal.initialized_count;
+            for( int i = 0; i < initialized_count; i++ )
+            {
+                mark_use( analysis, &expression->compound_literal.initialized_member_rvalues[ i ], use );
+            }
+            break;
+        }
+
+        // elements and members live inside the storage of the outer value,
+        // copying out a scalar element does not expose the array though
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            if( can_hold_reference( expression->array_subscript.element_type ) )
+            {
+                mark_use( analysis, expression->array_subscript.lvalue, use );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_MEMBERACCESS:
+        {
+            mark_use( analysis, expression->member_access.lvalue, use );
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+
+// `&lvalue` can be used to read and write the storage of `lvalue` from anywhere
+static void mark_address_taken( EscapeAnalysis* analysis, Expression* lvalue )
+{
+    switch( lvalue->kind )
+    {
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            VariableUse* variable = find_variable( analysis, lvalue->identifier.as_string );
+            if( variable != NULL )
+            {
+                analysis->has_changed |= merge_use( &variable->use, unknown_use );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            mark_address_taken( analysis, lvalue->array_subscript.lvalue );
+            break;
+        }
+
+        case EXPRESSIONKIND_MEMBERACCESS:
+        {
+            mark_address_taken( analysis, lvalue->member_access.lvalue );
+            break;
+        }
+
+        default:
+        {
+            mark_use( analysis, lvalue, unknown_use );
+            break;
+        }
+    }
+}
+
+// marks the array stored in `lvalue` as written to, e.g. `nums[ 0 ] = 1`
+static void mark_written( EscapeAnalysis* analysis, Expression* lvalue )
+{
+    ArrayUse written = { .is_mutated = true };
+
+    switch( lvalue->kind )
+    {
+        // assigning a new array to a local does not touch the old array, but
+        // assigning to a for-loop iterator writes into the iterable
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            VariableUse* variable = find_variable( analysis, lvalue->identifier.as_string );
+            if( variable != NULL && variable->is_reference )
+            {
+                analysis->has_changed |= merge_use( &variable->use, written );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            mark_use( analysis, lvalue->array_subscript.lvalue, written );
+            break;
+        }
+
+        case EXPRESSIONKIND_MEMBERACCESS:
+        {
+            mark_written( analysis, lvalue->member_access.lvalue );
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+
+// the local whose storage holds the array produced by `expression`, -1 if none
+static int find_root_variable_index( EscapeAnalysis* analysis, Expression* expression )
+{
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            int index = find_variable_index( analysis, expression->identifier.as_string );
+            if( index != -1 && analysis->variables[ index ].is_reference )
+            {
+                return -1;
+            }
+            return index;
+        }
+
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            return find_root_variable_index( analysis, expression->array_subscript.lvalue );
+        }
+
+        case EXPRESSIONKIND_MEMBERACCESS:
+        {
+            return find_root_variable_index( analysis, expression->member_access.lvalue );
+        }
+
+        default:
+        {
+            return -1;
+        }
+    }
+}
+
+// records that the local at `alias_index` now holds the array produced by
+// `rvalue`, anything that later happens through the alias happens to the array
+static void mark_aliased( EscapeAnalysis* analysis, int alias_index, Expression* rvalue )
+{
+    int target_index = find_root_variable_index( analysis, rvalue );
+
+    // an alias declared before its target can be in an outer scope and
+    // outlive the block the target's storage belongs to
+    if( target_index == -1 || alias_index < target_index )
+    {
+        mark_use( analysis, rvalue, unknown_use );
+        return;
+    }
+
+    AliasEdge edge = {
+        .alias_index = alias_index,
+        .target_index = target_index,
+    };
+    lvec_append_aggregate( analysis->alias_edges, edge );
+}
+
+static void bind_literal( EscapeAnalysis* analysis, int variable_index, Expression* literal )
+{
+    LiteralBinding binding = {
+        .variable_index = variable_index,
+        .literal = literal,
+    };
+    lvec_append_aggregate( analysis->literal_bindings, binding );
+}
+
+// passes the uses of locals on to the arrays they hold until nothing changes,
+// an array stored in a literal can be another local that has aliases of its own
+static void propagate_uses( EscapeAnalysis* analysis )
+{
+    size_t edge_count = lvec_get_length( analysis->alias_edges );
+    size_t binding_count = lvec_get_length( analysis->literal_bindings );
+    do
+    {
+        analysis->has_changed = false;
+        for( size_t i = 0; i < edge_count; i++ )
+        {
+            ArrayUse alias_use = analysis->variables[ analysis->alias_edges[ i ].alias_index ].use;
+            ArrayUse* target_use = &analysis->variables[ analysis->alias_edges[ i ].target_index ].use;
+            analysis->has_changed |= merge_use( target_use, alias_use );
+        }
+
+        for( size_t i = 0; i < binding_count; i++ )
+        {
+            LiteralBinding binding = analysis->literal_bindings[ i ];
+            mark_use( analysis, binding.literal, analysis->variables[ binding.variable_index ].use );
+        }
+    } while( analysis->has_changed );
+}
+
+static bool is_local_variable( EscapeAnalysis* analysis, Expression* lvalue )
+{
+    if( lvalue->kind != EXPRESSIONKIND_IDENTIFIER )
+    {
+        return false;
+    }
+
+    VariableUse* variable = find_variable( analysis, lvalue->identifier.as_string );
+    return variable != NULL && !variable->is_reference;
+}
+
+static void analyze_expression( Expression* expression, void* data );
+
+static void analyze_function_call( EscapeAnalysis* analysis, Expression* expression )
+{
+    char* identifier = expression->function_call.identifier_token.as_string;
+    FunctionSummary* summary = find_summary( analysis, identifier );
+
+    size_t arg_count = expression->function_call.arg_count;
+    for( size_t i = 0; i < arg_count; i++ )
+    {
+        Expression* arg = &expression->function_call.args[ i ];
+        analyze_expression( arg, analysis );
+
+        // extern functions, including their variadic args, are assumed to only
+        // use the array while the call runs, like printf or memcpy do, but they
+        // can write to it. a call that is not resolved could keep it
+        ArrayUse use = unknown_use;
+        if( summary != NULL && summary->is_extern )
+        {
+            use = ( ArrayUse ){ .is_mutated = true };
+        }
+        else if( summary != NULL && i < ( size_t )summary->declaration->function_declaration.param_count )
+        {
+            use = summary->param_uses[ i ];
+        }
+        mark_use( analysis, arg, use );
+    }
+}
+
+static void analyze_expression( Expression* expression, void* data )
+{
+    EscapeAnalysis* analysis = data;
+
+    switch( expression->kind )
+    {
+        // analyzed on their own
+        case EXPRESSIONKIND_FUNCTIONDECLARATION:
+        case EXPRESSIONKIND_EXTERN:
+        {
+            break;
+        }
+
+        case EXPRESSIONKIND_VARIABLEDECLARATION:
+        {
+            char* identifier = expression->variable_declaration.identifier_token.as_string;
+            add_variable( analysis, identifier, false );
+
+            Expression* rvalue = expression->variable_declaration.rvalue;
+            if( rvalue == NULL )
+            {
+                break;
+            }
+
+            analyze_expression( rvalue, analysis );
+            int index = find_variable_index( analysis, identifier );
+            if( rvalue->kind == EXPRESSIONKIND_ARRAYLITERAL )
+            {
+                find_literal( analysis, rvalue )->variable_declaration = expression;
+                bind_literal( analysis, index, rvalue );
+            }
+            else if( rvalue->kind == EXPRESSIONKIND_COMPOUNDLITERAL )
+            {
+                bind_literal( analysis, index, rvalue );
+            }
+            else
+            {
+                mark_aliased( analysis, index, rvalue );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_ASSIGNMENT:
+        {
+            Expression* lvalue = expression->assignment.lvalue;
+            Expression* rvalue = expression->assignment.rvalue;
+            expression_visit_children( expression, analyze_expression, analysis );
+
+            mark_written( analysis, lvalue );
+            if( is_local_variable( analysis, lvalue ) && rvalue->kind == EXPRESSIONKIND_ARRAYLITERAL )
+            {
+                bind_literal( analysis, find_variable_index( analysis, lvalue->identifier.as_string ), rvalue );
+            }
+            else if( is_local_variable( analysis, lvalue ) )
+            {
+                mark_aliased( analysis, find_variable_index( analysis, lvalue->identifier.as_string ), rvalue );
+            }
+            else
+            {
+                // stored somewhere in memory
+                mark_use( analysis, rvalue, unknown_use );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_RETURN:
+        {
+            expression_visit_children( expression, analyze_expression, analysis );
+
+            Expression* rvalue = expression->return_expression.rvalue;
+            if( rvalue != NULL )
+            {
+                mark_use( analysis, rvalue, unknown_use );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        {
+            analyze_function_call( analysis, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            expression_visit_children( expression, analyze_expression, analysis );
+
+            if( expression->unary.operation == UNARYOPERATION_ADDRESSOF )
+            {
+                mark_address_taken( analysis, expression->unary.operand );
+            }
+            break;
+        }
+
+        // arrays stored inside a literal get the uses of the literal, see
+        // mark_use()
+        case EXPRESSIONKIND_ARRAYLITERAL:
+        {
+            find_literal( analysis, expression );
+            expression_visit_children( expression, analyze_expression, analysis );
+            break;
+        }
+
+        // the iterator refers into the iterable, so whatever happens to the
+        // iterator happens to the iterable
+        case EXPRESSIONKIND_FORLOOP:
+        {
+            Expression* iterable_rvalue = expression->for_loop.iterable_rvalue;
+            analyze_expression( iterable_rvalue, analysis );
+
+            char* iterator_identifier = expression->for_loop.iterator_token.as_string;
+            add_variable( analysis, iterator_identifier, true );
+            analyze_expression( expression->for_loop.body, analysis );
+
+            ArrayUse iterator_use = find_variable( analysis, iterator_identifier )->use;
+            mark_use( analysis, iterable_rvalue, iterator_use );
+            break;
+        }
+
+        default:
+        {
+            expression_visit_children( expression, analyze_expression, analysis );
+            break;
+        }
+    }
+}
+
+static uint64_t type_size( Type type )
+{
+    switch( type.kind )
+    {
+        case TYPEKIND_NAMED:
+        {
+            return type_size( *type.named.definition );
+        }
+
+        case TYPEKIND_INTEGER:
+        {
+            return type.integer.bit_count / 8;
+        }
+
+        case TYPEKIND_FLOAT:
+        {
+            return type.floating.bit_count / 8;
+        }
+
+        case TYPEKIND_CHARACTER:
+        case TYPEKIND_BOOLEAN:
+        {
+            return 1;
+        }
+
+        case TYPEKIND_ARRAY:
+        {
+            return 2 * sizeof( uint64_t );
+        }
+
+        case TYPEKIND_COMPOUND:
+        {
+            uint64_t size = 0;
+            SymbolTable* member_symbol_table = type.compound.member_symbol_table;
+            for( int i = 0; i < member_symbol_table->length; i++ )
+            {
+                uint64_t member_size = type_size( member_symbol_table->symbols[ i ].type );
+                if( type.compound.is_struct )
+                {
+                    size += member_size;
+                }
+                else if( member_size > size )
+                {
+                    size = member_size;
+                }
+            }
+            return size;
+        }
+
+        default:
+        {
+            return sizeof( void* );
+        }
+    }
+}
+
+// true if the C initializer generated for `expression` is a constant expression
+static bool is_constant_initializer( Expression* expression )
+{
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_INTEGER:
+        case EXPRESSIONKIND_FLOAT:
+        case EXPRESSIONKIND_STRING:
+        case EXPRESSIONKIND_CHARACTER:
+        case EXPRESSIONKIND_BOOLEAN:
+        {
+            return true;
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            return expression->unary.operation == UNARYOPERATION_NEGATIVE &&
+                is_constant_initializer( expression->unary.operand );
+        }
+
+        case EXPRESSIONKIND_BINARY:
+        {
+            return is_constant_initializer( expression->binary.left ) &&
+                is_constant_initializer( expression->binary.right );
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+static ArrayStorage choose_storage( LiteralUse* literal_use )
+{
+    Expression* literal = literal_use->literal;
+    ArrayUse use = literal_use->use;
+
+    if( use.escapes )
+    {
+        return ARRAYSTORAGE_HEAP;
+    }
+
+    bool is_constant = true;
+    int count_initialized = literal->array_literal.count_initialized;
+    for( int i = 0; i < count_initialized; i++ )
+    {
+        if( !is_constant_initializer( &literal->array_literal.initialized_rvalues[ i ] ) )
+        {
+            is_constant = false;
+        }
+    }
+
+    if( is_constant && !use.is_mutated )
+    {
+        return ARRAYSTORAGE_STATIC;
+    }
+
+    Type type = literal->array_literal.type;
+    uint64_t size = type.array.length * type_size( *type.array.base_type );
+    if( size <= MAX_AUTOMATIC_ARRAY_SIZE )
+    {
+        return ARRAYSTORAGE_AUTOMATIC;
+    }
+
+    // only a declaration knows the scope its array lives in, a literal assigned
+    // to an existing variable can be used after the current block is left
+    return literal_use->variable_declaration != NULL ? ARRAYSTORAGE_SCOPEDHEAP : ARRAYSTORAGE_HEAP;
+}
+
+// gives `let nums: [n]T;` an explicit zero-initialized literal so that it can be
+// given a storage like any other array
+static void materialize_array_initializers( Expression* expression, void* data )
+{
+    ( void )data;
+
+    if( expression->kind == EXPRESSIONKIND_VARIABLEDECLARATION &&
+        expression->variable_declaration.rvalue == NULL &&
+        expression->variable_declaration.variable_type.kind == TYPEKIND_ARRAY )
+    {
+        Expression* literal = malloc( sizeof( Expression ) );
+        *literal = ( Expression ){
+            .kind = EXPRESSIONKIND_ARRAYLITERAL,
+            .starting_token = expression->starting_token,
+            .array_literal = {
+                .type = expression->variable_declaration.variable_type,
+                .count_initialized = 0,
+                .initialized_rvalues = NULL,
+            },
+        };
+        expression->variable_declaration.rvalue = literal;
+    }
+
+    expression_visit_children( expression, materialize_array_initializers, data );
+}
+
+// analyzes the body of `function`, returns true if the summary changed
+static bool analyze_function( EscapeAnalysis* analysis, FunctionSummary* summary )
+{
+    Expression* declaration = summary->declaration;
+    int param_count = declaration->function_declaration.param_count;
+
+    analysis->variables = lvec_new( VariableUse );
+    analysis->literals = lvec_new( LiteralUse );
+    analysis->alias_edges = lvec_new( AliasEdge );
+    analysis->literal_bindings = lvec_new( LiteralBinding );
+
+    for( int i = 0; i < param_count; i++ )
+    {
+        add_variable( analysis, declaration->function_declaration.param_identifiers_tokens[ i ].as_string, false );
+    }
+
+    analyze_expression( declaration->function_declaration.body, analysis );
+    propagate_uses( analysis );
+
+    bool has_changed = false;
+    for( int i = 0; i < param_count; i++ )
+    {
+        ArrayUse param_use = analysis->variables[ i ].use;
+        ArrayUse* summary_use = &summary->param_uses[ i ];
+        if( param_use.escapes != summary_use->escapes || param_use.is_mutated != summary_use->is_mutated )
+        {
+            *summary_use = param_use;
+            has_changed = true;
+        }
+    }
+
+    size_t literal_count = lvec_get_length( analysis->literals );
+    for( size_t i = 0; i < literal_count; i++ )
+    {
+        LiteralUse* literal_use = &analysis->literals[ i ];
+        literal_use->literal->array_literal.storage = choose_storage( literal_use );
+    }
+
+    lvec_free( analysis->variables );
+    lvec_free( analysis->literals );
+    lvec_free( analysis->alias_edges );
+    lvec_free( analysis->literal_bindings );
+
+    return has_changed;
+}
+
+// adds a summary for every function, including the ones declared inside the
+// bodies of other functions
+static void collect_summaries( Expression* expression, void* data )
+{
+    EscapeAnalysis* analysis = data;
+
+    bool is_extern = expression->kind == EXPRESSIONKIND_EXTERN;
+    Expression* function = is_extern ? expression->extern_expression.function : expression;
+    if( function->kind == EXPRESSIONKIND_FUNCTIONDECLARATION )
+    {
+        int param_count = function->function_declaration.param_count;
+        FunctionSummary summary = {
+            .identifier = function->function_declaration.identifier_token.as_string,
+            .declaration = function,
+            .is_extern = is_extern,
+            .param_uses = calloc( param_count + 1, sizeof( ArrayUse ) ),
+        };
+        lvec_append_aggregate( analysis->summaries, summary );
+    }
+
+    if( !is_extern )
+    {
+        expression_visit_children( expression, collect_summaries, data );
+    }
+}
+
+void annotate_array_storage( Expression* program )
+{
+    materialize_array_initializers( program, NULL );
+
+    EscapeAnalysis analysis = {
+        .summaries = lvec_new( FunctionSummary ),
+    };
+
+    // functions start out assumed to leave their params alone and are analyzed
+    // until that stops changing, so that recursive functions converge
+    expression_visit_children( program, collect_summaries, &analysis );
+
+    size_t summary_count = lvec_get_length( analysis.summaries );
+    bool has_changed = true;
+    while( has_changed )
+    {
+        has_changed = false;
+        for( size_t i = 0; i < summary_count; i++ )
+        {
+            FunctionSummary* summary = &analysis.summaries[ i ];
+            if( !summary->is_extern && analyze_function( &analysis, summary ) )
+            {
+                has_changed = true;
+            }
+        }
+    }
+
+    for( size_t i = 0; i < summary_count; i++ )
+    {
+        free( analysis.summaries[ i ].param_uses );
+    }
+    lvec_free( analysis.summaries );
+}
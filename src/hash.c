@@ -0,0 +1,22 @@
+#include <string.h>
+#include "hash.h"
+
+#define FNV_PRIME 0x100000001b3ull
+
+uint64_t hash_bytes( uint64_t hash, const void* data, size_t length )
+{
+    const unsigned char* bytes = data;
+    for( size_t i = 0; i < length; i++ )
+    {
+        hash ^= bytes[ i ];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+uint64_t hash_string( uint64_t hash, const char* string )
+{
+    // the terminator is included so that "ab" + "c" and "a" + "bc" differ
+    return hash_bytes( hash, string, strlen( string ) + 1 );
+}
@@ -0,0 +1,373 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codebuffer.h"
+#include "codegen.h"
+#include "debug.h"
+#include "driver.h"
+#include "hash.h"
+#include "hotreload.h"
+#include "lvec.h"
+#include "parser.h"
+#include "semantic.h"
+
+#if !defined( _WIN32 )
+#include <dlfcn.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// functions added while the program runs take the free slots
+#define MIN_SLOT_COUNT 1024
+
+typedef void ( *HotFunction )( void );
+typedef void ( *HotAttach )( void* table );
+typedef int ( *HotEntry )( int argc, char** argv );
+
+// a function that has a slot in the table, by slot
+typedef struct HotSlot
+{
+    char* identifier;
+    uint64_t signature_hash;
+    uint64_t definition_hash;
+} HotSlot;
+
+struct HotReload
+{
+    char* include_directory;
+    char* object_directory;
+    int object_count; // names the objects
+
+    HotSlot* slots;
+    int slot_capacity;
+    uint64_t layout_hash;
+
+    // the units read it on every call, the tables it pointed to before are
+    // never freed because a call can still be reading them
+    _Atomic( HotFunction* ) table;
+
+    void* first_library; // has main and the globals
+};
+
+static uint64_t hash_buffer( CodeBuffer* buffer )
+{
+    return hash_bytes( HASH_INITIAL, buffer->data, buffer->length );
+}
+
+static uint64_t hash_layout( SemanticContext* context, Expression* program )
+{
+    CodeBuffer layout;
+    code_buffer_initialize( &layout );
+    generate_hot_reload_layout( &layout, context, program );
+    uint64_t hash = hash_buffer( &layout );
+    code_buffer_free( &layout );
+    return hash;
+}
+
+static int find_slot( HotReload* reload, char* identifier )
+{
+    size_t slot_count = lvec_get_length( reload->slots );
+    for( size_t i = 0; i < slot_count; i++ )
+    {
+        if( strcmp( reload->slots[ i ].identifier, identifier ) == 0 )
+        {
+            return ( int )i;
+        }
+    }
+
+    return -1;
+}
+
+// compiles a unit to a shared object and loads it. the object is removed
+// right away, it stays mapped as long as it is loaded
+static void* build_unit( HotReload* reload, SemanticContext* context, Expression* program, int* slots,
+                         bool* is_defined, bool is_first )
+{
+    char* object_path = calloc( 1, strlen( reload->object_directory ) + 64 );
+    if( object_path == NULL ) ALLOC_ERROR();
+    sprintf( object_path, "%s/hot-%d-%d.so", reload->object_directory, ( int )getpid(), reload->object_count++ );
+
+    CodeBuffer generated_c;
+    code_buffer_initialize( &generated_c );
+
+    CCompiler compiler;
+    bool is_built = c_compiler_start( &compiler, &generated_c, object_path, reload->include_directory,
+                                      CCOMPILEROUTPUT_SHAREDOBJECT );
+    if( is_built )
+    {
+        generate_hot_reload_unit( &generated_c, context, program, slots, is_defined, is_first );
+        if( is_first )
+        {
+            generate_run_entry( &generated_c, program );
+        }
+        is_built = c_compiler_finish( &compiler );
+    }
+    code_buffer_free( &generated_c );
+
+    // later units find the globals of the first one
+    void* library = NULL;
+    if( is_built )
+    {
+        library = dlopen( object_path, RTLD_NOW | ( is_first ? RTLD_GLOBAL : RTLD_LOCAL ) );
+        if( library == NULL )
+        {
+            printf( "Could not load '%s': %s.\n", object_path, dlerror() );
+        }
+    }
+
+    if( library != NULL )
+    {
+        // iso c cannot cast between data and function pointers, posix can
+        void* symbol = dlsym( library, "octo_hot_attach" );
+        HotAttach attach;
+        memcpy( &attach, &symbol, sizeof( attach ) );
+        attach( ( void* )&reload->table );
+    }
+
+    remove( object_path );
+    free( object_path );
+    return library;
+}
+
+static HotFunction find_function( void* library, char* identifier )
+{
+    char* symbol_name = calloc( 1, strlen( HOT_RELOAD_PREFIX ) + strlen( identifier ) + 1 );
+    if( symbol_name == NULL ) ALLOC_ERROR();
+    sprintf( symbol_name, "%s%s", HOT_RELOAD_PREFIX, identifier );
+
+    void* symbol = dlsym( library, symbol_name );
+    free( symbol_name );
+
+    HotFunction function;
+    memcpy( &function, &symbol, sizeof( function ) );
+    return function;
+}
+
+HotReload* hot_reload_load( SemanticContext* context, Expression* program, char* include_directory,
+                            char* object_directory )
+{
+    HotReload* reload = calloc( 1, sizeof( HotReload ) );
+    if( reload == NULL ) ALLOC_ERROR();
+    reload->include_directory = include_directory;
+    reload->object_directory = object_directory;
+    reload->slots = lvec_new( HotSlot );
+    reload->layout_hash = hash_layout( context, program );
+
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    int* slots = calloc( statement_count + 1, sizeof( int ) );
+    bool* is_defined = calloc( statement_count + 1, sizeof( bool ) );
+    if( slots == NULL || is_defined == NULL ) ALLOC_ERROR();
+
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( !is_hot_reloadable( statement ) )
+        {
+            continue;
+        }
+
+        CodeBuffer signature;
+        CodeBuffer definition;
+        code_buffer_initialize( &signature );
+        code_buffer_initialize( &definition );
+        generate_hot_reload_function( &signature, &definition, context, statement );
+
+        HotSlot slot = {
+            .identifier = statement->function_declaration.identifier_token.as_string,
+            .signature_hash = hash_buffer( &signature ),
+            .definition_hash = hash_buffer( &definition ),
+        };
+        slots[ i ] = ( int )lvec_get_length( reload->slots );
+        is_defined[ i ] = true;
+        lvec_append_aggregate( reload->slots, slot );
+
+        code_buffer_free( &signature );
+        code_buffer_free( &definition );
+    }
+
+    int slot_count = ( int )lvec_get_length( reload->slots );
+    reload->slot_capacity = slot_count * 2 > MIN_SLOT_COUNT ? slot_count * 2 : MIN_SLOT_COUNT;
+    HotFunction* table = calloc( reload->slot_capacity, sizeof( HotFunction ) );
+    if( table == NULL ) ALLOC_ERROR();
+    atomic_store( &reload->table, table );
+
+    reload->first_library = build_unit( reload, context, program, slots, is_defined, true );
+    free( is_defined );
+    free( slots );
+    if( reload->first_library == NULL )
+    {
+        lvec_free( reload->slots );
+        free( table );
+        free( reload );
+        return NULL;
+    }
+
+    for( int i = 0; i < slot_count; i++ )
+    {
+        table[ i ] = find_function( reload->first_library, reload->slots[ i ].identifier );
+    }
+
+    return reload;
+}
+
+int hot_reload_run( HotReload* reload, int argc, char** argv )
+{
+    void* symbol = dlsym( reload->first_library, RUN_ENTRY_NAME );
+    if( symbol == NULL )
+    {
+        printf( "The program has no main to run.\n" );
+        return 1;
+    }
+
+    HotEntry entry;
+    memcpy( &entry, &symbol, sizeof( entry ) );
+
+    fflush( stdout );
+    return entry( argc, argv );
+}
+
+void hot_reload_update( HotReload* reload, SemanticContext* context, Expression* program )
+{
+    if( hash_layout( context, program ) != reload->layout_hash )
+    {
+        printf( "The types, externs or globals changed, restart the program to run the new code.\n" );
+        return;
+    }
+
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    int* slots = calloc( statement_count + 1, sizeof( int ) );
+    bool* is_defined = calloc( statement_count + 1, sizeof( bool ) );
+    HotSlot* changes = calloc( statement_count + 1, sizeof( HotSlot ) );
+    if( slots == NULL || is_defined == NULL || changes == NULL ) ALLOC_ERROR();
+
+    // new functions get the next free slots, but only keep them once they
+    // were loaded
+    int slot_count = ( int )lvec_get_length( reload->slots );
+    int next_slot = slot_count;
+    int defined_count = 0;
+    bool can_update = true;
+    for( size_t i = 0; i < statement_count && can_update; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( !is_hot_reloadable( statement ) )
+        {
+            continue;
+        }
+
+        CodeBuffer signature;
+        CodeBuffer definition;
+        code_buffer_initialize( &signature );
+        code_buffer_initialize( &definition );
+        generate_hot_reload_function( &signature, &definition, context, statement );
+
+        char* identifier = statement->function_declaration.identifier_token.as_string;
+        changes[ i ] = ( HotSlot ){
+            .identifier = identifier,
+            .signature_hash = hash_buffer( &signature ),
+            .definition_hash = hash_buffer( &definition ),
+        };
+        code_buffer_free( &signature );
+        code_buffer_free( &definition );
+
+        int slot = find_slot( reload, identifier );
+        if( slot == -1 )
+        {
+            if( next_slot == reload->slot_capacity )
+            {
+                printf( "Too many functions were added, restart the program to run the new code.\n" );
+                can_update = false;
+                break;
+            }
+
+            slot = next_slot++;
+            is_defined[ i ] = true;
+        }
+        else if( reload->slots[ slot ].signature_hash != changes[ i ].signature_hash )
+        {
+            // the callers that did not change would call it the old way
+            printf( "The signature of '%s' changed, restart the program to run the new code.\n", identifier );
+            can_update = false;
+            break;
+        }
+        else
+        {
+            is_defined[ i ] = reload->slots[ slot ].definition_hash != changes[ i ].definition_hash;
+        }
+
+        slots[ i ] = slot;
+        defined_count += is_defined[ i ];
+    }
+
+    void* library = NULL;
+    if( can_update && defined_count > 0 )
+    {
+        library = build_unit( reload, context, program, slots, is_defined, false );
+    }
+
+    if( library != NULL )
+    {
+        HotFunction* current_table = atomic_load( &reload->table );
+        HotFunction* table = calloc( reload->slot_capacity, sizeof( HotFunction ) );
+        if( table == NULL ) ALLOC_ERROR();
+        memcpy( table, current_table, reload->slot_capacity * sizeof( HotFunction ) );
+
+        for( size_t i = 0; i < statement_count; i++ )
+        {
+            if( !is_defined[ i ] )
+            {
+                continue;
+            }
+
+            table[ slots[ i ] ] = find_function( library, changes[ i ].identifier );
+            if( slots[ i ] < ( int )lvec_get_length( reload->slots ) )
+            {
+                reload->slots[ slots[ i ] ] = changes[ i ];
+            }
+            else
+            {
+                lvec_append_aggregate( reload->slots, changes[ i ] );
+            }
+        }
+
+        // every call from now on sees all of the new functions
+        atomic_store_explicit( &reload->table, table, memory_order_release );
+        printf( "reloaded %d function%s\n", defined_count, defined_count == 1 ? "" : "s" );
+        fflush( stdout );
+    }
+
+    free( changes );
+    free( is_defined );
+    free( slots );
+}
+
+#else
+
+HotReload* hot_reload_load( SemanticContext* context, Expression* program, char* include_directory,
+                            char* object_directory )
+{
+    ( void )context;
+    ( void )program;
+    ( void )include_directory;
+    ( void )object_directory;
+    printf( "Hot reloading needs dlopen(), which windows does not have.\n" );
+    return NULL;
+}
+
+int hot_reload_run( HotReload* reload, int argc, char** argv )
+{
+    ( void )reload;
+    ( void )argc;
+    ( void )argv;
+    UNREACHABLE();
+    return 1;
+}
+
+void hot_reload_update( HotReload* reload, SemanticContext* context, Expression* program )
+{
+    ( void )reload;
+    ( void )context;
+    ( void )program;
+    UNREACHABLE();
+}
+
+#endif
@@ -0,0 +1,186 @@
+#include <string.h>
+#include "inline.h"
+#include "lvec.h"
+#include "parser.h"
+
+typedef struct FunctionCost
+{
+    Expression* function;
+    int cost; // expressions in the body once the calls in it are inlined
+} FunctionCost;
+
+typedef struct InlineAnalysis
+{
+    FunctionCost* costs; // of the functions before the current one
+    int threshold;
+
+    // of the function whose calls are being decided
+    int cost;
+} InlineAnalysis;
+
+static FunctionCost* find_cost( InlineAnalysis* analysis, char* identifier )
+{
+    size_t length = lvec_get_length( analysis->costs );
+    for( size_t i = 0; i < length; i++ )
+    {
+        Expression* function = analysis->costs[ i ].function;
+        if( strcmp( function->function_declaration.identifier_token.as_string, identifier ) == 0 )
+        {
+            return &analysis->costs[ i ];
+        }
+    }
+
+    return NULL;
+}
+
+static bool should_inline( InlineAnalysis* analysis, FunctionCost* callee_cost )
+{
+    Expression* callee = callee_cost->function;
+    int attributes = callee->function_declaration.attributes;
+    if( callee->function_declaration.is_variadic || ( attributes & FUNCTIONATTRIBUTE_NOINLINE ) )
+    {
+        return false;
+    }
+
+    if( attributes & FUNCTIONATTRIBUTE_INLINE )
+    {
+        return true;
+    }
+
+    return callee_cost->cost <= analysis->threshold;
+}
+
+static void decide_calls( Expression* expression, void* data )
+{
+    InlineAnalysis* analysis = data;
+
+    // nested functions are left alone
+    if( expression->kind == EXPRESSIONKIND_FUNCTIONDECLARATION )
+    {
+        return;
+    }
+
+    analysis->cost++;
+    expression_visit_children( expression, decide_calls, data );
+
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        {
+            char* identifier = expression->function_call.identifier_token.as_string;
+            FunctionCost* callee_cost = find_cost( analysis, identifier );
+            if( callee_cost != NULL && should_inline( analysis, callee_cost ) )
+            {
+                expression->function_call.inlined_function = callee_cost->function;
+                analysis->cost += callee_cost->cost;
+            }
+            break;
+        }
+
+        // an inlined call is no longer a tail call
+        case EXPRESSIONKIND_RETURN:
+        {
+            Expression* rvalue = expression->return_expression.rvalue;
+            if( rvalue != NULL &&
+                rvalue->kind == EXPRESSIONKIND_FUNCTIONCALL &&
+                rvalue->function_call.inlined_function != NULL )
+            {
+                expression->return_expression.tail_call = TAILCALL_NONE;
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+
+typedef struct SelfCallSearch
+{
+    char* identifier;
+    bool is_found;
+} SelfCallSearch;
+
+static void find_self_call( Expression* expression, void* data )
+{
+    SelfCallSearch* search = data;
+    if( expression->kind == EXPRESSIONKIND_FUNCTIONCALL &&
+        strcmp( expression->function_call.identifier_token.as_string, search->identifier ) == 0 )
+    {
+        search->is_found = true;
+    }
+
+    expression_visit_children( expression, find_self_call, data );
+}
+
+static bool calls_itself( Expression* function )
+{
+    SelfCallSearch search = {
+        .identifier = function->function_declaration.identifier_token.as_string,
+        .is_found = false,
+    };
+    expression_visit_children( function->function_declaration.body, find_self_call, &search );
+
+    return search.is_found;
+}
+
+static void find_nested_function( Expression* expression, void* data )
+{
+    bool* is_found = data;
+    if( expression->kind == EXPRESSIONKIND_FUNCTIONDECLARATION )
+    {
+        *is_found = true;
+        return;
+    }
+
+    expression_visit_children( expression, find_nested_function, data );
+}
+
+static bool declares_function( Expression* function )
+{
+    bool is_found = false;
+    expression_visit_children( function->function_declaration.body, find_nested_function, &is_found );
+    return is_found;
+}
+
+void annotate_inline_calls( Expression* program, int threshold )
+{
+    InlineAnalysis analysis = {
+        .costs = lvec_new( FunctionCost ),
+        .threshold = threshold,
+    };
+
+    // callees are always declared before their callers, so their costs are
+    // known by the time their calls are decided. a function is not a callee of
+    // itself while its own calls are decided
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind != EXPRESSIONKIND_FUNCTIONDECLARATION )
+        {
+            continue;
+        }
+
+        analysis.cost = 0;
+        expression_visit_children( statement->function_declaration.body, decide_calls, &analysis );
+
+        // recursive functions are never inlined into their callers, and neither
+        // are functions with nested functions, whose copies would keep their
+        // names and whose returns would leave the inlined body
+        if( calls_itself( statement ) || declares_function( statement ) )
+        {
+            continue;
+        }
+
+        FunctionCost function_cost = {
+            .function = statement,
+            .cost = analysis.cost,
+        };
+        lvec_append_aggregate( analysis.costs, function_cost );
+    }
+
+    lvec_free( analysis.costs );
+}
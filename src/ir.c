@@ -0,0 +1,723 @@
+#include <stdlib.h>
+#include <string.h>
+#include "debug.h"
+#include "ir.h"
+#include "lvec.h"
+
+IrBlock* ir_block_new( IrFunction* function )
+{
+    IrBlock* block = calloc( 1, sizeof( IrBlock ) );
+    if( block == NULL ) ALLOC_ERROR();
+
+    block->index = function->block_count;
+    block->instructions = lvec_new( IrInstruction* );
+    block->predecessors = lvec_new( IrBlock* );
+    block->order = -1;
+    function->block_count++;
+
+    lvec_append( function->blocks, block );
+    return block;
+}
+
+IrInstruction* ir_instruction_new( IrFunction* function, IrOpcode opcode, Type type )
+{
+    IrInstruction* instruction = calloc( 1, sizeof( IrInstruction ) );
+    if( instruction == NULL ) ALLOC_ERROR();
+
+    instruction->opcode = opcode;
+    instruction->type = type;
+    instruction->index = function->instruction_count;
+    instruction->operands = lvec_new( IrInstruction* );
+    function->instruction_count++;
+
+    return instruction;
+}
+
+void ir_instruction_free( IrInstruction* instruction )
+{
+    lvec_free( instruction->operands );
+    free( instruction );
+}
+
+static void ir_block_free( IrBlock* block )
+{
+    size_t length = lvec_get_length( block->instructions );
+    for( size_t i = 0; i < length; i++ )
+    {
+        ir_instruction_free( block->instructions[ i ] );
+    }
+
+    lvec_free( block->instructions );
+    lvec_free( block->predecessors );
+    free( block );
+}
+
+void ir_function_free( IrFunction* function )
+{
+    size_t length = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < length; i++ )
+    {
+        ir_block_free( function->blocks[ i ] );
+    }
+
+    lvec_free( function->blocks );
+    free( function );
+}
+
+bool ir_is_terminator( IrInstruction* instruction )
+{
+    return instruction->opcode == IROPCODE_JUMP ||
+           instruction->opcode == IROPCODE_BRANCH ||
+           instruction->opcode == IROPCODE_RETURN;
+}
+
+// true if the instruction cannot be removed even when its value is unused
+bool ir_has_side_effects( IrInstruction* instruction )
+{
+    switch( instruction->opcode )
+    {
+        case IROPCODE_STORE:
+        case IROPCODE_JUMP:
+        case IROPCODE_BRANCH:
+        case IROPCODE_RETURN:
+        {
+            return true;
+        }
+
+        case IROPCODE_CALL:
+        {
+            int attributes = instruction->call.function->function_declaration.attributes;
+            return instruction->call.is_tail_call ||
+                   !( attributes & ( FUNCTIONATTRIBUTE_CONST | FUNCTIONATTRIBUTE_PURE ) );
+        }
+
+        // a failed bounds check stops the program
+        case IROPCODE_ELEMENT:
+        {
+            return instruction->element.is_bounds_checked;
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+IrInstruction* ir_block_get_terminator( IrBlock* block )
+{
+    size_t length = lvec_get_length( block->instructions );
+    if( length == 0 || !ir_is_terminator( block->instructions[ length - 1 ] ) )
+    {
+        return NULL;
+    }
+
+    return block->instructions[ length - 1 ];
+}
+
+int ir_block_get_successor_count( IrBlock* block )
+{
+    IrInstruction* terminator = ir_block_get_terminator( block );
+    if( terminator == NULL )
+    {
+        return 0;
+    }
+
+    switch( terminator->opcode )
+    {
+        case IROPCODE_JUMP:   return 1;
+        case IROPCODE_BRANCH: return 2;
+        default:              return 0;
+    }
+}
+
+IrBlock* ir_block_get_successor( IrBlock* block, int i )
+{
+    return ir_block_get_terminator( block )->targets[ i ];
+}
+
+void ir_block_insert( IrBlock* block, IrInstruction* instruction, size_t position )
+{
+    lvec_append( block->instructions, instruction );
+
+    size_t length = lvec_get_length( block->instructions );
+    for( size_t i = length - 1; i > position; i-- )
+    {
+        block->instructions[ i ] = block->instructions[ i - 1 ];
+    }
+    block->instructions[ position ] = instruction;
+    instruction->block = block;
+}
+
+void ir_block_insert_before_terminator( IrBlock* block, IrInstruction* instruction )
+{
+    size_t length = lvec_get_length( block->instructions );
+    size_t position = ir_block_get_terminator( block ) != NULL ? length - 1 : length;
+    ir_block_insert( block, instruction, position );
+}
+
+void ir_block_remove( IrBlock* block, IrInstruction* instruction )
+{
+    size_t length = lvec_get_length( block->instructions );
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( block->instructions[ i ] != instruction )
+        {
+            continue;
+        }
+
+        for( size_t j = i; j + 1 < length; j++ )
+        {
+            block->instructions[ j ] = block->instructions[ j + 1 ];
+        }
+        lvec_remove_last( block->instructions );
+        return;
+    }
+}
+
+void ir_add_edge( IrBlock* from, IrBlock* to )
+{
+    lvec_append( to->predecessors, from );
+}
+
+void ir_remove_edge( IrBlock* from, IrBlock* to )
+{
+    size_t predecessor_count = lvec_get_length( to->predecessors );
+    for( size_t i = 0; i < predecessor_count; i++ )
+    {
+        if( to->predecessors[ i ] != from )
+        {
+            continue;
+        }
+
+        for( size_t j = i; j + 1 < predecessor_count; j++ )
+        {
+            to->predecessors[ j ] = to->predecessors[ j + 1 ];
+        }
+        lvec_remove_last( to->predecessors );
+
+        // the phis lose the operand that came from `from`
+        size_t length = lvec_get_length( to->instructions );
+        for( size_t k = 0; k < length && to->instructions[ k ]->opcode == IROPCODE_PHI; k++ )
+        {
+            IrInstruction* phi = to->instructions[ k ];
+            for( size_t j = i; j + 1 < predecessor_count; j++ )
+            {
+                phi->operands[ j ] = phi->operands[ j + 1 ];
+            }
+            lvec_remove_last( phi->operands );
+        }
+        return;
+    }
+}
+
+void ir_replace_uses( IrFunction* function, IrInstruction* old_value, IrInstruction* new_value )
+{
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            size_t operand_count = lvec_get_length( instruction->operands );
+            for( size_t k = 0; k < operand_count; k++ )
+            {
+                if( instruction->operands[ k ] == old_value )
+                {
+                    instruction->operands[ k ] = new_value;
+                }
+            }
+        }
+    }
+}
+
+static void visit_postorder( IrBlock* block, bool* is_visited, IrBlock*** postorder )
+{
+    is_visited[ block->index ] = true;
+
+    int successor_count = ir_block_get_successor_count( block );
+    for( int i = 0; i < successor_count; i++ )
+    {
+        IrBlock* successor = ir_block_get_successor( block, i );
+        if( !is_visited[ successor->index ] )
+        {
+            visit_postorder( successor, is_visited, postorder );
+        }
+    }
+
+    lvec_append( *postorder, block );
+}
+
+void ir_remove_unreachable_blocks( IrFunction* function )
+{
+    bool* is_visited = calloc( function->block_count, sizeof( bool ) );
+    if( is_visited == NULL ) ALLOC_ERROR();
+
+    IrBlock** postorder = lvec_new( IrBlock* );
+    visit_postorder( function->blocks[ 0 ], is_visited, &postorder );
+
+    // unreachable blocks can still jump into reachable ones
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        if( is_visited[ block->index ] )
+        {
+            continue;
+        }
+
+        int successor_count = ir_block_get_successor_count( block );
+        for( int j = 0; j < successor_count; j++ )
+        {
+            ir_remove_edge( block, ir_block_get_successor( block, j ) );
+        }
+    }
+
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        if( !is_visited[ block->index ] )
+        {
+            ir_block_free( block );
+        }
+    }
+
+    size_t reachable_count = lvec_get_length( postorder );
+    lvec_free( function->blocks );
+    function->blocks = lvec_new( IrBlock* );
+    for( size_t i = 0; i < reachable_count; i++ )
+    {
+        IrBlock* block = postorder[ reachable_count - 1 - i ];
+        block->order = ( int )i;
+        lvec_append( function->blocks, block );
+    }
+
+    lvec_free( postorder );
+    free( is_visited );
+}
+
+static IrBlock* intersect( IrBlock* b1, IrBlock* b2 )
+{
+    while( b1 != b2 )
+    {
+        while( b1->order > b2->order )
+        {
+            b1 = b1->immediate_dominator;
+        }
+        while( b2->order > b1->order )
+        {
+            b2 = b2->immediate_dominator;
+        }
+    }
+
+    return b1;
+}
+
+// "a simple, fast dominance algorithm" by cooper, harvey and kennedy, over the
+// blocks in reverse postorder
+void ir_compute_dominators( IrFunction* function )
+{
+    ir_remove_unreachable_blocks( function );
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        function->blocks[ i ]->immediate_dominator = NULL;
+    }
+
+    IrBlock* entry = function->blocks[ 0 ];
+    entry->immediate_dominator = entry;
+
+    bool has_changed = true;
+    while( has_changed )
+    {
+        has_changed = false;
+        for( size_t i = 1; i < block_count; i++ )
+        {
+            IrBlock* block = function->blocks[ i ];
+            IrBlock* new_dominator = NULL;
+
+            size_t predecessor_count = lvec_get_length( block->predecessors );
+            for( size_t j = 0; j < predecessor_count; j++ )
+            {
+                IrBlock* predecessor = block->predecessors[ j ];
+                if( predecessor->immediate_dominator == NULL )
+                {
+                    continue;
+                }
+
+                new_dominator = new_dominator == NULL ? predecessor : intersect( predecessor, new_dominator );
+            }
+
+            if( block->immediate_dominator != new_dominator )
+            {
+                block->immediate_dominator = new_dominator;
+                has_changed = true;
+            }
+        }
+    }
+}
+
+bool ir_dominates( IrBlock* dominator, IrBlock* block )
+{
+    while( block != dominator )
+    {
+        if( block->immediate_dominator == block )
+        {
+            return false;
+        }
+        block = block->immediate_dominator;
+    }
+
+    return true;
+}
+
+Type ir_get_type_definition( Type type )
+{
+    if( type.kind == TYPEKIND_NAMED )
+    {
+        return *type.named.definition;
+    }
+
+    return type;
+}
+
+bool ir_type_is_integer( Type type )
+{
+    TypeKind kind = ir_get_type_definition( type ).kind;
+    return kind == TYPEKIND_INTEGER || kind == TYPEKIND_BOOLEAN || kind == TYPEKIND_CHARACTER;
+}
+
+bool ir_type_is_float( Type type )
+{
+    return ir_get_type_definition( type ).kind == TYPEKIND_FLOAT;
+}
+
+bool ir_type_is_signed( Type type )
+{
+    Type definition = ir_get_type_definition( type );
+    switch( definition.kind )
+    {
+        case TYPEKIND_INTEGER:   return definition.integer.is_signed;
+        case TYPEKIND_CHARACTER: return true;
+        case TYPEKIND_FLOAT:     return true;
+        default:                 return false;
+    }
+}
+
+int ir_type_get_bit_count( Type type )
+{
+    Type definition = ir_get_type_definition( type );
+    switch( definition.kind )
+    {
+        case TYPEKIND_INTEGER:   return ( int )definition.integer.bit_count;
+        case TYPEKIND_FLOAT:     return ( int )definition.floating.bit_count;
+        case TYPEKIND_CHARACTER: return 8;
+        case TYPEKIND_BOOLEAN:   return 8;
+        default:                 return 64;
+    }
+}
+
+// the same c type, array lengths do not matter and references are pointers
+uint64_t ir_get_constant_bits( IrInstruction* constant )
+{
+    if( !ir_type_is_float( constant->type ) )
+    {
+        return constant->integer; // null pointers are 0 too
+    }
+
+    if( ir_type_get_bit_count( constant->type ) == 64 )
+    {
+        uint64_t bits;
+        memcpy( &bits, &constant->floating, sizeof( bits ) );
+        return bits;
+    }
+
+    float single = ( float )constant->floating;
+    uint32_t bits;
+    memcpy( &bits, &single, sizeof( bits ) );
+    return bits;
+}
+
+bool ir_is_literal_initializer( Expression* rvalue )
+{
+    switch( rvalue->kind )
+    {
+        case EXPRESSIONKIND_INTEGER:
+        case EXPRESSIONKIND_FLOAT:
+        case EXPRESSIONKIND_BOOLEAN:
+        case EXPRESSIONKIND_CHARACTER:
+        case EXPRESSIONKIND_STRING:
+        {
+            return true;
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            Expression* operand = rvalue->unary.operand;
+            return rvalue->unary.operation == UNARYOPERATION_NEGATIVE &&
+                   ( operand->kind == EXPRESSIONKIND_INTEGER || operand->kind == EXPRESSIONKIND_FLOAT );
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+uint64_t ir_get_literal_bits( Expression* rvalue, Type type )
+{
+    bool is_negative = rvalue->kind == EXPRESSIONKIND_UNARY;
+    Expression* literal = is_negative ? rvalue->unary.operand : rvalue;
+
+    switch( literal->kind )
+    {
+        case EXPRESSIONKIND_BOOLEAN:   return literal->boolean ? 1 : 0;
+        case EXPRESSIONKIND_CHARACTER: return ( uint64_t )( int64_t )literal->character;
+        default:                       break;
+    }
+
+    if( ir_type_is_float( type ) )
+    {
+        double floating = literal->kind == EXPRESSIONKIND_FLOAT ? literal->floating : ( double )literal->integer;
+        IrInstruction constant = { .type = type, .floating = is_negative ? -floating : floating };
+        return ir_get_constant_bits( &constant );
+    }
+
+    return is_negative ? 0 - literal->integer : literal->integer;
+}
+
+bool ir_type_equals( Type t1, Type t2 )
+{
+    if( t1.kind == TYPEKIND_REFERENCE )
+    {
+        t1 = ( Type ){ .kind = TYPEKIND_POINTER, .pointer.base_type = t1.reference.base_type };
+    }
+    if( t2.kind == TYPEKIND_REFERENCE )
+    {
+        t2 = ( Type ){ .kind = TYPEKIND_POINTER, .pointer.base_type = t2.reference.base_type };
+    }
+
+    if( t1.kind != t2.kind )
+    {
+        return false;
+    }
+
+    switch( t1.kind )
+    {
+        case TYPEKIND_NAMED:     return strcmp( t1.named.as_string, t2.named.as_string ) == 0;
+        case TYPEKIND_POINTER:   return ir_type_equals( *t1.pointer.base_type, *t2.pointer.base_type );
+        case TYPEKIND_ARRAY:     return ir_type_equals( *t1.array.base_type, *t2.array.base_type );
+        default:                 return false;
+    }
+}
+
+static char* opcode_to_string[] = {
+    [ IROPCODE_CONSTANT ]     = "const",
+    [ IROPCODE_STRING ]       = "string",
+    [ IROPCODE_PARAM ]        = "param",
+    [ IROPCODE_PHI ]          = "phi",
+    [ IROPCODE_COPY ]         = "copy",
+    [ IROPCODE_CONVERT ]      = "convert",
+    [ IROPCODE_ADD ]          = "add",
+    [ IROPCODE_SUBTRACT ]     = "sub",
+    [ IROPCODE_MULTIPLY ]     = "mul",
+    [ IROPCODE_DIVIDE ]       = "div",
+    [ IROPCODE_MODULO ]       = "mod",
+    [ IROPCODE_EQUAL ]        = "eq",
+    [ IROPCODE_NOTEQUAL ]     = "ne",
+    [ IROPCODE_LESS ]         = "lt",
+    [ IROPCODE_LESSEQUAL ]    = "le",
+    [ IROPCODE_GREATER ]      = "gt",
+    [ IROPCODE_GREATEREQUAL ] = "ge",
+    [ IROPCODE_NEGATE ]       = "neg",
+    [ IROPCODE_NOT ]          = "not",
+    [ IROPCODE_SLOT ]         = "slot",
+    [ IROPCODE_GLOBAL ]       = "global",
+    [ IROPCODE_LOAD ]         = "load",
+    [ IROPCODE_STORE ]        = "store",
+    [ IROPCODE_ARRAYLITERAL ] = "array",
+    [ IROPCODE_ARRAYLENGTH ]  = "length",
+    [ IROPCODE_ELEMENT ]      = "element",
+    [ IROPCODE_CALL ]         = "call",
+    [ IROPCODE_JUMP ]         = "jump",
+    [ IROPCODE_BRANCH ]       = "branch",
+    [ IROPCODE_RETURN ]       = "return",
+};
+
+static void print_type( CodeBuffer* buffer, Type type )
+{
+    switch( type.kind )
+    {
+        case TYPEKIND_NAMED:
+        {
+            code_buffer_append_string( buffer, type.named.as_string );
+            break;
+        }
+
+        case TYPEKIND_POINTER:
+        {
+            code_buffer_append_string( buffer, "&" );
+            print_type( buffer, *type.pointer.base_type );
+            break;
+        }
+
+        case TYPEKIND_REFERENCE:
+        {
+            code_buffer_append_string( buffer, "ref " );
+            print_type( buffer, *type.reference.base_type );
+            break;
+        }
+
+        case TYPEKIND_ARRAY:
+        {
+            code_buffer_append_string( buffer, "[]" );
+            print_type( buffer, *type.array.base_type );
+            break;
+        }
+
+        default:
+        {
+            code_buffer_append_string( buffer, "?" );
+            break;
+        }
+    }
+}
+
+static void print_block_name( CodeBuffer* buffer, IrBlock* block )
+{
+    code_buffer_append_string( buffer, "block" );
+    code_buffer_append_integer( buffer, block->index );
+}
+
+static void print_instruction( CodeBuffer* buffer, IrInstruction* instruction )
+{
+    code_buffer_append_string( buffer, "    " );
+    bool has_value = !( instruction->type.kind == TYPEKIND_NAMED &&
+                        instruction->type.named.definition->kind == TYPEKIND_VOID );
+    if( has_value )
+    {
+        code_buffer_append_string( buffer, "v" );
+        code_buffer_append_integer( buffer, instruction->index );
+        code_buffer_append_string( buffer, ": " );
+        print_type( buffer, instruction->type );
+        code_buffer_append_string( buffer, " = " );
+    }
+    code_buffer_append_string( buffer, opcode_to_string[ instruction->opcode ] );
+
+    switch( instruction->opcode )
+    {
+        case IROPCODE_CONSTANT:
+        {
+            code_buffer_append_string( buffer, " " );
+            if( ir_type_is_float( instruction->type ) )
+            {
+                code_buffer_append_float( buffer, instruction->floating );
+            }
+            else if( ir_type_is_signed( instruction->type ) )
+            {
+                code_buffer_append_integer( buffer, ( int64_t )instruction->integer );
+            }
+            else
+            {
+                code_buffer_append_unsigned( buffer, instruction->integer );
+            }
+            break;
+        }
+
+        case IROPCODE_STRING:
+        {
+            code_buffer_append_string( buffer, " \"" );
+            code_buffer_append_string( buffer, instruction->string );
+            code_buffer_append_string( buffer, "\"" );
+            break;
+        }
+
+        case IROPCODE_PARAM:
+        {
+            code_buffer_append_string( buffer, " " );
+            code_buffer_append_integer( buffer, instruction->param_index );
+            break;
+        }
+
+        case IROPCODE_GLOBAL:
+        {
+            code_buffer_append_string( buffer, " " );
+            code_buffer_append_string( buffer, instruction->identifier );
+            break;
+        }
+
+        case IROPCODE_CALL:
+        {
+            code_buffer_append_string( buffer, instruction->call.is_tail_call ? " tail " : " " );
+            code_buffer_append_string( buffer, instruction->call.function->function_declaration.identifier_token.as_string );
+            break;
+        }
+
+        case IROPCODE_ELEMENT:
+        {
+            if( instruction->element.is_bounds_checked )
+            {
+                code_buffer_append_string( buffer, " checked" );
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    size_t operand_count = lvec_get_length( instruction->operands );
+    for( size_t i = 0; i < operand_count; i++ )
+    {
+        code_buffer_append_string( buffer, i == 0 ? " v" : ", v" );
+        code_buffer_append_integer( buffer, instruction->operands[ i ]->index );
+    }
+
+    if( instruction->opcode == IROPCODE_JUMP || instruction->opcode == IROPCODE_BRANCH )
+    {
+        int target_count = instruction->opcode == IROPCODE_JUMP ? 1 : 2;
+        for( int i = 0; i < target_count; i++ )
+        {
+            code_buffer_append_string( buffer, i == 0 && operand_count == 0 ? " " : ", " );
+            print_block_name( buffer, instruction->targets[ i ] );
+        }
+    }
+
+    code_buffer_append_string( buffer, "\n" );
+}
+
+void ir_print_function( CodeBuffer* buffer, IrFunction* function )
+{
+    code_buffer_append_string( buffer, "func " );
+    code_buffer_append_string( buffer, function->declaration->function_declaration.identifier_token.as_string );
+    code_buffer_append_string( buffer, "\n" );
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        print_block_name( buffer, block );
+        code_buffer_append_string( buffer, ":" );
+
+        size_t predecessor_count = lvec_get_length( block->predecessors );
+        for( size_t j = 0; j < predecessor_count; j++ )
+        {
+            code_buffer_append_string( buffer, j == 0 ? " ; from " : ", " );
+            print_block_name( buffer, block->predecessors[ j ] );
+        }
+        code_buffer_append_string( buffer, "\n" );
+
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            print_instruction( buffer, block->instructions[ j ] );
+        }
+    }
+    code_buffer_append_string( buffer, "\n" );
+}
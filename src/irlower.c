@@ -0,0 +1,1575 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "debug.h"
+#include "ir.h"
+#include "lvec.h"
+#include "parser.h"
+#include "semantic.h"
+#include "symboltable.h"
+
+// the ssa form is built while the ast is lowered, as described in "simple and
+// efficient construction of static single assignment form" by braun et al.
+// a block is sealed once all of its predecessors are known, reads of a local in
+// a block that is not sealed yet get a phi whose operands are added on sealing
+
+typedef enum LocalKind
+{
+    LOCALKIND_VALUE,     // kept in ssa values
+    LOCALKIND_SLOT,      // its address is taken, so it lives in memory
+    LOCALKIND_REFERENCE, // for-loop iterators, the value is the address of an element
+} LocalKind;
+
+typedef struct Local
+{
+    char* identifier;
+    int frame_index;
+    LocalKind kind;
+    Type type; // of the variable
+    Type value_type; // of the ssa values, the address for references
+    IrInstruction* slot;
+} Local;
+
+// the value of a local at the end of a block
+typedef struct Definition
+{
+    IrBlock* block;
+    int local_index;
+    IrInstruction* value;
+} Definition;
+
+typedef struct IncompletePhi
+{
+    IrBlock* block;
+    int local_index;
+    IrInstruction* phi;
+} IncompletePhi;
+
+// a function whose body is being lowered, either the function itself or a
+// function whose call is inlined
+typedef struct Frame
+{
+    int index;
+    Expression* function;
+    char** address_taken_identifiers;
+    IrBlock* return_block; // for inlined functions
+    int result_local_index; // for inlined functions, -1 if they return nothing
+} Frame;
+
+typedef struct Lowering
+{
+    SemanticContext* context;
+    Expression* program;
+    IrFunction* function;
+    IrBlock* block; // the block instructions are appended to
+    IrBlock* tail_call_block; // where calls of the function to itself jump to
+    bool is_supported; // cleared on anything the ir cannot express
+
+    Local* locals;
+    Definition* definitions;
+    IncompletePhi* incomplete_phis;
+    IrInstruction** removed_phis; // freed at the end, they can still be on the stack
+    Frame* frames; // innermost last
+    int frame_count; // frames ever entered
+    int synthetic_count; // locals made up by the lowering
+
+    Type void_type;
+    Type bool_type;
+    Type i32_type;
+    Type u32_type;
+    Type i64_type;
+    Type u64_type;
+    Type f32_type;
+    Type f64_type;
+    Type string_type;
+} Lowering;
+
+static Type lookup_type( SemanticContext* context, char* identifier )
+{
+    return *symbol_table_lookup( context->symbol_table, identifier )->type.type.info;
+}
+
+static bool is_void( Type type )
+{
+    return type.kind == TYPEKIND_NAMED && type.named.definition->kind == TYPEKIND_VOID;
+}
+
+// the types of the values the ir can hold, compound values are left to the ast
+static bool is_supported_type( Type type )
+{
+    switch( type.kind )
+    {
+        case TYPEKIND_NAMED:
+        {
+            return type.named.definition->kind != TYPEKIND_COMPOUND;
+        }
+
+        case TYPEKIND_POINTER:
+        case TYPEKIND_REFERENCE:
+        case TYPEKIND_ARRAY:
+        {
+            return true;
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+// the type that pointers of `type` point to
+static Type get_pointee_type( Type type )
+{
+    type = ir_get_type_definition( type );
+    switch( type.kind )
+    {
+        case TYPEKIND_POINTER:   return *type.pointer.base_type;
+        case TYPEKIND_REFERENCE: return *type.reference.base_type;
+        default:                 UNREACHABLE();
+    }
+}
+
+static Type make_reference_type( Type* base_type )
+{
+    return ( Type ){
+        .kind = TYPEKIND_REFERENCE,
+        .reference.base_type = base_type,
+    };
+}
+
+static void find_unsupported( Expression* expression, void* data )
+{
+    bool* is_supported = data;
+
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_MEMBERACCESS:
+        case EXPRESSIONKIND_COMPOUNDLITERAL:
+        case EXPRESSIONKIND_FUNCTIONDECLARATION:
+        case EXPRESSIONKIND_TYPEDECLARATION:
+        case EXPRESSIONKIND_EXTERN:
+        {
+            *is_supported = false;
+            return;
+        }
+
+        // these are freed when their variable goes out of scope, which the ir
+        // does not know about
+        case EXPRESSIONKIND_ARRAYLITERAL:
+        {
+            if( expression->array_literal.storage == ARRAYSTORAGE_SCOPEDHEAP )
+            {
+                *is_supported = false;
+            }
+            break;
+        }
+
+        // loop attributes become pragmas in front of c loops
+        case EXPRESSIONKIND_CONDITIONAL:
+        {
+            if( expression->conditional.loop_attributes.flags != 0 )
+            {
+                *is_supported = false;
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_FORLOOP:
+        {
+            if( expression->for_loop.loop_attributes.flags != 0 )
+            {
+                *is_supported = false;
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        {
+            Expression* inlined_function = expression->function_call.inlined_function;
+            if( inlined_function != NULL )
+            {
+                expression_visit_children( inlined_function->function_declaration.body, find_unsupported, data );
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    expression_visit_children( expression, find_unsupported, data );
+}
+
+static void find_address_taken_identifiers( Expression* expression, void* data )
+{
+    char*** identifiers = data;
+
+    if( expression->kind == EXPRESSIONKIND_UNARY &&
+        expression->unary.operation == UNARYOPERATION_ADDRESSOF &&
+        expression->unary.operand->kind == EXPRESSIONKIND_IDENTIFIER )
+    {
+        lvec_append( *identifiers, expression->unary.operand->identifier.as_string );
+    }
+
+    // the bodies of inlined calls are frames of their own
+    expression_visit_children( expression, find_address_taken_identifiers, data );
+}
+
+static bool contains_identifier( char** identifiers, char* identifier )
+{
+    size_t length = lvec_get_length( identifiers );
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( strcmp( identifiers[ i ], identifier ) == 0 )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static Expression* find_function( Expression* program, char* identifier )
+{
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_EXTERN )
+        {
+            statement = statement->extern_expression.function;
+        }
+
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION &&
+            strcmp( statement->function_declaration.identifier_token.as_string, identifier ) == 0 )
+        {
+            return statement;
+        }
+    }
+
+    return NULL;
+}
+
+static bool is_global_variable( Expression* program, char* identifier )
+{
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_VARIABLEDECLARATION &&
+            strcmp( statement->variable_declaration.identifier_token.as_string, identifier ) == 0 )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static Frame* get_frame( Lowering* lowering )
+{
+    return &lowering->frames[ lvec_get_length( lowering->frames ) - 1 ];
+}
+
+static IrInstruction* make_instruction( Lowering* lowering, IrOpcode opcode, Type type )
+{
+    if( !is_supported_type( type ) )
+    {
+        lowering->is_supported = false;
+    }
+
+    return ir_instruction_new( lowering->function, opcode, type );
+}
+
+// appends to the current block
+static IrInstruction* emit( Lowering* lowering, IrOpcode opcode, Type type )
+{
+    IrInstruction* instruction = make_instruction( lowering, opcode, type );
+    ir_block_insert( lowering->block, instruction, lvec_get_length( lowering->block->instructions ) );
+    return instruction;
+}
+
+static IrInstruction* emit_unary( Lowering* lowering, IrOpcode opcode, Type type, IrInstruction* operand )
+{
+    IrInstruction* instruction = emit( lowering, opcode, type );
+    lvec_append( instruction->operands, operand );
+    return instruction;
+}
+
+static IrInstruction* emit_binary( Lowering* lowering, IrOpcode opcode, Type type,
+                                   IrInstruction* left, IrInstruction* right )
+{
+    IrInstruction* instruction = emit( lowering, opcode, type );
+    lvec_append( instruction->operands, left );
+    lvec_append( instruction->operands, right );
+    return instruction;
+}
+
+static IrInstruction* emit_constant( Lowering* lowering, Type type, uint64_t integer )
+{
+    IrInstruction* constant = emit( lowering, IROPCODE_CONSTANT, type );
+    constant->integer = integer;
+    return constant;
+}
+
+static IrInstruction* emit_float_constant( Lowering* lowering, Type type, double floating )
+{
+    IrInstruction* constant = emit( lowering, IROPCODE_CONSTANT, type );
+    constant->floating = floating;
+    return constant;
+}
+
+static size_t get_phi_count( IrBlock* block )
+{
+    size_t count = 0;
+    size_t length = lvec_get_length( block->instructions );
+    while( count < length && block->instructions[ count ]->opcode == IROPCODE_PHI )
+    {
+        count++;
+    }
+
+    return count;
+}
+
+// the value of locals that are read before they are written, which can only
+// happen in blocks that are never reached
+static IrInstruction* make_zero( Lowering* lowering, IrBlock* block, Type type )
+{
+    IrInstruction* zero = make_instruction( lowering, IROPCODE_CONSTANT, type );
+    if( ir_type_is_float( type ) )
+    {
+        zero->floating = 0.0;
+    }
+    ir_block_insert( block, zero, get_phi_count( block ) );
+    return zero;
+}
+
+static IrInstruction* convert( Lowering* lowering, IrInstruction* value, Type type )
+{
+    if( ir_type_equals( value->type, type ) )
+    {
+        return value;
+    }
+
+    return emit_unary( lowering, IROPCODE_CONVERT, type, value );
+}
+
+static void add_jump( Lowering* lowering, IrBlock* target )
+{
+    IrInstruction* jump = emit( lowering, IROPCODE_JUMP, lowering->void_type );
+    jump->targets[ 0 ] = target;
+    ir_add_edge( lowering->block, target );
+}
+
+static void add_branch( Lowering* lowering, IrInstruction* condition, IrBlock* true_target, IrBlock* false_target )
+{
+    IrInstruction* branch = emit_unary( lowering, IROPCODE_BRANCH, lowering->void_type, condition );
+    branch->targets[ 0 ] = true_target;
+    branch->targets[ 1 ] = false_target;
+    ir_add_edge( lowering->block, true_target );
+    ir_add_edge( lowering->block, false_target );
+}
+
+// code after a return or a jump is lowered into a block nothing jumps to
+static void start_unreachable_block( Lowering* lowering )
+{
+    lowering->block = ir_block_new( lowering->function );
+    lowering->block->is_sealed = true;
+}
+
+static int declare_local( Lowering* lowering, char* identifier, LocalKind kind, Type type, Type value_type )
+{
+    Local local = {
+        .identifier = identifier,
+        .frame_index = get_frame( lowering )->index,
+        .kind = kind,
+        .type = type,
+        .value_type = value_type,
+    };
+    lvec_append_aggregate( lowering->locals, local );
+
+    return ( int )lvec_get_length( lowering->locals ) - 1;
+}
+
+static int declare_synthetic_local( Lowering* lowering, Type type )
+{
+    // no identifier in octo can start with a space
+    char* identifier = calloc( 1, sizeof( " local " ) + 11 );
+    if( identifier == NULL ) ALLOC_ERROR();
+    sprintf( identifier, " local %d", lowering->synthetic_count );
+    lowering->synthetic_count++;
+
+    return declare_local( lowering, identifier, LOCALKIND_VALUE, type, type );
+}
+
+// the local that `identifier` refers to in the current frame, the latest one
+// because sibling scopes can declare the same name, -1 if it is not a local
+static int find_local( Lowering* lowering, char* identifier )
+{
+    int frame_index = get_frame( lowering )->index;
+    for( int i = ( int )lvec_get_length( lowering->locals ) - 1; i >= 0; i-- )
+    {
+        Local local = lowering->locals[ i ];
+        if( local.frame_index == frame_index && strcmp( local.identifier, identifier ) == 0 )
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void write_variable( Lowering* lowering, int local_index, IrBlock* block, IrInstruction* value )
+{
+    size_t length = lvec_get_length( lowering->definitions );
+    for( size_t i = 0; i < length; i++ )
+    {
+        Definition* definition = &lowering->definitions[ i ];
+        if( definition->block == block && definition->local_index == local_index )
+        {
+            definition->value = value;
+            return;
+        }
+    }
+
+    Definition definition = {
+        .block = block,
+        .local_index = local_index,
+        .value = value,
+    };
+    lvec_append_aggregate( lowering->definitions, definition );
+}
+
+static IrInstruction* read_variable( Lowering* lowering, int local_index, IrBlock* block );
+
+static IrInstruction* new_phi( Lowering* lowering, int local_index, IrBlock* block )
+{
+    IrInstruction* phi = make_instruction( lowering, IROPCODE_PHI, lowering->locals[ local_index ].value_type );
+    ir_block_insert( block, phi, get_phi_count( block ) );
+    return phi;
+}
+
+static IrInstruction* try_remove_trivial_phi( Lowering* lowering, IrInstruction* phi )
+{
+    IrInstruction* same = NULL;
+    size_t operand_count = lvec_get_length( phi->operands );
+    for( size_t i = 0; i < operand_count; i++ )
+    {
+        IrInstruction* operand = phi->operands[ i ];
+        if( operand == same || operand == phi )
+        {
+            continue;
+        }
+
+        if( same != NULL )
+        {
+            return phi; // merges at least two values
+        }
+        same = operand;
+    }
+
+    IrBlock* block = phi->block;
+    if( same == NULL )
+    {
+        same = make_zero( lowering, block, phi->type );
+    }
+
+    // the phis that used this one can become trivial in turn
+    IrInstruction** phi_users = lvec_new( IrInstruction* );
+    size_t block_count = lvec_get_length( lowering->function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* user_block = lowering->function->blocks[ i ];
+        size_t phi_count = get_phi_count( user_block );
+        for( size_t j = 0; j < phi_count; j++ )
+        {
+            IrInstruction* user = user_block->instructions[ j ];
+            if( user != phi && lvec_get_length( user->operands ) > 0 )
+            {
+                for( size_t k = 0; k < lvec_get_length( user->operands ); k++ )
+                {
+                    if( user->operands[ k ] == phi )
+                    {
+                        lvec_append( phi_users, user );
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    ir_replace_uses( lowering->function, phi, same );
+    size_t definition_count = lvec_get_length( lowering->definitions );
+    for( size_t i = 0; i < definition_count; i++ )
+    {
+        if( lowering->definitions[ i ].value == phi )
+        {
+            lowering->definitions[ i ].value = same;
+        }
+    }
+
+    ir_block_remove( block, phi );
+    phi->block = NULL;
+    lvec_append( lowering->removed_phis, phi );
+
+    size_t user_count = lvec_get_length( phi_users );
+    for( size_t i = 0; i < user_count; i++ )
+    {
+        if( phi_users[ i ]->block != NULL )
+        {
+            try_remove_trivial_phi( lowering, phi_users[ i ] );
+        }
+    }
+    lvec_free( phi_users );
+
+    // `same` itself can have been a trivial phi that was just removed
+    while( same->opcode == IROPCODE_PHI && same->block == NULL )
+    {
+        same = same->operands[ 0 ];
+    }
+
+    return same;
+}
+
+static IrInstruction* add_phi_operands( Lowering* lowering, int local_index, IrInstruction* phi )
+{
+    IrBlock* block = phi->block;
+    size_t predecessor_count = lvec_get_length( block->predecessors );
+    for( size_t i = 0; i < predecessor_count; i++ )
+    {
+        IrInstruction* operand = read_variable( lowering, local_index, block->predecessors[ i ] );
+        lvec_append( phi->operands, operand );
+    }
+
+    return try_remove_trivial_phi( lowering, phi );
+}
+
+static IrInstruction* read_variable_recursive( Lowering* lowering, int local_index, IrBlock* block )
+{
+    IrInstruction* value;
+    size_t predecessor_count = lvec_get_length( block->predecessors );
+    if( !block->is_sealed )
+    {
+        value = new_phi( lowering, local_index, block );
+        IncompletePhi incomplete_phi = {
+            .block = block,
+            .local_index = local_index,
+            .phi = value,
+        };
+        lvec_append_aggregate( lowering->incomplete_phis, incomplete_phi );
+    }
+    else if( predecessor_count == 0 )
+    {
+        value = make_zero( lowering, block, lowering->locals[ local_index ].value_type );
+    }
+    else if( predecessor_count == 1 )
+    {
+        value = read_variable( lowering, local_index, block->predecessors[ 0 ] );
+    }
+    else
+    {
+        // the phi is written first to break cycles through loops
+        IrInstruction* phi = new_phi( lowering, local_index, block );
+        write_variable( lowering, local_index, block, phi );
+        value = add_phi_operands( lowering, local_index, phi );
+    }
+
+    write_variable( lowering, local_index, block, value );
+    return value;
+}
+
+static IrInstruction* read_variable( Lowering* lowering, int local_index, IrBlock* block )
+{
+    size_t length = lvec_get_length( lowering->definitions );
+    for( size_t i = 0; i < length; i++ )
+    {
+        Definition definition = lowering->definitions[ i ];
+        if( definition.block == block && definition.local_index == local_index )
+        {
+            return definition.value;
+        }
+    }
+
+    return read_variable_recursive( lowering, local_index, block );
+}
+
+static void seal_block( Lowering* lowering, IrBlock* block )
+{
+    // adding operands can add incomplete phis of other blocks, but never of
+    // this one
+    for( size_t i = 0; i < lvec_get_length( lowering->incomplete_phis ); i++ )
+    {
+        IncompletePhi incomplete_phi = lowering->incomplete_phis[ i ];
+        if( incomplete_phi.block == block )
+        {
+            add_phi_operands( lowering, incomplete_phi.local_index, incomplete_phi.phi );
+        }
+    }
+
+    size_t kept_count = 0;
+    size_t length = lvec_get_length( lowering->incomplete_phis );
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( lowering->incomplete_phis[ i ].block != block )
+        {
+            lowering->incomplete_phis[ kept_count ] = lowering->incomplete_phis[ i ];
+            kept_count++;
+        }
+    }
+    for( size_t i = kept_count; i < length; i++ )
+    {
+        lvec_remove_last( lowering->incomplete_phis );
+    }
+
+    block->is_sealed = true;
+}
+
+static IrInstruction* lower_rvalue( Lowering* lowering, Expression* expression, Type* expected_type );
+static void lower_statement( Lowering* lowering, Expression* expression );
+
+// integers narrower than an int are operated on as ints, like in c
+static Type promote( Lowering* lowering, Type type )
+{
+    if( ir_type_is_integer( type ) && ir_type_get_bit_count( type ) < 32 )
+    {
+        return lowering->i32_type;
+    }
+
+    return type;
+}
+
+// the usual arithmetic conversions of c
+static Type get_common_type( Lowering* lowering, Type left, Type right )
+{
+    if( ir_type_is_float( left ) || ir_type_is_float( right ) )
+    {
+        bool is_double = ( ir_type_is_float( left ) && ir_type_get_bit_count( left ) == 64 ) ||
+                         ( ir_type_is_float( right ) && ir_type_get_bit_count( right ) == 64 );
+        return is_double ? lowering->f64_type : lowering->f32_type;
+    }
+
+    if( !ir_type_is_integer( left ) || !ir_type_is_integer( right ) )
+    {
+        return left; // pointers, compared as they are
+    }
+
+    left = promote( lowering, left );
+    right = promote( lowering, right );
+    int left_bit_count = ir_type_get_bit_count( left );
+    int right_bit_count = ir_type_get_bit_count( right );
+    if( left_bit_count != right_bit_count )
+    {
+        return left_bit_count > right_bit_count ? left : right;
+    }
+
+    if( ir_type_is_signed( left ) != ir_type_is_signed( right ) )
+    {
+        return left_bit_count == 64 ? lowering->u64_type : lowering->u32_type;
+    }
+
+    return left;
+}
+
+// literals have the type of an unsuffixed c literal and are converted to the
+// type they are used as, sccp folds the conversion
+static IrInstruction* convert_to_expected( Lowering* lowering, IrInstruction* value, Type* expected_type )
+{
+    if( expected_type == NULL ||
+        ( !ir_type_is_float( *expected_type ) && ir_get_type_definition( *expected_type ).kind != TYPEKIND_INTEGER ) )
+    {
+        return value;
+    }
+
+    return convert( lowering, value, *expected_type );
+}
+
+static IrInstruction* lower_integer( Lowering* lowering, Expression* expression, Type* expected_type )
+{
+    uint64_t integer = expression->integer;
+    Type type = integer <= INT32_MAX ? lowering->i32_type
+              : integer <= INT64_MAX ? lowering->i64_type
+              : lowering->u64_type;
+    return convert_to_expected( lowering, emit_constant( lowering, type, integer ), expected_type );
+}
+
+static IrInstruction* lower_float( Lowering* lowering, Expression* expression, Type* expected_type )
+{
+    IrInstruction* literal = emit_float_constant( lowering, lowering->f64_type, expression->floating );
+    return convert_to_expected( lowering, literal, expected_type );
+}
+
+static IrInstruction* lower_logical( Lowering* lowering, Expression* expression )
+{
+    bool is_and = expression->binary.operation == BINARYOPERATION_AND;
+
+    IrInstruction* left = lower_rvalue( lowering, expression->binary.left, NULL );
+    IrInstruction* short_circuit_value = emit_constant( lowering, lowering->bool_type, is_and ? 0 : 1 );
+    IrBlock* left_block = lowering->block;
+
+    IrBlock* right_block = ir_block_new( lowering->function );
+    IrBlock* join_block = ir_block_new( lowering->function );
+    if( is_and )
+    {
+        add_branch( lowering, left, right_block, join_block );
+    }
+    else
+    {
+        add_branch( lowering, left, join_block, right_block );
+    }
+
+    seal_block( lowering, right_block );
+    lowering->block = right_block;
+    IrInstruction* right = lower_rvalue( lowering, expression->binary.right, NULL );
+    add_jump( lowering, join_block );
+
+    seal_block( lowering, join_block );
+    lowering->block = join_block;
+    IrInstruction* phi = make_instruction( lowering, IROPCODE_PHI, lowering->bool_type );
+    size_t predecessor_count = lvec_get_length( join_block->predecessors );
+    for( size_t i = 0; i < predecessor_count; i++ )
+    {
+        lvec_append( phi->operands, join_block->predecessors[ i ] == left_block ? short_circuit_value : right );
+    }
+    ir_block_insert( join_block, phi, 0 );
+
+    return phi;
+}
+
+static IrInstruction* lower_binary( Lowering* lowering, Expression* expression )
+{
+    BinaryOperation operation = expression->binary.operation;
+    if( operation == BINARYOPERATION_AND || operation == BINARYOPERATION_OR )
+    {
+        return lower_logical( lowering, expression );
+    }
+
+    // the operands are converted like in c, so `f * 0.5` is computed in f64
+    // even if f is an f32
+    IrInstruction* left = lower_rvalue( lowering, expression->binary.left, NULL );
+    IrInstruction* right = lower_rvalue( lowering, expression->binary.right, NULL );
+
+    Type common_type = get_common_type( lowering, left->type, right->type );
+    left = convert( lowering, left, common_type );
+    right = convert( lowering, right, common_type );
+
+    IrOpcode opcode;
+    switch( operation )
+    {
+        case BINARYOPERATION_ADD:          opcode = IROPCODE_ADD; break;
+        case BINARYOPERATION_SUBTRACT:     opcode = IROPCODE_SUBTRACT; break;
+        case BINARYOPERATION_MULTIPLY:     opcode = IROPCODE_MULTIPLY; break;
+        case BINARYOPERATION_DIVIDE:       opcode = IROPCODE_DIVIDE; break;
+        case BINARYOPERATION_MODULO:       opcode = IROPCODE_MODULO; break;
+        case BINARYOPERATION_EQUAL:        opcode = IROPCODE_EQUAL; break;
+        case BINARYOPERATION_NOTEQUAL:     opcode = IROPCODE_NOTEQUAL; break;
+        case BINARYOPERATION_LESS:         opcode = IROPCODE_LESS; break;
+        case BINARYOPERATION_LESSEQUAL:    opcode = IROPCODE_LESSEQUAL; break;
+        case BINARYOPERATION_GREATER:      opcode = IROPCODE_GREATER; break;
+        case BINARYOPERATION_GREATEREQUAL: opcode = IROPCODE_GREATEREQUAL; break;
+        default:                           UNREACHABLE();
+    }
+
+    bool is_comparison = operation >= BINARYOPERATION_BOOLEAN_START;
+    Type type = is_comparison ? lowering->bool_type : common_type;
+    return emit_binary( lowering, opcode, type, left, right );
+}
+
+static IrInstruction* lower_element_address( Lowering* lowering, Expression* expression )
+{
+    IrInstruction* array = lower_rvalue( lowering, expression->array_subscript.lvalue, NULL );
+    IrInstruction* index = lower_rvalue( lowering, expression->array_subscript.index_rvalue, &lowering->u64_type );
+    index = convert( lowering, index, lowering->u64_type );
+
+    Type type = make_reference_type( &expression->array_subscript.element_type );
+    IrInstruction* element = emit_binary( lowering, IROPCODE_ELEMENT, type, array, index );
+    element->element.is_bounds_checked = expression->array_subscript.is_bounds_checked;
+    element->element.location_token = expression->starting_token;
+    return element;
+}
+
+static IrInstruction* lower_identifier( Lowering* lowering, Expression* expression )
+{
+    char* identifier = expression->identifier.as_string;
+    int local_index = find_local( lowering, identifier );
+    if( local_index == -1 )
+    {
+        if( !is_global_variable( lowering->program, identifier ) )
+        {
+            lowering->is_supported = false; // a function used as a value
+            return make_zero( lowering, lowering->block, lowering->i32_type );
+        }
+
+        IrInstruction* global = emit( lowering, IROPCODE_GLOBAL, make_reference_type( &expression->identifier.type ) );
+        global->identifier = identifier;
+        return emit_unary( lowering, IROPCODE_LOAD, expression->identifier.type, global );
+    }
+
+    Local local = lowering->locals[ local_index ];
+    switch( local.kind )
+    {
+        case LOCALKIND_VALUE:
+        {
+            return read_variable( lowering, local_index, lowering->block );
+        }
+
+        case LOCALKIND_SLOT:
+        {
+            return emit_unary( lowering, IROPCODE_LOAD, local.type, local.slot );
+        }
+
+        case LOCALKIND_REFERENCE:
+        {
+            IrInstruction* address = read_variable( lowering, local_index, lowering->block );
+            return emit_unary( lowering, IROPCODE_LOAD, local.type, address );
+        }
+    }
+
+    UNREACHABLE();
+}
+
+static IrInstruction* lower_address_of( Lowering* lowering, Expression* operand )
+{
+    switch( operand->kind )
+    {
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            char* identifier = operand->identifier.as_string;
+            int local_index = find_local( lowering, identifier );
+            if( local_index == -1 )
+            {
+                IrInstruction* global = emit( lowering, IROPCODE_GLOBAL, make_reference_type( &operand->identifier.type ) );
+                global->identifier = identifier;
+                return global;
+            }
+
+            Local local = lowering->locals[ local_index ];
+            if( local.kind == LOCALKIND_REFERENCE )
+            {
+                return read_variable( lowering, local_index, lowering->block );
+            }
+
+            return local.slot;
+        }
+
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            return lower_element_address( lowering, operand );
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            if( operand->unary.operation == UNARYOPERATION_DEREFERENCE )
+            {
+                return lower_rvalue( lowering, operand->unary.operand, NULL );
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    lowering->is_supported = false;
+    return make_zero( lowering, lowering->block, lowering->i32_type );
+}
+
+static IrInstruction* lower_unary( Lowering* lowering, Expression* expression, Type* expected_type )
+{
+    Expression* operand_expression = expression->unary.operand;
+    switch( expression->unary.operation )
+    {
+        case UNARYOPERATION_NEGATIVE:
+        {
+            IrInstruction* operand = lower_rvalue( lowering, operand_expression, NULL );
+            operand = convert( lowering, operand, promote( lowering, operand->type ) );
+            IrInstruction* negated = emit_unary( lowering, IROPCODE_NEGATE, operand->type, operand );
+            return convert_to_expected( lowering, negated, expected_type );
+        }
+
+        case UNARYOPERATION_NOT:
+        {
+            IrInstruction* operand = lower_rvalue( lowering, operand_expression, NULL );
+            return emit_unary( lowering, IROPCODE_NOT, lowering->bool_type, operand );
+        }
+
+        case UNARYOPERATION_ADDRESSOF:
+        {
+            return lower_address_of( lowering, operand_expression );
+        }
+
+        case UNARYOPERATION_DEREFERENCE:
+        {
+            IrInstruction* address = lower_rvalue( lowering, operand_expression, NULL );
+            return emit_unary( lowering, IROPCODE_LOAD, get_pointee_type( address->type ), address );
+        }
+    }
+
+    UNREACHABLE();
+}
+
+static IrInstruction* lower_array_literal( Lowering* lowering, Expression* expression )
+{
+    Type type = expression->array_literal.type;
+    Type base_type = *type.array.base_type;
+
+    IrInstruction** elements = lvec_new( IrInstruction* );
+    for( int i = 0; i < expression->array_literal.count_initialized; i++ )
+    {
+        Expression* rvalue = &expression->array_literal.initialized_rvalues[ i ];
+        IrInstruction* element = lower_rvalue( lowering, rvalue, &base_type );
+        lvec_append( elements, convert( lowering, element, base_type ) );
+    }
+
+    IrInstruction* literal = emit( lowering, IROPCODE_ARRAYLITERAL, type );
+    literal->array_literal.type = type;
+    literal->array_literal.storage = expression->array_literal.storage;
+    lvec_free( literal->operands );
+    literal->operands = elements;
+    return literal;
+}
+
+static void enter_frame( Lowering* lowering, Expression* function )
+{
+    Frame frame = {
+        .index = lowering->frame_count,
+        .function = function,
+        .address_taken_identifiers = lvec_new( char* ),
+        .result_local_index = -1,
+    };
+    lowering->frame_count++;
+
+    Expression* body = function->function_declaration.body;
+    expression_visit_children( body, find_address_taken_identifiers, &frame.address_taken_identifiers );
+    lvec_append_aggregate( lowering->frames, frame );
+}
+
+static void leave_frame( Lowering* lowering )
+{
+    lvec_free( get_frame( lowering )->address_taken_identifiers );
+    lvec_remove_last( lowering->frames );
+}
+
+// variables whose address is taken get a slot in the entry block
+static int declare_variable( Lowering* lowering, char* identifier, Type* type, IrInstruction* value )
+{
+    Frame* frame = get_frame( lowering );
+    if( contains_identifier( frame->address_taken_identifiers, identifier ) )
+    {
+        int local_index = declare_local( lowering, identifier, LOCALKIND_SLOT, *type, *type );
+        IrBlock* entry = lowering->function->blocks[ 0 ];
+        IrInstruction* slot = make_instruction( lowering, IROPCODE_SLOT, make_reference_type( type ) );
+        ir_block_insert( entry, slot, get_phi_count( entry ) );
+        lowering->locals[ local_index ].slot = slot;
+
+        IrInstruction* store = emit_binary( lowering, IROPCODE_STORE, lowering->void_type, slot, value );
+        ( void )store;
+        return local_index;
+    }
+
+    int local_index = declare_local( lowering, identifier, LOCALKIND_VALUE, *type, *type );
+    write_variable( lowering, local_index, lowering->block, value );
+    return local_index;
+}
+
+static void bind_params( Lowering* lowering, Expression* function, IrInstruction** arguments )
+{
+    int param_count = function->function_declaration.param_count;
+    for( int i = 0; i < param_count; i++ )
+    {
+        char* identifier = function->function_declaration.param_identifiers_tokens[ i ].as_string;
+        declare_variable( lowering, identifier, &function->function_declaration.param_types[ i ], arguments[ i ] );
+    }
+}
+
+static IrInstruction** lower_arguments( Lowering* lowering, Expression* call, Expression* function )
+{
+    IrInstruction** arguments = lvec_new( IrInstruction* );
+    int param_count = function->function_declaration.param_count;
+    for( size_t i = 0; i < call->function_call.arg_count; i++ )
+    {
+        Expression* argument_expression = &call->function_call.args[ i ];
+        if( ( int )i < param_count )
+        {
+            Type param_type = function->function_declaration.param_types[ i ];
+            IrInstruction* argument = lower_rvalue( lowering, argument_expression, &param_type );
+            lvec_append( arguments, convert( lowering, argument, param_type ) );
+            continue;
+        }
+
+        // variadic arguments get the default argument promotions of c
+        IrInstruction* argument = lower_rvalue( lowering, argument_expression, NULL );
+        Type promoted_type = ir_type_is_float( argument->type ) ? lowering->f64_type : promote( lowering, argument->type );
+        lvec_append( arguments, convert( lowering, argument, promoted_type ) );
+    }
+
+    return arguments;
+}
+
+static IrInstruction* lower_inlined_call( Lowering* lowering, Expression* call, Expression* function )
+{
+    IrInstruction** arguments = lower_arguments( lowering, call, function );
+
+    enter_frame( lowering, function );
+    Frame* frame = get_frame( lowering );
+    frame->return_block = ir_block_new( lowering->function );
+
+    Type return_type = function->function_declaration.return_type;
+    if( !is_void( return_type ) )
+    {
+        frame->result_local_index = declare_synthetic_local( lowering, return_type );
+    }
+
+    bind_params( lowering, function, arguments );
+    lvec_free( arguments );
+
+    lower_statement( lowering, function->function_declaration.body );
+
+    frame = get_frame( lowering );
+    IrBlock* return_block = frame->return_block;
+    add_jump( lowering, return_block );
+    seal_block( lowering, return_block );
+    lowering->block = return_block;
+
+    IrInstruction* result = NULL;
+    if( frame->result_local_index != -1 )
+    {
+        result = read_variable( lowering, frame->result_local_index, return_block );
+    }
+
+    leave_frame( lowering );
+    return result;
+}
+
+static IrInstruction* lower_call( Lowering* lowering, Expression* call, bool is_tail_call )
+{
+    Expression* function = find_function( lowering->program, call->function_call.identifier_token.as_string );
+    if( function == NULL )
+    {
+        lowering->is_supported = false;
+        return make_zero( lowering, lowering->block, lowering->i32_type );
+    }
+
+    if( call->function_call.inlined_function != NULL )
+    {
+        return lower_inlined_call( lowering, call, function );
+    }
+
+    IrInstruction** arguments = lower_arguments( lowering, call, function );
+    IrInstruction* instruction = emit( lowering, IROPCODE_CALL, function->function_declaration.return_type );
+    instruction->call.function = function;
+    instruction->call.is_tail_call = is_tail_call;
+    lvec_free( instruction->operands );
+    instruction->operands = arguments;
+
+    return is_void( instruction->type ) ? NULL : instruction;
+}
+
+static IrInstruction* lower_rvalue( Lowering* lowering, Expression* expression, Type* expected_type )
+{
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_INTEGER:
+        {
+            return lower_integer( lowering, expression, expected_type );
+        }
+
+        case EXPRESSIONKIND_FLOAT:
+        {
+            return lower_float( lowering, expression, expected_type );
+        }
+
+        case EXPRESSIONKIND_BOOLEAN:
+        {
+            return emit_constant( lowering, lowering->bool_type, expression->boolean ? 1 : 0 );
+        }
+
+        case EXPRESSIONKIND_CHARACTER:
+        {
+            Type char_type = lookup_type( lowering->context, "char" );
+            return emit_constant( lowering, char_type, ( uint64_t )( int64_t )expression->character );
+        }
+
+        case EXPRESSIONKIND_STRING:
+        {
+            IrInstruction* string = emit( lowering, IROPCODE_STRING, lowering->string_type );
+            string->string = expression->string;
+            return string;
+        }
+
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            return lower_identifier( lowering, expression );
+        }
+
+        case EXPRESSIONKIND_BINARY:
+        {
+            return lower_binary( lowering, expression );
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            return lower_unary( lowering, expression, expected_type );
+        }
+
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        {
+            return lower_call( lowering, expression, false );
+        }
+
+        case EXPRESSIONKIND_ARRAYLITERAL:
+        {
+            return lower_array_literal( lowering, expression );
+        }
+
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            IrInstruction* address = lower_element_address( lowering, expression );
+            return emit_unary( lowering, IROPCODE_LOAD, expression->array_subscript.element_type, address );
+        }
+
+        default:
+        {
+            lowering->is_supported = false;
+            return make_zero( lowering, lowering->block, lowering->i32_type );
+        }
+    }
+}
+
+static void lower_variable_declaration( Lowering* lowering, Expression* expression )
+{
+    Type* type = &expression->variable_declaration.variable_type;
+    Expression* rvalue = expression->variable_declaration.rvalue;
+
+    IrInstruction* value;
+    if( rvalue != NULL )
+    {
+        value = convert( lowering, lower_rvalue( lowering, rvalue, type ), *type );
+    }
+    else if( type->kind == TYPEKIND_ARRAY )
+    {
+        value = emit( lowering, IROPCODE_ARRAYLITERAL, *type );
+        value->array_literal.type = *type;
+        value->array_literal.storage = ARRAYSTORAGE_AUTOMATIC;
+    }
+    else
+    {
+        value = make_zero( lowering, lowering->block, *type );
+    }
+
+    declare_variable( lowering, expression->variable_declaration.identifier_token.as_string, type, value );
+}
+
+static void lower_assignment( Lowering* lowering, Expression* expression )
+{
+    Expression* lvalue = expression->assignment.lvalue;
+    Expression* rvalue = expression->assignment.rvalue;
+
+    IrInstruction* address;
+    Type type;
+    switch( lvalue->kind )
+    {
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            char* identifier = lvalue->identifier.as_string;
+            int local_index = find_local( lowering, identifier );
+            if( local_index != -1 && lowering->locals[ local_index ].kind == LOCALKIND_VALUE )
+            {
+                Type local_type = lowering->locals[ local_index ].type;
+                IrInstruction* value = convert( lowering, lower_rvalue( lowering, rvalue, &local_type ), local_type );
+                write_variable( lowering, local_index, lowering->block, value );
+                return;
+            }
+
+            address = lower_address_of( lowering, lvalue );
+            type = local_index != -1 ? lowering->locals[ local_index ].type : lvalue->identifier.type;
+            break;
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            if( lvalue->unary.operation != UNARYOPERATION_DEREFERENCE )
+            {
+                lowering->is_supported = false;
+                return;
+            }
+
+            address = lower_rvalue( lowering, lvalue->unary.operand, NULL );
+            type = get_pointee_type( address->type );
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            address = lower_element_address( lowering, lvalue );
+            type = lvalue->array_subscript.element_type;
+            break;
+        }
+
+        default:
+        {
+            lowering->is_supported = false;
+            return;
+        }
+    }
+
+    IrInstruction* value = convert( lowering, lower_rvalue( lowering, rvalue, &type ), type );
+    emit_binary( lowering, IROPCODE_STORE, lowering->void_type, address, value );
+}
+
+static void lower_return( Lowering* lowering, Expression* expression )
+{
+    Frame* frame = get_frame( lowering );
+    Expression* function = frame->function;
+    Type return_type = function->function_declaration.return_type;
+    Expression* rvalue = expression->return_expression.rvalue;
+    bool is_inlined = lvec_get_length( lowering->frames ) > 1;
+
+    // the params are assigned the arguments and the body starts over
+    if( !is_inlined && expression->return_expression.tail_call == TAILCALL_SELF )
+    {
+        IrInstruction** arguments = lower_arguments( lowering, rvalue, function );
+        int param_count = function->function_declaration.param_count;
+        for( int i = 0; i < param_count; i++ )
+        {
+            char* identifier = function->function_declaration.param_identifiers_tokens[ i ].as_string;
+            int local_index = find_local( lowering, identifier );
+            Local local = lowering->locals[ local_index ];
+            if( local.kind == LOCALKIND_SLOT )
+            {
+                emit_binary( lowering, IROPCODE_STORE, lowering->void_type, local.slot, arguments[ i ] );
+            }
+            else
+            {
+                write_variable( lowering, local_index, lowering->block, arguments[ i ] );
+            }
+        }
+        lvec_free( arguments );
+
+        add_jump( lowering, lowering->tail_call_block );
+        start_unreachable_block( lowering );
+        return;
+    }
+
+    IrInstruction* value = NULL;
+    if( rvalue != NULL )
+    {
+        bool is_tail_call = !is_inlined && expression->return_expression.tail_call == TAILCALL_OTHER;
+        if( is_tail_call )
+        {
+            value = lower_call( lowering, rvalue, true );
+        }
+        else
+        {
+            value = lower_rvalue( lowering, rvalue, &return_type );
+        }
+
+        if( value != NULL )
+        {
+            value = convert( lowering, value, return_type );
+        }
+    }
+
+    // lowering the value can have entered frames and moved them
+    frame = get_frame( lowering );
+    if( is_inlined )
+    {
+        if( value != NULL )
+        {
+            write_variable( lowering, frame->result_local_index, lowering->block, value );
+        }
+        add_jump( lowering, frame->return_block );
+    }
+    else
+    {
+        IrInstruction* instruction = emit( lowering, IROPCODE_RETURN, lowering->void_type );
+        if( value != NULL )
+        {
+            lvec_append( instruction->operands, value );
+        }
+    }
+
+    start_unreachable_block( lowering );
+}
+
+static void lower_conditional( Lowering* lowering, Expression* expression )
+{
+    if( expression->conditional.is_loop )
+    {
+        IrBlock* header_block = ir_block_new( lowering->function );
+        add_jump( lowering, header_block );
+        lowering->block = header_block;
+
+        IrInstruction* condition = lower_rvalue( lowering, expression->conditional.condition, NULL );
+        IrBlock* body_block = ir_block_new( lowering->function );
+        IrBlock* exit_block = ir_block_new( lowering->function );
+        add_branch( lowering, condition, body_block, exit_block );
+
+        seal_block( lowering, body_block );
+        lowering->block = body_block;
+        lower_statement( lowering, expression->conditional.true_body );
+        add_jump( lowering, header_block );
+        seal_block( lowering, header_block );
+
+        seal_block( lowering, exit_block );
+        lowering->block = exit_block;
+        return;
+    }
+
+    IrInstruction* condition = lower_rvalue( lowering, expression->conditional.condition, NULL );
+    IrBlock* true_block = ir_block_new( lowering->function );
+    IrBlock* join_block = ir_block_new( lowering->function );
+    Expression* false_body = expression->conditional.false_body;
+    IrBlock* false_block = false_body != NULL ? ir_block_new( lowering->function ) : join_block;
+    add_branch( lowering, condition, true_block, false_block );
+
+    seal_block( lowering, true_block );
+    lowering->block = true_block;
+    lower_statement( lowering, expression->conditional.true_body );
+    add_jump( lowering, join_block );
+
+    if( false_body != NULL )
+    {
+        seal_block( lowering, false_block );
+        lowering->block = false_block;
+        lower_statement( lowering, false_body );
+        add_jump( lowering, join_block );
+    }
+
+    seal_block( lowering, join_block );
+    lowering->block = join_block;
+}
+
+// a counted loop over the elements, the iterator is the address of the
+// current one
+static void lower_for_loop( Lowering* lowering, Expression* expression )
+{
+    IrInstruction* iterable = lower_rvalue( lowering, expression->for_loop.iterable_rvalue, NULL );
+    IrInstruction* length = emit_unary( lowering, IROPCODE_ARRAYLENGTH, lowering->u64_type, iterable );
+
+    int index_local = declare_synthetic_local( lowering, lowering->u64_type );
+    write_variable( lowering, index_local, lowering->block, emit_constant( lowering, lowering->u64_type, 0 ) );
+
+    IrBlock* header_block = ir_block_new( lowering->function );
+    add_jump( lowering, header_block );
+    lowering->block = header_block;
+
+    IrInstruction* index = read_variable( lowering, index_local, header_block );
+    IrInstruction* condition = emit_binary( lowering, IROPCODE_LESS, lowering->bool_type, index, length );
+    IrBlock* body_block = ir_block_new( lowering->function );
+    IrBlock* exit_block = ir_block_new( lowering->function );
+    add_branch( lowering, condition, body_block, exit_block );
+
+    seal_block( lowering, body_block );
+    lowering->block = body_block;
+
+    Type iterator_type = expression->for_loop.iterator_type;
+    IrInstruction* element = emit_binary( lowering, IROPCODE_ELEMENT, iterator_type, iterable, index );
+    int iterator_local = declare_local( lowering, expression->for_loop.iterator_token.as_string, LOCALKIND_REFERENCE,
+                                        *iterator_type.reference.base_type, iterator_type );
+    write_variable( lowering, iterator_local, body_block, element );
+
+    lower_statement( lowering, expression->for_loop.body );
+
+    IrInstruction* next_index = read_variable( lowering, index_local, lowering->block );
+    IrInstruction* one = emit_constant( lowering, lowering->u64_type, 1 );
+    next_index = emit_binary( lowering, IROPCODE_ADD, lowering->u64_type, next_index, one );
+    write_variable( lowering, index_local, lowering->block, next_index );
+    add_jump( lowering, header_block );
+    seal_block( lowering, header_block );
+
+    seal_block( lowering, exit_block );
+    lowering->block = exit_block;
+}
+
+static void lower_statement( Lowering* lowering, Expression* expression )
+{
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_VARIABLEDECLARATION:
+        {
+            lower_variable_declaration( lowering, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_COMPOUND:
+        {
+            size_t length = lvec_get_length( expression->compound.expressions );
+            for( size_t i = 0; i < length; i++ )
+            {
+                lower_statement( lowering, expression->compound.expressions[ i ] );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_RETURN:
+        {
+            lower_return( lowering, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_ASSIGNMENT:
+        {
+            lower_assignment( lowering, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        {
+            lower_call( lowering, expression, false );
+            break;
+        }
+
+        case EXPRESSIONKIND_CONDITIONAL:
+        {
+            lower_conditional( lowering, expression );
+            break;
+        }
+
+        case EXPRESSIONKIND_FORLOOP:
+        {
+            lower_for_loop( lowering, expression );
+            break;
+        }
+
+        default:
+        {
+            lowering->is_supported = false;
+            break;
+        }
+    }
+}
+
+IrFunction* ir_lower_function( SemanticContext* context, Expression* program, Expression* function )
+{
+    Expression* body = function->function_declaration.body;
+    bool is_supported = true;
+    expression_visit_children( body, find_unsupported, &is_supported );
+    if( !is_supported )
+    {
+        return NULL;
+    }
+
+    IrFunction* ir_function = calloc( 1, sizeof( IrFunction ) );
+    if( ir_function == NULL ) ALLOC_ERROR();
+    ir_function->declaration = function;
+    ir_function->blocks = lvec_new( IrBlock* );
+
+    Type* char_type_info = symbol_table_lookup( context->symbol_table, "char" )->type.type.info;
+    Lowering lowering = {
+        .context = context,
+        .program = program,
+        .function = ir_function,
+        .is_supported = true,
+        .locals = lvec_new( Local ),
+        .definitions = lvec_new( Definition ),
+        .incomplete_phis = lvec_new( IncompletePhi ),
+        .removed_phis = lvec_new( IrInstruction* ),
+        .frames = lvec_new( Frame ),
+        .void_type = lookup_type( context, "void" ),
+        .bool_type = lookup_type( context, "bool" ),
+        .i32_type = lookup_type( context, "i32" ),
+        .u32_type = lookup_type( context, "u32" ),
+        .i64_type = lookup_type( context, "i64" ),
+        .u64_type = lookup_type( context, "u64" ),
+        .f32_type = lookup_type( context, "f32" ),
+        .f64_type = lookup_type( context, "f64" ),
+        .string_type = {
+            .kind = TYPEKIND_POINTER,
+            .pointer.base_type = char_type_info,
+        },
+    };
+
+    lowering.block = ir_block_new( ir_function );
+    lowering.block->is_sealed = true;
+    enter_frame( &lowering, function );
+
+    int param_count = function->function_declaration.param_count;
+    IrInstruction** params = lvec_new( IrInstruction* );
+    for( int i = 0; i < param_count; i++ )
+    {
+        IrInstruction* param = emit( &lowering, IROPCODE_PARAM, function->function_declaration.param_types[ i ] );
+        param->param_index = i;
+        lvec_append( params, param );
+    }
+    bind_params( &lowering, function, params );
+    lvec_free( params );
+
+    if( function->function_declaration.has_self_tail_call )
+    {
+        lowering.tail_call_block = ir_block_new( ir_function );
+        add_jump( &lowering, lowering.tail_call_block );
+        lowering.block = lowering.tail_call_block;
+    }
+
+    lower_statement( &lowering, body );
+
+    // falling off the end of a function that returns a value is undefined, the
+    // zero is as good as anything
+    Type return_type = function->function_declaration.return_type;
+    IrInstruction* final_return = emit( &lowering, IROPCODE_RETURN, lowering.void_type );
+    if( !is_void( return_type ) )
+    {
+        lvec_append( final_return->operands, make_zero( &lowering, lowering.block, return_type ) );
+    }
+
+    if( lowering.tail_call_block != NULL )
+    {
+        seal_block( &lowering, lowering.tail_call_block );
+    }
+    leave_frame( &lowering );
+
+    size_t local_count = lvec_get_length( lowering.locals );
+    for( size_t i = 0; i < local_count; i++ )
+    {
+        if( lowering.locals[ i ].identifier[ 0 ] == ' ' )
+        {
+            free( lowering.locals[ i ].identifier );
+        }
+    }
+
+    size_t removed_count = lvec_get_length( lowering.removed_phis );
+    for( size_t i = 0; i < removed_count; i++ )
+    {
+        ir_instruction_free( lowering.removed_phis[ i ] );
+    }
+
+    lvec_free( lowering.locals );
+    lvec_free( lowering.definitions );
+    lvec_free( lowering.incomplete_phis );
+    lvec_free( lowering.removed_phis );
+    lvec_free( lowering.frames );
+
+    if( !lowering.is_supported )
+    {
+        ir_function_free( ir_function );
+        return NULL;
+    }
+
+    ir_remove_unreachable_blocks( ir_function );
+    return ir_function;
+}
+
+void ir_lower_program( SemanticContext* context, Expression* program )
+{
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind != EXPRESSIONKIND_FUNCTIONDECLARATION || !statement->function_declaration.is_reachable )
+        {
+            continue;
+        }
+
+        IrFunction* function = ir_lower_function( context, program, statement );
+        if( function != NULL )
+        {
+            ir_optimize( function );
+            statement->function_declaration.ir = function;
+        }
+    }
+}
@@ -0,0 +1,1269 @@
+#include <stdlib.h>
+#include <string.h>
+#include "debug.h"
+#include "ir.h"
+#include "lvec.h"
+
+// removes `instruction` from its block and frees it, it must not be used anymore
+static void delete_instruction( IrInstruction* instruction )
+{
+    ir_block_remove( instruction->block, instruction );
+    ir_instruction_free( instruction );
+}
+
+static bool is_trivial_phi( IrInstruction* phi, IrInstruction** same )
+{
+    *same = NULL;
+    size_t operand_count = lvec_get_length( phi->operands );
+    for( size_t i = 0; i < operand_count; i++ )
+    {
+        IrInstruction* operand = phi->operands[ i ];
+        if( operand == phi || operand == *same )
+        {
+            continue;
+        }
+
+        if( *same != NULL )
+        {
+            return false;
+        }
+        *same = operand;
+    }
+
+    return *same != NULL;
+}
+
+// copies, phis that merge a single value and conversions to the same c type
+// are replaced by their operand
+void ir_propagate_copies( IrFunction* function )
+{
+    bool has_changed = true;
+    while( has_changed )
+    {
+        has_changed = false;
+
+        size_t block_count = lvec_get_length( function->blocks );
+        for( size_t i = 0; i < block_count; i++ )
+        {
+            IrBlock* block = function->blocks[ i ];
+            for( size_t j = 0; j < lvec_get_length( block->instructions ); j++ )
+            {
+                IrInstruction* instruction = block->instructions[ j ];
+                IrInstruction* source = NULL;
+                switch( instruction->opcode )
+                {
+                    case IROPCODE_COPY:
+                    {
+                        source = instruction->operands[ 0 ];
+                        break;
+                    }
+
+                    case IROPCODE_CONVERT:
+                    {
+                        if( ir_type_equals( instruction->type, instruction->operands[ 0 ]->type ) )
+                        {
+                            source = instruction->operands[ 0 ];
+                        }
+                        break;
+                    }
+
+                    case IROPCODE_PHI:
+                    {
+                        IrInstruction* same;
+                        if( is_trivial_phi( instruction, &same ) )
+                        {
+                            source = same;
+                        }
+                        break;
+                    }
+
+                    default:
+                    {
+                        break;
+                    }
+                }
+
+                if( source != NULL )
+                {
+                    ir_replace_uses( function, instruction, source );
+                    delete_instruction( instruction );
+                    has_changed = true;
+                    j--;
+                }
+            }
+        }
+    }
+}
+
+// constant propagation over the lattice top > constant > bottom, only along the
+// edges that can be taken, as in "constant propagation with conditional
+// branches" by wegman and zadeck. the values are updated in reverse postorder
+// until nothing changes, which for the functions octo programs have is as
+// fast as keeping worklists
+typedef enum LatticeKind
+{
+    LATTICEKIND_TOP,      // not known yet
+    LATTICEKIND_CONSTANT,
+    LATTICEKIND_BOTTOM,   // known not to be constant
+} LatticeKind;
+
+typedef struct LatticeValue
+{
+    LatticeKind kind;
+    uint64_t integer;
+    double floating;
+} LatticeValue;
+
+static bool is_numeric( Type type )
+{
+    return ir_type_is_integer( type ) || ir_type_is_float( type );
+}
+
+// the bits of `integer` as a value of `type`, sign-extended for signed types
+static uint64_t normalize( Type type, uint64_t integer )
+{
+    if( ir_get_type_definition( type ).kind == TYPEKIND_BOOLEAN )
+    {
+        return integer != 0;
+    }
+
+    int bit_count = ir_type_get_bit_count( type );
+    if( bit_count == 64 )
+    {
+        return integer;
+    }
+
+    uint64_t mask = ( 1ULL << bit_count ) - 1;
+    integer &= mask;
+    if( ir_type_is_signed( type ) && ( integer >> ( bit_count - 1 ) ) & 1 )
+    {
+        integer |= ~mask;
+    }
+
+    return integer;
+}
+
+static bool fold_float_binary( IrOpcode opcode, bool is_f32, double left, double right, LatticeValue* result )
+{
+    switch( opcode )
+    {
+        case IROPCODE_ADD:          result->floating = is_f32 ? ( float )left + ( float )right : left + right; break;
+        case IROPCODE_SUBTRACT:     result->floating = is_f32 ? ( float )left - ( float )right : left - right; break;
+        case IROPCODE_MULTIPLY:     result->floating = is_f32 ? ( float )left * ( float )right : left * right; break;
+        case IROPCODE_EQUAL:        result->integer = left == right; break;
+        case IROPCODE_NOTEQUAL:     result->integer = left != right; break;
+        case IROPCODE_LESS:         result->integer = left < right; break;
+        case IROPCODE_LESSEQUAL:    result->integer = left <= right; break;
+        case IROPCODE_GREATER:      result->integer = left > right; break;
+        case IROPCODE_GREATEREQUAL: result->integer = left >= right; break;
+
+        case IROPCODE_DIVIDE:
+        {
+            if( right == 0.0 )
+            {
+                return false;
+            }
+            result->floating = is_f32 ? ( float )left / ( float )right : left / right;
+            break;
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool fold_integer_binary( IrOpcode opcode, Type type, uint64_t left, uint64_t right, LatticeValue* result )
+{
+    bool is_signed = ir_type_is_signed( type );
+    int64_t signed_left = ( int64_t )left;
+    int64_t signed_right = ( int64_t )right;
+
+    switch( opcode )
+    {
+        // wrap around like the machine does
+        case IROPCODE_ADD:      result->integer = normalize( type, left + right ); break;
+        case IROPCODE_SUBTRACT: result->integer = normalize( type, left - right ); break;
+        case IROPCODE_MULTIPLY: result->integer = normalize( type, left * right ); break;
+
+        case IROPCODE_DIVIDE:
+        case IROPCODE_MODULO:
+        {
+            // left for the program to fail on
+            int bit_count = ir_type_get_bit_count( type );
+            int64_t minimum = bit_count == 64 ? INT64_MIN : -( ( int64_t )1 << ( bit_count - 1 ) );
+            if( right == 0 || ( is_signed && signed_left == minimum && signed_right == -1 ) )
+            {
+                return false;
+            }
+
+            bool is_divide = opcode == IROPCODE_DIVIDE;
+            if( is_signed )
+            {
+                int64_t quotient = is_divide ? signed_left / signed_right : signed_left % signed_right;
+                result->integer = normalize( type, ( uint64_t )quotient );
+            }
+            else
+            {
+                result->integer = normalize( type, is_divide ? left / right : left % right );
+            }
+            break;
+        }
+
+        case IROPCODE_EQUAL:        result->integer = left == right; break;
+        case IROPCODE_NOTEQUAL:     result->integer = left != right; break;
+        case IROPCODE_LESS:         result->integer = is_signed ? signed_left < signed_right : left < right; break;
+        case IROPCODE_LESSEQUAL:    result->integer = is_signed ? signed_left <= signed_right : left <= right; break;
+        case IROPCODE_GREATER:      result->integer = is_signed ? signed_left > signed_right : left > right; break;
+        case IROPCODE_GREATEREQUAL: result->integer = is_signed ? signed_left >= signed_right : left >= right; break;
+
+        default:
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool fold_convert( Type from, Type to, LatticeValue operand, LatticeValue* result )
+{
+    bool is_to_f32 = ir_type_is_float( to ) && ir_type_get_bit_count( to ) == 32;
+    if( ir_type_is_integer( from ) && ir_type_is_integer( to ) )
+    {
+        result->integer = normalize( to, operand.integer );
+    }
+    else if( ir_type_is_integer( from ) && ir_type_is_float( to ) )
+    {
+        if( ir_type_is_signed( from ) )
+        {
+            int64_t integer = ( int64_t )operand.integer;
+            result->floating = is_to_f32 ? ( double )( float )integer : ( double )integer;
+        }
+        else
+        {
+            result->floating = is_to_f32 ? ( double )( float )operand.integer : ( double )operand.integer;
+        }
+    }
+    else if( ir_type_is_float( from ) && ir_type_is_float( to ) )
+    {
+        result->floating = is_to_f32 ? ( double )( float )operand.floating : operand.floating;
+    }
+    else if( ir_type_is_float( from ) && ir_type_is_integer( to ) )
+    {
+        double floating = operand.floating;
+        if( ir_get_type_definition( to ).kind == TYPEKIND_BOOLEAN )
+        {
+            result->integer = floating != 0.0;
+            return true;
+        }
+
+        // values that do not fit are undefined in c, they are left alone
+        int bit_count = ir_type_get_bit_count( to );
+        if( ir_type_is_signed( to ) )
+        {
+            double limit = ( double )( 1ULL << ( bit_count - 1 ) );
+            if( !( floating > -limit - 1.0 && floating < limit ) )
+            {
+                return false;
+            }
+            result->integer = normalize( to, ( uint64_t )( int64_t )floating );
+        }
+        else
+        {
+            double limit = ( double )( 1ULL << ( bit_count - 1 ) ) * 2.0;
+            if( !( floating > -1.0 && floating < limit ) )
+            {
+                return false;
+            }
+            result->integer = ( uint64_t )floating;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+static LatticeValue evaluate( IrInstruction* instruction, LatticeValue* values )
+{
+    LatticeValue bottom = { .kind = LATTICEKIND_BOTTOM };
+    LatticeValue top = { .kind = LATTICEKIND_TOP };
+    LatticeValue result = { .kind = LATTICEKIND_CONSTANT };
+
+    if( !is_numeric( instruction->type ) )
+    {
+        return bottom;
+    }
+
+    switch( instruction->opcode )
+    {
+        case IROPCODE_CONSTANT:
+        {
+            result.integer = instruction->integer;
+            result.floating = instruction->floating;
+            return result;
+        }
+
+        case IROPCODE_COPY:
+        {
+            return values[ instruction->operands[ 0 ]->index ];
+        }
+
+        case IROPCODE_CONVERT:
+        case IROPCODE_NEGATE:
+        case IROPCODE_NOT:
+        {
+            IrInstruction* operand = instruction->operands[ 0 ];
+            LatticeValue value = values[ operand->index ];
+            if( value.kind != LATTICEKIND_CONSTANT )
+            {
+                return value;
+            }
+
+            if( instruction->opcode == IROPCODE_CONVERT )
+            {
+                return fold_convert( operand->type, instruction->type, value, &result ) ? result : bottom;
+            }
+
+            if( instruction->opcode == IROPCODE_NOT )
+            {
+                result.integer = value.integer == 0;
+            }
+            else if( ir_type_is_float( instruction->type ) )
+            {
+                result.floating = -value.floating;
+            }
+            else
+            {
+                result.integer = normalize( instruction->type, 0 - value.integer );
+            }
+            return result;
+        }
+
+        case IROPCODE_ADD:
+        case IROPCODE_SUBTRACT:
+        case IROPCODE_MULTIPLY:
+        case IROPCODE_DIVIDE:
+        case IROPCODE_MODULO:
+        case IROPCODE_EQUAL:
+        case IROPCODE_NOTEQUAL:
+        case IROPCODE_LESS:
+        case IROPCODE_LESSEQUAL:
+        case IROPCODE_GREATER:
+        case IROPCODE_GREATEREQUAL:
+        {
+            Type operand_type = instruction->operands[ 0 ]->type;
+            LatticeValue left = values[ instruction->operands[ 0 ]->index ];
+            LatticeValue right = values[ instruction->operands[ 1 ]->index ];
+            if( left.kind == LATTICEKIND_BOTTOM || right.kind == LATTICEKIND_BOTTOM || !is_numeric( operand_type ) )
+            {
+                return bottom;
+            }
+            if( left.kind == LATTICEKIND_TOP || right.kind == LATTICEKIND_TOP )
+            {
+                return top;
+            }
+
+            bool has_folded;
+            if( ir_type_is_float( operand_type ) )
+            {
+                bool is_f32 = ir_type_get_bit_count( operand_type ) == 32;
+                has_folded = fold_float_binary( instruction->opcode, is_f32, left.floating, right.floating, &result );
+            }
+            else
+            {
+                has_folded = fold_integer_binary( instruction->opcode, operand_type, left.integer, right.integer, &result );
+            }
+            return has_folded ? result : bottom;
+        }
+
+        default:
+        {
+            return bottom;
+        }
+    }
+}
+
+static LatticeValue meet( Type type, LatticeValue v1, LatticeValue v2 )
+{
+    if( v1.kind == LATTICEKIND_TOP )
+    {
+        return v2;
+    }
+    if( v2.kind == LATTICEKIND_TOP )
+    {
+        return v1;
+    }
+
+    bool is_same = ir_type_is_float( type )
+                 ? memcmp( &v1.floating, &v2.floating, sizeof( double ) ) == 0
+                 : v1.integer == v2.integer;
+    if( v1.kind == LATTICEKIND_CONSTANT && v2.kind == LATTICEKIND_CONSTANT && is_same )
+    {
+        return v1;
+    }
+
+    return ( LatticeValue ){ .kind = LATTICEKIND_BOTTOM };
+}
+
+static bool lattice_equals( LatticeValue v1, LatticeValue v2 )
+{
+    return v1.kind == v2.kind && v1.integer == v2.integer &&
+           memcmp( &v1.floating, &v2.floating, sizeof( double ) ) == 0;
+}
+
+// marks the edges from `block` to `successor` as taken
+static bool mark_edge( bool** is_edge_executable, IrBlock* block, IrBlock* successor )
+{
+    bool has_changed = false;
+    size_t predecessor_count = lvec_get_length( successor->predecessors );
+    for( size_t i = 0; i < predecessor_count; i++ )
+    {
+        if( successor->predecessors[ i ] == block && !is_edge_executable[ successor->index ][ i ] )
+        {
+            is_edge_executable[ successor->index ][ i ] = true;
+            has_changed = true;
+        }
+    }
+
+    return has_changed;
+}
+
+void ir_propagate_constants( IrFunction* function )
+{
+    ir_remove_unreachable_blocks( function );
+
+    LatticeValue* values = calloc( function->instruction_count, sizeof( LatticeValue ) );
+    bool* is_block_executable = calloc( function->block_count, sizeof( bool ) );
+    bool** is_edge_executable = calloc( function->block_count, sizeof( bool* ) );
+    if( values == NULL || is_block_executable == NULL || is_edge_executable == NULL ) ALLOC_ERROR();
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        is_edge_executable[ block->index ] = calloc( lvec_get_length( block->predecessors ) + 1, sizeof( bool ) );
+        if( is_edge_executable[ block->index ] == NULL ) ALLOC_ERROR();
+    }
+    is_block_executable[ function->blocks[ 0 ]->index ] = true;
+
+    bool has_changed = true;
+    while( has_changed )
+    {
+        has_changed = false;
+        for( size_t i = 0; i < block_count; i++ )
+        {
+            IrBlock* block = function->blocks[ i ];
+            if( !is_block_executable[ block->index ] )
+            {
+                continue;
+            }
+
+            size_t length = lvec_get_length( block->instructions );
+            for( size_t j = 0; j < length; j++ )
+            {
+                IrInstruction* instruction = block->instructions[ j ];
+                LatticeValue value;
+                if( instruction->opcode == IROPCODE_PHI )
+                {
+                    value = ( LatticeValue ){ .kind = LATTICEKIND_TOP };
+                    size_t operand_count = lvec_get_length( instruction->operands );
+                    for( size_t k = 0; k < operand_count; k++ )
+                    {
+                        if( is_edge_executable[ block->index ][ k ] )
+                        {
+                            value = meet( instruction->type, value, values[ instruction->operands[ k ]->index ] );
+                        }
+                    }
+
+                    if( !is_numeric( instruction->type ) && value.kind != LATTICEKIND_TOP )
+                    {
+                        value.kind = LATTICEKIND_BOTTOM;
+                    }
+                }
+                else
+                {
+                    value = evaluate( instruction, values );
+                }
+
+                if( !lattice_equals( value, values[ instruction->index ] ) )
+                {
+                    values[ instruction->index ] = value;
+                    has_changed = true;
+                }
+            }
+
+            IrInstruction* terminator = ir_block_get_terminator( block );
+            int successor_count = ir_block_get_successor_count( block );
+            for( int j = 0; j < successor_count; j++ )
+            {
+                if( terminator->opcode == IROPCODE_BRANCH )
+                {
+                    LatticeValue condition = values[ terminator->operands[ 0 ]->index ];
+                    bool is_taken = condition.kind != LATTICEKIND_CONSTANT || ( condition.integer != 0 ) == ( j == 0 );
+                    if( !is_taken )
+                    {
+                        continue;
+                    }
+                }
+
+                IrBlock* successor = ir_block_get_successor( block, j );
+                has_changed |= mark_edge( is_edge_executable, block, successor );
+                if( !is_block_executable[ successor->index ] )
+                {
+                    is_block_executable[ successor->index ] = true;
+                    has_changed = true;
+                }
+            }
+        }
+    }
+
+    // the constants are defined in the entry block, where they dominate every use
+    IrBlock* entry = function->blocks[ 0 ];
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        if( !is_block_executable[ block->index ] )
+        {
+            continue;
+        }
+
+        for( size_t j = 0; j < lvec_get_length( block->instructions ); j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            LatticeValue value = values[ instruction->index ];
+            if( value.kind != LATTICEKIND_CONSTANT || instruction->opcode == IROPCODE_CONSTANT )
+            {
+                continue;
+            }
+
+            IrInstruction* constant = ir_instruction_new( function, IROPCODE_CONSTANT, instruction->type );
+            if( ir_type_is_float( instruction->type ) )
+            {
+                constant->floating = value.floating;
+            }
+            else
+            {
+                constant->integer = value.integer;
+            }
+            ir_block_insert( entry, constant, 0 );
+            ir_replace_uses( function, instruction, constant );
+
+            if( block == entry )
+            {
+                j++; // the constant went in front of it
+            }
+            if( !ir_has_side_effects( instruction ) )
+            {
+                delete_instruction( instruction );
+                j--;
+            }
+        }
+
+        // branches on constants become jumps
+        IrInstruction* terminator = ir_block_get_terminator( block );
+        if( terminator != NULL && terminator->opcode == IROPCODE_BRANCH &&
+            terminator->operands[ 0 ]->opcode == IROPCODE_CONSTANT )
+        {
+            bool condition = terminator->operands[ 0 ]->integer != 0;
+            IrBlock* taken = terminator->targets[ condition ? 0 : 1 ];
+            IrBlock* not_taken = terminator->targets[ condition ? 1 : 0 ];
+            ir_remove_edge( block, not_taken );
+
+            terminator->opcode = IROPCODE_JUMP;
+            terminator->targets[ 0 ] = taken;
+            lvec_remove_last( terminator->operands );
+        }
+    }
+
+    for( int i = 0; i < function->block_count; i++ )
+    {
+        free( is_edge_executable[ i ] );
+    }
+    free( is_edge_executable );
+    free( is_block_executable );
+    free( values );
+
+    ir_remove_unreachable_blocks( function );
+}
+
+// operations whose result only depends on their operands
+static bool is_numberable( IrInstruction* instruction )
+{
+    switch( instruction->opcode )
+    {
+        case IROPCODE_CONSTANT:
+        case IROPCODE_STRING:
+        case IROPCODE_CONVERT:
+        case IROPCODE_ADD:
+        case IROPCODE_SUBTRACT:
+        case IROPCODE_MULTIPLY:
+        case IROPCODE_DIVIDE:
+        case IROPCODE_MODULO:
+        case IROPCODE_EQUAL:
+        case IROPCODE_NOTEQUAL:
+        case IROPCODE_LESS:
+        case IROPCODE_LESSEQUAL:
+        case IROPCODE_GREATER:
+        case IROPCODE_GREATEREQUAL:
+        case IROPCODE_NEGATE:
+        case IROPCODE_NOT:
+        case IROPCODE_GLOBAL:
+        case IROPCODE_ARRAYLENGTH:
+        case IROPCODE_ELEMENT:
+        {
+            return true;
+        }
+
+        // const functions do not even read memory
+        case IROPCODE_CALL:
+        {
+            int attributes = instruction->call.function->function_declaration.attributes;
+            return ( attributes & FUNCTIONATTRIBUTE_CONST ) && !instruction->call.is_tail_call;
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+static bool is_commutative( IrOpcode opcode )
+{
+    return opcode == IROPCODE_ADD || opcode == IROPCODE_MULTIPLY ||
+           opcode == IROPCODE_EQUAL || opcode == IROPCODE_NOTEQUAL;
+}
+
+static bool have_same_operands( IrInstruction* i1, IrInstruction* i2 )
+{
+    size_t operand_count = lvec_get_length( i1->operands );
+    if( operand_count != lvec_get_length( i2->operands ) )
+    {
+        return false;
+    }
+
+    bool is_same = true;
+    for( size_t i = 0; i < operand_count; i++ )
+    {
+        is_same = is_same && i1->operands[ i ] == i2->operands[ i ];
+    }
+
+    if( !is_same && is_commutative( i1->opcode ) && !ir_type_is_float( i1->type ) )
+    {
+        is_same = i1->operands[ 0 ] == i2->operands[ 1 ] && i1->operands[ 1 ] == i2->operands[ 0 ];
+    }
+
+    return is_same;
+}
+
+// true if `available` computes the same value as `instruction`, so that
+// `instruction` can use it instead
+static bool is_equivalent( IrInstruction* available, IrInstruction* instruction )
+{
+    if( available->opcode != instruction->opcode ||
+        !ir_type_equals( available->type, instruction->type ) ||
+        !have_same_operands( available, instruction ) )
+    {
+        return false;
+    }
+
+    switch( instruction->opcode )
+    {
+        case IROPCODE_CONSTANT:
+        {
+            return ir_type_is_float( instruction->type )
+                 ? memcmp( &available->floating, &instruction->floating, sizeof( double ) ) == 0
+                 : available->integer == instruction->integer;
+        }
+
+        case IROPCODE_STRING:
+        {
+            return strcmp( available->string, instruction->string ) == 0;
+        }
+
+        case IROPCODE_GLOBAL:
+        {
+            return strcmp( available->identifier, instruction->identifier ) == 0;
+        }
+
+        // an index that was checked does not need to be checked again
+        case IROPCODE_ELEMENT:
+        {
+            return available->element.is_bounds_checked || !instruction->element.is_bounds_checked;
+        }
+
+        case IROPCODE_CALL:
+        {
+            return available->call.function == instruction->call.function;
+        }
+
+        default:
+        {
+            return true;
+        }
+    }
+}
+
+static void number_values_in_block( IrFunction* function, IrBlock* block, IrBlock*** children,
+                                    IrInstruction*** available )
+{
+    size_t available_count = lvec_get_length( *available );
+
+    for( size_t i = 0; i < lvec_get_length( block->instructions ); i++ )
+    {
+        IrInstruction* instruction = block->instructions[ i ];
+        if( !is_numberable( instruction ) )
+        {
+            continue;
+        }
+
+        IrInstruction* equivalent = NULL;
+        size_t length = lvec_get_length( *available );
+        for( size_t j = 0; j < length && equivalent == NULL; j++ )
+        {
+            if( is_equivalent( ( *available )[ j ], instruction ) )
+            {
+                equivalent = ( *available )[ j ];
+            }
+        }
+
+        if( equivalent != NULL )
+        {
+            ir_replace_uses( function, instruction, equivalent );
+            delete_instruction( instruction );
+            i--;
+        }
+        else
+        {
+            lvec_append( *available, instruction );
+        }
+    }
+
+    IrBlock** block_children = children[ block->order ];
+    size_t child_count = lvec_get_length( block_children );
+    for( size_t i = 0; i < child_count; i++ )
+    {
+        number_values_in_block( function, block_children[ i ], children, available );
+    }
+
+    // the values of this block are not available in its siblings
+    while( lvec_get_length( *available ) > available_count )
+    {
+        lvec_remove_last( *available );
+    }
+}
+
+// global value numbering over the dominator tree: an instruction that computes
+// a value already computed in a dominating block is replaced by it
+void ir_number_values( IrFunction* function )
+{
+    ir_compute_dominators( function );
+
+    size_t block_count = lvec_get_length( function->blocks );
+    IrBlock*** children = calloc( block_count, sizeof( IrBlock** ) );
+    if( children == NULL ) ALLOC_ERROR();
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        children[ i ] = lvec_new( IrBlock* );
+    }
+    for( size_t i = 1; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        lvec_append( children[ block->immediate_dominator->order ], block );
+    }
+
+    IrInstruction** available = lvec_new( IrInstruction* );
+    number_values_in_block( function, function->blocks[ 0 ], children, &available );
+    lvec_free( available );
+
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        lvec_free( children[ i ] );
+    }
+    free( children );
+}
+
+// instructions that can be executed when the loop would not have executed them
+static bool can_hoist( IrInstruction* instruction )
+{
+    switch( instruction->opcode )
+    {
+        case IROPCODE_CONSTANT:
+        case IROPCODE_STRING:
+        case IROPCODE_COPY:
+        case IROPCODE_CONVERT:
+        case IROPCODE_ADD:
+        case IROPCODE_SUBTRACT:
+        case IROPCODE_MULTIPLY:
+        case IROPCODE_EQUAL:
+        case IROPCODE_NOTEQUAL:
+        case IROPCODE_LESS:
+        case IROPCODE_LESSEQUAL:
+        case IROPCODE_GREATER:
+        case IROPCODE_GREATEREQUAL:
+        case IROPCODE_NEGATE:
+        case IROPCODE_NOT:
+        case IROPCODE_GLOBAL:
+        case IROPCODE_ARRAYLENGTH:
+        {
+            return true;
+        }
+
+        // a division by zero traps
+        case IROPCODE_DIVIDE:
+        case IROPCODE_MODULO:
+        {
+            IrInstruction* divisor = instruction->operands[ 1 ];
+            if( ir_type_is_float( instruction->type ) )
+            {
+                return true;
+            }
+
+            return divisor->opcode == IROPCODE_CONSTANT && divisor->integer != 0 &&
+                   ( !ir_type_is_signed( divisor->type ) || ( int64_t )divisor->integer != -1 );
+        }
+
+        // a failed bounds check stops the program
+        case IROPCODE_ELEMENT:
+        {
+            return !instruction->element.is_bounds_checked;
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+// the single block outside the loop that jumps to its header, inserted if
+// there is none
+static IrBlock* get_preheader( IrFunction* function, IrBlock* header, bool* is_in_loop )
+{
+    IrBlock** outside_predecessors = lvec_new( IrBlock* );
+    size_t predecessor_count = lvec_get_length( header->predecessors );
+    for( size_t i = 0; i < predecessor_count; i++ )
+    {
+        if( !is_in_loop[ header->predecessors[ i ]->index ] )
+        {
+            lvec_append( outside_predecessors, header->predecessors[ i ] );
+        }
+    }
+
+    size_t outside_count = lvec_get_length( outside_predecessors );
+    if( outside_count == 0 )
+    {
+        lvec_free( outside_predecessors );
+        return NULL;
+    }
+
+    IrBlock* predecessor = outside_predecessors[ 0 ];
+    if( outside_count == 1 && ir_block_get_successor_count( predecessor ) == 1 )
+    {
+        lvec_free( outside_predecessors );
+        return predecessor;
+    }
+
+    // the outside edges go through the new block, the phis of the header
+    // get one operand for all of them
+    IrBlock* preheader = ir_block_new( function );
+    IrInstruction* jump = ir_instruction_new( function, IROPCODE_JUMP, ir_block_get_terminator( header )->type );
+    jump->targets[ 0 ] = header;
+    ir_block_insert( preheader, jump, 0 );
+
+    IrBlock** predecessors = lvec_new( IrBlock* );
+    size_t phi_count = 0;
+    while( header->instructions[ phi_count ]->opcode == IROPCODE_PHI )
+    {
+        phi_count++;
+    }
+
+    for( size_t i = 0; i < predecessor_count; i++ )
+    {
+        IrBlock* outside = header->predecessors[ i ];
+        if( is_in_loop[ outside->index ] )
+        {
+            continue;
+        }
+
+        lvec_append( preheader->predecessors, outside );
+        IrInstruction* terminator = ir_block_get_terminator( outside );
+        for( int j = 0; j < ir_block_get_successor_count( outside ); j++ )
+        {
+            if( terminator->targets[ j ] == header )
+            {
+                terminator->targets[ j ] = preheader;
+            }
+        }
+    }
+
+    for( size_t i = 0; i < phi_count; i++ )
+    {
+        IrInstruction* phi = header->instructions[ i ];
+        IrInstruction** operands = lvec_new( IrInstruction* );
+        IrInstruction* outside_phi = ir_instruction_new( function, IROPCODE_PHI, phi->type );
+        for( size_t j = 0; j < predecessor_count; j++ )
+        {
+            if( is_in_loop[ header->predecessors[ j ]->index ] )
+            {
+                lvec_append( operands, phi->operands[ j ] );
+            }
+            else
+            {
+                lvec_append( outside_phi->operands, phi->operands[ j ] );
+            }
+        }
+
+        if( outside_count == 1 )
+        {
+            lvec_append( operands, outside_phi->operands[ 0 ] );
+            ir_instruction_free( outside_phi );
+        }
+        else
+        {
+            lvec_append( operands, outside_phi );
+            ir_block_insert( preheader, outside_phi, 0 );
+        }
+        lvec_free( phi->operands );
+        phi->operands = operands;
+    }
+
+    for( size_t i = 0; i < predecessor_count; i++ )
+    {
+        if( is_in_loop[ header->predecessors[ i ]->index ] )
+        {
+            lvec_append( predecessors, header->predecessors[ i ] );
+        }
+    }
+    lvec_append( predecessors, preheader );
+    lvec_free( header->predecessors );
+    header->predecessors = predecessors;
+
+    lvec_free( outside_predecessors );
+    return preheader;
+}
+
+// the blocks of the natural loops with this header: those that reach one of
+// its back edges without going through the header
+static bool find_loop( IrFunction* function, IrBlock* header, bool* is_in_loop )
+{
+    memset( is_in_loop, 0, ( function->block_count + 1 ) * sizeof( bool ) );
+    is_in_loop[ header->index ] = true;
+
+    IrBlock** worklist = lvec_new( IrBlock* );
+    size_t predecessor_count = lvec_get_length( header->predecessors );
+    for( size_t i = 0; i < predecessor_count; i++ )
+    {
+        if( ir_dominates( header, header->predecessors[ i ] ) )
+        {
+            lvec_append( worklist, header->predecessors[ i ] );
+        }
+    }
+
+    bool is_loop = lvec_get_length( worklist ) > 0;
+    while( lvec_get_length( worklist ) > 0 )
+    {
+        IrBlock* block = worklist[ lvec_get_length( worklist ) - 1 ];
+        lvec_remove_last( worklist );
+        if( is_in_loop[ block->index ] )
+        {
+            continue;
+        }
+
+        is_in_loop[ block->index ] = true;
+        size_t count = lvec_get_length( block->predecessors );
+        for( size_t i = 0; i < count; i++ )
+        {
+            lvec_append( worklist, block->predecessors[ i ] );
+        }
+    }
+
+    lvec_free( worklist );
+    return is_loop;
+}
+
+// instructions of a loop whose operands are all defined outside of it are
+// moved in front of it, inner loops first so that their invariants can leave
+// the outer loops as well
+void ir_hoist_loop_invariants( IrFunction* function )
+{
+    ir_compute_dominators( function );
+
+    IrBlock** headers = lvec_new( IrBlock* );
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = block_count; i-- > 0; )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t predecessor_count = lvec_get_length( block->predecessors );
+        for( size_t j = 0; j < predecessor_count; j++ )
+        {
+            if( ir_dominates( block, block->predecessors[ j ] ) )
+            {
+                lvec_append( headers, block );
+                break;
+            }
+        }
+    }
+
+    size_t header_count = lvec_get_length( headers );
+    for( size_t i = 0; i < header_count; i++ )
+    {
+        IrBlock* header = headers[ i ];
+        ir_compute_dominators( function );
+
+        bool* is_in_loop = calloc( function->block_count + 1, sizeof( bool ) );
+        if( is_in_loop == NULL ) ALLOC_ERROR();
+
+        IrBlock* preheader = find_loop( function, header, is_in_loop ) ? get_preheader( function, header, is_in_loop ) : NULL;
+        bool has_changed = preheader != NULL;
+        while( has_changed )
+        {
+            has_changed = false;
+
+            // in reverse postorder, so that operands are hoisted before their users
+            size_t count = lvec_get_length( function->blocks );
+            for( size_t j = 0; j < count; j++ )
+            {
+                IrBlock* block = function->blocks[ j ];
+                if( !is_in_loop[ block->index ] )
+                {
+                    continue;
+                }
+
+                for( size_t k = 0; k < lvec_get_length( block->instructions ); k++ )
+                {
+                    IrInstruction* instruction = block->instructions[ k ];
+                    if( !can_hoist( instruction ) )
+                    {
+                        continue;
+                    }
+
+                    bool is_invariant = true;
+                    size_t operand_count = lvec_get_length( instruction->operands );
+                    for( size_t l = 0; l < operand_count; l++ )
+                    {
+                        is_invariant = is_invariant && !is_in_loop[ instruction->operands[ l ]->block->index ];
+                    }
+
+                    if( is_invariant )
+                    {
+                        ir_block_remove( block, instruction );
+                        ir_block_insert_before_terminator( preheader, instruction );
+                        has_changed = true;
+                        k--;
+                    }
+                }
+            }
+        }
+
+        free( is_in_loop );
+    }
+
+    lvec_free( headers );
+    ir_compute_dominators( function );
+}
+
+// stores that nothing can read: to slots that are never loaded and whose
+// address does not escape, and stores overwritten in the same block before
+// anything could have read them
+void ir_eliminate_dead_stores( IrFunction* function )
+{
+    bool* is_read = calloc( function->instruction_count, sizeof( bool ) );
+    if( is_read == NULL ) ALLOC_ERROR();
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            size_t operand_count = lvec_get_length( instruction->operands );
+            for( size_t k = 0; k < operand_count; k++ )
+            {
+                // storing to a slot is the only use that does not read it
+                bool is_store_address = instruction->opcode == IROPCODE_STORE && k == 0;
+                if( !is_store_address )
+                {
+                    is_read[ instruction->operands[ k ]->index ] = true;
+                }
+            }
+        }
+    }
+
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        for( size_t j = 0; j < lvec_get_length( block->instructions ); j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            if( instruction->opcode != IROPCODE_STORE )
+            {
+                continue;
+            }
+
+            IrInstruction* address = instruction->operands[ 0 ];
+            bool is_dead = address->opcode == IROPCODE_SLOT && !is_read[ address->index ];
+
+            for( size_t k = j + 1; k < lvec_get_length( block->instructions ) && !is_dead; k++ )
+            {
+                IrInstruction* later = block->instructions[ k ];
+                if( later->opcode == IROPCODE_STORE && later->operands[ 0 ] == address )
+                {
+                    is_dead = true;
+                }
+                else if( later->opcode == IROPCODE_LOAD || later->opcode == IROPCODE_CALL )
+                {
+                    break;
+                }
+            }
+
+            if( is_dead )
+            {
+                delete_instruction( instruction );
+                j--;
+            }
+        }
+    }
+
+    free( is_read );
+}
+
+// instructions whose values are not used and that have no side effects
+void ir_eliminate_dead_code( IrFunction* function )
+{
+    bool* is_live = calloc( function->instruction_count, sizeof( bool ) );
+    if( is_live == NULL ) ALLOC_ERROR();
+
+    IrInstruction** worklist = lvec_new( IrInstruction* );
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            if( ir_has_side_effects( instruction ) )
+            {
+                is_live[ instruction->index ] = true;
+                lvec_append( worklist, instruction );
+            }
+        }
+    }
+
+    while( lvec_get_length( worklist ) > 0 )
+    {
+        IrInstruction* instruction = worklist[ lvec_get_length( worklist ) - 1 ];
+        lvec_remove_last( worklist );
+
+        size_t operand_count = lvec_get_length( instruction->operands );
+        for( size_t i = 0; i < operand_count; i++ )
+        {
+            IrInstruction* operand = instruction->operands[ i ];
+            if( !is_live[ operand->index ] )
+            {
+                is_live[ operand->index ] = true;
+                lvec_append( worklist, operand );
+            }
+        }
+    }
+    lvec_free( worklist );
+
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        for( size_t j = 0; j < lvec_get_length( block->instructions ); j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            if( !is_live[ instruction->index ] )
+            {
+                delete_instruction( instruction );
+                j--;
+            }
+        }
+    }
+
+    free( is_live );
+}
+
+// a block whose only predecessor jumps to it becomes part of that
+// predecessor, the inlined calls and the ifs whose conditions were constant
+// leave many of them
+static void merge_blocks( IrFunction* function )
+{
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        IrInstruction* jump = ir_block_get_terminator( block );
+        while( jump != NULL && jump->opcode == IROPCODE_JUMP )
+        {
+            IrBlock* successor = jump->targets[ 0 ];
+            if( successor == block || successor == function->blocks[ 0 ] ||
+                lvec_get_length( successor->predecessors ) != 1 )
+            {
+                break;
+            }
+
+            while( successor->instructions[ 0 ]->opcode == IROPCODE_PHI )
+            {
+                IrInstruction* phi = successor->instructions[ 0 ];
+                ir_replace_uses( function, phi, phi->operands[ 0 ] );
+                delete_instruction( phi );
+            }
+
+            delete_instruction( jump );
+            size_t length = lvec_get_length( successor->instructions );
+            for( size_t j = 0; j < length; j++ )
+            {
+                ir_block_insert( block, successor->instructions[ j ], lvec_get_length( block->instructions ) );
+            }
+            while( lvec_get_length( successor->instructions ) > 0 )
+            {
+                lvec_remove_last( successor->instructions );
+            }
+            lvec_remove_last( successor->predecessors );
+
+            // the successors of the merged block are now reached from this one
+            int successor_count = ir_block_get_successor_count( block );
+            for( int j = 0; j < successor_count; j++ )
+            {
+                IrBlock* next = ir_block_get_successor( block, j );
+                size_t predecessor_count = lvec_get_length( next->predecessors );
+                for( size_t k = 0; k < predecessor_count; k++ )
+                {
+                    if( next->predecessors[ k ] == successor )
+                    {
+                        next->predecessors[ k ] = block;
+                    }
+                }
+            }
+
+            jump = ir_block_get_terminator( block );
+        }
+    }
+
+    // the merged blocks are empty and unreachable now
+    ir_remove_unreachable_blocks( function );
+}
+
+void ir_optimize( IrFunction* function )
+{
+    ir_propagate_copies( function );
+    ir_propagate_constants( function );
+    ir_propagate_copies( function );
+    ir_number_values( function );
+    ir_hoist_loop_invariants( function );
+    ir_eliminate_dead_stores( function );
+    ir_eliminate_dead_code( function );
+    merge_blocks( function );
+}
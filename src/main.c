@@ -1,91 +1,1642 @@
+// for realpath
+#define _XOPEN_SOURCE 700
+
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "arena.h"
+#include "boundscheck.h"
+#include "cache.h"
+#include "codebuffer.h"
 #include "codegen.h"
+#include "compiler.h"
+#include "debug.h"
+#include "driver.h"
 #include "error.h"
+#include "hash.h"
+#include "hotreload.h"
+#include "inline.h"
+#include "ir.h"
+#include "module.h"
+#include "purity.h"
 #include "lvec.h"
+#include "native.h"
 #include "parser.h"
 #include "tokenizer.h"
 #include "semantic.h"
+#include "serve.h"
+#include "vm.h"
+#include "watch.h"
 #include "whereami.h"
 
-SourceCode g_source_code;
+#if !defined( _WIN32 )
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#endif
+
 void debug_print_type( Type type );
 
-int main( int argc, char* argv[] )
+// the shards of `octo build --watch` without `-j`
+#define WATCH_JOB_COUNT 4
+
+typedef struct Shard
 {
-    if( argc < 2 )
+    CodeBuffer buffer;
+    CCompiler compiler;
+    char* object_path;
+    char* temporary_path; // where the object is compiled before it is cached
+    bool is_compiling;
+} Shard;
+
+// compiles the program as `shard_count` translation units at the same time and
+// links them together, shards found in `cache` are not compiled again
+static bool compile_in_shards( SemanticContext* context, Expression* program, int shard_count,
+                               ObjectCache* cache, char* output_path, char* include_directory )
+{
+    int function_count = 0;
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
     {
-        printf( "No file specified.\n" );
-        return -1;
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION && statement->function_declaration.is_reachable )
+        {
+            function_count++;
+        }
+    }
+
+    if( shard_count > function_count )
+    {
+        shard_count = function_count > 0 ? function_count : 1;
     }
 
-    char* source_file_path = argv[ 1 ];
-    g_source_code = source_code_load( source_file_path );
+    int* shard_indices = partition_program( program, shard_count );
 
-    Token* tokens = tokenize();
-    if( tokens == NULL )
+    // the first shard always has the globals, the others can end up empty
+    bool* is_shard_used = calloc( shard_count, sizeof( bool ) );
+    if( is_shard_used == NULL ) ALLOC_ERROR();
+    is_shard_used[ 0 ] = true;
+    for( size_t i = 0; i < statement_count; i++ )
     {
-        return 1;
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION && statement->function_declaration.is_reachable )
+        {
+            is_shard_used[ shard_indices[ i ] ] = true;
+        }
     }
 
-    Parser parser;
-    parser_initialize( &parser, tokens );
+    Shard* shards = lvec_new( Shard );
+    char** object_paths = lvec_new( char* );
+    int cached_count = 0;
 
-    Expression* program = parse( &parser );
-    if( program == NULL )
+    // each shard is compiled by its own compiler, which keeps compiling while
+    // the next shard is generated. without a cache the code is streamed to it,
+    // with a cache the whole shard is needed up front to look it up
+    bool is_successful = true;
+    for( int i = 0; i < shard_count && is_successful; i++ )
     {
-        return 1;
+        if( !is_shard_used[ i ] )
+        {
+            continue;
+        }
+
+        Shard shard = { 0 };
+        code_buffer_initialize( &shard.buffer );
+
+        char* compile_path;
+        if( cache != NULL )
+        {
+            generate_shard( &shard.buffer, context, program, shard_indices, i );
+            shard.object_path = object_cache_get_path( cache, &shard.buffer );
+            if( object_cache_contains( shard.object_path ) )
+            {
+                cached_count++;
+                lvec_append_aggregate( shards, shard );
+                continue;
+            }
+
+            shard.temporary_path = object_cache_get_temporary_path( shard.object_path );
+            compile_path = shard.temporary_path;
+        }
+        else
+        {
+            shard.object_path = calloc( 1, strlen( output_path ) + 32 );
+            if( shard.object_path == NULL ) ALLOC_ERROR();
+            sprintf( shard.object_path, "%s.%d.o", output_path, i );
+            compile_path = shard.object_path;
+        }
+
+        shard.is_compiling = c_compiler_start( &shard.compiler, &shard.buffer, compile_path, include_directory,
+                                               CCOMPILEROUTPUT_OBJECT );
+        if( shard.is_compiling )
+        {
+            if( cache == NULL )
+            {
+                generate_shard( &shard.buffer, context, program, shard_indices, i );
+            }
+            c_compiler_end_input( &shard.compiler );
+        }
+        else
+        {
+            is_successful = false;
+        }
+
+        lvec_append_aggregate( shards, shard );
     }
-    lvec_free( tokens );
 
-    SemanticContext semantic_context;
-    semantic_context_initialize( &semantic_context );
-    bool is_valid = check_semantics( &semantic_context, program );
-    if( !is_valid )
+    size_t used_count = lvec_get_length( shards );
+    for( size_t i = 0; i < used_count; i++ )
     {
-        return 1;
+        Shard* shard = &shards[ i ];
+        if( shard->is_compiling && !c_compiler_wait( &shard->compiler ) )
+        {
+            is_successful = false;
+        }
     }
 
-    char file_name[256];
-    sprintf( file_name, "%s.c", g_source_code.path );
-    FILE* generated_c = fopen( file_name, "w+" );
-    generate_code( generated_c, &semantic_context, program );
-    fclose( generated_c );
+    for( size_t i = 0; i < used_count; i++ )
+    {
+        Shard* shard = &shards[ i ];
+        if( shard->temporary_path != NULL )
+        {
+            if( is_successful && !object_cache_insert( shard->temporary_path, shard->object_path ) )
+            {
+                is_successful = false;
+            }
+            remove( shard->temporary_path );
+        }
+        lvec_append( object_paths, shard->object_path );
+    }
 
-    for( int i = 0; i < semantic_context.symbol_table.length; i++ )
+    if( is_successful )
     {
-        Symbol symbol = semantic_context.symbol_table.symbols[ i ];
-        printf( "%s: ", symbol.token.as_string );
-        debug_print_type( symbol.type );
-        putchar( '\n' );
+        is_successful = c_compiler_link( object_paths, used_count, output_path );
     }
 
-    expression_print( program );
+    if( cache != NULL )
+    {
+        printf( "objects: %d compiled, %d reused from the cache\n", ( int )used_count - cached_count, cached_count );
+    }
 
-    int octo_exe_path_length = wai_getExecutablePath( NULL, 0, NULL );
-    char* octo_exe_dir = calloc( 1, octo_exe_path_length + 1 );
-    wai_getExecutablePath( octo_exe_dir, octo_exe_path_length, NULL );
+    for( size_t i = 0; i < used_count; i++ )
+    {
+        Shard* shard = &shards[ i ];
+        if( cache == NULL )
+        {
+            remove( shard->object_path );
+        }
+        code_buffer_free( &shard->buffer );
+        free( shard->object_path );
+        free( shard->temporary_path );
+    }
+    lvec_free( object_paths );
+    lvec_free( shards );
+    free( is_shard_used );
+    free( shard_indices );
 
-    // get only the directory
-    for( int i = octo_exe_path_length; i >= 0; i-- )
+    return is_successful;
+}
+
+typedef struct BuildOptions
+{
+    char* source_path;
+    bool emit_c;
+    int job_count;
+    bool use_cache;
+    char* cache_directory;
+    char* output_path;
+    char* include_directory;
+} BuildOptions;
+
+// compiles the program into `options->output_path` with the flags the driver
+// was last configured with
+static bool build_executable( SemanticContext* context, Expression* program, BuildOptions* options )
+{
+    CodeBuffer generated_c;
+    code_buffer_initialize( &generated_c );
+
+    // the generated c is streamed to the compiler while it is being generated,
+    // unless it is kept around on disk
+    bool is_compiled;
+    if( options->emit_c )
     {
-        char* c = &octo_exe_dir[ i ];
-        if( *c == '\\' || *c == '/' )
+        char* c_path = calloc( 1, strlen( options->source_path ) + sizeof( ".c" ) );
+        sprintf( c_path, "%s.c", options->source_path );
+
+        generate_program( &generated_c, context, program );
+
+        FILE* c_file = fopen( c_path, "wb" );
+        if( c_file == NULL || !code_buffer_write( &generated_c, c_file ) )
         {
-            *c = 0;
-            break;
+            printf( "Could not write '%s'.\n", c_path );
+            return false;
+        }
+        fclose( c_file );
+
+        is_compiled = c_compiler_compile_file( c_path, options->output_path, options->include_directory );
+        free( c_path );
+    }
+    else if( options->job_count > 1 )
+    {
+        ObjectCache cache;
+        char* runtime_header_path = calloc( 1, strlen( options->include_directory ) + sizeof( "/../octoruntime/types.h" ) );
+        sprintf( runtime_header_path, "%s/../octoruntime/types.h", options->include_directory );
+
+        bool is_cache_open = options->use_cache
+            && object_cache_open( &cache, options->cache_directory, runtime_header_path );
+        is_compiled = compile_in_shards( context, program, options->job_count, is_cache_open ? &cache : NULL,
+                                         options->output_path, options->include_directory );
+        if( is_cache_open )
+        {
+            object_cache_close( &cache );
+        }
+    }
+    else
+    {
+        CCompiler compiler;
+        if( !c_compiler_start( &compiler, &generated_c, options->output_path, options->include_directory,
+                               CCOMPILEROUTPUT_EXECUTABLE ) )
+        {
+            return false;
+        }
+
+        generate_program( &generated_c, context, program );
+        is_compiled = c_compiler_finish( &compiler );
+    }
+    code_buffer_free( &generated_c );
+
+    return is_compiled;
+}
+
+static char* get_absolute_path( char* path )
+{
+#if defined( _WIN32 )
+    char* absolute_path = _fullpath( NULL, path, 0 );
+#else
+    char* absolute_path = realpath( path, NULL );
+#endif
+    if( absolute_path == NULL )
+    {
+        printf( "Could not resolve the path '%s'.\n", path );
+        return NULL;
+    }
+
+    // the c library allocated the path, everything else frees it like its own
+    char* path_copy = malloc( strlen( absolute_path ) + 1 );
+    if( path_copy == NULL ) ALLOC_ERROR();
+    strcpy( path_copy, absolute_path );
+    arena_free_system( absolute_path );
+
+    return path_copy;
+}
+
+// builds an instrumented executable, runs `training_command` to record a
+// profile with it and then builds the executable again using that profile
+static bool build_with_profile( SemanticContext* context, Expression* program, BuildOptions* options,
+                                BuildProfile profile, char* training_command )
+{
+    // the profile is found by the path of each object, which is different for
+    // every cached object, and a cached object would not reflect a new profile
+    options->use_cache = false;
+
+    // the instrumented executable records to this directory wherever it is run
+    char* source_path = get_absolute_path( options->source_path );
+    if( source_path == NULL )
+    {
+        return false;
+    }
+    char* profile_directory = calloc( 1, strlen( source_path ) + sizeof( ".profile" ) );
+    sprintf( profile_directory, "%s.profile", source_path );
+    free( source_path );
+
+    c_compiler_configure( profile, PROFILEGUIDANCE_GENERATE, profile_directory );
+    bool is_successful = build_executable( context, program, options );
+
+    if( is_successful )
+    {
+        printf( "training: %s\n", training_command );
+        fflush( stdout );
+
+        if( system( training_command ) != 0 )
+        {
+            printf( "The training command failed.\n" );
+            is_successful = false;
+        }
+    }
+
+    if( is_successful )
+    {
+        c_compiler_configure( profile, PROFILEGUIDANCE_USE, profile_directory );
+        is_successful = build_executable( context, program, options );
+    }
+
+    c_compiler_configure( profile, PROFILEGUIDANCE_NONE, NULL );
+    free( profile_directory );
+    return is_successful;
+}
+
+// appends "<kind> <hash> [path]"
+static void append_manifest_line( CodeBuffer* manifest, char* kind, uint64_t hash, char* path )
+{
+    char line[ 64 ];
+    snprintf( line, sizeof( line ), "%s %016llx", kind, ( unsigned long long )hash );
+    code_buffer_append_string( manifest, line );
+    if( path != NULL )
+    {
+        code_buffer_append_char( manifest, ' ' );
+        code_buffer_append_string( manifest, path );
+    }
+    code_buffer_append_char( manifest, '\n' );
+}
+
+// continues `hash` with the stamps of the interface and the object of a module
+static uint64_t hash_module_stamp( uint64_t hash, char* interface_path )
+{
+    char* object_path = get_module_object_path( interface_path );
+    hash = object_cache_hash_file_stamp( hash, interface_path );
+    hash = object_cache_hash_file_stamp( hash, object_path );
+    free( object_path );
+    return hash;
+}
+
+// the manifest next to an executable records what it was built from: the
+// command line, octo and its runtime, every source, the modules it imports and
+// the executable itself. `interface_paths` is an lvec
+static void generate_manifest( CodeBuffer* manifest, int argc, char* argv[], SourceCode* sources, int source_count,
+                               char** interface_paths, char* octo_exe_path, char* runtime_header_path,
+                               char* output_path )
+{
+    uint64_t options_hash = HASH_INITIAL;
+    for( int i = 1; i < argc; i++ )
+    {
+        // with the terminator, so that two arguments cannot read as one
+        options_hash = hash_bytes( options_hash, argv[ i ], strlen( argv[ i ] ) + 1 );
+    }
+    options_hash = object_cache_hash_file_stamp( options_hash, octo_exe_path );
+    options_hash = object_cache_hash_file_stamp( options_hash, runtime_header_path );
+    append_manifest_line( manifest, "options", options_hash, NULL );
+
+    for( int i = 0; i < source_count; i++ )
+    {
+        uint64_t source_hash = hash_bytes( HASH_INITIAL, sources[ i ].code, sources[ i ].length );
+        append_manifest_line( manifest, "source", source_hash, sources[ i ].path );
+    }
+
+    size_t interface_count = lvec_get_length( interface_paths );
+    for( size_t i = 0; i < interface_count; i++ )
+    {
+        append_manifest_line( manifest, "module", hash_module_stamp( HASH_INITIAL, interface_paths[ i ] ),
+                              interface_paths[ i ] );
+    }
+
+    append_manifest_line( manifest, "executable", object_cache_hash_file_stamp( HASH_INITIAL, output_path ), NULL );
+}
+
+// the interfaces of the modules in the manifest on disk, which are only known
+// from the source once it is parsed
+static char** read_manifest_interface_paths( char* manifest_path )
+{
+    char** interface_paths = lvec_new( char* );
+    FILE* file = fopen( manifest_path, "rb" );
+    if( file == NULL )
+    {
+        return interface_paths;
+    }
+
+    // "module <16 digits> <path>"
+    char line[ 4096 ];
+    size_t prefix_length = sizeof( "module 0123456789abcdef " ) - 1;
+    while( fgets( line, sizeof( line ), file ) != NULL )
+    {
+        size_t length = strlen( line );
+        if( strncmp( line, "module ", 7 ) != 0 || length <= prefix_length || line[ length - 1 ] != '\n' )
+        {
+            continue;
+        }
+
+        line[ length - 1 ] = '\0';
+        char* interface_path = malloc( length - prefix_length );
+        if( interface_path == NULL ) ALLOC_ERROR();
+        strcpy( interface_path, line + prefix_length );
+        lvec_append( interface_paths, interface_path );
+    }
+
+    fclose( file );
+    return interface_paths;
+}
+
+// whether the manifest on disk is the same as `manifest`
+static bool is_manifest_current( char* manifest_path, CodeBuffer* manifest )
+{
+    FILE* file = fopen( manifest_path, "rb" );
+    if( file == NULL )
+    {
+        return false;
+    }
+
+    char* contents = malloc( manifest->length + 1 );
+    if( contents == NULL ) ALLOC_ERROR();
+    size_t length = fread( contents, 1, manifest->length + 1, file );
+    bool is_current = length == manifest->length && memcmp( contents, manifest->data, length ) == 0;
+
+    free( contents );
+    fclose( file );
+    return is_current;
+}
+
+// records the inputs of an executable that was just built
+static void write_manifest( char* manifest_path, int argc, char* argv[], SourceCode* sources, int source_count,
+                            char** interface_paths, char* octo_exe_path, char* runtime_header_path,
+                            char* output_path )
+{
+    CodeBuffer manifest;
+    code_buffer_initialize( &manifest );
+    generate_manifest( &manifest, argc, argv, sources, source_count, interface_paths, octo_exe_path,
+                       runtime_header_path, output_path );
+
+    FILE* file = fopen( manifest_path, "wb" );
+    if( file == NULL || !code_buffer_write( &manifest, file ) )
+    {
+        printf( "Could not write '%s'.\n", manifest_path );
+    }
+    if( file != NULL )
+    {
+        fclose( file );
+    }
+    code_buffer_free( &manifest );
+}
+
+// compiles a module into the object next to its interface, then writes the
+// interface so that it is never newer than the object
+static bool build_module( SemanticContext* context, Expression* program, char* include_directory )
+{
+    char* object_path = get_module_object_path( context->module_interface_path );
+    CodeBuffer generated_c;
+    code_buffer_initialize( &generated_c );
+
+    CCompiler compiler;
+    bool is_built = c_compiler_start( &compiler, &generated_c, object_path, include_directory,
+                                      CCOMPILEROUTPUT_OBJECT );
+    if( is_built )
+    {
+        generate_program( &generated_c, context, program );
+        is_built = c_compiler_finish( &compiler );
+    }
+
+    code_buffer_free( &generated_c );
+    free( object_path );
+    return is_built && write_module_interface( context, program );
+}
+
+// writes the optimized ir of every function that was lowered to `<file>.ir`
+static bool write_ir( Expression* program, char* source_path )
+{
+    CodeBuffer buffer;
+    code_buffer_initialize( &buffer );
+
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind != EXPRESSIONKIND_FUNCTIONDECLARATION || !statement->function_declaration.is_reachable )
+        {
+            continue;
+        }
+
+        if( statement->function_declaration.ir != NULL )
+        {
+            ir_print_function( &buffer, statement->function_declaration.ir );
+        }
+        else
+        {
+            code_buffer_append_string( &buffer, "; " );
+            code_buffer_append_string( &buffer, statement->function_declaration.identifier_token.as_string );
+            code_buffer_append_string( &buffer, " is generated from the ast\n\n" );
+        }
+    }
+
+    char* ir_path = calloc( 1, strlen( source_path ) + sizeof( ".ir" ) );
+    sprintf( ir_path, "%s.ir", source_path );
+
+    FILE* ir_file = fopen( ir_path, "wb" );
+    bool is_written = ir_file != NULL && code_buffer_write( &buffer, ir_file );
+    if( !is_written )
+    {
+        printf( "Could not write '%s'.\n", ir_path );
+    }
+    if( ir_file != NULL )
+    {
+        fclose( ir_file );
+    }
+
+    free( ir_path );
+    code_buffer_free( &buffer );
+    return is_written;
+}
+
+// whether the native backend can build the program with these options, prints
+// why not if it cannot
+static bool can_build_natively( Expression* program, bool use_ir, BuildProfile profile, char* pgo_command,
+                                BuildOptions* options )
+{
+#if defined( __x86_64__ ) && defined( __linux__ )
+    if( !use_ir || options->emit_c || profile != BUILDPROFILE_DEBUG || pgo_command != NULL )
+    {
+        printf( "The native backend only makes debug builds from the ir, compiling with gcc instead.\n" );
+        return false;
+    }
+
+    return native_can_generate( program );
+#else
+    ( void )program;
+    ( void )use_ir;
+    ( void )profile;
+    ( void )pgo_command;
+    ( void )options;
+    printf( "The native backend only targets x86-64 linux, compiling with gcc instead.\n" );
+    return false;
+#endif
+}
+
+// writes the machine code for the program to `<output>.o` and links it
+static bool build_native( Expression* program, CheckMode check_mode, char* source_path, char* output_path )
+{
+    char* object_path = calloc( 1, strlen( output_path ) + sizeof( ".o" ) );
+    if( object_path == NULL ) ALLOC_ERROR();
+    sprintf( object_path, "%s.o", output_path );
+
+    c_compiler_configure( BUILDPROFILE_DEBUG, PROFILEGUIDANCE_NONE, NULL );
+    bool is_built = generate_native_object( program, object_path, check_mode, source_path )
+        && c_compiler_link( &object_path, 1, output_path );
+
+    remove( object_path );
+    free( object_path );
+    return is_built;
+}
+
+// runs `main` in the interpreter. returns false without running anything if
+// the interpreter cannot run the program
+static bool run_interpreted( Expression* program, CheckMode check_mode, char* source_path, int* out_exit_code )
+{
+    Expression* main_function = NULL;
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION &&
+            strcmp( statement->function_declaration.identifier_token.as_string, "main" ) == 0 )
+        {
+            main_function = statement;
+        }
+    }
+
+    if( main_function == NULL || main_function->function_declaration.param_count > 0 )
+    {
+        printf( "The interpreter can only run a 'main' without parameters.\n" );
+        return false;
+    }
+
+    Vm* vm = vm_compile( program, check_mode, source_path );
+    if( vm == NULL )
+    {
+        return false;
+    }
+
+    uint64_t result = vm_call( vm, vm_find_function( vm, "main" ), NULL );
+    bool is_void = ir_get_type_definition( main_function->function_declaration.return_type ).kind == TYPEKIND_VOID;
+    *out_exit_code = is_void ? 0 : ( int )result;
+
+    vm_free( vm );
+    return true;
+}
+
+// appends `argument` to a shell command so that the shell passes it on as is
+static void append_shell_argument( CodeBuffer* command, char* argument )
+{
+#if defined( _WIN32 )
+    code_buffer_append_string( command, " \"" );
+    code_buffer_append_string( command, argument );
+    code_buffer_append_char( command, '"' );
+#else
+    code_buffer_append_string( command, " '" );
+    for( char* c = argument; *c != '\0'; c++ )
+    {
+        if( *c == '\'' )
+        {
+            code_buffer_append_string( command, "'\\''" );
         }
+        else
+        {
+            code_buffer_append_char( command, *c );
+        }
+    }
+    code_buffer_append_char( command, '\'' );
+#endif
+}
+
+// runs the executable that was built with the arguments after the first in
+// `program_argv` and returns its exit code
+static int run_executable( char* output_path, int program_argc, char** program_argv )
+{
+    char* executable_path = get_absolute_path( output_path );
+    if( executable_path == NULL )
+    {
+        return 1;
+    }
+
+    CodeBuffer command;
+    code_buffer_initialize( &command );
+    code_buffer_append_char( &command, '"' );
+    code_buffer_append_string( &command, executable_path );
+    code_buffer_append_char( &command, '"' );
+    for( int i = 1; i < program_argc; i++ )
+    {
+        append_shell_argument( &command, program_argv[ i ] );
+    }
+    code_buffer_append_char( &command, '\0' );
+
+    fflush( stdout );
+    int status = system( command.data );
+#if !defined( _WIN32 )
+    status = WIFEXITED( status ) ? WEXITSTATUS( status ) : 1;
+#endif
+
+    code_buffer_free( &command );
+    free( executable_path );
+    return status;
+}
+
+#if !defined( _WIN32 )
+// hashes everything a program is generated from besides the c compiler and
+// the runtime header, which the cache adds. this is known before the source
+// is even tokenized, so unchanged programs are not compiled at all
+static uint64_t hash_program_inputs( SourceCode* source_code, char* octo_exe_path, bool bounds_checks,
+                                     CheckMode check_mode, int inline_threshold, bool use_ir )
+{
+    uint64_t hash = hash_bytes( HASH_INITIAL, source_code->code, source_code->length );
+
+    // the path ends up in the messages of failed bounds checks
+    hash = hash_string( hash, source_code->path );
+
+    int options[] = { bounds_checks, check_mode, inline_threshold, use_ir };
+    hash = hash_bytes( hash, options, sizeof( options ) );
+
+    // a new octo generates different code for the same source
+    return object_cache_hash_file_stamp( hash, octo_exe_path );
+}
+#endif
+
+// generates the program with its run entry and compiles it into the cache as
+// a shared object
+static bool build_shared_object( SemanticContext* context, Expression* program, char* shared_object_path,
+                                 char* include_directory )
+{
+    CodeBuffer generated_c;
+    code_buffer_initialize( &generated_c );
+    char* temporary_path = object_cache_get_temporary_path( shared_object_path );
+
+    CCompiler compiler;
+    bool is_built = c_compiler_start( &compiler, &generated_c, temporary_path, include_directory,
+                                      CCOMPILEROUTPUT_SHAREDOBJECT );
+    if( is_built )
+    {
+        generate_program( &generated_c, context, program );
+        generate_run_entry( &generated_c, program );
+        is_built = c_compiler_finish( &compiler ) && object_cache_insert( temporary_path, shared_object_path );
+    }
+
+    remove( temporary_path );
+    free( temporary_path );
+    code_buffer_free( &generated_c );
+    return is_built;
+}
+
+#if !defined( _WIN32 )
+// loads the program into this process and calls its main with `program_argv`,
+// returns the exit code
+static int run_shared_object( char* shared_object_path, char* source_path, int program_argc, char** program_argv )
+{
+    void* library = dlopen( shared_object_path, RTLD_NOW | RTLD_LOCAL );
+    if( library == NULL )
+    {
+        printf( "Could not load '%s': %s.\n", shared_object_path, dlerror() );
+        return 1;
+    }
+
+    void* symbol = dlsym( library, RUN_ENTRY_NAME );
+    if( symbol == NULL )
+    {
+        printf( "'%s' has no main to run.\n", source_path );
+        return 1;
     }
 
-    char command[1024];
-    sprintf( command, "gcc %s -I%s/.. -o %s.exe -std=gnu99 -Wall -Wextra",
-             file_name,
-             octo_exe_dir,
-             file_name );
+    // iso c cannot cast between data and function pointers, posix can
+    RunEntry run_entry;
+    memcpy( &run_entry, &symbol, sizeof( run_entry ) );
+
+    // the library stays loaded, the program can still have atexit() handlers
+    fflush( stdout );
+    return run_entry( program_argc, program_argv );
+}
+#endif
+
+#if !defined( _WIN32 )
+// what the thread that rebuilds a hot reloaded program needs
+typedef struct SourceWatch
+{
+    HotReload* reload;
+    FrontEndOptions front_end_options;
+    char* path;
+} SourceWatch;
+
+// rebuilds the program whenever the source changes, for as long as the
+// program runs
+static void* watch_source( void* argument )
+{
+    SourceWatch* watch = argument;
+    SourceWatcher* watcher = source_watcher_open( watch->path );
+    for( ;; )
+    {
+        source_watcher_wait( watcher );
+
+        SourceCode source_code;
+        if( !source_code_load( &source_code, watch->path ) )
+        {
+            continue;
+        }
+
+        SemanticContext context;
+        BoundsCheckStats bounds_check_stats;
+        Expression* program = analyze_program( &source_code, &context, &watch->front_end_options,
+                                               &bounds_check_stats );
+        if( program != NULL )
+        {
+            hot_reload_update( watch->reload, &context, program );
+        }
+        source_code_free( &source_code );
+        fflush( stdout );
+    }
+
+    return NULL;
+}
+#endif
+
+// runs the program from shared objects while another thread rebuilds the
+// functions that change in the source, returns the exit code of the program
+static int run_hot_reloaded( SemanticContext* context, Expression* program, FrontEndOptions* front_end_options,
+                             char* include_directory, char* cache_directory, int program_argc, char** program_argv )
+{
+    ObjectCache cache;
+    char* runtime_header_path = calloc( 1, strlen( include_directory ) + sizeof( "/../octoruntime/types.h" ) );
+    if( runtime_header_path == NULL ) ALLOC_ERROR();
+    sprintf( runtime_header_path, "%s/../octoruntime/types.h", include_directory );
+    bool is_cache_open = object_cache_open( &cache, cache_directory, runtime_header_path );
+    free( runtime_header_path );
+    if( !is_cache_open )
+    {
+        return 1;
+    }
+
+    // the objects are only compiled in the cache directory, they are removed
+    // as soon as they are loaded
+    HotReload* reload = hot_reload_load( context, program, include_directory, cache.directory );
+    if( reload == NULL )
+    {
+        return 1;
+    }
+
+#if !defined( _WIN32 )
+    SourceWatch* watch = calloc( 1, sizeof( SourceWatch ) );
+    if( watch == NULL ) ALLOC_ERROR();
+    watch->reload = reload;
+    watch->front_end_options = *front_end_options;
+    watch->path = context->source_code->path;
+
+    pthread_t watch_thread;
+    if( pthread_create( &watch_thread, NULL, watch_source, watch ) != 0 )
+    {
+        printf( "Could not start watching '%s', running without hot reloading.\n", context->source_code->path );
+    }
+#else
+    ( void )front_end_options;
+#endif
+
+    return hot_reload_run( reload, program_argc, program_argv );
+}
+
+// a program that `octo serve` analyzed for an earlier request. it is used
+// again for as long as the source and the options of the front end are the same
+typedef struct AnalyzedProgram
+{
+    Arena* arena; // has everything below, and whatever analyzing the program allocated
+    char* absolute_path;
+    uint64_t source_hash;
+    FrontEndOptions options;
+    SourceCode* source_code;
+    SemanticContext context;
+    Expression* program;
+    BoundsCheckStats bounds_check_stats;
+    uint64_t modules_hash; // of the modules the program imports, when it was analyzed
+} AnalyzedProgram;
+
+static uint64_t hash_imported_modules( SemanticContext* context )
+{
+    uint64_t hash = HASH_INITIAL;
+    size_t interface_count = lvec_get_length( context->imported_interface_paths );
+    for( size_t i = 0; i < interface_count; i++ )
+    {
+        hash = hash_module_stamp( hash, context->imported_interface_paths[ i ] );
+    }
+
+    return hash;
+}
+
+static bool is_same_front_end( FrontEndOptions* a, FrontEndOptions* b )
+{
+    // the purity report is only printed, it does not change the program
+    return a->bounds_checks == b->bounds_checks && a->inline_threshold == b->inline_threshold && a->use_ir == b->use_ir;
+}
+
+// like analyze_program(), but takes the program from `analyzed_programs` if it
+// was analyzed before. `source_code` is freed and replaced by the copy that is
+// kept with the program. a program that changed replaces the one before it,
+// which is freed
+static Expression* analyze_program_cached( AnalyzedProgram** analyzed_programs, SourceCode* source_code,
+                                           SemanticContext* context, FrontEndOptions* options,
+                                           BoundsCheckStats* out_bounds_check_stats )
+{
+    char* absolute_path = get_absolute_path( source_code->path );
+    if( absolute_path == NULL )
+    {
+        return NULL;
+    }
+    uint64_t source_hash = hash_bytes( HASH_INITIAL, source_code->code, source_code->length );
+
+    // the path as it was given ends up in messages, so it has to match as well
+    AnalyzedProgram* previous = NULL;
+    size_t analyzed_count = lvec_get_length( *analyzed_programs );
+    for( size_t i = 0; i < analyzed_count; i++ )
+    {
+        AnalyzedProgram* analyzed = &( *analyzed_programs )[ i ];
+        if( strcmp( analyzed->absolute_path, absolute_path ) == 0 &&
+            strcmp( analyzed->source_code->path, source_code->path ) == 0 &&
+            is_same_front_end( &analyzed->options, options ) )
+        {
+            previous = analyzed;
+            break;
+        }
+    }
+
+    if( previous != NULL && previous->source_hash == source_hash &&
+        previous->modules_hash == hash_imported_modules( &previous->context ) )
+    {
+        free( absolute_path );
+        source_code_free( source_code );
+        *source_code = *previous->source_code;
+        *context = previous->context;
+        *out_bounds_check_stats = previous->bounds_check_stats;
+        if( options->report_purity )
+        {
+            print_purity_report( previous->program );
+        }
+
+        return previous->program;
+    }
+
+    // the program outlives the command, which frees what it allocated itself
+    Arena* arena = arena_new();
+    Arena* previous_arena = arena_make_current( arena );
+    SourceCode* kept_source_code = malloc( sizeof( SourceCode ) );
+    char* kept_absolute_path = malloc( strlen( absolute_path ) + 1 );
+    if( kept_source_code == NULL || kept_absolute_path == NULL ) ALLOC_ERROR();
+    source_code_initialize( kept_source_code, source_code->path, source_code->code, source_code->length );
+    kept_source_code->diagnostics = source_code->diagnostics;
+    strcpy( kept_absolute_path, absolute_path );
+
+    Expression* program = analyze_program( kept_source_code, context, options, out_bounds_check_stats );
+    arena_make_current( previous_arena );
+    free( absolute_path );
+    if( program == NULL )
+    {
+        arena_free( arena );
+        return NULL;
+    }
+
+    source_code_free( source_code );
+    *source_code = *kept_source_code;
+
+    AnalyzedProgram analyzed = {
+        .arena = arena,
+        .absolute_path = kept_absolute_path,
+        .source_hash = source_hash,
+        .options = *options,
+        .source_code = kept_source_code,
+        .context = *context,
+        .program = program,
+        .bounds_check_stats = *out_bounds_check_stats,
+        .modules_hash = hash_imported_modules( context ),
+    };
+    if( previous != NULL )
+    {
+        arena_free( previous->arena );
+        *previous = analyzed;
+    }
+    else
+    {
+        lvec_append_aggregate( *analyzed_programs, analyzed );
+    }
+
+    return program;
+}
+
+// the path of the octo executable and the directory it is in, where the
+// runtime is found
+static void get_octo_exe_path( char** out_path, char** out_directory )
+{
+    int octo_exe_path_length = wai_getExecutablePath( NULL, 0, NULL );
+    char* octo_exe_path = calloc( 1, octo_exe_path_length + 1 );
+    char* octo_exe_dir = calloc( 1, octo_exe_path_length + 1 );
+    if( octo_exe_path == NULL || octo_exe_dir == NULL ) ALLOC_ERROR();
+    wai_getExecutablePath( octo_exe_path, octo_exe_path_length, NULL );
+    memcpy( octo_exe_dir, octo_exe_path, octo_exe_path_length );
+
+    // get only the directory
+    for( int i = octo_exe_path_length; i >= 0; i-- )
+    {
+        char* c = &octo_exe_dir[ i ];
+        if( *c == '\\' || *c == '/' )
+        {
+            *c = 0;
+            break;
+        }
+    }
+
+    *out_path = octo_exe_path;
+    *out_directory = octo_exe_dir;
+}
+
+static int run_command( int argc, char* argv[], ServeRequest* request, void* data );
+
+// runs a command of the server or of `--watch` in an arena that is freed when
+// it returns, also when its program has errors. the programs that are kept
+// have arenas of their own
+static int run_command_in_arena( int argc, char* argv[], ServeRequest* request, void* data )
+{
+    Arena* arena = arena_new();
+    Arena* previous_arena = arena_make_current( arena );
+    int exit_code = run_command( argc, argv, request, data );
+    arena_make_current( previous_arena );
+    arena_free( arena );
+
+    return exit_code;
+}
+
+// `octo build --watch` builds the program again every time the source changes,
+// until the compiler is stopped
+static int build_watched( int argc, char* argv[], char* source_path )
+{
+    // opened first, so that a change during the first build is not missed
+    SourceWatcher* watcher = source_watcher_open( source_path );
+    AnalyzedProgram* analyzed_programs = lvec_new( AnalyzedProgram );
+    for( ;; )
+    {
+        struct timespec start;
+        timespec_get( &start, TIME_UTC );
+
+        int exit_code = run_command_in_arena( argc, argv, NULL, &analyzed_programs );
+
+        struct timespec end;
+        timespec_get( &end, TIME_UTC );
+        long milliseconds = ( end.tv_sec - start.tv_sec ) * 1000 + ( end.tv_nsec - start.tv_nsec ) / 1000000;
+        printf( "%s in %ld ms, waiting for '%s' to change\n", exit_code == 0 ? "built" : "failed", milliseconds,
+                source_path );
+        fflush( stdout );
+
+        source_watcher_wait( watcher );
+    }
+
+    source_watcher_close( watcher );
+    return 0;
+}
+
+// runs one command line, either in this process or for a request on the
+// server. `data` are the programs the server or `--watch` analyzed so far
+static int run_command( int argc, char* argv[], ServeRequest* request, void* data )
+{
+    AnalyzedProgram** analyzed_programs = data;
+    char** source_file_paths = lvec_new( char* );
+    bool bounds_checks = false;
+    bool emit_c = false;
+    bool report_purity = false;
+    bool use_ir = true;
+    bool emit_ir = false;
+    bool use_native = false;
+    bool is_running = false;
+    bool use_interpreter = false;
+    bool use_hot_reload = false;
+    bool use_watch = false;
+    CheckMode check_mode = CHECKMODE_DIAGNOSTIC;
+    int inline_threshold = DEFAULT_INLINE_THRESHOLD;
+    int job_count = 1;
+    bool use_cache = true;
+    char* cache_directory = NULL;
+    BuildProfile profile = BUILDPROFILE_DEBUG;
+    char* pgo_command = NULL;
+    int program_argc = 0;
+    char** program_argv = NULL;
+
+    // `octo build <file>` is the same as `octo <file>`. `octo run <file> [args]`
+    // runs the program after building it, everything after the file is passed
+    // to the program
+    int first_option = 1;
+    if( argc > 1 && strcmp( argv[ 1 ], "build" ) == 0 )
+    {
+        first_option = 2;
+    }
+    else if( argc > 1 && strcmp( argv[ 1 ], "run" ) == 0 )
+    {
+        first_option = 2;
+        is_running = true;
+    }
+
+    for( int i = first_option; i < argc; i++ )
+    {
+        char* arg = argv[ i ];
+        if( strcmp( arg, "--bounds-checks" ) == 0 || strcmp( arg, "--bounds-checks=diagnostic" ) == 0 )
+        {
+            bounds_checks = true;
+            check_mode = CHECKMODE_DIAGNOSTIC;
+        }
+        else if( strcmp( arg, "--bounds-checks=trap" ) == 0 )
+        {
+            bounds_checks = true;
+            check_mode = CHECKMODE_TRAP;
+        }
+        else if( strcmp( arg, "--emit-c" ) == 0 )
+        {
+            emit_c = true;
+        }
+        else if( strcmp( arg, "--no-ir" ) == 0 )
+        {
+            use_ir = false;
+        }
+        else if( strcmp( arg, "--emit-ir" ) == 0 )
+        {
+            emit_ir = true;
+        }
+        else if( strcmp( arg, "--native" ) == 0 )
+        {
+            use_native = true;
+        }
+        else if( strcmp( arg, "--interp" ) == 0 )
+        {
+            use_interpreter = true;
+        }
+        else if( strcmp( arg, "--hot-reload" ) == 0 )
+        {
+            use_hot_reload = true;
+        }
+        else if( strcmp( arg, "--watch" ) == 0 )
+        {
+            use_watch = true;
+        }
+        else if( strcmp( arg, "--report-purity" ) == 0 )
+        {
+            report_purity = true;
+        }
+        else if( strcmp( arg, "--inline-threshold" ) == 0 )
+        {
+            if( i + 1 >= argc )
+            {
+                printf( "Missing threshold after '--inline-threshold'.\n" );
+                return -1;
+            }
+
+            i++;
+            char* end;
+            inline_threshold = strtol( argv[ i ], &end, 10 );
+            if( *argv[ i ] == '\0' || *end != '\0' || inline_threshold < 0 )
+            {
+                printf( "Invalid inline threshold '%s'.\n", argv[ i ] );
+                return -1;
+            }
+        }
+        else if( strcmp( arg, "--debug" ) == 0 )
+        {
+            profile = BUILDPROFILE_DEBUG;
+        }
+        else if( strcmp( arg, "--release" ) == 0 )
+        {
+            profile = BUILDPROFILE_RELEASE;
+        }
+        else if( strcmp( arg, "--size" ) == 0 )
+        {
+            profile = BUILDPROFILE_SIZE;
+        }
+        else if( strcmp( arg, "--pgo" ) == 0 )
+        {
+            if( i + 1 >= argc )
+            {
+                printf( "Missing training command after '--pgo'.\n" );
+                return -1;
+            }
+
+            i++;
+            pgo_command = argv[ i ];
+        }
+        else if( strcmp( arg, "--no-cache" ) == 0 )
+        {
+            use_cache = false;
+        }
+        else if( strcmp( arg, "--cache-dir" ) == 0 )
+        {
+            if( i + 1 >= argc )
+            {
+                printf( "Missing directory after '--cache-dir'.\n" );
+                return -1;
+            }
+
+            i++;
+            cache_directory = argv[ i ];
+        }
+        else if( strcmp( arg, "--no-server" ) == 0 )
+        {
+            // only for main()
+        }
+        else if( strcmp( arg, "--socket" ) == 0 )
+        {
+            if( i + 1 >= argc )
+            {
+                printf( "Missing path after '--socket'.\n" );
+                return -1;
+            }
+
+            // only for main()
+            i++;
+        }
+        else if( strncmp( arg, "-j", 2 ) == 0 )
+        {
+            // both "-j 8" and "-j8"
+            char* count = arg + 2;
+            if( *count == '\0' && i + 1 < argc )
+            {
+                i++;
+                count = argv[ i ];
+            }
+
+            char* end;
+            job_count = strtol( count, &end, 10 );
+            if( *count == '\0' || *end != '\0' || job_count < 1 )
+            {
+                printf( "Invalid job count '%s'.\n", count );
+                return -1;
+            }
+        }
+        else if( arg[ 0 ] == '-' )
+        {
+            printf( "Unknown option '%s'.\n", arg );
+            return -1;
+        }
+        else
+        {
+            lvec_append( source_file_paths, arg );
+            if( is_running )
+            {
+                // the program sees its own path as its first argument
+                program_argc = argc - i;
+                program_argv = &argv[ i ];
+                break;
+            }
+        }
+    }
+
+    int source_count = ( int )lvec_get_length( source_file_paths );
+    if( source_count == 0 )
+    {
+        printf( "No file specified.\n" );
+        return -1;
+    }
+    char* source_file_path = source_file_paths[ 0 ];
+
+    if( use_interpreter && !is_running )
+    {
+        printf( "'--interp' only works with 'octo run'.\n" );
+        return -1;
+    }
+
+    if( use_hot_reload && ( !is_running || use_interpreter || use_native ) )
+    {
+        printf( "'--hot-reload' only works with 'octo run', without '--interp' or '--native'.\n" );
+        return -1;
+    }
+
+    // a call that was inlined would keep running the code of the function
+    // from before it changed
+    if( use_hot_reload )
+    {
+        inline_threshold = 0;
+    }
+
+    // the program would run in the server instead of where it was started
+    if( is_running && request != NULL )
+    {
+        printf( "'octo run' does not go through the server.\n" );
+        return -1;
+    }
+
+    if( use_watch && ( is_running || request != NULL || source_count > 1 ) )
+    {
+        printf( "'--watch' only works with 'octo build' of a single file, without the server.\n" );
+        return -1;
+    }
+
+    // a change only compiles the shards it touches again, the others are in
+    // the object cache
+    if( use_watch && job_count == 1 )
+    {
+        job_count = WATCH_JOB_COUNT;
+    }
+
+    // every build of the loop runs this again, with the programs it keeps
+    if( use_watch && analyzed_programs == NULL )
+    {
+        return build_watched( argc, argv, source_file_path );
+    }
+
+    c_compiler_set_check_mode( check_mode );
+    c_compiler_configure( profile, PROFILEGUIDANCE_NONE, NULL );
+    SourceCode* sources = calloc( source_count, sizeof( SourceCode ) );
+    if( sources == NULL ) ALLOC_ERROR();
+    for( int i = 0; i < source_count; i++ )
+    {
+        if( !source_code_load( &sources[ i ], source_file_paths[ i ] ) )
+        {
+            printf( "Could not read '%s'.\n", source_file_paths[ i ] );
+            return 1;
+        }
+    }
+    SourceCode source_code = sources[ 0 ];
+
+    char* octo_exe_path;
+    char* octo_exe_dir;
+    get_octo_exe_path( &octo_exe_path, &octo_exe_dir );
+
+    // the executable is named after the first file
+    size_t path_length = strlen( source_code.path );
+    char* output_path = calloc( 1, path_length + sizeof( ".exe" ) );
+    if( output_path == NULL ) ALLOC_ERROR();
+    sprintf( output_path, "%s.exe", source_code.path );
+
+    // a build that only writes the executable does nothing if the manifest
+    // says it was built from the same inputs
+    char* manifest_path = NULL;
+    char* runtime_header_path = calloc( 1, strlen( octo_exe_dir ) + sizeof( "/../octoruntime/types.h" ) );
+    if( runtime_header_path == NULL ) ALLOC_ERROR();
+    sprintf( runtime_header_path, "%s/../octoruntime/types.h", octo_exe_dir );
+    if( !is_running && use_cache && !emit_c && !emit_ir && !report_purity )
+    {
+        manifest_path = calloc( 1, strlen( output_path ) + sizeof( ".manifest" ) );
+        if( manifest_path == NULL ) ALLOC_ERROR();
+        sprintf( manifest_path, "%s.manifest", output_path );
+
+        CodeBuffer manifest;
+        code_buffer_initialize( &manifest );
+        char** interface_paths = read_manifest_interface_paths( manifest_path );
+        generate_manifest( &manifest, argc, argv, sources, source_count, interface_paths, octo_exe_path,
+                           runtime_header_path, output_path );
+        bool is_current = is_manifest_current( manifest_path, &manifest );
+        code_buffer_free( &manifest );
+        for( size_t i = 0; i < lvec_get_length( interface_paths ); i++ )
+        {
+            free( interface_paths[ i ] );
+        }
+        lvec_free( interface_paths );
+        if( is_current )
+        {
+            printf( "'%s' is up to date.\n", output_path );
+            return 0;
+        }
+    }
+
+    // `octo run` keeps the program as a shared object in the cache and loads it
+    // into this process, so a program that did not change is neither compiled
+    // nor even parsed again. anything that builds differently or writes more
+    // than the executable goes through an executable instead
+    char* shared_object_path = NULL;
+#if !defined( _WIN32 )
+    bool use_shared_object = is_running && !use_interpreter && !use_hot_reload && !use_native && pgo_command == NULL && !emit_c &&
+        !emit_ir && !report_purity && job_count == 1 && use_cache;
+    ObjectCache cache;
+    if( use_shared_object )
+    {
+        if( object_cache_open( &cache, cache_directory, runtime_header_path ) )
+        {
+            uint64_t program_hash = hash_program_inputs( &source_code, octo_exe_path, bounds_checks, check_mode,
+                                                         inline_threshold, use_ir );
+            shared_object_path = object_cache_get_program_path( &cache, program_hash );
+            object_cache_close( &cache );
+        }
+        free( runtime_header_path );
+    }
+
+    if( shared_object_path != NULL && object_cache_contains( shared_object_path ) )
+    {
+        return run_shared_object( shared_object_path, source_code.path, program_argc, program_argv );
+    }
+#endif
+
+    SemanticContext semantic_context;
+    BoundsCheckStats bounds_check_stats = { 0 };
+    FrontEndOptions front_end_options = {
+        .bounds_checks = bounds_checks,
+        .report_purity = report_purity,
+        .inline_threshold = inline_threshold,
+        .use_ir = use_ir,
+    };
+    Expression* program;
+    if( analyzed_programs != NULL && source_count == 1 )
+    {
+        // the source can be swapped for the same one from before
+        program = analyze_program_cached( analyzed_programs, &sources[ 0 ], &semantic_context, &front_end_options,
+                                          &bounds_check_stats );
+        source_code = sources[ 0 ];
+    }
+    else
+    {
+        program = analyze_files( sources, source_count, job_count, &semantic_context, &front_end_options,
+                                 &bounds_check_stats );
+    }
+    if( program == NULL )
+    {
+        return 1;
+    }
+
+    bool is_module = semantic_context.module_name != NULL;
+    if( is_module && is_running )
+    {
+        printf( "'%s' is the module '%s', which can only be built and imported.\n", source_code.path,
+                semantic_context.module_name );
+        return 1;
+    }
+
+    // the objects of the imported modules are linked into whatever is built.
+    // the shared object and hot reloading would need them to be position
+    // independent
+    size_t import_count = lvec_get_length( semantic_context.imported_interface_paths );
+    char** module_object_paths = lvec_new( char* );
+    for( size_t i = 0; i < import_count; i++ )
+    {
+        lvec_append( module_object_paths, get_module_object_path( semantic_context.imported_interface_paths[ i ] ) );
+    }
+    c_compiler_set_link_objects( module_object_paths, ( int )import_count );
+    if( import_count > 0 )
+    {
+        if( use_hot_reload )
+        {
+            printf( "'--hot-reload' does not work with programs that import modules.\n" );
+            return 1;
+        }
+        shared_object_path = NULL;
+    }
+
+    if( emit_ir && !write_ir( program, source_code.path ) )
+    {
+        return 1;
+    }
+
+    // the server takes the next request while this one is compiled
+    if( !serve_detach( request ) )
+    {
+        free( octo_exe_path );
+        free( octo_exe_dir );
+        return 0;
+    }
+
+    if( is_module )
+    {
+        return build_module( &semantic_context, program, octo_exe_dir ) ? 0 : 1;
+    }
+
+    if( use_hot_reload )
+    {
+        return run_hot_reloaded( &semantic_context, program, &front_end_options, octo_exe_dir, cache_directory,
+                                 program_argc, program_argv );
+    }
+
+    if( use_interpreter )
+    {
+        int exit_code;
+        if( !use_ir )
+        {
+            printf( "The interpreter runs the ir, building with gcc instead.\n" );
+        }
+        else if( run_interpreted( program, check_mode, source_code.path, &exit_code ) )
+        {
+            return exit_code;
+        }
+        else
+        {
+            printf( "Building with gcc instead.\n" );
+        }
+    }
+
+    BuildOptions build_options = {
+        .source_path = source_code.path,
+        .emit_c = emit_c,
+        .job_count = job_count,
+        .use_cache = use_cache,
+        .cache_directory = cache_directory,
+        .output_path = output_path,
+        .include_directory = octo_exe_dir,
+    };
+
+    bool is_compiled;
+    if( shared_object_path != NULL )
+    {
+        is_compiled = build_shared_object( &semantic_context, program, shared_object_path, octo_exe_dir );
+    }
+    else if( use_native && can_build_natively( program, use_ir, profile, pgo_command, &build_options ) )
+    {
+        is_compiled = build_native( program, check_mode, source_code.path, output_path );
+    }
+    else if( pgo_command != NULL )
+    {
+        is_compiled = build_with_profile( &semantic_context, program, &build_options, profile, pgo_command );
+    }
+    else
+    {
+        c_compiler_configure( profile, PROFILEGUIDANCE_NONE, NULL );
+        is_compiled = build_executable( &semantic_context, program, &build_options );
+    }
+
+    if( is_running && !is_compiled )
+    {
+        return 1;
+    }
+
+    if( manifest_path != NULL && is_compiled )
+    {
+        write_manifest( manifest_path, argc, argv, sources, source_count, semantic_context.imported_interface_paths,
+                        octo_exe_path, runtime_header_path, output_path );
+    }
+#if !defined( _WIN32 )
+    if( shared_object_path != NULL )
+    {
+        return run_shared_object( shared_object_path, source_code.path, program_argc, program_argv );
+    }
+#endif
+    if( is_running )
+    {
+        return run_executable( output_path, program_argc, program_argv );
+    }
+
+    for( int i = 0; i < semantic_context.symbol_table.length; i++ )
+    {
+        Symbol symbol = semantic_context.symbol_table.symbols[ i ];
+        printf( "%s: ", symbol.token.as_string );
+        debug_print_type( symbol.type );
+        putchar( '\n' );
+    }
+
+    expression_print( program );
+    putchar( '\n' );
+
+    if( bounds_checks )
+    {
+        printf( "bounds checks: %d emitted, %d eliminated\n",
+                bounds_check_stats.checked_count,
+                bounds_check_stats.eliminated_count );
+    }
+
+    return is_compiled ? 0 : 1;
+}
+
+// where `octo serve` listens, `--socket` or the cache directory. null if there
+// is no cache directory
+static char* get_socket_path( int argc, char* argv[] )
+{
+    for( int i = 1; i + 1 < argc; i++ )
+    {
+        if( strcmp( argv[ i ], "--socket" ) == 0 )
+        {
+            char* socket_path = calloc( 1, strlen( argv[ i + 1 ] ) + 1 );
+            if( socket_path == NULL ) ALLOC_ERROR();
+            strcpy( socket_path, argv[ i + 1 ] );
+            return socket_path;
+        }
+    }
+
+    char* cache_directory = object_cache_get_default_directory();
+    if( cache_directory == NULL )
+    {
+        return NULL;
+    }
+
+    char* socket_path = calloc( 1, strlen( cache_directory ) + sizeof( "/serve.sock" ) );
+    if( socket_path == NULL ) ALLOC_ERROR();
+    sprintf( socket_path, "%s/serve.sock", cache_directory );
+    free( cache_directory );
+    return socket_path;
+}
+
+// a server only takes requests from the same build of octo
+static uint64_t get_serve_version( void )
+{
+    char* octo_exe_path;
+    char* octo_exe_dir;
+    get_octo_exe_path( &octo_exe_path, &octo_exe_dir );
+    uint64_t version = object_cache_hash_file_stamp( HASH_INITIAL, octo_exe_path );
+
+    free( octo_exe_path );
+    free( octo_exe_dir );
+    return version;
+}
+
+// `octo serve [--socket <path>]`
+static int run_server( int argc, char* argv[] )
+{
+    for( int i = 2; i < argc; i++ )
+    {
+        if( strcmp( argv[ i ], "--socket" ) == 0 && i + 1 < argc )
+        {
+            i++;
+        }
+        else
+        {
+            printf( "Unknown option '%s'.\n", argv[ i ] );
+            return -1;
+        }
+    }
+
+    char* socket_path = get_socket_path( argc, argv );
+    if( socket_path == NULL )
+    {
+        printf( "There is no cache directory for the socket, use '--socket'.\n" );
+        return 1;
+    }
+
+    // the default socket is in the cache directory, which might not exist yet
+    char* cache_directory = object_cache_get_default_directory();
+    if( cache_directory != NULL )
+    {
+        char* octo_exe_path;
+        char* octo_exe_dir;
+        get_octo_exe_path( &octo_exe_path, &octo_exe_dir );
+        char* runtime_header_path = calloc( 1, strlen( octo_exe_dir ) + sizeof( "/../octoruntime/types.h" ) );
+        if( runtime_header_path == NULL ) ALLOC_ERROR();
+        sprintf( runtime_header_path, "%s/../octoruntime/types.h", octo_exe_dir );
+
+        ObjectCache cache;
+        if( object_cache_open( &cache, cache_directory, runtime_header_path ) )
+        {
+            object_cache_close( &cache );
+        }
+
+        free( runtime_header_path );
+        free( octo_exe_path );
+        free( octo_exe_dir );
+        free( cache_directory );
+    }
+
+    AnalyzedProgram* analyzed_programs = lvec_new( AnalyzedProgram );
+    bool is_served = serve_requests( socket_path, get_serve_version(), run_command_in_arena, &analyzed_programs );
+
+    free( socket_path );
+    return is_served ? 0 : 1;
+}
+
+int main( int argc, char* argv[] )
+{
+    if( argc > 1 && strcmp( argv[ 1 ], "serve" ) == 0 )
+    {
+        return run_server( argc, argv );
+    }
+
+    // a build goes to the server if one is running. `octo run` has to run the
+    // program in this process, and `--watch` keeps building in this process
+    bool use_server = argc > 1 && strcmp( argv[ 1 ], "run" ) != 0;
+    for( int i = 1; i < argc && use_server; i++ )
+    {
+        if( strcmp( argv[ i ], "--no-server" ) == 0 || strcmp( argv[ i ], "--watch" ) == 0 )
+        {
+            use_server = false;
+        }
+    }
+
+    char* socket_path = use_server ? get_socket_path( argc, argv ) : NULL;
+    if( socket_path != NULL )
+    {
+        int exit_code;
+        bool is_forwarded = serve_forward( socket_path, get_serve_version(), argc, argv, &exit_code );
+        free( socket_path );
+        if( is_forwarded )
+        {
+            return exit_code;
+        }
+    }
 
-    // temporarily use this to test
-    system( command );
-    // system("del generated.c");
+    return run_command( argc, argv, NULL, NULL );
 }
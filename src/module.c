@@ -0,0 +1,732 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codebuffer.h"
+#include "debug.h"
+#include "error.h"
+#include "lvec.h"
+#include "module.h"
+#include "parser.h"
+#include "semantic.h"
+
+// an interface is the magic and the version, the name of the module, the names
+// of the modules it imports and then its declarations in program order.
+// integers are little endian u32s, kinds are single bytes and strings are
+// their length followed by their bytes
+#define INTERFACE_MAGIC "OCTOI"
+#define INTERFACE_VERSION 1
+
+// how deep types can nest in an interface that is read, so that a broken one
+// cannot overflow the stack
+#define MAX_TYPE_DEPTH 256
+
+typedef enum InterfaceDeclaration
+{
+    INTERFACEDECLARATION_TYPE,
+    INTERFACEDECLARATION_FUNCTION,
+} InterfaceDeclaration;
+
+typedef enum InterfaceType
+{
+    INTERFACETYPE_IDENTIFIER,
+    INTERFACETYPE_POINTER,
+    INTERFACETYPE_ARRAY,
+    INTERFACETYPE_STRUCT,
+    INTERFACETYPE_UNION,
+} InterfaceType;
+
+// what purity analysis found out about a function is exported as attributes,
+// which is all that the callers in other modules can go by
+static const struct
+{
+    FunctionAttribute flag;
+    char* identifier;
+} exported_attributes[] = {
+    { FUNCTIONATTRIBUTE_PURE,     "pure" },
+    { FUNCTIONATTRIBUTE_CONST,    "const" },
+    { FUNCTIONATTRIBUTE_NORETURN, "noreturn" },
+};
+
+#define EXPORTED_ATTRIBUTES ( FUNCTIONATTRIBUTE_PURE | FUNCTIONATTRIBUTE_CONST | FUNCTIONATTRIBUTE_NORETURN )
+
+typedef struct InterfaceReader
+{
+    char* data;
+    size_t length;
+    size_t position;
+    bool is_valid; // false as soon as something does not fit
+
+    // the name in the import, where everything that is read is reported
+    Token location;
+} InterfaceReader;
+
+typedef struct ModuleResolver
+{
+    SemanticContext* context;
+    Expression** statements; // the top level of the program with the imports resolved
+    bool is_valid;
+} ModuleResolver;
+
+static void write_u8( CodeBuffer* buffer, uint8_t value )
+{
+    code_buffer_append_char( buffer, ( char )value );
+}
+
+static void write_u32( CodeBuffer* buffer, uint32_t value )
+{
+    for( int i = 0; i < 4; i++ )
+    {
+        write_u8( buffer, ( uint8_t )( value >> ( 8 * i ) ) );
+    }
+}
+
+static void write_string( CodeBuffer* buffer, char* string )
+{
+    size_t length = strlen( string );
+    write_u32( buffer, ( uint32_t )length );
+    code_buffer_append_data( buffer, string, length );
+}
+
+static void write_type_rvalue( CodeBuffer* buffer, Expression* type_rvalue )
+{
+    switch( type_rvalue->kind )
+    {
+        case EXPRESSIONKIND_TYPEIDENTIFIER:
+        {
+            write_u8( buffer, INTERFACETYPE_IDENTIFIER );
+            write_string( buffer, type_rvalue->type_identifier.token.as_string );
+            break;
+        }
+
+        case EXPRESSIONKIND_POINTERTYPE:
+        {
+            write_u8( buffer, INTERFACETYPE_POINTER );
+            write_type_rvalue( buffer, type_rvalue->pointer_type.base_type_rvalue );
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYTYPE:
+        {
+            write_u8( buffer, INTERFACETYPE_ARRAY );
+            write_u32( buffer, ( uint32_t )type_rvalue->array_type.length );
+            write_type_rvalue( buffer, type_rvalue->array_type.base_type_rvalue );
+            break;
+        }
+
+        case EXPRESSIONKIND_COMPOUNDDEFINITION:
+        {
+            write_u8( buffer, type_rvalue->compound_definition.is_struct ? INTERFACETYPE_STRUCT : INTERFACETYPE_UNION );
+            write_u32( buffer, ( uint32_t )type_rvalue->compound_definition.member_count );
+            for( int i = 0; i < type_rvalue->compound_definition.member_count; i++ )
+            {
+                write_string( buffer, type_rvalue->compound_definition.member_identifier_tokens[ i ].as_string );
+                write_type_rvalue( buffer, &type_rvalue->compound_definition.member_type_rvalues[ i ] );
+            }
+            break;
+        }
+
+        default:
+        {
+            UNREACHABLE();
+        }
+    }
+}
+
+static void write_function( CodeBuffer* buffer, Expression* function )
+{
+    write_u8( buffer, INTERFACEDECLARATION_FUNCTION );
+    write_string( buffer, function->function_declaration.identifier_token.as_string );
+    write_u32( buffer, function->function_declaration.attributes & EXPORTED_ATTRIBUTES );
+    write_u8( buffer, function->function_declaration.is_variadic );
+
+    write_u32( buffer, function->function_declaration.param_count );
+    for( int i = 0; i < function->function_declaration.param_count; i++ )
+    {
+        write_string( buffer, function->function_declaration.param_identifiers_tokens[ i ].as_string );
+        write_type_rvalue( buffer, &function->function_declaration.param_type_rvalues[ i ] );
+    }
+
+    write_type_rvalue( buffer, function->function_declaration.return_type_rvalue );
+}
+
+static uint8_t read_u8( InterfaceReader* reader )
+{
+    if( reader->position >= reader->length )
+    {
+        reader->is_valid = false;
+        return 0;
+    }
+
+    uint8_t value = ( uint8_t )reader->data[ reader->position ];
+    reader->position++;
+    return value;
+}
+
+static uint32_t read_u32( InterfaceReader* reader )
+{
+    uint32_t value = 0;
+    for( int i = 0; i < 4; i++ )
+    {
+        value |= ( uint32_t )read_u8( reader ) << ( 8 * i );
+    }
+
+    return value;
+}
+
+// returns an empty string if there is none
+static char* read_string( InterfaceReader* reader )
+{
+    uint32_t length = read_u32( reader );
+    if( !reader->is_valid || length > reader->length - reader->position )
+    {
+        reader->is_valid = false;
+        return "";
+    }
+
+    char* string = malloc( length + 1 );
+    if( string == NULL ) ALLOC_ERROR();
+    memcpy( string, reader->data + reader->position, length );
+    string[ length ] = '\0';
+    reader->position += length;
+
+    return string;
+}
+
+// errors in what the module declares are reported at the import
+static Token make_token( InterfaceReader* reader, TokenKind kind, char* string )
+{
+    Token token = reader->location;
+    token.kind = kind;
+    token.as_string = string;
+    token.identifier = string;
+    return token;
+}
+
+// starts with the `import` token, which tells the declarations of imported
+// modules apart from those of the program
+static Expression* new_expression( InterfaceReader* reader, ExpressionKind kind )
+{
+    Expression* expression = calloc( 1, sizeof( Expression ) );
+    if( expression == NULL ) ALLOC_ERROR();
+
+    expression->kind = kind;
+    expression->starting_token = make_token( reader, TOKENKIND_IMPORT, "import" );
+    return expression;
+}
+
+// returns null if the interface is broken
+static Expression* read_type_rvalue( InterfaceReader* reader, int depth )
+{
+    uint8_t kind = read_u8( reader );
+    if( !reader->is_valid || depth > MAX_TYPE_DEPTH )
+    {
+        reader->is_valid = false;
+        return NULL;
+    }
+
+    switch( kind )
+    {
+        case INTERFACETYPE_IDENTIFIER:
+        {
+            Expression* expression = new_expression( reader, EXPRESSIONKIND_TYPEIDENTIFIER );
+            expression->type_identifier.token = make_token( reader, TOKENKIND_IDENTIFIER, read_string( reader ) );
+            return expression;
+        }
+
+        case INTERFACETYPE_POINTER:
+        {
+            Expression* base_type_rvalue = read_type_rvalue( reader, depth + 1 );
+            if( base_type_rvalue == NULL )
+            {
+                return NULL;
+            }
+
+            Expression* expression = new_expression( reader, EXPRESSIONKIND_POINTERTYPE );
+            expression->pointer_type.base_type_rvalue = base_type_rvalue;
+            return expression;
+        }
+
+        case INTERFACETYPE_ARRAY:
+        {
+            int length = ( int32_t )read_u32( reader );
+            Expression* base_type_rvalue = read_type_rvalue( reader, depth + 1 );
+            if( base_type_rvalue == NULL )
+            {
+                return NULL;
+            }
+
+            Expression* expression = new_expression( reader, EXPRESSIONKIND_ARRAYTYPE );
+            expression->array_type.length = length;
+            expression->array_type.base_type_rvalue = base_type_rvalue;
+            return expression;
+        }
+
+        case INTERFACETYPE_STRUCT:
+        case INTERFACETYPE_UNION:
+        {
+            Token* member_identifier_tokens = lvec_new( Token );
+            Expression* member_type_rvalues = lvec_new( Expression );
+
+            uint32_t member_count = read_u32( reader );
+            for( uint32_t i = 0; i < member_count && reader->is_valid; i++ )
+            {
+                Token member_identifier_token = make_token( reader, TOKENKIND_IDENTIFIER, read_string( reader ) );
+                Expression* member_type_rvalue = read_type_rvalue( reader, depth + 1 );
+                if( member_type_rvalue == NULL )
+                {
+                    return NULL;
+                }
+
+                lvec_append_aggregate( member_identifier_tokens, member_identifier_token );
+                lvec_append_aggregate( member_type_rvalues, *member_type_rvalue );
+            }
+
+            Expression* expression = new_expression( reader, EXPRESSIONKIND_COMPOUNDDEFINITION );
+            expression->compound_definition.is_struct = kind == INTERFACETYPE_STRUCT;
+            expression->compound_definition.member_identifier_tokens = member_identifier_tokens;
+            expression->compound_definition.member_type_rvalues = member_type_rvalues;
+            expression->compound_definition.member_count = lvec_get_length( member_identifier_tokens );
+            return reader->is_valid ? expression : NULL;
+        }
+
+        default:
+        {
+            reader->is_valid = false;
+            return NULL;
+        }
+    }
+}
+
+// a type declaration as if it was written where the module is imported
+static Expression* read_type_declaration( InterfaceReader* reader )
+{
+    Expression* expression = new_expression( reader, EXPRESSIONKIND_TYPEDECLARATION );
+    expression->type_declaration.identifier_token = make_token( reader, TOKENKIND_IDENTIFIER, read_string( reader ) );
+    expression->type_declaration.rvalue = read_type_rvalue( reader, 0 );
+
+    return expression->type_declaration.rvalue != NULL ? expression : NULL;
+}
+
+// an extern with the signature of the function, and its purity as attributes
+static Expression* read_function( InterfaceReader* reader )
+{
+    Expression* function = new_expression( reader, EXPRESSIONKIND_FUNCTIONDECLARATION );
+    function->function_declaration.identifier_token = make_token( reader, TOKENKIND_IDENTIFIER, read_string( reader ) );
+
+    uint32_t attributes = read_u32( reader );
+    if( attributes & ~EXPORTED_ATTRIBUTES )
+    {
+        reader->is_valid = false;
+        return NULL;
+    }
+
+    function->function_declaration.is_variadic = read_u8( reader ) != 0;
+
+    Token* param_identifiers_tokens = lvec_new( Token );
+    Expression* param_type_rvalues = lvec_new( Expression );
+    uint32_t param_count = read_u32( reader );
+    for( uint32_t i = 0; i < param_count && reader->is_valid; i++ )
+    {
+        Token param_identifier_token = make_token( reader, TOKENKIND_IDENTIFIER, read_string( reader ) );
+        Expression* param_type_rvalue = read_type_rvalue( reader, 0 );
+        if( param_type_rvalue == NULL )
+        {
+            return NULL;
+        }
+
+        lvec_append_aggregate( param_identifiers_tokens, param_identifier_token );
+        lvec_append_aggregate( param_type_rvalues, *param_type_rvalue );
+    }
+    function->function_declaration.param_identifiers_tokens = param_identifiers_tokens;
+    function->function_declaration.param_type_rvalues = param_type_rvalues;
+    function->function_declaration.param_count = lvec_get_length( param_identifiers_tokens );
+
+    function->function_declaration.return_type_rvalue = read_type_rvalue( reader, 0 );
+    if( function->function_declaration.return_type_rvalue == NULL )
+    {
+        return NULL;
+    }
+
+    if( attributes != 0 )
+    {
+        function->attributes = lvec_new( Attribute );
+        for( size_t i = 0; i < sizeof( exported_attributes ) / sizeof( exported_attributes[ 0 ] ); i++ )
+        {
+            if( attributes & exported_attributes[ i ].flag )
+            {
+                Attribute attribute = {
+                    .identifier_token = make_token( reader, TOKENKIND_IDENTIFIER, exported_attributes[ i ].identifier ),
+                };
+                lvec_append_aggregate( function->attributes, attribute );
+            }
+        }
+    }
+
+    Expression* expression = new_expression( reader, EXPRESSIONKIND_EXTERN );
+    expression->extern_expression.function = function;
+    return expression;
+}
+
+// returns false if the file cannot be read
+static bool read_file( char* path, char** out_data, size_t* out_length )
+{
+    FILE* file = fopen( path, "rb" );
+    if( file == NULL )
+    {
+        return false;
+    }
+
+    char* data = NULL;
+    size_t length = 0;
+    size_t capacity = 0;
+    while( true )
+    {
+        if( length == capacity )
+        {
+            capacity = capacity == 0 ? 4096 : capacity * 2;
+            data = realloc( data, capacity );
+            if( data == NULL ) ALLOC_ERROR();
+        }
+
+        size_t read_count = fread( data + length, 1, capacity - length, file );
+        length += read_count;
+        if( read_count == 0 )
+        {
+            break;
+        }
+    }
+
+    bool is_read = !ferror( file );
+    fclose( file );
+    if( !is_read )
+    {
+        free( data );
+        return false;
+    }
+
+    *out_data = data;
+    *out_length = length;
+    return true;
+}
+
+// whether the file at `path` holds exactly what is in `buffer`
+static bool is_file_same( char* path, CodeBuffer* buffer )
+{
+    char* data;
+    size_t length;
+    if( !read_file( path, &data, &length ) )
+    {
+        return false;
+    }
+
+    bool is_same = length == buffer->length && memcmp( data, buffer->data, length ) == 0;
+    free( data );
+    return is_same;
+}
+
+// the directory part of `path`, "." if it has none
+static char* get_directory( char* path )
+{
+    char* last_separator = strrchr( path, '/' );
+#if defined( _WIN32 )
+    char* last_backslash = strrchr( path, '\\' );
+    if( last_backslash != NULL && ( last_separator == NULL || last_backslash > last_separator ) )
+    {
+        last_separator = last_backslash;
+    }
+#endif
+
+    if( last_separator == NULL )
+    {
+        char* directory = malloc( sizeof( "." ) );
+        if( directory == NULL ) ALLOC_ERROR();
+        strcpy( directory, "." );
+        return directory;
+    }
+
+    size_t length = last_separator - path;
+    char* directory = malloc( length + 1 );
+    if( directory == NULL ) ALLOC_ERROR();
+    memcpy( directory, path, length );
+    directory[ length ] = '\0';
+    return directory;
+}
+
+static char* get_interface_path( char* directory, char* module_name )
+{
+    char* path = malloc( strlen( directory ) + strlen( module_name ) + sizeof( "/" MODULE_INTERFACE_EXTENSION ) );
+    if( path == NULL ) ALLOC_ERROR();
+    sprintf( path, "%s/%s" MODULE_INTERFACE_EXTENSION, directory, module_name );
+    return path;
+}
+
+// the directory of the file `token` is in
+static char* get_token_directory( SemanticContext* context, Token token )
+{
+    SourceCode* source_code = token.source_code != NULL ? token.source_code : context->source_code;
+    return get_directory( source_code->path );
+}
+
+char* get_module_object_path( char* interface_path )
+{
+    size_t length = strlen( interface_path ) - strlen( MODULE_INTERFACE_EXTENSION );
+    char* object_path = malloc( length + sizeof( ".o" ) );
+    if( object_path == NULL ) ALLOC_ERROR();
+    memcpy( object_path, interface_path, length );
+    strcpy( object_path + length, ".o" );
+    return object_path;
+}
+
+static void report_module_error( ModuleResolver* resolver, ErrorKind kind, Token location, char* module_name,
+                                 char* interface_path )
+{
+    location.as_string = module_name;
+    Error error = {
+        .kind = kind,
+        .offending_token = location,
+        .missing_module.interface_path = interface_path,
+    };
+    report_error( resolver->context->source_code, error );
+    resolver->is_valid = false;
+}
+
+// appends the declarations of `module_name` from its interface in `directory`,
+// after those of the modules it imports. a module that was imported before is
+// skipped
+static void import_module( ModuleResolver* resolver, char* module_name, char* directory, Token location )
+{
+    SemanticContext* context = resolver->context;
+    if( context->module_name != NULL && strcmp( module_name, context->module_name ) == 0 )
+    {
+        report_module_error( resolver, ERRORKIND_SELFIMPORT, location, module_name, NULL );
+        return;
+    }
+
+    size_t imported_count = lvec_get_length( context->imported_module_names );
+    for( size_t i = 0; i < imported_count; i++ )
+    {
+        if( strcmp( context->imported_module_names[ i ], module_name ) == 0 )
+        {
+            return;
+        }
+    }
+
+    char* interface_path = get_interface_path( directory, module_name );
+    InterfaceReader reader = {
+        .is_valid = true,
+        .location = location,
+    };
+    if( !read_file( interface_path, &reader.data, &reader.length ) )
+    {
+        report_module_error( resolver, ERRORKIND_MISSINGMODULE, location, module_name, interface_path );
+        return;
+    }
+
+    // before its imports, which might import it again
+    lvec_append( context->imported_module_names, module_name );
+    lvec_append( context->imported_interface_paths, interface_path );
+
+    size_t magic_length = strlen( INTERFACE_MAGIC );
+    reader.is_valid = reader.length >= magic_length && memcmp( reader.data, INTERFACE_MAGIC, magic_length ) == 0;
+    reader.position = magic_length;
+    if( read_u32( &reader ) != INTERFACE_VERSION || strcmp( read_string( &reader ), module_name ) != 0 )
+    {
+        reader.is_valid = false;
+    }
+
+    // the modules it imports are next to it
+    uint32_t import_count = read_u32( &reader );
+    for( uint32_t i = 0; i < import_count && reader.is_valid; i++ )
+    {
+        char* imported_module_name = read_string( &reader );
+        if( reader.is_valid )
+        {
+            import_module( resolver, imported_module_name, directory, location );
+        }
+    }
+
+    uint32_t declaration_count = read_u32( &reader );
+    for( uint32_t i = 0; i < declaration_count && reader.is_valid; i++ )
+    {
+        Expression* declaration;
+        switch( read_u8( &reader ) )
+        {
+            case INTERFACEDECLARATION_TYPE:     declaration = read_type_declaration( &reader ); break;
+            case INTERFACEDECLARATION_FUNCTION: declaration = read_function( &reader ); break;
+            default:                            declaration = NULL; break;
+        }
+
+        if( declaration == NULL )
+        {
+            reader.is_valid = false;
+            break;
+        }
+        lvec_append( resolver->statements, declaration );
+    }
+
+    if( !reader.is_valid || reader.position != reader.length )
+    {
+        report_module_error( resolver, ERRORKIND_INVALIDMODULEINTERFACE, location, module_name, interface_path );
+    }
+    free( reader.data );
+}
+
+bool resolve_modules( SemanticContext* context, Expression* program )
+{
+    ModuleResolver resolver = {
+        .context = context,
+        .statements = lvec_new( Expression* ),
+        .is_valid = true,
+    };
+
+    // the name of the module has to be known before the imports, none of which
+    // can be of the module itself
+    Token module_token = { 0 };
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind != EXPRESSIONKIND_MODULE )
+        {
+            continue;
+        }
+
+        Token identifier_token = statement->module_declaration.identifier_token;
+        if( context->module_name != NULL )
+        {
+            Error error = {
+                .kind = ERRORKIND_MULTIPLEMODULES,
+                .offending_token = identifier_token,
+                .multiple_modules.other_module_token = module_token,
+            };
+            report_error( context->source_code, error );
+            resolver.is_valid = false;
+            continue;
+        }
+
+        module_token = identifier_token;
+        context->module_name = identifier_token.as_string;
+
+        char* directory = get_token_directory( context, identifier_token );
+        context->module_interface_path = get_interface_path( directory, context->module_name );
+        free( directory );
+    }
+
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        switch( statement->kind )
+        {
+            case EXPRESSIONKIND_MODULE:
+            {
+                break;
+            }
+
+            case EXPRESSIONKIND_IMPORT:
+            {
+                Token identifier_token = statement->module_declaration.identifier_token;
+                char* directory = get_token_directory( context, identifier_token );
+                import_module( &resolver, identifier_token.as_string, directory, identifier_token );
+                free( directory );
+                break;
+            }
+
+            case EXPRESSIONKIND_FUNCTIONDECLARATION:
+            {
+                Token identifier_token = statement->function_declaration.identifier_token;
+                if( context->module_name != NULL && strcmp( identifier_token.as_string, "main" ) == 0 )
+                {
+                    Error error = {
+                        .kind = ERRORKIND_MAININMODULE,
+                        .offending_token = identifier_token,
+                    };
+                    report_error( context->source_code, error );
+                    resolver.is_valid = false;
+                }
+                lvec_append( resolver.statements, statement );
+                break;
+            }
+
+            default:
+            {
+                lvec_append( resolver.statements, statement );
+                break;
+            }
+        }
+    }
+
+    lvec_free( program->compound.expressions );
+    program->compound.expressions = resolver.statements;
+    return resolver.is_valid;
+}
+
+bool write_module_interface( SemanticContext* context, Expression* program )
+{
+    CodeBuffer interface;
+    code_buffer_initialize( &interface );
+
+    code_buffer_append_string( &interface, INTERFACE_MAGIC );
+    write_u32( &interface, INTERFACE_VERSION );
+    write_string( &interface, context->module_name );
+
+    size_t import_count = lvec_get_length( context->imported_module_names );
+    write_u32( &interface, ( uint32_t )import_count );
+    for( size_t i = 0; i < import_count; i++ )
+    {
+        write_string( &interface, context->imported_module_names[ i ] );
+    }
+
+    // the declarations of imported modules are exported by those. a function
+    // at the top level always has a body, the others are externs
+    Expression** exported = lvec_new( Expression* );
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        bool is_own_type = statement->kind == EXPRESSIONKIND_TYPEDECLARATION &&
+            statement->starting_token.kind != TOKENKIND_IMPORT;
+        if( is_own_type || statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION )
+        {
+            lvec_append( exported, statement );
+        }
+    }
+
+    size_t exported_count = lvec_get_length( exported );
+    write_u32( &interface, ( uint32_t )exported_count );
+    for( size_t i = 0; i < exported_count; i++ )
+    {
+        Expression* declaration = exported[ i ];
+        if( declaration->kind == EXPRESSIONKIND_TYPEDECLARATION )
+        {
+            write_u8( &interface, INTERFACEDECLARATION_TYPE );
+            write_string( &interface, declaration->type_declaration.identifier_token.as_string );
+            write_type_rvalue( &interface, declaration->type_declaration.rvalue );
+        }
+        else
+        {
+            write_function( &interface, declaration );
+        }
+    }
+    lvec_free( exported );
+
+    char* interface_path = context->module_interface_path;
+    bool is_written = is_file_same( interface_path, &interface );
+    if( !is_written )
+    {
+        FILE* file = fopen( interface_path, "wb" );
+        is_written = file != NULL && code_buffer_write( &interface, file );
+        if( file != NULL && fclose( file ) != 0 )
+        {
+            is_written = false;
+        }
+    }
+
+    if( !is_written )
+    {
+        printf( "Could not write '%s'.\n", interface_path );
+    }
+
+    code_buffer_free( &interface );
+    return is_written;
+}
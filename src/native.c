@@ -0,0 +1,2163 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codebuffer.h"
+#include "debug.h"
+#include "driver.h"
+#include "elf.h"
+#include "error.h"
+#include "ir.h"
+#include "lvec.h"
+#include "native.h"
+#include "parser.h"
+
+// every value that is not a constant or an address lives in one of the
+// callee-saved registers or in a stack slot. instructions load their operands
+// into scratch registers, compute the result in rax and store it back, which
+// is slow code but quick to generate
+
+typedef enum Register
+{
+    REGISTER_RAX,
+    REGISTER_RCX,
+    REGISTER_RDX,
+    REGISTER_RBX,
+    REGISTER_RSP,
+    REGISTER_RBP,
+    REGISTER_RSI,
+    REGISTER_RDI,
+    REGISTER_R8,
+    REGISTER_R9,
+    REGISTER_R10,
+    REGISTER_R11,
+    REGISTER_R12,
+    REGISTER_R13,
+    REGISTER_R14,
+    REGISTER_R15,
+} Register;
+
+// values keep their registers across calls without being saved around them
+static const Register allocatable_registers[] = {
+    REGISTER_RBX, REGISTER_R12, REGISTER_R13, REGISTER_R14, REGISTER_R15,
+};
+#define ALLOCATABLE_REGISTER_COUNT ( int )( sizeof( allocatable_registers ) / sizeof( Register ) )
+
+static const Register argument_registers[] = {
+    REGISTER_RDI, REGISTER_RSI, REGISTER_RDX, REGISTER_RCX, REGISTER_R8, REGISTER_R9,
+};
+#define ARGUMENT_REGISTER_COUNT 6
+#define FLOAT_ARGUMENT_REGISTER_COUNT 8
+
+typedef enum ConditionCode
+{
+    CONDITIONCODE_B  = 0x2,
+    CONDITIONCODE_AE = 0x3,
+    CONDITIONCODE_E  = 0x4,
+    CONDITIONCODE_NE = 0x5,
+    CONDITIONCODE_BE = 0x6,
+    CONDITIONCODE_A  = 0x7,
+    CONDITIONCODE_S  = 0x8,
+    CONDITIONCODE_P  = 0xa,
+    CONDITIONCODE_NP = 0xb,
+    CONDITIONCODE_L  = 0xc,
+    CONDITIONCODE_GE = 0xd,
+    CONDITIONCODE_LE = 0xe,
+    CONDITIONCODE_G  = 0xf,
+} ConditionCode;
+
+// how an instruction is encoded besides its opcode
+#define ENCODING_WIDE 0x01 // 64-bit operands
+#define ENCODING_BYTE 0x02 // byte registers, spl to dil need a rex prefix
+#define ENCODING_66   0x04
+#define ENCODING_F2   0x08
+#define ENCODING_F3   0x10
+
+typedef enum OperandKind
+{
+    OPERANDKIND_REGISTER,
+    OPERANDKIND_MEMORY, // base register plus displacement
+    OPERANDKIND_SYMBOL, // rip-relative, symbol plus displacement
+} OperandKind;
+
+typedef struct Operand
+{
+    OperandKind kind;
+    Register reg;
+    int32_t displacement;
+    int symbol;
+} Operand;
+
+typedef enum LocationKind
+{
+    LOCATIONKIND_NONE, // constants and addresses, which are generated where they are used
+    LOCATIONKIND_REGISTER,
+    LOCATIONKIND_STACK,
+} LocationKind;
+
+typedef struct Location
+{
+    LocationKind kind;
+    Register reg;
+    int32_t offset; // from rbp
+} Location;
+
+// a jump whose 32-bit displacement is filled in once its target is placed
+typedef struct Fixup
+{
+    size_t offset;
+    IrBlock* target;
+} Fixup;
+
+typedef enum StubKind
+{
+    STUBKIND_BOUNDSCHECK, // rcx holds the index and rax the length
+    STUBKIND_OUTOFMEMORY,
+} StubKind;
+
+// the code for a failure, placed after the function so that the checks fall
+// through when they pass
+typedef struct Stub
+{
+    StubKind kind;
+    size_t offset; // of the displacement of the jump to the stub
+    Token location_token;
+    int length;
+} Stub;
+
+typedef struct Interval
+{
+    IrInstruction* value;
+    int start;
+    int end;
+} Interval;
+
+typedef struct Native
+{
+    ElfObject object;
+    CodeBuffer* text;
+    CheckMode check_mode;
+    char* source_path; // where failed bounds checks say they are, unless their token knows
+
+    // in .rodata, -1 until they are needed
+    int64_t bounds_format_offset;
+    int64_t allocation_format_offset;
+
+    // the function being generated
+    IrFunction* function;
+    Location* locations; // by instruction index, for slots where their memory is
+    Location* phi_inputs; // by instruction index, where predecessors put the values of phis
+    int32_t* array_data_offsets; // by instruction index, of arrays on the stack
+    int64_t* string_offsets; // by instruction index, in .rodata, -1 until they are needed
+    size_t* block_offsets; // by block index
+    Register* saved_registers;
+    int32_t frame_size;
+    bool has_frame_memory; // slots or arrays, which arguments can point into
+    Fixup* fixups;
+    Stub* stubs;
+} Native;
+
+static bool is_array( Type type )
+{
+    return type.kind == TYPEKIND_ARRAY;
+}
+
+static bool is_double( Type type )
+{
+    return ir_type_is_float( type ) && ir_type_get_bit_count( type ) == 64;
+}
+
+static bool is_void( Type type )
+{
+    return ir_get_type_definition( type ).kind == TYPEKIND_VOID;
+}
+
+// of values of `type` in memory
+static int get_type_size( Type type )
+{
+    if( is_array( type ) )
+    {
+        return 16;
+    }
+
+    if( ir_type_is_integer( type ) || ir_type_is_float( type ) )
+    {
+        return ir_type_get_bit_count( type ) / 8;
+    }
+
+    return 8; // pointers and references
+}
+
+static int32_t align( int32_t value, int32_t alignment )
+{
+    return ( value + alignment - 1 ) & ~( alignment - 1 );
+}
+
+static char* get_function_name( Expression* function )
+{
+    return function->function_declaration.identifier_token.as_string;
+}
+
+// encoding
+
+static void emit_byte( Native* native, uint8_t byte )
+{
+    code_buffer_append_char( native->text, ( char )byte );
+}
+
+static void emit_u32( Native* native, uint32_t value )
+{
+    for( int i = 0; i < 4; i++ )
+    {
+        emit_byte( native, ( value >> ( i * 8 ) ) & 0xff );
+    }
+}
+
+static void emit_u64( Native* native, uint64_t value )
+{
+    emit_u32( native, value & 0xffffffff );
+    emit_u32( native, value >> 32 );
+}
+
+static void patch_u32( Native* native, size_t offset, uint32_t value )
+{
+    for( int i = 0; i < 4; i++ )
+    {
+        native->text->data[ offset + i ] = ( char )( ( value >> ( i * 8 ) ) & 0xff );
+    }
+}
+
+static Operand register_operand( Register reg )
+{
+    return ( Operand ){ .kind = OPERANDKIND_REGISTER, .reg = reg };
+}
+
+static Operand memory_operand( Register base, int32_t displacement )
+{
+    return ( Operand ){ .kind = OPERANDKIND_MEMORY, .reg = base, .displacement = displacement };
+}
+
+static Operand symbol_operand( int symbol, int32_t displacement )
+{
+    return ( Operand ){ .kind = OPERANDKIND_SYMBOL, .symbol = symbol, .displacement = displacement };
+}
+
+// `opcode` is one to three bytes, the first in the highest one. `reg` is the
+// register or the opcode extension of the modrm byte. rip-relative operands
+// must not be followed by an immediate
+static void emit_instruction( Native* native, int encoding, uint32_t opcode, int reg, Operand rm )
+{
+    if( encoding & ENCODING_66 ) emit_byte( native, 0x66 );
+    if( encoding & ENCODING_F2 ) emit_byte( native, 0xf2 );
+    if( encoding & ENCODING_F3 ) emit_byte( native, 0xf3 );
+
+    int base = rm.kind == OPERANDKIND_SYMBOL ? 0 : rm.reg;
+    uint8_t rex = 0x40 | ( encoding & ENCODING_WIDE ? 0x08 : 0 ) | ( reg & 8 ? 0x04 : 0 ) | ( base & 8 ? 0x01 : 0 );
+    if( rex != 0x40 || encoding & ENCODING_BYTE )
+    {
+        emit_byte( native, rex );
+    }
+
+    if( opcode > 0xffff ) emit_byte( native, ( opcode >> 16 ) & 0xff );
+    if( opcode > 0xff ) emit_byte( native, ( opcode >> 8 ) & 0xff );
+    emit_byte( native, opcode & 0xff );
+
+    switch( rm.kind )
+    {
+        case OPERANDKIND_REGISTER:
+        {
+            emit_byte( native, 0xc0 | ( reg & 7 ) << 3 | ( rm.reg & 7 ) );
+            break;
+        }
+
+        case OPERANDKIND_MEMORY:
+        {
+            // always a 32-bit displacement, rsp and r12 need a sib byte
+            emit_byte( native, 0x80 | ( reg & 7 ) << 3 | ( rm.reg & 7 ) );
+            if( ( rm.reg & 7 ) == REGISTER_RSP )
+            {
+                emit_byte( native, 0x24 );
+            }
+            emit_u32( native, ( uint32_t )rm.displacement );
+            break;
+        }
+
+        case OPERANDKIND_SYMBOL:
+        {
+            emit_byte( native, 0x05 | ( reg & 7 ) << 3 );
+            elf_object_add_relocation( &native->object, ELFSECTION_TEXT, native->text->length, rm.symbol,
+                                       ELFRELOCATIONKIND_PC32, rm.displacement - 4 );
+            emit_u32( native, 0 );
+            break;
+        }
+    }
+}
+
+static void emit_move( Native* native, Register destination, Register source )
+{
+    if( destination != source )
+    {
+        emit_instruction( native, ENCODING_WIDE, 0x8b, destination, register_operand( source ) );
+    }
+}
+
+static void emit_move_immediate( Native* native, Register destination, uint64_t value )
+{
+    if( value == 0 )
+    {
+        emit_instruction( native, 0, 0x33, destination, register_operand( destination ) ); // xor r32, r32
+    }
+    else if( value <= UINT32_MAX )
+    {
+        // writing the 32-bit register clears the upper half
+        if( destination & 8 ) emit_byte( native, 0x41 );
+        emit_byte( native, 0xb8 + ( destination & 7 ) );
+        emit_u32( native, ( uint32_t )value );
+    }
+    else if( ( int64_t )value >= INT32_MIN && ( int64_t )value <= INT32_MAX )
+    {
+        emit_instruction( native, ENCODING_WIDE, 0xc7, 0, register_operand( destination ) );
+        emit_u32( native, ( uint32_t )value );
+    }
+    else
+    {
+        emit_byte( native, destination & 8 ? 0x49 : 0x48 );
+        emit_byte( native, 0xb8 + ( destination & 7 ) );
+        emit_u64( native, value );
+    }
+}
+
+static void emit_load_address( Native* native, Register destination, Operand source )
+{
+    emit_instruction( native, ENCODING_WIDE, 0x8d, destination, source );
+}
+
+static void emit_load_word( Native* native, Register destination, Operand source )
+{
+    emit_instruction( native, ENCODING_WIDE, 0x8b, destination, source );
+}
+
+static void emit_store_word( Native* native, Operand destination, Register source )
+{
+    emit_instruction( native, ENCODING_WIDE, 0x89, source, destination );
+}
+
+// loads a value of `type`, extended to 64 bits the way values are kept
+static void emit_load( Native* native, Register destination, Operand source, Type type )
+{
+    int size = get_type_size( type );
+    bool is_signed = ir_type_is_signed( type ) && !ir_type_is_float( type );
+    switch( size )
+    {
+        case 1:  emit_instruction( native, is_signed ? ENCODING_WIDE : 0, is_signed ? 0x0fbe : 0x0fb6, destination, source ); break;
+        case 2:  emit_instruction( native, is_signed ? ENCODING_WIDE : 0, is_signed ? 0x0fbf : 0x0fb7, destination, source ); break;
+        case 4:  emit_instruction( native, is_signed ? ENCODING_WIDE : 0, is_signed ? 0x63 : 0x8b, destination, source ); break;
+        default: emit_load_word( native, destination, source ); break;
+    }
+}
+
+static void emit_store( Native* native, Operand destination, Register source, Type type )
+{
+    switch( get_type_size( type ) )
+    {
+        case 1:  emit_instruction( native, ENCODING_BYTE, 0x88, source, destination ); break;
+        case 2:  emit_instruction( native, ENCODING_66, 0x89, source, destination ); break;
+        case 4:  emit_instruction( native, 0, 0x89, source, destination ); break;
+        default: emit_store_word( native, destination, source ); break;
+    }
+}
+
+// sign- or zero-extends the low bits of `reg` that hold a value of `type`
+static void emit_normalize( Native* native, Register reg, Type type )
+{
+    if( !ir_type_is_integer( type ) || ir_type_get_bit_count( type ) == 64 )
+    {
+        return;
+    }
+
+    emit_load( native, reg, register_operand( reg ), type );
+}
+
+// `opcode` is the form that takes a register and a register or memory operand
+static void emit_arithmetic( Native* native, uint32_t opcode, Register destination, Register source )
+{
+    emit_instruction( native, ENCODING_WIDE, opcode, destination, register_operand( source ) );
+}
+
+#define OPCODE_ADD  0x03
+#define OPCODE_SUB  0x2b
+#define OPCODE_AND  0x23
+#define OPCODE_OR   0x0b
+#define OPCODE_XOR  0x33
+#define OPCODE_CMP  0x3b
+#define OPCODE_TEST 0x85
+#define OPCODE_IMUL 0x0faf
+
+static void emit_add_immediate( Native* native, Register reg, int32_t value )
+{
+    emit_instruction( native, ENCODING_WIDE, 0x81, 0, register_operand( reg ) );
+    emit_u32( native, ( uint32_t )value );
+}
+
+static void emit_shift_immediate( Native* native, int extension, Register reg, uint8_t count )
+{
+    emit_instruction( native, ENCODING_WIDE, 0xc1, extension, register_operand( reg ) );
+    emit_byte( native, count );
+}
+
+// setcc and zero-extension into the whole register
+static void emit_set_condition( Native* native, ConditionCode condition, Register reg )
+{
+    emit_instruction( native, ENCODING_BYTE, 0x0f90 + condition, 0, register_operand( reg ) );
+    emit_instruction( native, ENCODING_BYTE, 0x0fb6, reg, register_operand( reg ) );
+}
+
+static void emit_push( Native* native, Register reg )
+{
+    if( reg & 8 ) emit_byte( native, 0x41 );
+    emit_byte( native, 0x50 + ( reg & 7 ) );
+}
+
+static void emit_pop( Native* native, Register reg )
+{
+    if( reg & 8 ) emit_byte( native, 0x41 );
+    emit_byte( native, 0x58 + ( reg & 7 ) );
+}
+
+static void emit_call( Native* native, int symbol )
+{
+    emit_byte( native, 0xe8 );
+    elf_object_add_relocation( &native->object, ELFSECTION_TEXT, native->text->length, symbol,
+                               ELFRELOCATIONKIND_PLT32, -4 );
+    emit_u32( native, 0 );
+}
+
+static void emit_jump_to_symbol( Native* native, int symbol )
+{
+    emit_byte( native, 0xe9 );
+    elf_object_add_relocation( &native->object, ELFSECTION_TEXT, native->text->length, symbol,
+                               ELFRELOCATIONKIND_PLT32, -4 );
+    emit_u32( native, 0 );
+}
+
+static void emit_jump( Native* native, IrBlock* target )
+{
+    emit_byte( native, 0xe9 );
+    Fixup fixup = { .offset = native->text->length, .target = target };
+    lvec_append_aggregate( native->fixups, fixup );
+    emit_u32( native, 0 );
+}
+
+static void emit_jump_if( Native* native, ConditionCode condition, IrBlock* target )
+{
+    emit_byte( native, 0x0f );
+    emit_byte( native, 0x80 + condition );
+    Fixup fixup = { .offset = native->text->length, .target = target };
+    lvec_append_aggregate( native->fixups, fixup );
+    emit_u32( native, 0 );
+}
+
+// a short forward jump inside the code of one instruction, returns the offset
+// to pass to place_short_jump()
+static size_t emit_short_jump_if( Native* native, ConditionCode condition )
+{
+    emit_byte( native, 0x70 + condition );
+    emit_byte( native, 0 );
+    return native->text->length;
+}
+
+static size_t emit_short_jump( Native* native )
+{
+    emit_byte( native, 0xeb );
+    emit_byte( native, 0 );
+    return native->text->length;
+}
+
+static void place_short_jump( Native* native, size_t end )
+{
+    native->text->data[ end - 1 ] = ( char )( native->text->length - end );
+}
+
+static void emit_stub_jump( Native* native, StubKind kind, Token location_token, int length )
+{
+    emit_byte( native, 0x0f );
+    emit_byte( native, 0x80 + ( kind == STUBKIND_BOUNDSCHECK ? CONDITIONCODE_AE : CONDITIONCODE_E ) );
+    Stub stub = {
+        .kind = kind,
+        .offset = native->text->length,
+        .location_token = location_token,
+        .length = length,
+    };
+    lvec_append_aggregate( native->stubs, stub );
+    emit_u32( native, 0 );
+}
+
+// between the bits of a float in a general purpose register and xmm0 or xmm1
+static void emit_move_to_xmm( Native* native, int xmm, Register source, bool is_double )
+{
+    emit_instruction( native, ENCODING_66 | ( is_double ? ENCODING_WIDE : 0 ), 0x0f6e, xmm, register_operand( source ) );
+}
+
+static void emit_move_from_xmm( Native* native, Register destination, int xmm, bool is_double )
+{
+    emit_instruction( native, ENCODING_66 | ( is_double ? ENCODING_WIDE : 0 ), 0x0f7e, xmm, register_operand( destination ) );
+}
+
+// addsd, subsd and friends, xmm0 is the destination and xmm1 the source
+static void emit_float_arithmetic( Native* native, uint32_t opcode, bool is_double )
+{
+    emit_instruction( native, is_double ? ENCODING_F2 : ENCODING_F3, opcode, 0, register_operand( 1 ) );
+}
+
+static void emit_float_compare( Native* native, int left_xmm, int right_xmm, bool is_double )
+{
+    emit_instruction( native, is_double ? ENCODING_66 : 0, 0x0f2e, left_xmm, register_operand( right_xmm ) );
+}
+
+// strings and data
+
+static int64_t add_rodata( Native* native, const char* data, size_t length, uint64_t alignment )
+{
+    int64_t offset = ( int64_t )elf_object_align( &native->object, ELFSECTION_RODATA, alignment );
+    code_buffer_append_data( &native->object.sections[ ELFSECTION_RODATA ], data, length );
+    return offset;
+}
+
+// string literals keep the escape sequences of the source
+static int64_t add_string( Native* native, const char* escaped )
+{
+    CodeBuffer* rodata = &native->object.sections[ ELFSECTION_RODATA ];
+    int64_t offset = ( int64_t )rodata->length;
+    code_buffer_append_unescaped( rodata, escaped );
+    code_buffer_append_char( rodata, '\0' );
+    return offset;
+}
+
+static int64_t get_string_offset( Native* native, IrInstruction* string )
+{
+    if( native->string_offsets[ string->index ] == -1 )
+    {
+        native->string_offsets[ string->index ] = add_string( native, string->string );
+    }
+
+    return native->string_offsets[ string->index ];
+}
+
+// values
+
+static Operand get_stack_operand( Location location, int word )
+{
+    return memory_operand( REGISTER_RBP, location.offset + word * 8 );
+}
+
+static void load_value( Native* native, Register destination, IrInstruction* value )
+{
+    switch( value->opcode )
+    {
+        case IROPCODE_CONSTANT:
+        {
+            emit_move_immediate( native, destination, ir_get_constant_bits( value ) );
+            return;
+        }
+
+        case IROPCODE_STRING:
+        {
+            int symbol = elf_object_get_section_symbol( ELFSECTION_RODATA );
+            emit_load_address( native, destination, symbol_operand( symbol, ( int32_t )get_string_offset( native, value ) ) );
+            return;
+        }
+
+        case IROPCODE_SLOT:
+        {
+            emit_load_address( native, destination, get_stack_operand( native->locations[ value->index ], 0 ) );
+            return;
+        }
+
+        case IROPCODE_GLOBAL:
+        {
+            int symbol = elf_object_get_symbol( &native->object, value->identifier );
+            emit_load_address( native, destination, symbol_operand( symbol, 0 ) );
+            return;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    Location location = native->locations[ value->index ];
+    switch( location.kind )
+    {
+        case LOCATIONKIND_REGISTER: emit_move( native, destination, location.reg ); break;
+        case LOCATIONKIND_STACK:    emit_load_word( native, destination, get_stack_operand( location, 0 ) ); break;
+        default:                    UNREACHABLE();
+    }
+}
+
+// arrays are kept on the stack as their length followed by their data pointer
+static void load_array( Native* native, Register length, Register data, IrInstruction* array )
+{
+    if( array->opcode == IROPCODE_CONSTANT )
+    {
+        emit_move_immediate( native, length, 0 );
+        emit_move_immediate( native, data, 0 );
+        return;
+    }
+
+    Location location = native->locations[ array->index ];
+    emit_load_word( native, length, get_stack_operand( location, 0 ) );
+    emit_load_word( native, data, get_stack_operand( location, 1 ) );
+}
+
+static void store_result( Native* native, IrInstruction* instruction, Register source )
+{
+    Location location = native->locations[ instruction->index ];
+    switch( location.kind )
+    {
+        case LOCATIONKIND_REGISTER: emit_move( native, location.reg, source ); break;
+        case LOCATIONKIND_STACK:    emit_store_word( native, get_stack_operand( location, 0 ), source ); break;
+        case LOCATIONKIND_NONE:     break; // unused
+    }
+}
+
+static void store_array_result( Native* native, IrInstruction* instruction, Register length, Register data )
+{
+    Location location = native->locations[ instruction->index ];
+    if( location.kind == LOCATIONKIND_STACK )
+    {
+        emit_store_word( native, get_stack_operand( location, 0 ), length );
+        emit_store_word( native, get_stack_operand( location, 1 ), data );
+    }
+}
+
+static void copy_value( Native* native, IrInstruction* destination, IrInstruction* source )
+{
+    if( is_array( destination->type ) )
+    {
+        load_array( native, REGISTER_RAX, REGISTER_RCX, source );
+        store_array_result( native, destination, REGISTER_RAX, REGISTER_RCX );
+        return;
+    }
+
+    load_value( native, REGISTER_RAX, source );
+    store_result( native, destination, REGISTER_RAX );
+}
+
+// register allocation
+
+static bool is_generated_inline( IrInstruction* instruction )
+{
+    switch( instruction->opcode )
+    {
+        case IROPCODE_CONSTANT:
+        case IROPCODE_STRING:
+        case IROPCODE_SLOT:
+        case IROPCODE_GLOBAL:
+        {
+            return true;
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+static bool needs_location( IrInstruction* instruction )
+{
+    return !is_generated_inline( instruction ) && !is_void( instruction->type ) &&
+           !ir_is_terminator( instruction ) && instruction->opcode != IROPCODE_STORE;
+}
+
+static int compare_intervals( const void* a, const void* b )
+{
+    const Interval* interval_a = a;
+    const Interval* interval_b = b;
+    if( interval_a->start != interval_b->start )
+    {
+        return interval_a->start < interval_b->start ? -1 : 1;
+    }
+
+    return interval_a->value->index - interval_b->value->index;
+}
+
+static bool bit_set_contains( uint64_t* set, int bit )
+{
+    return ( set[ bit / 64 ] >> ( bit % 64 ) ) & 1;
+}
+
+static void bit_set_add( uint64_t* set, int bit )
+{
+    set[ bit / 64 ] |= 1ull << ( bit % 64 );
+}
+
+// live ranges are one interval each, from the definition to the last position
+// the value is live at in the order the blocks are generated in. then the
+// intervals are assigned registers by linear scan, and the ones that do not
+// get one are spilled to the stack
+static void allocate_registers( Native* native, bool* is_register_used )
+{
+    IrFunction* function = native->function;
+    size_t block_count = lvec_get_length( function->blocks );
+    int instruction_count = function->instruction_count;
+
+    int* positions = calloc( instruction_count, sizeof( int ) );
+    int* block_starts = calloc( function->block_count, sizeof( int ) );
+    int* block_ends = calloc( function->block_count, sizeof( int ) );
+    int* block_positions = calloc( function->block_count, sizeof( int ) );
+    bool* is_used = calloc( instruction_count, sizeof( bool ) );
+    if( positions == NULL || block_starts == NULL || block_ends == NULL || block_positions == NULL || is_used == NULL )
+    {
+        ALLOC_ERROR();
+    }
+
+    int position = 0;
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        block_positions[ block->index ] = ( int )i;
+        block_starts[ block->index ] = position;
+
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            // params are stored in the prologue, before everything else
+            positions[ instruction->index ] = instruction->opcode == IROPCODE_PARAM ? -1 : position;
+            position += 2;
+
+            size_t operand_count = lvec_get_length( instruction->operands );
+            for( size_t k = 0; k < operand_count; k++ )
+            {
+                is_used[ instruction->operands[ k ]->index ] = true;
+            }
+        }
+        block_ends[ block->index ] = position - 2;
+    }
+
+    // liveness at block boundaries, operands of phis are used at the end of
+    // their predecessor
+    size_t word_count = ( instruction_count + 63 ) / 64;
+    uint64_t* sets = calloc( block_count * word_count * 4, sizeof( uint64_t ) );
+    if( sets == NULL ) ALLOC_ERROR();
+    uint64_t* live_in = sets;
+    uint64_t* live_out = sets + block_count * word_count;
+    uint64_t* generated = sets + block_count * word_count * 2;
+    uint64_t* defined = sets + block_count * word_count * 3;
+
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            bit_set_add( &defined[ i * word_count ], instruction->index );
+
+            size_t operand_count = lvec_get_length( instruction->operands );
+            for( size_t k = 0; k < operand_count; k++ )
+            {
+                IrInstruction* operand = instruction->operands[ k ];
+                if( !needs_location( operand ) )
+                {
+                    continue;
+                }
+
+                if( instruction->opcode == IROPCODE_PHI )
+                {
+                    size_t predecessor = block_positions[ block->predecessors[ k ]->index ];
+                    bit_set_add( &generated[ predecessor * word_count ], operand->index );
+                }
+                else if( operand->block != block )
+                {
+                    bit_set_add( &generated[ i * word_count ], operand->index );
+                }
+            }
+        }
+    }
+
+    // phi operands are generated at the end of the predecessor, so they are
+    // live out of it but not necessarily into it. the loop below treats them
+    // like any use, which only makes their intervals a little longer
+    bool has_changed = true;
+    while( has_changed )
+    {
+        has_changed = false;
+        for( size_t i = block_count; i-- > 0; )
+        {
+            IrBlock* block = function->blocks[ i ];
+            uint64_t* in = &live_in[ i * word_count ];
+            uint64_t* out = &live_out[ i * word_count ];
+
+            int successor_count = ir_block_get_successor_count( block );
+            for( int j = 0; j < successor_count; j++ )
+            {
+                uint64_t* successor_in = &live_in[ block_positions[ ir_block_get_successor( block, j )->index ] * word_count ];
+                for( size_t w = 0; w < word_count; w++ )
+                {
+                    out[ w ] |= successor_in[ w ];
+                }
+            }
+
+            for( size_t w = 0; w < word_count; w++ )
+            {
+                uint64_t new_in = generated[ i * word_count + w ] | ( out[ w ] & ~defined[ i * word_count + w ] );
+                if( new_in != in[ w ] )
+                {
+                    in[ w ] = new_in;
+                    has_changed = true;
+                }
+            }
+        }
+    }
+
+    Interval* intervals = lvec_new( Interval );
+    int* interval_indices = malloc( instruction_count * sizeof( int ) );
+    if( interval_indices == NULL ) ALLOC_ERROR();
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            interval_indices[ instruction->index ] = -1;
+            if( !needs_location( instruction ) || !is_used[ instruction->index ] )
+            {
+                continue;
+            }
+
+            interval_indices[ instruction->index ] = ( int )lvec_get_length( intervals );
+            int start = positions[ instruction->index ];
+            Interval interval = { .value = instruction, .start = start, .end = start };
+            lvec_append_aggregate( intervals, interval );
+        }
+    }
+
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            size_t operand_count = lvec_get_length( instruction->operands );
+            for( size_t k = 0; k < operand_count; k++ )
+            {
+                IrInstruction* operand = instruction->operands[ k ];
+                if( !needs_location( operand ) )
+                {
+                    continue;
+                }
+
+                int use = instruction->opcode == IROPCODE_PHI ? block_ends[ block->predecessors[ k ]->index ]
+                                                              : positions[ instruction->index ];
+                Interval* interval = &intervals[ interval_indices[ operand->index ] ];
+                interval->end = use > interval->end ? use : interval->end;
+            }
+        }
+
+        for( int index = 0; index < instruction_count; index++ )
+        {
+            bool is_live_in = bit_set_contains( &live_in[ i * word_count ], index );
+            bool is_live_out = bit_set_contains( &live_out[ i * word_count ], index );
+            if( !is_live_in && !is_live_out )
+            {
+                continue;
+            }
+
+            Interval* interval = &intervals[ interval_indices[ index ] ];
+            int end = is_live_out ? block_ends[ block->index ] : block_starts[ block->index ];
+            interval->end = end > interval->end ? end : interval->end;
+        }
+    }
+
+    size_t interval_count = lvec_get_length( intervals );
+    qsort( intervals, interval_count, sizeof( Interval ), compare_intervals );
+
+    // the intervals holding a register, sorted by their end
+    Interval* active[ ALLOCATABLE_REGISTER_COUNT ];
+    int active_count = 0;
+    bool is_free[ ALLOCATABLE_REGISTER_COUNT ];
+    for( int i = 0; i < ALLOCATABLE_REGISTER_COUNT; i++ )
+    {
+        is_free[ i ] = true;
+    }
+
+    for( size_t i = 0; i < interval_count; i++ )
+    {
+        Interval* interval = &intervals[ i ];
+        Location* location = &native->locations[ interval->value->index ];
+        if( is_array( interval->value->type ) )
+        {
+            location->kind = LOCATIONKIND_STACK;
+            continue;
+        }
+
+        // frees the registers of the intervals that ended
+        int kept_count = 0;
+        for( int j = 0; j < active_count; j++ )
+        {
+            if( active[ j ]->end < interval->start )
+            {
+                Register reg = native->locations[ active[ j ]->value->index ].reg;
+                for( int r = 0; r < ALLOCATABLE_REGISTER_COUNT; r++ )
+                {
+                    if( allocatable_registers[ r ] == reg )
+                    {
+                        is_free[ r ] = true;
+                    }
+                }
+                continue;
+            }
+            active[ kept_count++ ] = active[ j ];
+        }
+        active_count = kept_count;
+
+        int free_register = -1;
+        for( int r = 0; r < ALLOCATABLE_REGISTER_COUNT && free_register == -1; r++ )
+        {
+            if( is_free[ r ] )
+            {
+                free_register = r;
+            }
+        }
+
+        Interval* assigned = interval;
+        if( free_register != -1 )
+        {
+            is_free[ free_register ] = false;
+            location->kind = LOCATIONKIND_REGISTER;
+            location->reg = allocatable_registers[ free_register ];
+        }
+        else if( active[ active_count - 1 ]->end > interval->end )
+        {
+            // the interval that ends last gives up its register
+            Interval* spilled = active[ --active_count ];
+            Location* spilled_location = &native->locations[ spilled->value->index ];
+            *location = *spilled_location;
+            spilled_location->kind = LOCATIONKIND_STACK;
+        }
+        else
+        {
+            location->kind = LOCATIONKIND_STACK;
+            assigned = NULL;
+        }
+
+        if( assigned != NULL )
+        {
+            is_register_used[ location->reg ] = true;
+            int j = active_count++;
+            while( j > 0 && active[ j - 1 ]->end > assigned->end )
+            {
+                active[ j ] = active[ j - 1 ];
+                j--;
+            }
+            active[ j ] = assigned;
+        }
+    }
+
+    lvec_free( intervals );
+    free( interval_indices );
+    free( sets );
+    free( is_used );
+    free( block_positions );
+    free( block_ends );
+    free( block_starts );
+    free( positions );
+}
+
+// lays out the stack frame below the saved registers
+static void assign_stack_slots( Native* native )
+{
+    IrFunction* function = native->function;
+    int32_t offset = -8 * ( int32_t )lvec_get_length( native->saved_registers );
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            Location* location = &native->locations[ instruction->index ];
+            int32_t size = is_array( instruction->type ) ? 16 : 8;
+
+            if( location->kind == LOCATIONKIND_STACK )
+            {
+                offset -= size;
+                location->offset = offset;
+            }
+
+            if( instruction->opcode == IROPCODE_PHI )
+            {
+                offset -= size;
+                native->phi_inputs[ instruction->index ] = ( Location ){ .kind = LOCATIONKIND_STACK, .offset = offset };
+            }
+            else if( instruction->opcode == IROPCODE_SLOT )
+            {
+                native->has_frame_memory = true;
+                offset = -align( -offset + get_type_size( *instruction->type.reference.base_type ), 8 );
+                *location = ( Location ){ .kind = LOCATIONKIND_STACK, .offset = offset };
+            }
+            else if( instruction->opcode == IROPCODE_ARRAYLITERAL &&
+                     instruction->array_literal.storage == ARRAYSTORAGE_AUTOMATIC )
+            {
+                Type array_type = instruction->array_literal.type;
+                int32_t data_size = array_type.array.length * get_type_size( *array_type.array.base_type );
+                native->has_frame_memory = true;
+                offset = -align( -offset + data_size, 16 );
+                native->array_data_offsets[ instruction->index ] = offset;
+            }
+        }
+    }
+
+    // rsp stays 16-byte aligned after the return address and rbp are pushed
+    native->frame_size = align( -offset, 16 ) - 8 * ( int32_t )lvec_get_length( native->saved_registers );
+}
+
+// the system v calling convention
+
+typedef struct ArgumentLocation
+{
+    bool is_on_stack;
+    int register_index; // of the first general purpose or xmm register
+    int32_t stack_offset; // from the first argument on the stack
+} ArgumentLocation;
+
+// returns the size of the arguments on the stack
+static int32_t classify_arguments( Type* types, size_t count, ArgumentLocation* locations, int* float_count )
+{
+    int integer_count = 0;
+    *float_count = 0;
+    int32_t stack_size = 0;
+    for( size_t i = 0; i < count; i++ )
+    {
+        Type type = types[ i ];
+        ArgumentLocation* location = &locations[ i ];
+        location->is_on_stack = false;
+
+        if( is_array( type ) && integer_count + 2 <= ARGUMENT_REGISTER_COUNT )
+        {
+            location->register_index = integer_count;
+            integer_count += 2;
+        }
+        else if( ir_type_is_float( type ) && *float_count < FLOAT_ARGUMENT_REGISTER_COUNT )
+        {
+            location->register_index = ( *float_count )++;
+        }
+        else if( !is_array( type ) && !ir_type_is_float( type ) && integer_count < ARGUMENT_REGISTER_COUNT )
+        {
+            location->register_index = integer_count++;
+        }
+        else
+        {
+            location->is_on_stack = true;
+            location->stack_offset = stack_size;
+            stack_size += is_array( type ) ? 16 : 8;
+        }
+    }
+
+    return stack_size;
+}
+
+static void emit_epilogue( Native* native )
+{
+    size_t saved_count = lvec_get_length( native->saved_registers );
+    if( saved_count > 0 )
+    {
+        emit_load_address( native, REGISTER_RSP, memory_operand( REGISTER_RBP, -8 * ( int32_t )saved_count ) );
+        for( size_t i = saved_count; i-- > 0; )
+        {
+            emit_pop( native, native->saved_registers[ i ] );
+        }
+    }
+    else
+    {
+        emit_move( native, REGISTER_RSP, REGISTER_RBP );
+    }
+    emit_pop( native, REGISTER_RBP );
+}
+
+static void generate_prologue( Native* native, Expression* declaration )
+{
+    emit_push( native, REGISTER_RBP );
+    emit_move( native, REGISTER_RBP, REGISTER_RSP );
+    size_t saved_count = lvec_get_length( native->saved_registers );
+    for( size_t i = 0; i < saved_count; i++ )
+    {
+        emit_push( native, native->saved_registers[ i ] );
+    }
+    if( native->frame_size > 0 )
+    {
+        emit_instruction( native, ENCODING_WIDE, 0x81, 5, register_operand( REGISTER_RSP ) ); // sub rsp, imm32
+        emit_u32( native, ( uint32_t )native->frame_size );
+    }
+
+    int param_count = declaration->function_declaration.param_count;
+    ArgumentLocation* arguments = calloc( param_count + 1, sizeof( ArgumentLocation ) );
+    if( arguments == NULL ) ALLOC_ERROR();
+    int float_count;
+    classify_arguments( declaration->function_declaration.param_types, param_count, arguments, &float_count );
+
+    IrBlock* entry = native->function->blocks[ 0 ];
+    size_t length = lvec_get_length( entry->instructions );
+    for( size_t i = 0; i < length; i++ )
+    {
+        IrInstruction* param = entry->instructions[ i ];
+        if( param->opcode != IROPCODE_PARAM || native->locations[ param->index ].kind == LOCATIONKIND_NONE )
+        {
+            continue;
+        }
+
+        ArgumentLocation argument = arguments[ param->param_index ];
+        Type type = param->type;
+        if( argument.is_on_stack )
+        {
+            // above the return address and the saved rbp
+            Operand source = memory_operand( REGISTER_RBP, 16 + argument.stack_offset );
+            if( is_array( type ) )
+            {
+                emit_load_word( native, REGISTER_RAX, source );
+                source.displacement += 8;
+                emit_load_word( native, REGISTER_RCX, source );
+                store_array_result( native, param, REGISTER_RAX, REGISTER_RCX );
+                continue;
+            }
+
+            emit_load( native, REGISTER_RAX, source, type );
+            store_result( native, param, REGISTER_RAX );
+        }
+        else if( is_array( type ) )
+        {
+            store_array_result( native, param, argument_registers[ argument.register_index ],
+                                argument_registers[ argument.register_index + 1 ] );
+        }
+        else if( ir_type_is_float( type ) )
+        {
+            emit_move_from_xmm( native, REGISTER_RAX, argument.register_index, is_double( type ) );
+            store_result( native, param, REGISTER_RAX );
+        }
+        else
+        {
+            // only the bits of the type are guaranteed to be set
+            Register reg = argument_registers[ argument.register_index ];
+            emit_normalize( native, reg, type );
+            store_result( native, param, reg );
+        }
+    }
+
+    free( arguments );
+}
+
+// instructions
+
+static void load_xmm( Native* native, int xmm, IrInstruction* value )
+{
+    load_value( native, REGISTER_RAX, value );
+    emit_move_to_xmm( native, xmm, REGISTER_RAX, is_double( value->type ) );
+}
+
+static void generate_float_binary( Native* native, IrInstruction* instruction )
+{
+    IrInstruction* left = instruction->operands[ 0 ];
+    IrInstruction* right = instruction->operands[ 1 ];
+    bool is_double_operation = is_double( left->type );
+    load_xmm( native, 1, right );
+    load_xmm( native, 0, left );
+
+    switch( instruction->opcode )
+    {
+        case IROPCODE_ADD:          emit_float_arithmetic( native, 0x0f58, is_double_operation ); break;
+        case IROPCODE_SUBTRACT:     emit_float_arithmetic( native, 0x0f5c, is_double_operation ); break;
+        case IROPCODE_MULTIPLY:     emit_float_arithmetic( native, 0x0f59, is_double_operation ); break;
+        case IROPCODE_DIVIDE:       emit_float_arithmetic( native, 0x0f5e, is_double_operation ); break;
+
+        // unordered comparisons are false, except for not equal
+        case IROPCODE_EQUAL:
+        case IROPCODE_NOTEQUAL:
+        {
+            bool is_equal = instruction->opcode == IROPCODE_EQUAL;
+            emit_float_compare( native, 0, 1, is_double_operation );
+            emit_set_condition( native, is_equal ? CONDITIONCODE_E : CONDITIONCODE_NE, REGISTER_RAX );
+            emit_set_condition( native, is_equal ? CONDITIONCODE_NP : CONDITIONCODE_P, REGISTER_RCX );
+            emit_arithmetic( native, is_equal ? OPCODE_AND : OPCODE_OR, REGISTER_RAX, REGISTER_RCX );
+            store_result( native, instruction, REGISTER_RAX );
+            return;
+        }
+
+        case IROPCODE_GREATER:
+        case IROPCODE_GREATEREQUAL:
+        case IROPCODE_LESS:
+        case IROPCODE_LESSEQUAL:
+        {
+            // `a < b` is `b > a`, which is false for unordered operands
+            bool is_greater = instruction->opcode == IROPCODE_GREATER || instruction->opcode == IROPCODE_GREATEREQUAL;
+            bool is_strict = instruction->opcode == IROPCODE_GREATER || instruction->opcode == IROPCODE_LESS;
+            emit_float_compare( native, is_greater ? 0 : 1, is_greater ? 1 : 0, is_double_operation );
+            emit_set_condition( native, is_strict ? CONDITIONCODE_A : CONDITIONCODE_AE, REGISTER_RAX );
+            store_result( native, instruction, REGISTER_RAX );
+            return;
+        }
+
+        default:
+        {
+            UNREACHABLE();
+        }
+    }
+
+    emit_move_from_xmm( native, REGISTER_RAX, 0, is_double_operation );
+    store_result( native, instruction, REGISTER_RAX );
+}
+
+static void generate_binary( Native* native, IrInstruction* instruction )
+{
+    IrInstruction* left = instruction->operands[ 0 ];
+    IrInstruction* right = instruction->operands[ 1 ];
+    if( ir_type_is_float( left->type ) )
+    {
+        generate_float_binary( native, instruction );
+        return;
+    }
+
+    load_value( native, REGISTER_RAX, left );
+    load_value( native, REGISTER_RCX, right );
+
+    // pointers compare like unsigned integers
+    bool is_signed = ir_type_is_signed( left->type );
+    ConditionCode condition;
+    switch( instruction->opcode )
+    {
+        case IROPCODE_ADD:      emit_arithmetic( native, OPCODE_ADD, REGISTER_RAX, REGISTER_RCX ); break;
+        case IROPCODE_SUBTRACT: emit_arithmetic( native, OPCODE_SUB, REGISTER_RAX, REGISTER_RCX ); break;
+        case IROPCODE_MULTIPLY: emit_arithmetic( native, OPCODE_IMUL, REGISTER_RAX, REGISTER_RCX ); break;
+
+        case IROPCODE_DIVIDE:
+        case IROPCODE_MODULO:
+        {
+            // the operands are extended to 64 bits, so the 64-bit division
+            // gives the same result
+            if( is_signed )
+            {
+                emit_byte( native, 0x48 );
+                emit_byte( native, 0x99 ); // cqo
+                emit_instruction( native, ENCODING_WIDE, 0xf7, 7, register_operand( REGISTER_RCX ) ); // idiv
+            }
+            else
+            {
+                emit_move_immediate( native, REGISTER_RDX, 0 );
+                emit_instruction( native, ENCODING_WIDE, 0xf7, 6, register_operand( REGISTER_RCX ) ); // div
+            }
+
+            if( instruction->opcode == IROPCODE_MODULO )
+            {
+                emit_move( native, REGISTER_RAX, REGISTER_RDX );
+            }
+            break;
+        }
+
+        case IROPCODE_EQUAL:        condition = CONDITIONCODE_E; goto compare;
+        case IROPCODE_NOTEQUAL:     condition = CONDITIONCODE_NE; goto compare;
+        case IROPCODE_LESS:         condition = is_signed ? CONDITIONCODE_L : CONDITIONCODE_B; goto compare;
+        case IROPCODE_LESSEQUAL:    condition = is_signed ? CONDITIONCODE_LE : CONDITIONCODE_BE; goto compare;
+        case IROPCODE_GREATER:      condition = is_signed ? CONDITIONCODE_G : CONDITIONCODE_A; goto compare;
+        case IROPCODE_GREATEREQUAL: condition = is_signed ? CONDITIONCODE_GE : CONDITIONCODE_AE; goto compare;
+        compare:
+        {
+            emit_arithmetic( native, OPCODE_CMP, REGISTER_RAX, REGISTER_RCX );
+            emit_set_condition( native, condition, REGISTER_RAX );
+            store_result( native, instruction, REGISTER_RAX );
+            return;
+        }
+
+        default:
+        {
+            UNREACHABLE();
+        }
+    }
+
+    emit_normalize( native, REGISTER_RAX, instruction->type );
+    store_result( native, instruction, REGISTER_RAX );
+}
+
+static void generate_convert( Native* native, IrInstruction* instruction )
+{
+    IrInstruction* operand = instruction->operands[ 0 ];
+    Type from = operand->type;
+    Type to = instruction->type;
+    bool is_to_bool = ir_get_type_definition( to ).kind == TYPEKIND_BOOLEAN;
+
+    if( ir_type_is_float( from ) && ir_type_is_float( to ) )
+    {
+        load_xmm( native, 0, operand );
+        if( is_double( from ) != is_double( to ) )
+        {
+            // cvtss2sd or cvtsd2ss
+            emit_instruction( native, is_double( from ) ? ENCODING_F2 : ENCODING_F3, 0x0f5a, 0, register_operand( 0 ) );
+        }
+        emit_move_from_xmm( native, REGISTER_RAX, 0, is_double( to ) );
+    }
+    else if( ir_type_is_float( from ) && is_to_bool )
+    {
+        load_xmm( native, 0, operand );
+        emit_instruction( native, 0, 0x0f57, 1, register_operand( 1 ) ); // xorps xmm1, xmm1
+        emit_float_compare( native, 0, 1, is_double( from ) );
+        emit_set_condition( native, CONDITIONCODE_NE, REGISTER_RAX );
+        emit_set_condition( native, CONDITIONCODE_P, REGISTER_RCX );
+        emit_arithmetic( native, OPCODE_OR, REGISTER_RAX, REGISTER_RCX );
+    }
+    else if( ir_type_is_float( from ) && ir_type_is_integer( to ) )
+    {
+        bool is_double_operand = is_double( from );
+        int encoding = ENCODING_WIDE | ( is_double_operand ? ENCODING_F2 : ENCODING_F3 );
+        load_xmm( native, 0, operand );
+        if( !ir_type_is_signed( to ) && ir_type_get_bit_count( to ) == 64 )
+        {
+            // values from 2^63 on do not fit a signed conversion, they are
+            // converted with 2^63 taken off and the top bit set afterwards
+            emit_move_immediate( native, REGISTER_RCX, is_double_operand ? 0x43e0000000000000ull : 0x5f000000ull );
+            emit_move_to_xmm( native, 1, REGISTER_RCX, is_double_operand );
+            emit_float_compare( native, 0, 1, is_double_operand );
+            size_t is_large = emit_short_jump_if( native, CONDITIONCODE_AE );
+            emit_instruction( native, encoding, 0x0f2c, REGISTER_RAX, register_operand( 0 ) ); // cvttsd2si
+            size_t done = emit_short_jump( native );
+            place_short_jump( native, is_large );
+            emit_float_arithmetic( native, 0x0f5c, is_double_operand );
+            emit_instruction( native, encoding, 0x0f2c, REGISTER_RAX, register_operand( 0 ) );
+            emit_instruction( native, ENCODING_WIDE, 0x0fba, 7, register_operand( REGISTER_RAX ) ); // btc rax, 63
+            emit_byte( native, 63 );
+            place_short_jump( native, done );
+        }
+        else
+        {
+            emit_instruction( native, encoding, 0x0f2c, REGISTER_RAX, register_operand( 0 ) );
+            emit_normalize( native, REGISTER_RAX, to );
+        }
+    }
+    else if( ir_type_is_integer( from ) && ir_type_is_float( to ) )
+    {
+        bool is_double_result = is_double( to );
+        int encoding = ENCODING_WIDE | ( is_double_result ? ENCODING_F2 : ENCODING_F3 );
+        load_value( native, REGISTER_RAX, operand );
+        if( !ir_type_is_signed( from ) && ir_type_get_bit_count( from ) == 64 )
+        {
+            // halved with the lowest bit kept for rounding, then doubled
+            emit_arithmetic( native, OPCODE_TEST, REGISTER_RAX, REGISTER_RAX );
+            size_t is_large = emit_short_jump_if( native, CONDITIONCODE_S );
+            emit_instruction( native, encoding, 0x0f2a, 0, register_operand( REGISTER_RAX ) ); // cvtsi2sd
+            size_t done = emit_short_jump( native );
+            place_short_jump( native, is_large );
+            emit_move( native, REGISTER_RCX, REGISTER_RAX );
+            emit_shift_immediate( native, 5, REGISTER_RCX, 1 );
+            emit_instruction( native, 0, 0x83, 4, register_operand( REGISTER_RAX ) ); // and eax, 1
+            emit_byte( native, 1 );
+            emit_arithmetic( native, OPCODE_OR, REGISTER_RCX, REGISTER_RAX );
+            emit_instruction( native, encoding, 0x0f2a, 0, register_operand( REGISTER_RCX ) );
+            emit_instruction( native, is_double_result ? ENCODING_F2 : ENCODING_F3, 0x0f58, 0, register_operand( 0 ) );
+            place_short_jump( native, done );
+        }
+        else
+        {
+            emit_instruction( native, encoding, 0x0f2a, 0, register_operand( REGISTER_RAX ) );
+        }
+        emit_move_from_xmm( native, REGISTER_RAX, 0, is_double_result );
+    }
+    else if( ir_type_is_integer( from ) && is_to_bool )
+    {
+        load_value( native, REGISTER_RAX, operand );
+        emit_arithmetic( native, OPCODE_TEST, REGISTER_RAX, REGISTER_RAX );
+        emit_set_condition( native, CONDITIONCODE_NE, REGISTER_RAX );
+    }
+    else if( ir_type_is_integer( to ) )
+    {
+        load_value( native, REGISTER_RAX, operand );
+        emit_normalize( native, REGISTER_RAX, to );
+    }
+    else
+    {
+        // between pointers and references
+        copy_value( native, instruction, operand );
+        return;
+    }
+
+    store_result( native, instruction, REGISTER_RAX );
+}
+
+static void generate_unary( Native* native, IrInstruction* instruction )
+{
+    Type type = instruction->type;
+    load_value( native, REGISTER_RAX, instruction->operands[ 0 ] );
+
+    if( instruction->opcode == IROPCODE_NOT )
+    {
+        emit_arithmetic( native, OPCODE_TEST, REGISTER_RAX, REGISTER_RAX );
+        emit_set_condition( native, CONDITIONCODE_E, REGISTER_RAX );
+    }
+    else if( is_double( type ) )
+    {
+        emit_instruction( native, ENCODING_WIDE, 0x0fba, 7, register_operand( REGISTER_RAX ) ); // btc rax, 63
+        emit_byte( native, 63 );
+    }
+    else if( ir_type_is_float( type ) )
+    {
+        emit_instruction( native, 0, 0x81, 6, register_operand( REGISTER_RAX ) ); // xor eax, imm32
+        emit_u32( native, 0x80000000 );
+    }
+    else
+    {
+        emit_instruction( native, ENCODING_WIDE, 0xf7, 3, register_operand( REGISTER_RAX ) ); // neg
+        emit_normalize( native, REGISTER_RAX, type );
+    }
+
+    store_result( native, instruction, REGISTER_RAX );
+}
+
+static void generate_load( Native* native, IrInstruction* instruction )
+{
+    load_value( native, REGISTER_RAX, instruction->operands[ 0 ] );
+    if( is_array( instruction->type ) )
+    {
+        emit_load_word( native, REGISTER_RCX, memory_operand( REGISTER_RAX, 0 ) );
+        emit_load_word( native, REGISTER_RDX, memory_operand( REGISTER_RAX, 8 ) );
+        store_array_result( native, instruction, REGISTER_RCX, REGISTER_RDX );
+        return;
+    }
+
+    emit_load( native, REGISTER_RAX, memory_operand( REGISTER_RAX, 0 ), instruction->type );
+    store_result( native, instruction, REGISTER_RAX );
+}
+
+// stores `value` at `address` plus `displacement`, `address` must not be rcx
+// or rdx
+static void generate_store_to( Native* native, Register address, int32_t displacement, IrInstruction* value )
+{
+    if( is_array( value->type ) )
+    {
+        load_array( native, REGISTER_RCX, REGISTER_RDX, value );
+        emit_store_word( native, memory_operand( address, displacement ), REGISTER_RCX );
+        emit_store_word( native, memory_operand( address, displacement + 8 ), REGISTER_RDX );
+        return;
+    }
+
+    load_value( native, REGISTER_RCX, value );
+    emit_store( native, memory_operand( address, displacement ), REGISTER_RCX, value->type );
+}
+
+// the data of static arrays is written once, the instruction makes an array
+// that points to it
+static void generate_static_array_data( Native* native, IrInstruction* instruction )
+{
+    Type array_type = instruction->array_literal.type;
+    Type element_type = *array_type.array.base_type;
+    int element_size = get_type_size( element_type );
+    size_t operand_count = lvec_get_length( instruction->operands );
+
+    // strings need relocations, which do not belong in .rodata
+    bool has_strings = false;
+    for( size_t i = 0; i < operand_count; i++ )
+    {
+        has_strings = has_strings || instruction->operands[ i ]->opcode == IROPCODE_STRING;
+    }
+
+    ElfSection section = has_strings ? ELFSECTION_DATA : ELFSECTION_RODATA;
+    CodeBuffer* data = &native->object.sections[ section ];
+    uint64_t offset = elf_object_align( &native->object, section, 16 );
+    for( int i = 0; i < array_type.array.length; i++ )
+    {
+        uint64_t bits = 0;
+        if( ( size_t )i < operand_count )
+        {
+            IrInstruction* element = instruction->operands[ i ];
+            if( element->opcode == IROPCODE_STRING )
+            {
+                int rodata_symbol = elf_object_get_section_symbol( ELFSECTION_RODATA );
+                elf_object_add_relocation( &native->object, ELFSECTION_DATA, data->length, rodata_symbol,
+                                           ELFRELOCATIONKIND_ABSOLUTE64, get_string_offset( native, element ) );
+            }
+            else
+            {
+                bits = ir_get_constant_bits( element );
+            }
+        }
+
+        for( int b = 0; b < element_size; b++ )
+        {
+            code_buffer_append_char( data, ( char )( ( bits >> ( b * 8 ) ) & 0xff ) );
+        }
+    }
+
+    emit_move_immediate( native, REGISTER_RAX, ( uint64_t )array_type.array.length );
+    emit_load_address( native, REGISTER_RCX, symbol_operand( elf_object_get_section_symbol( section ), ( int32_t )offset ) );
+    store_array_result( native, instruction, REGISTER_RAX, REGISTER_RCX );
+}
+
+static void generate_array_literal( Native* native, IrInstruction* instruction )
+{
+    Type array_type = instruction->array_literal.type;
+    int length = array_type.array.length;
+    int element_size = get_type_size( *array_type.array.base_type );
+    size_t operand_count = lvec_get_length( instruction->operands );
+
+    switch( instruction->array_literal.storage )
+    {
+        case ARRAYSTORAGE_STATIC:
+        {
+            generate_static_array_data( native, instruction );
+            return;
+        }
+
+        case ARRAYSTORAGE_AUTOMATIC:
+        {
+            // zeroed with rep stosb every time, like a compound literal
+            int32_t data_offset = native->array_data_offsets[ instruction->index ];
+            emit_load_address( native, REGISTER_RDI, memory_operand( REGISTER_RBP, data_offset ) );
+            emit_move_immediate( native, REGISTER_RCX, ( uint64_t )( length * element_size ) );
+            emit_move_immediate( native, REGISTER_RAX, 0 );
+            emit_byte( native, 0xf3 );
+            emit_byte( native, 0xaa );
+            emit_load_address( native, REGISTER_RAX, memory_operand( REGISTER_RBP, data_offset ) );
+            break;
+        }
+
+        case ARRAYSTORAGE_HEAP:
+        case ARRAYSTORAGE_SCOPEDHEAP:
+        {
+            emit_move_immediate( native, REGISTER_RDI, ( uint64_t )length );
+            emit_move_immediate( native, REGISTER_RSI, ( uint64_t )element_size );
+            emit_call( native, elf_object_get_symbol( &native->object, "calloc" ) );
+            emit_arithmetic( native, OPCODE_TEST, REGISTER_RAX, REGISTER_RAX );
+            emit_stub_jump( native, STUBKIND_OUTOFMEMORY, ( Token ){ 0 }, length );
+            break;
+        }
+    }
+
+    // rax holds the data
+    for( size_t i = 0; i < operand_count; i++ )
+    {
+        generate_store_to( native, REGISTER_RAX, ( int32_t )i * element_size, instruction->operands[ i ] );
+    }
+
+    emit_move( native, REGISTER_RCX, REGISTER_RAX );
+    emit_move_immediate( native, REGISTER_RAX, ( uint64_t )length );
+    store_array_result( native, instruction, REGISTER_RAX, REGISTER_RCX );
+}
+
+static void generate_element( Native* native, IrInstruction* instruction )
+{
+    IrInstruction* array = instruction->operands[ 0 ];
+    load_value( native, REGISTER_RCX, instruction->operands[ 1 ] );
+    load_array( native, REGISTER_RAX, REGISTER_RDX, array );
+    if( instruction->element.is_bounds_checked )
+    {
+        emit_arithmetic( native, OPCODE_CMP, REGISTER_RCX, REGISTER_RAX );
+        emit_stub_jump( native, STUBKIND_BOUNDSCHECK, instruction->element.location_token, 0 );
+    }
+
+    int element_size = get_type_size( *instruction->type.reference.base_type );
+    if( element_size > 1 && ( element_size & ( element_size - 1 ) ) == 0 )
+    {
+        uint8_t shift = 0;
+        while( ( 1 << shift ) < element_size )
+        {
+            shift++;
+        }
+        emit_shift_immediate( native, 4, REGISTER_RCX, shift );
+    }
+    else if( element_size > 1 )
+    {
+        emit_instruction( native, ENCODING_WIDE, 0x69, REGISTER_RCX, register_operand( REGISTER_RCX ) ); // imul
+        emit_u32( native, ( uint32_t )element_size );
+    }
+
+    emit_arithmetic( native, OPCODE_ADD, REGISTER_RDX, REGISTER_RCX );
+    store_result( native, instruction, REGISTER_RDX );
+}
+
+// the arguments go where classify_arguments() puts them, the ones on the
+// stack first since they need a scratch register. returns true if the call
+// became a jump, which also returns from the function
+static bool generate_call( Native* native, IrInstruction* call, bool is_tail_call )
+{
+    Expression* function = call->call.function;
+    size_t argument_count = lvec_get_length( call->operands );
+    Type* types = calloc( argument_count + 1, sizeof( Type ) );
+    ArgumentLocation* arguments = calloc( argument_count + 1, sizeof( ArgumentLocation ) );
+    if( types == NULL || arguments == NULL ) ALLOC_ERROR();
+    for( size_t i = 0; i < argument_count; i++ )
+    {
+        types[ i ] = call->operands[ i ]->type;
+    }
+
+    int float_count;
+    int32_t stack_size = classify_arguments( types, argument_count, arguments, &float_count );
+    int32_t stack_adjustment = align( stack_size, 16 );
+
+    // tail calls with arguments on the stack would overwrite the caller's
+    // arguments, and the arguments can point into the caller's frame. those
+    // become ordinary calls
+    is_tail_call = is_tail_call && stack_size == 0 && !native->has_frame_memory;
+
+    if( stack_adjustment > 0 )
+    {
+        emit_add_immediate( native, REGISTER_RSP, -stack_adjustment );
+    }
+
+    for( size_t i = 0; i < argument_count; i++ )
+    {
+        if( arguments[ i ].is_on_stack )
+        {
+            generate_store_to( native, REGISTER_RSP, arguments[ i ].stack_offset, call->operands[ i ] );
+        }
+    }
+
+    for( size_t i = 0; i < argument_count; i++ )
+    {
+        ArgumentLocation argument = arguments[ i ];
+        IrInstruction* operand = call->operands[ i ];
+        if( argument.is_on_stack )
+        {
+            continue;
+        }
+
+        if( is_array( operand->type ) )
+        {
+            load_array( native, argument_registers[ argument.register_index ],
+                        argument_registers[ argument.register_index + 1 ], operand );
+        }
+        else if( ir_type_is_float( operand->type ) )
+        {
+            load_xmm( native, argument.register_index, operand );
+        }
+        else
+        {
+            load_value( native, argument_registers[ argument.register_index ], operand );
+        }
+    }
+
+    // variadic functions are told how many vector registers are used
+    if( function->function_declaration.is_variadic )
+    {
+        emit_move_immediate( native, REGISTER_RAX, ( uint64_t )float_count );
+    }
+
+    int symbol = elf_object_get_symbol( &native->object, get_function_name( function ) );
+    if( is_tail_call )
+    {
+        emit_epilogue( native );
+        emit_jump_to_symbol( native, symbol );
+    }
+    else
+    {
+        emit_call( native, symbol );
+        if( stack_adjustment > 0 )
+        {
+            emit_add_immediate( native, REGISTER_RSP, stack_adjustment );
+        }
+
+        Type type = call->type;
+        if( is_array( type ) )
+        {
+            store_array_result( native, call, REGISTER_RAX, REGISTER_RDX );
+        }
+        else if( ir_type_is_float( type ) )
+        {
+            emit_move_from_xmm( native, REGISTER_RAX, 0, is_double( type ) );
+            store_result( native, call, REGISTER_RAX );
+        }
+        else if( !is_void( type ) )
+        {
+            emit_normalize( native, REGISTER_RAX, type );
+            store_result( native, call, REGISTER_RAX );
+        }
+    }
+
+    free( arguments );
+    free( types );
+    return is_tail_call;
+}
+
+// the values of the phis of `successor` are put where the phis read them from
+static void generate_phi_inputs( Native* native, IrBlock* block, IrBlock* successor )
+{
+    size_t predecessor_index = 0;
+    while( successor->predecessors[ predecessor_index ] != block )
+    {
+        predecessor_index++;
+    }
+
+    size_t length = lvec_get_length( successor->instructions );
+    for( size_t i = 0; i < length && successor->instructions[ i ]->opcode == IROPCODE_PHI; i++ )
+    {
+        IrInstruction* phi = successor->instructions[ i ];
+        Location input = native->phi_inputs[ phi->index ];
+        IrInstruction* operand = phi->operands[ predecessor_index ];
+        if( is_array( phi->type ) )
+        {
+            load_array( native, REGISTER_RAX, REGISTER_RCX, operand );
+            emit_store_word( native, get_stack_operand( input, 0 ), REGISTER_RAX );
+            emit_store_word( native, get_stack_operand( input, 1 ), REGISTER_RCX );
+            continue;
+        }
+
+        load_value( native, REGISTER_RAX, operand );
+        emit_store_word( native, get_stack_operand( input, 0 ), REGISTER_RAX );
+    }
+}
+
+static void generate_phi( Native* native, IrInstruction* phi )
+{
+    Location input = native->phi_inputs[ phi->index ];
+    if( is_array( phi->type ) )
+    {
+        emit_load_word( native, REGISTER_RAX, get_stack_operand( input, 0 ) );
+        emit_load_word( native, REGISTER_RCX, get_stack_operand( input, 1 ) );
+        store_array_result( native, phi, REGISTER_RAX, REGISTER_RCX );
+        return;
+    }
+
+    emit_load_word( native, REGISTER_RAX, get_stack_operand( input, 0 ) );
+    store_result( native, phi, REGISTER_RAX );
+}
+
+static void generate_terminator( Native* native, IrBlock* block, IrBlock* next_block, IrInstruction* terminator )
+{
+    switch( terminator->opcode )
+    {
+        case IROPCODE_JUMP:
+        {
+            generate_phi_inputs( native, block, terminator->targets[ 0 ] );
+            if( terminator->targets[ 0 ] != next_block )
+            {
+                emit_jump( native, terminator->targets[ 0 ] );
+            }
+            break;
+        }
+
+        case IROPCODE_BRANCH:
+        {
+            IrBlock* true_target = terminator->targets[ 0 ];
+            IrBlock* false_target = terminator->targets[ 1 ];
+            generate_phi_inputs( native, block, true_target );
+            generate_phi_inputs( native, block, false_target );
+
+            load_value( native, REGISTER_RAX, terminator->operands[ 0 ] );
+            emit_arithmetic( native, OPCODE_TEST, REGISTER_RAX, REGISTER_RAX );
+            if( true_target == next_block )
+            {
+                emit_jump_if( native, CONDITIONCODE_E, false_target );
+                break;
+            }
+
+            emit_jump_if( native, CONDITIONCODE_NE, true_target );
+            if( false_target != next_block )
+            {
+                emit_jump( native, false_target );
+            }
+            break;
+        }
+
+        case IROPCODE_RETURN:
+        {
+            if( lvec_get_length( terminator->operands ) > 0 )
+            {
+                IrInstruction* value = terminator->operands[ 0 ];
+                if( is_array( value->type ) )
+                {
+                    load_array( native, REGISTER_RAX, REGISTER_RDX, value );
+                }
+                else if( ir_type_is_float( value->type ) )
+                {
+                    load_xmm( native, 0, value );
+                }
+                else
+                {
+                    load_value( native, REGISTER_RAX, value );
+                }
+            }
+
+            emit_epilogue( native );
+            emit_byte( native, 0xc3 ); // ret
+            break;
+        }
+
+        default:
+        {
+            UNREACHABLE();
+        }
+    }
+}
+
+static int64_t get_format_offset( Native* native, int64_t* offset, const char* format )
+{
+    if( *offset == -1 )
+    {
+        *offset = add_rodata( native, format, strlen( format ) + 1, 1 );
+    }
+
+    return *offset;
+}
+
+static void generate_stubs( Native* native )
+{
+    int rodata_symbol = elf_object_get_section_symbol( ELFSECTION_RODATA );
+    size_t stub_count = lvec_get_length( native->stubs );
+    for( size_t i = 0; i < stub_count; i++ )
+    {
+        Stub stub = native->stubs[ i ];
+        patch_u32( native, stub.offset, ( uint32_t )( native->text->length - ( stub.offset + 4 ) ) );
+
+        if( stub.kind == STUBKIND_BOUNDSCHECK && native->check_mode == CHECKMODE_TRAP )
+        {
+            emit_byte( native, 0x0f );
+            emit_byte( native, 0x0b ); // ud2
+            continue;
+        }
+
+        // dprintf( 2, format, ... ) and abort(), like the runtime header does
+        if( stub.kind == STUBKIND_BOUNDSCHECK )
+        {
+            char location[ 64 ];
+            snprintf( location, sizeof( location ), ":%d:%d", stub.location_token.line, stub.location_token.column );
+            int64_t location_offset = ( int64_t )native->object.sections[ ELFSECTION_RODATA ].length;
+            CodeBuffer* rodata = &native->object.sections[ ELFSECTION_RODATA ];
+            Token token = stub.location_token;
+            code_buffer_append_string( rodata, token.source_code != NULL ? token.source_code->path : native->source_path );
+            code_buffer_append_data( rodata, location, strlen( location ) + 1 );
+
+            int64_t format_offset = get_format_offset( native, &native->bounds_format_offset,
+                "%s: index %llu is out of bounds for array of length %llu\n" );
+            emit_move( native, REGISTER_R8, REGISTER_RAX );
+            emit_load_address( native, REGISTER_RDX, symbol_operand( rodata_symbol, ( int32_t )location_offset ) );
+            emit_load_address( native, REGISTER_RSI, symbol_operand( rodata_symbol, ( int32_t )format_offset ) );
+        }
+        else
+        {
+            int64_t format_offset = get_format_offset( native, &native->allocation_format_offset,
+                "out of memory allocating an array of length %llu\n" );
+            emit_move_immediate( native, REGISTER_RDX, ( uint64_t )stub.length );
+            emit_load_address( native, REGISTER_RSI, symbol_operand( rodata_symbol, ( int32_t )format_offset ) );
+        }
+
+        emit_move_immediate( native, REGISTER_RDI, 2 );
+        emit_move_immediate( native, REGISTER_RAX, 0 );
+        emit_call( native, elf_object_get_symbol( &native->object, "dprintf" ) );
+        emit_call( native, elf_object_get_symbol( &native->object, "abort" ) );
+    }
+}
+
+static void generate_function( Native* native, Expression* declaration )
+{
+    IrFunction* function = declaration->function_declaration.ir;
+    native->function = function;
+    native->has_frame_memory = false;
+
+    int instruction_count = function->instruction_count;
+    native->locations = calloc( instruction_count, sizeof( Location ) );
+    native->phi_inputs = calloc( instruction_count, sizeof( Location ) );
+    native->array_data_offsets = calloc( instruction_count, sizeof( int32_t ) );
+    native->string_offsets = malloc( instruction_count * sizeof( int64_t ) );
+    native->block_offsets = calloc( function->block_count, sizeof( size_t ) );
+    if( native->locations == NULL || native->phi_inputs == NULL || native->array_data_offsets == NULL ||
+        native->string_offsets == NULL || native->block_offsets == NULL )
+    {
+        ALLOC_ERROR();
+    }
+    for( int i = 0; i < instruction_count; i++ )
+    {
+        native->string_offsets[ i ] = -1;
+    }
+
+    bool is_register_used[ 16 ] = { 0 };
+    allocate_registers( native, is_register_used );
+    native->saved_registers = lvec_new( Register );
+    for( int i = 0; i < ALLOCATABLE_REGISTER_COUNT; i++ )
+    {
+        if( is_register_used[ allocatable_registers[ i ] ] )
+        {
+            lvec_append( native->saved_registers, allocatable_registers[ i ] );
+        }
+    }
+    assign_stack_slots( native );
+
+    native->fixups = lvec_new( Fixup );
+    native->stubs = lvec_new( Stub );
+
+    size_t start = elf_object_align( &native->object, ELFSECTION_TEXT, 16 );
+    generate_prologue( native, declaration );
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        IrBlock* next_block = i + 1 < block_count ? function->blocks[ i + 1 ] : NULL;
+        native->block_offsets[ block->index ] = native->text->length;
+
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            switch( instruction->opcode )
+            {
+                case IROPCODE_CONSTANT:
+                case IROPCODE_STRING:
+                case IROPCODE_PARAM:
+                case IROPCODE_SLOT:
+                case IROPCODE_GLOBAL:
+                {
+                    break;
+                }
+
+                case IROPCODE_PHI:
+                {
+                    generate_phi( native, instruction );
+                    break;
+                }
+
+                case IROPCODE_COPY:
+                {
+                    copy_value( native, instruction, instruction->operands[ 0 ] );
+                    break;
+                }
+
+                case IROPCODE_CONVERT:
+                {
+                    generate_convert( native, instruction );
+                    break;
+                }
+
+                case IROPCODE_NEGATE:
+                case IROPCODE_NOT:
+                {
+                    generate_unary( native, instruction );
+                    break;
+                }
+
+                case IROPCODE_LOAD:
+                {
+                    generate_load( native, instruction );
+                    break;
+                }
+
+                case IROPCODE_STORE:
+                {
+                    load_value( native, REGISTER_RAX, instruction->operands[ 0 ] );
+                    generate_store_to( native, REGISTER_RAX, 0, instruction->operands[ 1 ] );
+                    break;
+                }
+
+                case IROPCODE_ARRAYLITERAL:
+                {
+                    generate_array_literal( native, instruction );
+                    break;
+                }
+
+                case IROPCODE_ARRAYLENGTH:
+                {
+                    load_array( native, REGISTER_RAX, REGISTER_RCX, instruction->operands[ 0 ] );
+                    store_result( native, instruction, REGISTER_RAX );
+                    break;
+                }
+
+                case IROPCODE_ELEMENT:
+                {
+                    generate_element( native, instruction );
+                    break;
+                }
+
+                case IROPCODE_CALL:
+                {
+                    // the return that follows a tail call is part of the jump
+                    if( generate_call( native, instruction, instruction->call.is_tail_call ) )
+                    {
+                        j = length;
+                    }
+                    break;
+                }
+
+                case IROPCODE_JUMP:
+                case IROPCODE_BRANCH:
+                case IROPCODE_RETURN:
+                {
+                    generate_terminator( native, block, next_block, instruction );
+                    break;
+                }
+
+                default:
+                {
+                    generate_binary( native, instruction );
+                    break;
+                }
+            }
+        }
+    }
+
+    size_t fixup_count = lvec_get_length( native->fixups );
+    for( size_t i = 0; i < fixup_count; i++ )
+    {
+        Fixup fixup = native->fixups[ i ];
+        size_t target = native->block_offsets[ fixup.target->index ];
+        patch_u32( native, fixup.offset, ( uint32_t )( target - ( fixup.offset + 4 ) ) );
+    }
+    generate_stubs( native );
+
+    int symbol = elf_object_get_symbol( &native->object, get_function_name( declaration ) );
+    elf_object_define_symbol( &native->object, symbol, ELFSECTION_TEXT, ELFSYMBOLKIND_FUNCTION,
+                              start, native->text->length - start, true );
+
+    lvec_free( native->stubs );
+    lvec_free( native->fixups );
+    lvec_free( native->saved_registers );
+    free( native->block_offsets );
+    free( native->string_offsets );
+    free( native->array_data_offsets );
+    free( native->phi_inputs );
+    free( native->locations );
+}
+
+// globals
+
+static void generate_global( Native* native, Expression* declaration )
+{
+    Type type = declaration->variable_declaration.variable_type;
+    Expression* rvalue = declaration->variable_declaration.rvalue;
+    int size = get_type_size( type );
+    int symbol = elf_object_get_symbol( &native->object, declaration->variable_declaration.identifier_token.as_string );
+
+    if( rvalue == NULL )
+    {
+        uint64_t offset = elf_object_align( &native->object, ELFSECTION_BSS, 8 );
+        native->object.bss_size += size;
+        elf_object_define_symbol( &native->object, symbol, ELFSECTION_BSS, ELFSYMBOLKIND_OBJECT, offset, size, true );
+        return;
+    }
+
+    uint64_t offset = elf_object_align( &native->object, ELFSECTION_DATA, 8 );
+    CodeBuffer* data = &native->object.sections[ ELFSECTION_DATA ];
+    uint64_t bits = 0;
+    if( rvalue->kind == EXPRESSIONKIND_STRING )
+    {
+        int64_t string_offset = add_string( native, rvalue->string );
+        elf_object_add_relocation( &native->object, ELFSECTION_DATA, offset,
+                                   elf_object_get_section_symbol( ELFSECTION_RODATA ),
+                                   ELFRELOCATIONKIND_ABSOLUTE64, string_offset );
+    }
+    else
+    {
+        bits = ir_get_literal_bits( rvalue, type );
+    }
+
+    for( int b = 0; b < size; b++ )
+    {
+        code_buffer_append_char( data, ( char )( ( bits >> ( b * 8 ) ) & 0xff ) );
+    }
+    elf_object_define_symbol( &native->object, symbol, ELFSECTION_DATA, ELFSYMBOLKIND_OBJECT, offset, size, true );
+}
+
+// the checks
+
+static bool is_supported_array_literal( IrInstruction* instruction )
+{
+    if( instruction->array_literal.storage != ARRAYSTORAGE_STATIC )
+    {
+        return true;
+    }
+
+    size_t operand_count = lvec_get_length( instruction->operands );
+    for( size_t i = 0; i < operand_count; i++ )
+    {
+        IrOpcode opcode = instruction->operands[ i ]->opcode;
+        if( opcode != IROPCODE_CONSTANT && opcode != IROPCODE_STRING )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool is_supported_function( IrFunction* function )
+{
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            if( instruction->opcode == IROPCODE_ARRAYLITERAL && !is_supported_array_literal( instruction ) )
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool native_can_generate( Expression* program )
+{
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION && statement->function_declaration.is_reachable )
+        {
+            char* identifier = get_function_name( statement );
+            IrFunction* function = statement->function_declaration.ir;
+            if( function == NULL || statement->function_declaration.is_variadic || !is_supported_function( function ) )
+            {
+                printf( "The native backend cannot generate '%s', compiling with gcc instead.\n", identifier );
+                return false;
+            }
+        }
+        else if( statement->kind == EXPRESSIONKIND_VARIABLEDECLARATION )
+        {
+            Type type = statement->variable_declaration.variable_type;
+            Expression* rvalue = statement->variable_declaration.rvalue;
+            bool is_supported_type = ir_type_is_integer( type ) || ir_type_is_float( type ) ||
+                                     type.kind == TYPEKIND_POINTER;
+            if( !is_supported_type || ( rvalue != NULL && !ir_is_literal_initializer( rvalue ) ) )
+            {
+                printf( "The native backend cannot initialize '%s', compiling with gcc instead.\n",
+                        statement->variable_declaration.identifier_token.as_string );
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool generate_native_object( Expression* program, char* object_path, CheckMode check_mode, char* source_path )
+{
+    Native native = {
+        .check_mode = check_mode,
+        .source_path = source_path,
+        .bounds_format_offset = -1,
+        .allocation_format_offset = -1,
+    };
+    elf_object_initialize( &native.object );
+    native.text = &native.object.sections[ ELFSECTION_TEXT ];
+
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION && statement->function_declaration.is_reachable )
+        {
+            generate_function( &native, statement );
+        }
+        else if( statement->kind == EXPRESSIONKIND_VARIABLEDECLARATION )
+        {
+            generate_global( &native, statement );
+        }
+    }
+
+    bool is_written = elf_object_write( &native.object, object_path );
+    elf_object_free( &native.object );
+    return is_written;
+}
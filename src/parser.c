@@ -33,12 +33,12 @@ static bool _expect( Parser* parser, TokenKind* expected_token_kinds, size_t len
     }
     if( !is_valid )
     {
-        printf( "ERROR CALLED FROM LINE %d\n", line );
+        report_message( parser->source_code, "ERROR CALLED FROM LINE %d\n", line );
         Error error = {
             .kind = ERRORKIND_UNEXPECTEDSYMBOL,
             .offending_token = parser->current_token,
         };
-        report_error( error );
+        report_error( parser->source_code, error );
     }
 
     return is_valid;
@@ -57,12 +57,12 @@ static bool _expect_next( Parser* parser, TokenKind* expected_token_kinds, size_
     }
     if( !is_valid )
     {
-        printf( "ERROR CALLED FROM LINE %d\n", line );
+        report_message( parser->source_code, "ERROR CALLED FROM LINE %d\n", line );
         Error error = {
             .kind = ERRORKIND_UNEXPECTEDSYMBOL,
             .offending_token = parser->next_token,
         };
-        report_error( error );
+        report_error( parser->source_code, error );
     }
 
     return is_valid;
@@ -113,9 +113,10 @@ static void advance( Parser* parser )
     parser->next_token = parser->tokens[ parser->current_token_index + 1 ];
 }
 
-void parser_initialize( Parser* parser, Token* _tokens )
+void parser_initialize( Parser* parser, Token* _tokens, SourceCode* source_code )
 {
     parser->tokens = _tokens;
+    parser->source_code = source_code;
     parser->current_token_index = -1;
     advance( parser );
 }
@@ -1386,6 +1387,91 @@ static Expression* parse_type_declaration( Parser* parser )
     return expression;
 }
 
+// `module name;` and `import name;`
+static Expression* parse_module_declaration( Parser* parser )
+{
+    Expression* expression = calloc( 1, sizeof( Expression ) );
+    if( expression == NULL ) ALLOC_ERROR();
+
+    expression->kind = parser->current_token.kind == TOKENKIND_MODULE ? EXPRESSIONKIND_MODULE : EXPRESSIONKIND_IMPORT;
+    expression->starting_token = parser->current_token;
+
+    advance( parser );
+    if( !EXPECT( parser, TOKENKIND_IDENTIFIER ) )
+    {
+        return NULL;
+    }
+
+    expression->module_declaration.identifier_token = parser->current_token;
+
+    advance( parser );
+    if( !EXPECT( parser, TOKENKIND_SEMICOLON ) )
+    {
+        return NULL;
+    }
+
+    return expression;
+}
+
+// parses any number of `#[a, b(argument)]` groups, stops at the last `]`
+static Attribute* parse_attributes( Parser* parser )
+{
+    Attribute* attributes = lvec_new( Attribute );
+
+    while( true )
+    {
+        advance( parser );
+        if( !EXPECT( parser, TOKENKIND_LEFTBRACKET ) )
+        {
+            return NULL;
+        }
+
+        do
+        {
+            advance( parser );
+            if( !EXPECT( parser, TOKENKIND_IDENTIFIER ) )
+            {
+                return NULL;
+            }
+
+            Attribute attribute = {
+                .identifier_token = parser->current_token,
+            };
+
+            if( parser->next_token.kind == TOKENKIND_LEFTPAREN )
+            {
+                advance( parser );
+                advance( parser );
+                attribute.argument = parse_rvalue( parser );
+                if( attribute.argument == NULL )
+                {
+                    return NULL;
+                }
+
+                advance( parser );
+                if( !EXPECT( parser, TOKENKIND_RIGHTPAREN ) )
+                {
+                    return NULL;
+                }
+            }
+
+            lvec_append_aggregate( attributes, attribute );
+            advance( parser );
+        } while( parser->current_token.kind == TOKENKIND_COMMA );
+
+        if( !EXPECT( parser, TOKENKIND_RIGHTBRACKET ) )
+        {
+            return NULL;
+        }
+
+        if( parser->next_token.kind != TOKENKIND_HASH )
+        {
+            return attributes;
+        }
+        advance( parser );
+    }
+}
+
 Expression* parse( Parser* parser )
 {
     Expression* expression;
@@ -1498,6 +1584,38 @@ Expression* parse( Parser* parser )
             break;
         }
 
+        case TOKENKIND_MODULE:
+        case TOKENKIND_IMPORT:
+        {
+            expression = parse_module_declaration( parser );
+            break;
+        }
+
+        case TOKENKIND_HASH:
+        {
+            Attribute* attributes = parse_attributes( parser );
+            if( attributes == NULL )
+            {
+                return NULL;
+            }
+
+            advance( parser );
+            expression = parse( parser );
+            if( expression == NULL )
+            {
+                return NULL;
+            }
+
+            // the attributes of an extern are about its function
+            Expression* attributed = expression;
+            if( attributed->kind == EXPRESSIONKIND_EXTERN )
+            {
+                attributed = attributed->extern_expression.function;
+            }
+            attributed->attributes = attributes;
+            break;
+        }
+
         default:
         {
             UNIMPLEMENTED();
@@ -1506,3 +1624,138 @@ Expression* parse( Parser* parser )
 
     return expression;
 }
+
+void expression_visit_children( Expression* expression,
+                                void ( *visit )( Expression* child, void* data ),
+                                void* data )
+{
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_BINARY:
+        {
+            visit( expression->binary.left, data );
+            visit( expression->binary.right, data );
+            break;
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            visit( expression->unary.operand, data );
+            break;
+        }
+
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        {
+            for( size_t i = 0; i < expression->function_call.arg_count; i++ )
+            {
+                visit( &expression->function_call.args[ i ], data );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYLITERAL:
+        {
+            for( int i = 0; i < expression->array_literal.count_initialized; i++ )
+            {
+                visit( &expression->array_literal.initialized_rvalues[ i ], data );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_COMPOUNDLITERAL:
+        {
+            for( int i = 0; i < expression->compound_literal.initialized_count; i++ )
+            {
+                visit( &expression->compound_literal.initialized_member_rvalues[ i ], data );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            visit( expression->array_subscript.lvalue, data );
+            visit( expression->array_subscript.index_rvalue, data );
+            break;
+        }
+
+        case EXPRESSIONKIND_MEMBERACCESS:
+        {
+            visit( expression->member_access.lvalue, data );
+            break;
+        }
+
+        case EXPRESSIONKIND_VARIABLEDECLARATION:
+        {
+            if( expression->variable_declaration.rvalue != NULL )
+            {
+                visit( expression->variable_declaration.rvalue, data );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_FUNCTIONDECLARATION:
+        {
+            if( expression->function_declaration.body != NULL )
+            {
+                visit( expression->function_declaration.body, data );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_COMPOUND:
+        {
+            size_t length = lvec_get_length( expression->compound.expressions );
+            for( size_t i = 0; i < length; i++ )
+            {
+                visit( expression->compound.expressions[ i ], data );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_RETURN:
+        {
+            if( expression->return_expression.rvalue != NULL )
+            {
+                visit( expression->return_expression.rvalue, data );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_ASSIGNMENT:
+        {
+            visit( expression->assignment.lvalue, data );
+            visit( expression->assignment.rvalue, data );
+            break;
+        }
+
+        case EXPRESSIONKIND_EXTERN:
+        {
+            visit( expression->extern_expression.function, data );
+            break;
+        }
+
+        case EXPRESSIONKIND_CONDITIONAL:
+        {
+            visit( expression->conditional.condition, data );
+            visit( expression->conditional.true_body, data );
+            if( expression->conditional.false_body != NULL )
+            {
+                visit( expression->conditional.false_body, data );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_FORLOOP:
+        {
+            visit( expression->for_loop.iterable_rvalue, data );
+            visit( expression->for_loop.body, data );
+            break;
+        }
+
+        default:
+        {
+            // base cases, type declarations and type rvalues have no children
+            break;
+        }
+    }
+}
@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <string.h>
+#include "lvec.h"
+#include "parser.h"
+#include "purity.h"
+
+typedef struct PurityAnalysis
+{
+    Expression** functions; // top-level functions and externs
+    char** global_identifiers;
+
+    // of the function being classified
+    Purity purity;
+} PurityAnalysis;
+
+static char* purity_to_string[] = {
+    [ PURITY_CONST ]       = "const",
+    [ PURITY_PURE ]        = "pure",
+    [ PURITY_SIDEEFFECTS ] = "side effects",
+};
+
+static void weaken( PurityAnalysis* analysis, Purity purity )
+{
+    if( purity > analysis->purity )
+    {
+        analysis->purity = purity;
+    }
+}
+
+// locals that shadow a global are treated as the global, which is only ever
+// more conservative
+static bool is_global( PurityAnalysis* analysis, char* identifier )
+{
+    size_t length = lvec_get_length( analysis->global_identifiers );
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( strcmp( analysis->global_identifiers[ i ], identifier ) == 0 )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static Expression* find_function( PurityAnalysis* analysis, char* identifier )
+{
+    size_t length = lvec_get_length( analysis->functions );
+    for( size_t i = 0; i < length; i++ )
+    {
+        Expression* function = analysis->functions[ i ];
+        if( strcmp( function->function_declaration.identifier_token.as_string, identifier ) == 0 )
+        {
+            return function;
+        }
+    }
+
+    return NULL;
+}
+
+// true if writing to `lvalue` only changes locals of the function
+static bool is_local_lvalue( PurityAnalysis* analysis, Expression* lvalue )
+{
+    while( lvalue->kind == EXPRESSIONKIND_MEMBERACCESS )
+    {
+        lvalue = lvalue->member_access.lvalue;
+    }
+
+    // iterators refer to the elements of an array
+    return lvalue->kind == EXPRESSIONKIND_IDENTIFIER &&
+           lvalue->identifier.type.kind != TYPEKIND_REFERENCE &&
+           !is_global( analysis, lvalue->identifier.as_string );
+}
+
+static void classify_expression( Expression* expression, void* data )
+{
+    PurityAnalysis* analysis = data;
+
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_ASSIGNMENT:
+        {
+            if( !is_local_lvalue( analysis, expression->assignment.lvalue ) )
+            {
+                weaken( analysis, PURITY_SIDEEFFECTS );
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        {
+            Expression* callee = find_function( analysis, expression->function_call.identifier_token.as_string );
+            weaken( analysis, callee != NULL ? callee->function_declaration.purity : PURITY_SIDEEFFECTS );
+            break;
+        }
+
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            if( expression->identifier.type.kind == TYPEKIND_REFERENCE ||
+                is_global( analysis, expression->identifier.as_string ) )
+            {
+                weaken( analysis, PURITY_PURE );
+            }
+            break;
+        }
+
+        // a failed bounds check stops the program, which must happen even if
+        // the result of the call is unused
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            weaken( analysis, expression->array_subscript.is_bounds_checked ? PURITY_SIDEEFFECTS : PURITY_PURE );
+            break;
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            if( expression->unary.operation == UNARYOPERATION_DEREFERENCE )
+            {
+                weaken( analysis, PURITY_PURE );
+            }
+            break;
+        }
+
+        // allocating is a side effect, two calls must not return the same array
+        case EXPRESSIONKIND_ARRAYLITERAL:
+        {
+            ArrayStorage storage = expression->array_literal.storage;
+            if( storage == ARRAYSTORAGE_HEAP || storage == ARRAYSTORAGE_SCOPEDHEAP )
+            {
+                weaken( analysis, PURITY_SIDEEFFECTS );
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    expression_visit_children( expression, classify_expression, data );
+}
+
+static bool is_annotated( Expression* function )
+{
+    return function->function_declaration.attributes & ( FUNCTIONATTRIBUTE_CONST | FUNCTIONATTRIBUTE_PURE );
+}
+
+void annotate_purity( Expression* program )
+{
+    PurityAnalysis analysis = {
+        .functions = lvec_new( Expression* ),
+        .global_identifiers = lvec_new( char* ),
+    };
+
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        switch( statement->kind )
+        {
+            case EXPRESSIONKIND_EXTERN:
+            {
+                statement = statement->extern_expression.function;
+                [[ fallthrough ]];
+            }
+
+            case EXPRESSIONKIND_FUNCTIONDECLARATION:
+            {
+                // annotations are trusted, everything else starts out as const
+                // and is weakened until nothing changes, so that recursive
+                // functions converge
+                int attributes = statement->function_declaration.attributes;
+                Purity purity = PURITY_CONST;
+                if( attributes & FUNCTIONATTRIBUTE_PURE )
+                {
+                    purity = PURITY_PURE;
+                }
+                else if( !( attributes & FUNCTIONATTRIBUTE_CONST ) && statement->function_declaration.body == NULL )
+                {
+                    purity = PURITY_SIDEEFFECTS;
+                }
+                statement->function_declaration.purity = purity;
+
+                lvec_append( analysis.functions, statement );
+                break;
+            }
+
+            case EXPRESSIONKIND_VARIABLEDECLARATION:
+            {
+                lvec_append( analysis.global_identifiers, statement->variable_declaration.identifier_token.as_string );
+                break;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    size_t function_count = lvec_get_length( analysis.functions );
+    bool has_changed = true;
+    while( has_changed )
+    {
+        has_changed = false;
+        for( size_t i = 0; i < function_count; i++ )
+        {
+            Expression* function = analysis.functions[ i ];
+            if( function->function_declaration.body == NULL || is_annotated( function ) )
+            {
+                continue;
+            }
+
+            analysis.purity = PURITY_CONST;
+            classify_expression( function->function_declaration.body, &analysis );
+            if( analysis.purity != function->function_declaration.purity )
+            {
+                function->function_declaration.purity = analysis.purity;
+                has_changed = true;
+            }
+        }
+    }
+
+    // gcc ignores the attributes on functions that return nothing. main is
+    // left alone, nothing can call it twice
+    for( size_t i = 0; i < function_count; i++ )
+    {
+        Expression* function = analysis.functions[ i ];
+        Type return_type = function->function_declaration.return_type;
+        bool returns_void = return_type.kind == TYPEKIND_NAMED && return_type.named.definition->kind == TYPEKIND_VOID;
+        bool is_main = strcmp( function->function_declaration.identifier_token.as_string, "main" ) == 0;
+        if( returns_void || is_main || is_annotated( function ) ||
+            ( function->function_declaration.attributes & FUNCTIONATTRIBUTE_NORETURN ) )
+        {
+            continue;
+        }
+
+        switch( function->function_declaration.purity )
+        {
+            case PURITY_CONST: function->function_declaration.attributes |= FUNCTIONATTRIBUTE_CONST; break;
+            case PURITY_PURE:  function->function_declaration.attributes |= FUNCTIONATTRIBUTE_PURE; break;
+            case PURITY_SIDEEFFECTS: break;
+        }
+    }
+
+    lvec_free( analysis.functions );
+    lvec_free( analysis.global_identifiers );
+}
+
+void print_purity_report( Expression* program )
+{
+    printf( "purity:\n" );
+
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_EXTERN )
+        {
+            statement = statement->extern_expression.function;
+        }
+
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION )
+        {
+            printf( "    %s: %s\n",
+                    statement->function_declaration.identifier_token.as_string,
+                    purity_to_string[ statement->function_declaration.purity ] );
+        }
+    }
+}
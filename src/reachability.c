@@ -0,0 +1,389 @@
+#include <string.h>
+#include "debug.h"
+#include "lvec.h"
+#include "parser.h"
+#include "reachability.h"
+#include "semantic.h"
+#include "symboltable.h"
+
+typedef struct Reachability
+{
+    Expression* program;
+    Expression** function_worklist; // reachable functions whose bodies are not visited yet
+
+    // base types of the pointer and array instantiations in use
+    Type* pointer_types;
+    Type* array_types;
+} Reachability;
+
+static Expression* find_function( Expression* program, char* identifier )
+{
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_EXTERN )
+        {
+            statement = statement->extern_expression.function;
+        }
+
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION &&
+            strcmp( statement->function_declaration.identifier_token.as_string, identifier ) == 0 )
+        {
+            return statement;
+        }
+    }
+
+    return NULL;
+}
+
+static Expression* find_type_declaration( Expression* program, char* identifier )
+{
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_TYPEDECLARATION &&
+            strcmp( statement->type_declaration.identifier_token.as_string, identifier ) == 0 )
+        {
+            return statement;
+        }
+    }
+
+    return NULL;
+}
+
+// two types are the same instantiation if they generate the same c type, array
+// lengths do not matter
+static bool is_same_instantiation( Type t1, Type t2 )
+{
+    if( t1.kind != t2.kind )
+    {
+        return false;
+    }
+
+    switch( t1.kind )
+    {
+        case TYPEKIND_NAMED:
+        {
+            return strcmp( t1.named.as_string, t2.named.as_string ) == 0;
+        }
+
+        case TYPEKIND_POINTER:
+        {
+            return is_same_instantiation( *t1.pointer.base_type, *t2.pointer.base_type );
+        }
+
+        case TYPEKIND_REFERENCE:
+        {
+            return is_same_instantiation( *t1.reference.base_type, *t2.reference.base_type );
+        }
+
+        case TYPEKIND_ARRAY:
+        {
+            return is_same_instantiation( *t1.array.base_type, *t2.array.base_type );
+        }
+
+        case TYPEKIND_COMPOUND:
+        {
+            return t1.compound.member_symbol_table == t2.compound.member_symbol_table;
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+static bool contains_instantiation( Type* base_types, Type base_type )
+{
+    size_t length = lvec_get_length( base_types );
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( is_same_instantiation( base_types[ i ], base_type ) )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void use_function( Reachability* reachability, Expression* function )
+{
+    if( function->function_declaration.is_reachable )
+    {
+        return;
+    }
+
+    function->function_declaration.is_reachable = true;
+    lvec_append( reachability->function_worklist, function );
+}
+
+static void use_type( Reachability* reachability, Type type )
+{
+    switch( type.kind )
+    {
+        case TYPEKIND_NAMED:
+        {
+            // the builtin types have no declaration
+            Expression* declaration = find_type_declaration( reachability->program, type.named.as_string );
+            if( declaration == NULL || declaration->type_declaration.is_reachable )
+            {
+                break;
+            }
+
+            declaration->type_declaration.is_reachable = true;
+            use_type( reachability, *type.named.definition );
+            break;
+        }
+
+        case TYPEKIND_COMPOUND:
+        {
+            SymbolTable* members = type.compound.member_symbol_table;
+            for( int i = 0; i < members->length; i++ )
+            {
+                use_type( reachability, members->symbols[ i ].type );
+            }
+            break;
+        }
+
+        case TYPEKIND_FUNCTION:
+        {
+            for( int i = 0; i < type.function.param_count; i++ )
+            {
+                use_type( reachability, type.function.param_types[ i ] );
+            }
+            use_type( reachability, *type.function.return_type );
+            break;
+        }
+
+        case TYPEKIND_POINTER:
+        {
+            Type base_type = *type.pointer.base_type;
+            if( !contains_instantiation( reachability->pointer_types, base_type ) )
+            {
+                lvec_append_aggregate( reachability->pointer_types, base_type );
+            }
+            use_type( reachability, base_type );
+            break;
+        }
+
+        case TYPEKIND_ARRAY:
+        {
+            Type base_type = *type.array.base_type;
+            if( !contains_instantiation( reachability->array_types, base_type ) )
+            {
+                lvec_append_aggregate( reachability->array_types, base_type );
+            }
+            use_type( reachability, base_type );
+            break;
+        }
+
+        case TYPEKIND_REFERENCE:
+        {
+            use_type( reachability, *type.reference.base_type );
+            break;
+        }
+
+        case TYPEKIND_TYPE:
+        {
+            use_type( reachability, *type.type.info );
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+
+// subscripts and for loops use the array type of their elements
+static void use_array_of( Reachability* reachability, Type element_type )
+{
+    Type array_type = {
+        .kind = TYPEKIND_ARRAY,
+        .array.base_type = &element_type,
+    };
+    use_type( reachability, array_type );
+}
+
+static void visit_expression( Expression* expression, void* data )
+{
+    Reachability* reachability = data;
+
+    switch( expression->kind )
+    {
+        case EXPRESSIONKIND_FUNCTIONCALL:
+        {
+            char* identifier = expression->function_call.identifier_token.as_string;
+            Expression* callee = find_function( reachability->program, identifier );
+            if( callee != NULL )
+            {
+                use_function( reachability, callee );
+            }
+            break;
+        }
+
+        // nested functions are emitted with the function they are declared in
+        case EXPRESSIONKIND_FUNCTIONDECLARATION:
+        {
+            use_function( reachability, expression );
+            return;
+        }
+
+        case EXPRESSIONKIND_IDENTIFIER:
+        {
+            use_type( reachability, expression->identifier.type );
+            break;
+        }
+
+        case EXPRESSIONKIND_VARIABLEDECLARATION:
+        {
+            use_type( reachability, expression->variable_declaration.variable_type );
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYLITERAL:
+        {
+            use_type( reachability, expression->array_literal.type );
+            break;
+        }
+
+        case EXPRESSIONKIND_ARRAYSUBSCRIPT:
+        {
+            use_array_of( reachability, expression->array_subscript.element_type );
+            break;
+        }
+
+        case EXPRESSIONKIND_FORLOOP:
+        {
+            Type iterator_type = expression->for_loop.iterator_type;
+            use_type( reachability, iterator_type );
+            use_array_of( reachability, *iterator_type.reference.base_type );
+            break;
+        }
+
+        case EXPRESSIONKIND_COMPOUNDLITERAL:
+        {
+            char* type_identifier = expression->compound_literal.type_identifier_token.as_string;
+            Expression* declaration = find_type_declaration( reachability->program, type_identifier );
+            if( declaration != NULL )
+            {
+                use_type( reachability, declaration->type_declaration.type );
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    expression_visit_children( expression, visit_expression, data );
+}
+
+static void visit_function( Reachability* reachability, Expression* function )
+{
+    for( int i = 0; i < function->function_declaration.param_count; i++ )
+    {
+        use_type( reachability, function->function_declaration.param_types[ i ] );
+    }
+    use_type( reachability, function->function_declaration.return_type );
+
+    Expression* body = function->function_declaration.body;
+    if( body != NULL )
+    {
+        expression_visit_children( body, visit_expression, reachability );
+    }
+}
+
+// removes the instantiations that are not in `used_base_types`, in place
+// because every copy of the named type shares the vector
+static void remove_unused_instantiations( Type* base_types, Type* used_base_types )
+{
+    size_t length = lvec_get_length( base_types );
+    size_t kept_count = 0;
+    for( size_t i = 0; i < length; i++ )
+    {
+        if( contains_instantiation( used_base_types, base_types[ i ] ) )
+        {
+            base_types[ kept_count ] = base_types[ i ];
+            kept_count++;
+        }
+    }
+
+    for( size_t i = kept_count; i < length; i++ )
+    {
+        lvec_remove_last( base_types );
+    }
+}
+
+void eliminate_dead_code( SemanticContext* context, Expression* program )
+{
+    Reachability reachability = {
+        .program = program,
+        .function_worklist = lvec_new( Expression* ),
+        .pointer_types = lvec_new( Type ),
+        .array_types = lvec_new( Type ),
+    };
+
+    // the globals are always emitted. a program without a `main` keeps all of
+    // its functions
+    Expression* main_function = find_function( program, "main" );
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        switch( statement->kind )
+        {
+            case EXPRESSIONKIND_VARIABLEDECLARATION:
+            {
+                visit_expression( statement, &reachability );
+                break;
+            }
+
+            case EXPRESSIONKIND_FUNCTIONDECLARATION:
+            {
+                if( main_function == NULL || statement == main_function )
+                {
+                    use_function( &reachability, statement );
+                }
+                break;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    while( lvec_get_length( reachability.function_worklist ) > 0 )
+    {
+        size_t last = lvec_get_length( reachability.function_worklist ) - 1;
+        Expression* function = reachability.function_worklist[ last ];
+        lvec_remove_last( reachability.function_worklist );
+        visit_function( &reachability, function );
+    }
+
+    for( int i = 0; i < context->symbol_table.length; i++ )
+    {
+        Symbol symbol = context->symbol_table.symbols[ i ];
+        if( symbol.type.kind != TYPEKIND_TYPE || symbol.type.type.info->kind != TYPEKIND_NAMED )
+        {
+            continue;
+        }
+
+        Type named_type = *symbol.type.type.info;
+        remove_unused_instantiations( named_type.named.pointer_types, reachability.pointer_types );
+        remove_unused_instantiations( named_type.named.array_types, reachability.array_types );
+    }
+
+    lvec_free( reachability.function_worklist );
+    lvec_free( reachability.pointer_types );
+    lvec_free( reachability.array_types );
+}
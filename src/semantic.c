@@ -22,21 +22,6 @@ typedef struct TypeKindPair
     TypeKind tk2;
 } TypeKindPair;
 
-// primitive types for convenience
-Type void_type;
-Type char_type;
-Type bool_type;
-Type i8_type;
-Type i16_type;
-Type i32_type;
-Type i64_type;
-Type u8_type;
-Type u16_type;
-Type u32_type;
-Type u64_type;
-Type f32_type;
-Type f64_type;
-
 void push_return_type( SemanticContext* context, Type type )
 {
     lvec_append_aggregate( context->return_type_stack, type );
@@ -53,10 +38,16 @@ Type get_top_return_type( SemanticContext* context )
     return context->return_type_stack[ last_index ];
 }
 
-void semantic_context_initialize( SemanticContext* context )
+void semantic_context_initialize( SemanticContext* context, SourceCode* source_code )
 {
+    context->source_code = source_code;
     symbol_table_initialize( &context->symbol_table );
     context->return_type_stack = lvec_new( Type );
+    context->function_stack = lvec_new( Expression* );
+    context->module_name = NULL;
+    context->module_interface_path = NULL;
+    context->imported_module_names = lvec_new( char* );
+    context->imported_interface_paths = lvec_new( char* );
 
     Type* void_definition = malloc( sizeof( Type ) );
     *void_definition = ( Type ){
@@ -74,14 +65,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    void_type = ( Type ){
+    context->void_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = void_info,
     };
 
     Symbol void_symbol = {
         .token = { .as_string = "void" },
-        .type = void_type,
+        .type = context->void_type,
     };
 
     Type* char_definition = malloc( sizeof( Type ) );
@@ -100,14 +91,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    char_type = ( Type ){
+    context->char_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = char_info,
     };
 
     Symbol char_symbol = {
         .token = { .as_string = "char" },
-        .type = char_type,
+        .type = context->char_type,
     };
 
     Type* bool_definition = malloc( sizeof( Type ) );
@@ -126,14 +117,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    bool_type = ( Type ){
+    context->bool_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = bool_info,
     };
 
     Symbol bool_symbol = {
         .token = { .as_string = "bool" },
-        .type = bool_type,
+        .type = context->bool_type,
     };
 
     Symbol true_symbol = {
@@ -180,14 +171,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    i8_type = ( Type ){
+    context->i8_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = i8_info,
     };
 
     Symbol i8_symbol = {
         .token = { .as_string = "i8" },
-        .type = i8_type,
+        .type = context->i8_type,
     };
 
     Type* i16_definition = malloc( sizeof( Type ) );
@@ -210,7 +201,7 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    i16_type = ( Type ){
+    context->i16_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = i16_info,
     };
@@ -243,14 +234,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    i32_type = ( Type ){
+    context->i32_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = i32_info,
     };
 
     Symbol i32_symbol = {
         .token = { .as_string = "i32" },
-        .type = i32_type,
+        .type = context->i32_type,
     };
 
     Type* i64_definition = malloc( sizeof( Type ) );
@@ -273,14 +264,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    i64_type = ( Type ){
+    context->i64_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = i64_info,
     };
 
     Symbol i64_symbol = {
         .token = { .as_string = "i64" },
-        .type = i64_type,
+        .type = context->i64_type,
     };
 
     Type* u8_definition = malloc( sizeof( Type ) );
@@ -303,14 +294,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    u8_type = ( Type ){
+    context->u8_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = u8_info,
     };
 
     Symbol u8_symbol = {
         .token = { .as_string = "u8" },
-        .type = u8_type,
+        .type = context->u8_type,
     };
 
     Type* u16_definition = malloc( sizeof( Type ) );
@@ -333,14 +324,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    u16_type = ( Type ){
+    context->u16_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = u16_info,
     };
 
     Symbol u16_symbol = {
         .token = { .as_string = "u16" },
-        .type = u16_type,
+        .type = context->u16_type,
     };
 
     Type* u32_definition = malloc( sizeof( Type ) );
@@ -363,14 +354,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    u32_type = ( Type ){
+    context->u32_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = u32_info,
     };
 
     Symbol u32_symbol = {
         .token = { .as_string = "u32" },
-        .type = u32_type,
+        .type = context->u32_type,
     };
 
     Type* u64_definition = malloc( sizeof( Type ) );
@@ -393,14 +384,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    u64_type = ( Type ){
+    context->u64_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = u64_info,
     };
 
     Symbol u64_symbol = {
         .token = { .as_string = "u64" },
-        .type = u64_type,
+        .type = context->u64_type,
     };
 
     Type* f32_definition = malloc( sizeof( Type ) );
@@ -420,14 +411,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    f32_type = ( Type ){
+    context->f32_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = f32_info,
     };
 
     Symbol f32_symbol = {
         .token = { .as_string = "f32" },
-        .type = f32_type,
+        .type = context->f32_type,
     };
 
     Type* f64_definition = malloc( sizeof( Type ) );
@@ -447,14 +438,14 @@ void semantic_context_initialize( SemanticContext* context )
         }
     };
 
-    f64_type = ( Type ){
+    context->f64_type = ( Type ){
         .kind = TYPEKIND_TYPE,
         .type.info = f64_info,
     };
 
     Symbol f64_symbol = {
         .token = { .as_string = "f64" },
-        .type = f64_type,
+        .type = context->f64_type,
     };
 
     symbol_table_push_symbol( &context->symbol_table, void_symbol );
@@ -705,6 +696,11 @@ void add_pointer_type( Type base_type )
     lvec_append_aggregate( named_type.named.pointer_types, base_type );
 }
 
+static bool is_void( Type type )
+{
+    return type.kind == TYPEKIND_NAMED && type.named.definition->kind == TYPEKIND_VOID;
+}
+
 static bool implicit_cast_possible( Type to, Type from )
 {
     if( type_equals( to, from ) )
@@ -759,8 +755,7 @@ static bool implicit_cast_possible( Type to, Type from )
             // &T -> &void is allowed
             // &void -> &T is allowed
             // &T -> &U where T, U != void is not allowed
-            if( type_equals( *to.pointer.base_type, *void_type.type.info ) ||
-                type_equals( *from.pointer.base_type, *void_type.type.info ) )
+            if( is_void( *to.pointer.base_type ) || is_void( *from.pointer.base_type ) )
             {
                 return true;
             }
@@ -843,6 +838,17 @@ static bool check_binary( SemanticContext* context, Expression* expression, Type
         return false;
     }
 
+    // iterators are references, it is their values that are operated on
+    if( left_type.kind == TYPEKIND_REFERENCE )
+    {
+        left_type = *left_type.reference.base_type;
+    }
+
+    if( right_type.kind == TYPEKIND_REFERENCE )
+    {
+        right_type = *right_type.reference.base_type;
+    }
+
     Type left_type_definition = left_type;
     if( left_type.kind == TYPEKIND_NAMED )
     {
@@ -881,7 +887,7 @@ static bool check_binary( SemanticContext* context, Expression* expression, Type
                 .right_type = right_type,
             }
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -927,7 +933,7 @@ static bool check_binary( SemanticContext* context, Expression* expression, Type
 
             if( operation >= BINARYOPERATION_BOOLEAN_START && operation < BINARYOPERATION_BOOLEAN_END )
             {
-                *inferred_type = *bool_type.type.info;
+                *inferred_type = *context->bool_type.type.info;
             }
             else if( left_type.kind == TYPEKIND_NUMERICLITERAL || right_type.kind == TYPEKIND_NUMERICLITERAL )
             {
@@ -1001,7 +1007,7 @@ static bool check_binary( SemanticContext* context, Expression* expression, Type
                 break;
             }
 
-            *inferred_type = *bool_type.type.info;
+            *inferred_type = *context->bool_type.type.info;
 
             is_valid = true;
             break;
@@ -1011,7 +1017,7 @@ static bool check_binary( SemanticContext* context, Expression* expression, Type
         case BINARYOPERATION_EQUAL:
         case BINARYOPERATION_NOTEQUAL:
         {
-            *inferred_type = *bool_type.type.info;
+            *inferred_type = *context->bool_type.type.info;
             is_valid = true;
             break;
         }
@@ -1028,7 +1034,7 @@ static bool check_binary( SemanticContext* context, Expression* expression, Type
                 .right_type = right_type,
             }
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1048,7 +1054,7 @@ static bool check_rvalue_identifier( SemanticContext* context, Expression* expre
             .offending_token = identifier_token,
         };
 
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1058,7 +1064,7 @@ static bool check_rvalue_identifier( SemanticContext* context, Expression* expre
             .kind = ERRORKIND_CANNOTUSETYPEASVALUE,
             .offending_token = identifier_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1079,7 +1085,7 @@ static bool check_function_call( SemanticContext* context, Expression* expressio
             .offending_token = identifier_token,
         };
 
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1109,17 +1115,19 @@ static bool check_function_call( SemanticContext* context, Expression* expressio
                 .found = arg_count,
             },
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
     // check if args are valid
     for( int i = 0; i < arg_count; i++ )
     {
-        Expression arg_rvalue = expression->function_call.args[ i ];
+        // checked in place so that annotations made during semantic analysis
+        // are kept for later passes
+        Expression* arg_rvalue = &expression->function_call.args[ i ];
         Type arg_type;
 
-        bool is_arg_valid = check_rvalue( context, &arg_rvalue, &arg_type );
+        bool is_arg_valid = check_rvalue( context, arg_rvalue, &arg_type );
         if( !is_arg_valid )
         {
             // no need to report error here because that is handled by check_rvalue
@@ -1133,13 +1141,13 @@ static bool check_function_call( SemanticContext* context, Expression* expressio
             {
                 Error error = {
                     .kind = ERRORKIND_TYPEMISMATCH,
-                    .offending_token = arg_rvalue.starting_token,
+                    .offending_token = arg_rvalue->starting_token,
                     .type_mismatch = {
                         .expected = param_type,
                         .found = arg_type,
                     }
                 };
-                report_error( error );
+                report_error( context->source_code, error );
                 return false;
             }
         }
@@ -1164,6 +1172,12 @@ static bool check_unary( SemanticContext* context, Expression* expression, Type*
         return false;
     }
 
+    // iterators are references, it is their values that are operated on
+    if( operand_type.kind == TYPEKIND_REFERENCE )
+    {
+        operand_type = *operand_type.reference.base_type;
+    }
+
     switch( operation )
     {
         case UNARYOPERATION_NEGATIVE:
@@ -1172,8 +1186,8 @@ static bool check_unary( SemanticContext* context, Expression* expression, Type*
             //       The result of negating a literal must be signed but its
             //       bit count must not be specified
 
-            if( !implicit_cast_possible( *i64_type.type.info, operand_type ) &&
-                !implicit_cast_possible( *f64_type.type.info, operand_type ) )
+            if( !implicit_cast_possible( *context->i64_type.type.info, operand_type ) &&
+                !implicit_cast_possible( *context->f64_type.type.info, operand_type ) )
             {
                 Error error = {
                     .kind = ERRORKIND_INVALIDUNARYOPERATION,
@@ -1182,7 +1196,7 @@ static bool check_unary( SemanticContext* context, Expression* expression, Type*
                         .operand_type = operand_type
                     }
                 };
-                report_error( error );
+                report_error( context->source_code, error );
                 return false;
             }
 
@@ -1192,7 +1206,7 @@ static bool check_unary( SemanticContext* context, Expression* expression, Type*
 
         case UNARYOPERATION_NOT:
         {
-            if( !implicit_cast_possible( *bool_type.type.info, operand_type ) )
+            if( !implicit_cast_possible( *context->bool_type.type.info, operand_type ) )
             {
                 Error error = {
                     .kind = ERRORKIND_INVALIDUNARYOPERATION,
@@ -1201,7 +1215,7 @@ static bool check_unary( SemanticContext* context, Expression* expression, Type*
                         .operand_type = operand_type
                     }
                 };
-                report_error( error );
+                report_error( context->source_code, error );
                 return false;
             }
 
@@ -1217,10 +1231,15 @@ static bool check_unary( SemanticContext* context, Expression* expression, Type*
                     .kind = ERRORKIND_INVALIDADDRESSOF,
                     .offending_token = expression->unary.operand->starting_token
                 };
-                report_error( error );
+                report_error( context->source_code, error );
                 return false;
             }
 
+            if( operand_type.kind == TYPEKIND_REFERENCE )
+            {
+                operand_type = *operand_type.reference.base_type;
+            }
+
             Type* base_type = malloc( sizeof( Type ) );
             *base_type = operand_type;
             Type pointer_type = {
@@ -1241,18 +1260,18 @@ static bool check_unary( SemanticContext* context, Expression* expression, Type*
                     .kind = ERRORKIND_NONPOINTERDEREFERENCE,
                     .offending_token = expression->unary.operand->starting_token
                 };
-                report_error( error );
+                report_error( context->source_code, error );
                 return false;
             }
 
             Type base_type = *operand_type.pointer.base_type;
-            if( type_equals( base_type, *void_type.type.info ) )
+            if( type_equals( base_type, *context->void_type.type.info ) )
             {
                 Error error = {
                     .kind = ERRORKIND_VOIDPOINTERDEREFERENCE,
                     .offending_token = expression->unary.operand->starting_token
                 };
-                report_error( error );
+                report_error( context->source_code, error );
                 return false;
 
             }
@@ -1286,7 +1305,7 @@ static bool check_array_literal( SemanticContext* context, Expression* expressio
             .kind = ERRORKIND_ZEROLENGTHARRAY,
             .offending_token = expression->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1304,7 +1323,7 @@ static bool check_array_literal( SemanticContext* context, Expression* expressio
                 .found = count_initialized,
             },
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
     array_type.array.length = found_length;
@@ -1329,7 +1348,7 @@ static bool check_array_literal( SemanticContext* context, Expression* expressio
                     .found = element_type,
                 },
             };
-            report_error( error );
+            report_error( context->source_code, error );
             are_initializers_valid = false;
         }
     }
@@ -1363,7 +1382,7 @@ static bool check_array_subscript( SemanticContext* context, Expression* express
             .kind = ERRORKIND_NOTANARRAY,
             .offending_token = lvalue->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1374,7 +1393,7 @@ static bool check_array_subscript( SemanticContext* context, Expression* express
         return false;
     }
 
-    Type expected_index_type = *u64_type.type.info;
+    Type expected_index_type = *context->u64_type.type.info;
     if( !implicit_cast_possible( expected_index_type, index_rvalue_type ) )
     {
         Error error = {
@@ -1385,11 +1404,12 @@ static bool check_array_subscript( SemanticContext* context, Expression* express
                 .found = index_rvalue_type,
             },
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
     expression->array_subscript.element_type = *lvalue_type.array.base_type;
+    expression->array_subscript.array_length = lvalue_type.array.length;
 
     *out_type = *lvalue_type.array.base_type;
     return true;
@@ -1420,7 +1440,7 @@ static bool check_member_access( SemanticContext* context, Expression* expressio
             .kind = ERRORKIND_NOTCOMPOUND,
             .offending_token = lvalue->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1433,7 +1453,7 @@ static bool check_member_access( SemanticContext* context, Expression* expressio
             .offending_token = member_identifier_token,
             .missing_member.parent_type = lvalue_type,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1456,7 +1476,7 @@ static bool check_compound_literal( SemanticContext* context, Expression* expres
             .kind = ERRORKIND_UNDECLAREDSYMBOL,
             .offending_token = type_identifier_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1467,7 +1487,7 @@ static bool check_compound_literal( SemanticContext* context, Expression* expres
             .kind = ERRORKIND_INVALIDCOMPOUNDLITERAL,
             .offending_token = type_identifier_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1485,7 +1505,7 @@ static bool check_compound_literal( SemanticContext* context, Expression* expres
             .kind = ERRORKIND_UNINITIALIZEDMEMBER,
             .offending_token = expression->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
     // unions must only have one member initialized
@@ -1496,7 +1516,7 @@ static bool check_compound_literal( SemanticContext* context, Expression* expres
             .kind = ERRORKIND_MULTIPLEMEMBERINITIALIZEDUNION,
             .offending_token = expression->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1513,13 +1533,13 @@ static bool check_compound_literal( SemanticContext* context, Expression* expres
                 .offending_token = member_identifier_token,
                 .missing_member.parent_type = type_info
             };
-            report_error( error );
+            report_error( context->source_code, error );
             return false;
         }
 
-        Expression initializer_rvalue = initialized_member_rvalues[ i ];
+        Expression* initializer_rvalue = &initialized_member_rvalues[ i ];
         Type initializer_type;
-        if( !check_rvalue( context, &initializer_rvalue, &initializer_type ) )
+        if( !check_rvalue( context, initializer_rvalue, &initializer_type ) )
         {
             return false;
         }
@@ -1529,13 +1549,13 @@ static bool check_compound_literal( SemanticContext* context, Expression* expres
         {
             Error error = {
                 .kind = ERRORKIND_TYPEMISMATCH,
-                .offending_token = initializer_rvalue.starting_token,
+                .offending_token = initializer_rvalue->starting_token,
                 .type_mismatch = {
                     .expected = member_type,
                     .found = initializer_type
                 }
             };
-            report_error( error );
+            report_error( context->source_code, error );
             return false;
         }
     }
@@ -1554,20 +1574,20 @@ static bool check_rvalue( SemanticContext* context, Expression* expression, Type
     {
         case EXPRESSIONKIND_CHARACTER:
         {
-            *inferred_type = *char_type.type.info;
+            *inferred_type = *context->char_type.type.info;
             break;
         }
 
         case EXPRESSIONKIND_BOOLEAN:
         {
-            *inferred_type = *bool_type.type.info;
+            *inferred_type = *context->bool_type.type.info;
             break;
         }
 
         case EXPRESSIONKIND_STRING:
         {
             inferred_type->kind = TYPEKIND_POINTER;
-            inferred_type->pointer.base_type = char_type.type.info;
+            inferred_type->pointer.base_type = context->char_type.type.info;
             break;
         }
 
@@ -1705,7 +1725,7 @@ static bool check_variable_declaration( SemanticContext* context, Expression* ex
             .offending_token = identifier_token,
             .symbol_redeclaration.original_declaration_token = original_declaration->token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1726,7 +1746,7 @@ static bool check_variable_declaration( SemanticContext* context, Expression* ex
                 .kind = ERRORKIND_NOTATYPE,
                 .offending_token = type_rvalue->starting_token
             };
-            report_error( error );
+            report_error( context->source_code, error );
             return false;
         }
 
@@ -1738,7 +1758,7 @@ static bool check_variable_declaration( SemanticContext* context, Expression* ex
         /*         .kind = ERRORKIND_INVALIDANONYMOUSTYPE, */
         /*         .offending_token = type_rvalue->starting_token */
         /*     }; */
-        /*     report_error( error ); */
+        /*     report_error( context->source_code, error ); */
         /*     return false; */
         /* } */
 
@@ -1752,7 +1772,7 @@ static bool check_variable_declaration( SemanticContext* context, Expression* ex
             .kind = ERRORKIND_VOIDVARIABLE,
             .offending_token = type_rvalue->starting_token
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1780,8 +1800,8 @@ static bool check_variable_declaration( SemanticContext* context, Expression* ex
             {
                 switch( inferred_type.literal.kind )
                 {
-                    case TYPEKIND_INTEGER: variable_type = *i32_type.type.info; break;
-                    case TYPEKIND_FLOAT:   variable_type = *f32_type.type.info; break;
+                    case TYPEKIND_INTEGER: variable_type = *context->i32_type.type.info; break;
+                    case TYPEKIND_FLOAT:   variable_type = *context->f32_type.type.info; break;
                     default: UNREACHABLE();
                 }
             }
@@ -1802,7 +1822,7 @@ static bool check_variable_declaration( SemanticContext* context, Expression* ex
                         .from = inferred_type,
                     }
                 };
-                report_error( error );
+                report_error( context->source_code, error );
                 return false;
             }
 
@@ -1829,7 +1849,7 @@ static bool check_variable_declaration( SemanticContext* context, Expression* ex
                 .kind = ERRORKIND_CANNOTINFERARRAYLENGTH,
                 .offending_token = type_rvalue->starting_token,
             };
-            report_error( error );
+            report_error( context->source_code, error );
             return false;
         }
     }
@@ -1873,6 +1893,335 @@ static bool check_compound( SemanticContext* context, Expression* expression )
     return is_valid;
 }
 
+// what a function attribute needs of the function's return type
+typedef enum AttributeReturn
+{
+    ATTRIBUTERETURN_ANY,
+    ATTRIBUTERETURN_VOID,
+    ATTRIBUTERETURN_VALUE,
+} AttributeReturn;
+
+// finds anything that could point into the frame of a function, which a tail
+// call would reuse while it is still pointed to
+static void find_frame_references( Expression* expression, void* data )
+{
+    bool* has_frame_references = data;
+
+    switch( expression->kind )
+    {
+        // array literals and declarations can be placed on the stack later
+        case EXPRESSIONKIND_ARRAYLITERAL:
+        {
+            *has_frame_references = true;
+            return;
+        }
+
+        case EXPRESSIONKIND_VARIABLEDECLARATION:
+        {
+            if( expression->variable_declaration.variable_type.kind == TYPEKIND_ARRAY )
+            {
+                *has_frame_references = true;
+                return;
+            }
+            break;
+        }
+
+        case EXPRESSIONKIND_UNARY:
+        {
+            if( expression->unary.operation == UNARYOPERATION_ADDRESSOF )
+            {
+                *has_frame_references = true;
+                return;
+            }
+            break;
+        }
+
+        // nested functions have their own frames
+        case EXPRESSIONKIND_FUNCTIONDECLARATION:
+        {
+            return;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    expression_visit_children( expression, find_frame_references, data );
+}
+
+static void collect_tail_calls( Expression* expression, void* data )
+{
+    Expression*** tail_calls = data;
+
+    if( expression->kind == EXPRESSIONKIND_FUNCTIONDECLARATION )
+    {
+        return;
+    }
+
+    if( expression->kind == EXPRESSIONKIND_RETURN && expression->return_expression.tail_call != TAILCALL_NONE )
+    {
+        lvec_append( *tail_calls, expression );
+    }
+
+    expression_visit_children( expression, collect_tail_calls, data );
+}
+
+static void decide_tail_calls( Expression* function )
+{
+    Expression* body = function->function_declaration.body;
+
+    Expression** tail_calls = lvec_new( Expression* );
+    expression_visit_children( body, collect_tail_calls, &tail_calls );
+
+    bool has_frame_references = false;
+    expression_visit_children( body, find_frame_references, &has_frame_references );
+
+    size_t tail_call_count = lvec_get_length( tail_calls );
+    for( size_t i = 0; i < tail_call_count; i++ )
+    {
+        if( has_frame_references )
+        {
+            tail_calls[ i ]->return_expression.tail_call = TAILCALL_NONE;
+        }
+        else if( tail_calls[ i ]->return_expression.tail_call == TAILCALL_SELF )
+        {
+            function->function_declaration.has_self_tail_call = true;
+        }
+    }
+
+    lvec_free( tail_calls );
+}
+
+typedef struct FunctionAttributeInfo
+{
+    char* identifier;
+    FunctionAttribute flag;
+    int conflicting_flags;
+    bool needs_body;
+    AttributeReturn needed_return;
+} FunctionAttributeInfo;
+
+static FunctionAttributeInfo function_attribute_infos[] = {
+    { "inline",    FUNCTIONATTRIBUTE_INLINE,   FUNCTIONATTRIBUTE_NOINLINE,                       true,  ATTRIBUTERETURN_ANY   },
+    { "noinline",  FUNCTIONATTRIBUTE_NOINLINE, FUNCTIONATTRIBUTE_INLINE,                         false, ATTRIBUTERETURN_ANY   },
+    { "hot",       FUNCTIONATTRIBUTE_HOT,      FUNCTIONATTRIBUTE_COLD,                           false, ATTRIBUTERETURN_ANY   },
+    { "cold",      FUNCTIONATTRIBUTE_COLD,     FUNCTIONATTRIBUTE_HOT,                            false, ATTRIBUTERETURN_ANY   },
+    { "flatten",   FUNCTIONATTRIBUTE_FLATTEN,  0,                                                true,  ATTRIBUTERETURN_ANY   },
+    { "pure",      FUNCTIONATTRIBUTE_PURE,     FUNCTIONATTRIBUTE_NORETURN,                       false, ATTRIBUTERETURN_VALUE },
+    { "const",     FUNCTIONATTRIBUTE_CONST,    FUNCTIONATTRIBUTE_NORETURN,                       false, ATTRIBUTERETURN_VALUE },
+    { "fast_math", FUNCTIONATTRIBUTE_FASTMATH, 0,                                                true,  ATTRIBUTERETURN_ANY   },
+    { "noreturn",  FUNCTIONATTRIBUTE_NORETURN, FUNCTIONATTRIBUTE_PURE | FUNCTIONATTRIBUTE_CONST, false, ATTRIBUTERETURN_VOID  },
+};
+
+static FunctionAttributeInfo* find_function_attribute_info( char* identifier )
+{
+    for( size_t i = 0; i < sizeof( function_attribute_infos ) / sizeof( function_attribute_infos[ 0 ] ); i++ )
+    {
+        if( strcmp( function_attribute_infos[ i ].identifier, identifier ) == 0 )
+        {
+            return &function_attribute_infos[ i ];
+        }
+    }
+
+    return NULL;
+}
+
+static void report_invalid_attribute( SemanticContext* context, Attribute attribute, const char* reason )
+{
+    Error error = {
+        .kind = ERRORKIND_INVALIDATTRIBUTE,
+        .offending_token = attribute.identifier_token,
+        .invalid_attribute.reason = reason,
+    };
+    report_error( context->source_code, error );
+}
+
+typedef struct LoopAttributeInfo
+{
+    char* identifier;
+    LoopAttribute flag;
+    int conflicting_flags;
+    bool takes_argument;
+    bool needs_for_loop;
+} LoopAttributeInfo;
+
+// gcc cannot combine `#pragma omp simd` with its own loop pragmas
+static LoopAttributeInfo loop_attribute_infos[] = {
+    { "unroll",       LOOPATTRIBUTE_UNROLL,      LOOPATTRIBUTE_VECTORIZE,                                                   true,  false },
+    { "vectorize",    LOOPATTRIBUTE_VECTORIZE,   LOOPATTRIBUTE_NOVECTORIZE | LOOPATTRIBUTE_UNROLL | LOOPATTRIBUTE_IVDEP,    false, true  },
+    { "no_vectorize", LOOPATTRIBUTE_NOVECTORIZE, LOOPATTRIBUTE_VECTORIZE,                                                   false, false },
+    { "ivdep",        LOOPATTRIBUTE_IVDEP,       LOOPATTRIBUTE_VECTORIZE,                                                   false, false },
+};
+
+static LoopAttributeInfo* find_loop_attribute_info( char* identifier )
+{
+    for( size_t i = 0; i < sizeof( loop_attribute_infos ) / sizeof( loop_attribute_infos[ 0 ] ); i++ )
+    {
+        if( strcmp( loop_attribute_infos[ i ].identifier, identifier ) == 0 )
+        {
+            return &loop_attribute_infos[ i ];
+        }
+    }
+
+    return NULL;
+}
+
+// the largest unroll count gcc accepts
+#define MAX_UNROLL_COUNT 65534
+
+static bool check_loop_attributes( SemanticContext* context, Expression* expression, bool is_for_loop, LoopAttributes* out_loop_attributes )
+{
+    *out_loop_attributes = ( LoopAttributes ){ 0 };
+
+    Attribute* attributes = expression->attributes;
+    if( attributes == NULL )
+    {
+        return true;
+    }
+
+    size_t attribute_count = lvec_get_length( attributes );
+    for( size_t i = 0; i < attribute_count; i++ )
+    {
+        Attribute attribute = attributes[ i ];
+        LoopAttributeInfo* info = find_loop_attribute_info( attribute.identifier_token.as_string );
+        if( info == NULL )
+        {
+            Error error = {
+                .kind = ERRORKIND_UNKNOWNATTRIBUTE,
+                .offending_token = attribute.identifier_token,
+            };
+            report_error( context->source_code, error );
+            return false;
+        }
+
+        if( info->takes_argument )
+        {
+            if( attribute.argument == NULL ||
+                attribute.argument->kind != EXPRESSIONKIND_INTEGER ||
+                attribute.argument->integer > MAX_UNROLL_COUNT )
+            {
+                report_invalid_attribute( context, attribute, "needs an integer from 0 to 65534" );
+                return false;
+            }
+
+            out_loop_attributes->unroll_count = ( int )attribute.argument->integer;
+        }
+        else if( attribute.argument != NULL )
+        {
+            report_invalid_attribute( context, attribute, "does not take an argument" );
+            return false;
+        }
+
+        if( info->needs_for_loop && !is_for_loop )
+        {
+            report_invalid_attribute( context, attribute, "can only be used on for loops" );
+            return false;
+        }
+
+        if( out_loop_attributes->flags & info->conflicting_flags )
+        {
+            for( size_t j = 0; j < i; j++ )
+            {
+                LoopAttributeInfo* other_info = find_loop_attribute_info( attributes[ j ].identifier_token.as_string );
+                if( other_info->flag & info->conflicting_flags )
+                {
+                    Error error = {
+                        .kind = ERRORKIND_CONFLICTINGATTRIBUTES,
+                        .offending_token = attribute.identifier_token,
+                        .conflicting_attributes.other_attribute_token = attributes[ j ].identifier_token,
+                    };
+                    report_error( context->source_code, error );
+                    return false;
+                }
+            }
+        }
+
+        out_loop_attributes->flags |= info->flag;
+    }
+
+    return true;
+}
+
+// must be called after the return type is known
+static bool check_function_attributes( SemanticContext* context, Expression* expression, bool is_extern )
+{
+    Attribute* attributes = expression->attributes;
+    if( attributes == NULL )
+    {
+        return true;
+    }
+
+    Type return_type = expression->function_declaration.return_type;
+    bool returns_void = return_type.kind == TYPEKIND_NAMED && return_type.named.definition->kind == TYPEKIND_VOID;
+
+    int flags = 0;
+    size_t attribute_count = lvec_get_length( attributes );
+    for( size_t i = 0; i < attribute_count; i++ )
+    {
+        Attribute attribute = attributes[ i ];
+        FunctionAttributeInfo* info = find_function_attribute_info( attribute.identifier_token.as_string );
+        if( info == NULL )
+        {
+            Error error = {
+                .kind = ERRORKIND_UNKNOWNATTRIBUTE,
+                .offending_token = attribute.identifier_token,
+            };
+            report_error( context->source_code, error );
+            return false;
+        }
+
+        if( attribute.argument != NULL )
+        {
+            report_invalid_attribute( context, attribute, "does not take an argument" );
+            return false;
+        }
+
+        if( info->needs_body && is_extern )
+        {
+            report_invalid_attribute( context, attribute, "needs a function with a body" );
+            return false;
+        }
+
+        if( info->needed_return == ATTRIBUTERETURN_VOID && !returns_void )
+        {
+            report_invalid_attribute( context, attribute, "needs a function that returns void" );
+            return false;
+        }
+
+        if( info->needed_return == ATTRIBUTERETURN_VALUE && returns_void )
+        {
+            report_invalid_attribute( context, attribute, "needs a function that returns a value" );
+            return false;
+        }
+
+        if( flags & info->conflicting_flags )
+        {
+            // find the earlier attribute it conflicts with
+            for( size_t j = 0; j < i; j++ )
+            {
+                FunctionAttributeInfo* other_info = find_function_attribute_info( attributes[ j ].identifier_token.as_string );
+                if( other_info->flag & info->conflicting_flags )
+                {
+                    Error error = {
+                        .kind = ERRORKIND_CONFLICTINGATTRIBUTES,
+                        .offending_token = attribute.identifier_token,
+                        .conflicting_attributes.other_attribute_token = attributes[ j ].identifier_token,
+                    };
+                    report_error( context->source_code, error );
+                    return false;
+                }
+            }
+        }
+
+        flags |= info->flag;
+    }
+
+    expression->function_declaration.attributes = flags;
+    return true;
+}
+
 static bool check_function_declaration( SemanticContext* context,Expression* expression, bool is_extern )
 {
     Token identifier_token = expression->function_declaration.identifier_token;
@@ -1886,7 +2235,7 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
             .offending_token = identifier_token,
             .symbol_redeclaration.original_declaration_token = original_declaration->token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1903,7 +2252,7 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
             .kind = ERRORKIND_NOTATYPE,
             .offending_token = return_type_rvalue->starting_token
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -1915,13 +2264,18 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
     /*         .kind = ERRORKIND_INVALIDANONYMOUSTYPE, */
     /*         .offending_token = return_type_rvalue->starting_token */
     /*     }; */
-    /*     report_error( error ); */
+    /*     report_error( context->source_code, error ); */
     /*     return false; */
     /* } */
 
     *return_type = *return_type->type.info;
     expression->function_declaration.return_type = *return_type;
 
+    if( !check_function_attributes( context, expression, is_extern ) )
+    {
+        return false;
+    }
+
     Token* param_identifiers_tokens = expression->function_declaration.param_identifiers_tokens;
     Expression* param_type_rvalues = expression->function_declaration.param_type_rvalues;
     int param_count = expression->function_declaration.param_count;
@@ -1944,7 +2298,7 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
                 .kind = ERRORKIND_NOTATYPE,
                 .offending_token = param_type_rvalue.starting_token
             };
-            report_error( error );
+            report_error( context->source_code, error );
             return false;
         }
 
@@ -1956,7 +2310,7 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
         /*         .kind = ERRORKIND_INVALIDANONYMOUSTYPE, */
         /*         .offending_token = param_type_rvalue.starting_token */
         /*     }; */
-        /*     report_error( error ); */
+        /*     report_error( context->source_code, error ); */
         /*     return false; */
         /* } */
 
@@ -1973,7 +2327,7 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
                 .offending_token = param_identifier_token,
                 .symbol_redeclaration.original_declaration_token = lookup_result->token,
             };
-            report_error( error );
+            report_error( context->source_code, error );
             return false;
         }
         else if( strcmp( param_identifier_token.as_string, identifier_token.as_string ) == 0 )
@@ -1983,7 +2337,7 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
                 .offending_token = param_identifier_token,
                 .symbol_redeclaration.original_declaration_token = identifier_token,
             };
-            report_error( error );
+            report_error( context->source_code, error );
             return false;
         }
     }
@@ -2026,7 +2380,7 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
             .kind = ERRORKIND_MISSINGFUNCTIONBODY,
             .offending_token = expression->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
     else if( body != NULL && is_extern )
@@ -2035,14 +2389,16 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
             .kind = ERRORKIND_EXTERNWITHBODY,
             .offending_token = expression->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
     bool is_body_valid = true;
     if( !is_extern )
     {
+        lvec_append( context->function_stack, expression );
         is_body_valid = check_compound( context, body );
+        lvec_remove_last( context->function_stack );
     }
 
     symbol_table_pop_scope( &context->symbol_table );
@@ -2053,9 +2409,61 @@ static bool check_function_declaration( SemanticContext* context,Expression* exp
         return false;
     }
 
+    if( !is_extern )
+    {
+        decide_tail_calls( expression );
+    }
+
     return true;
 }
 
+static TailCall classify_tail_call( SemanticContext* context, Expression* function_call )
+{
+    size_t function_count = lvec_get_length( context->function_stack );
+    if( function_count == 0 )
+    {
+        return TAILCALL_NONE;
+    }
+
+    Expression* function = context->function_stack[ function_count - 1 ];
+    if( function->function_declaration.is_variadic )
+    {
+        return TAILCALL_NONE;
+    }
+
+    char* identifier = function_call->function_call.identifier_token.as_string;
+    if( strcmp( identifier, function->function_declaration.identifier_token.as_string ) == 0 )
+    {
+        return TAILCALL_SELF;
+    }
+
+    // a real tail call needs the callee to take and return exactly what the
+    // caller does, so that the caller's frame can be handed over
+    Symbol* callee = symbol_table_lookup( context->symbol_table, identifier );
+    if( callee == NULL || callee->type.kind != TYPEKIND_FUNCTION )
+    {
+        return TAILCALL_NONE;
+    }
+
+    int param_count = function->function_declaration.param_count;
+    if( callee->type.function.is_variadic ||
+        callee->type.function.param_count != param_count ||
+        !type_equals( *callee->type.function.return_type, function->function_declaration.return_type ) )
+    {
+        return TAILCALL_NONE;
+    }
+
+    for( int i = 0; i < param_count; i++ )
+    {
+        if( !type_equals( callee->type.function.param_types[ i ], function->function_declaration.param_types[ i ] ) )
+        {
+            return TAILCALL_NONE;
+        }
+    }
+
+    return TAILCALL_OTHER;
+}
+
 bool check_return( SemanticContext* context, Expression* expression )
 {
     Type found_return_type = *symbol_table_lookup( context->symbol_table, "void" )->type.type.info;
@@ -2093,10 +2501,18 @@ bool check_return( SemanticContext* context, Expression* expression )
                 .found = found_return_type,
             },
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
+    // check_function_declaration() decides whether the tail call can be made
+    // once it has seen the whole function
+    Expression* rvalue = expression->return_expression.rvalue;
+    if( rvalue != NULL && rvalue->kind == EXPRESSIONKIND_FUNCTIONCALL )
+    {
+        expression->return_expression.tail_call = classify_tail_call( context, rvalue );
+    }
+
     return true;
 }
 
@@ -2158,7 +2574,7 @@ bool check_assignment( SemanticContext* context, Expression* expression )
         /*     .kind = ERRORKIND_INVALIDLVALUE, */
         /*     .offending_token = expression->starting_token, */
         /* }; */
-        /* report_error( error ); */
+        /* report_error( context->source_code, error ); */
         return false;
     }
 
@@ -2178,7 +2594,7 @@ bool check_assignment( SemanticContext* context, Expression* expression )
             .kind = ERRORKIND_CANNOTUSETYPEASVALUE,
             .offending_token = expression->assignment.rvalue->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2194,7 +2610,7 @@ bool check_assignment( SemanticContext* context, Expression* expression )
                 .found = found_rvalue_type,
             }
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2211,17 +2627,28 @@ static bool check_conditional( SemanticContext* context, Expression* expression
         return false;
     }
 
-    if( !implicit_cast_possible( *bool_type.type.info, condition_type ) )
+    if( !implicit_cast_possible( *context->bool_type.type.info, condition_type ) )
     {
         Error error = {
             .kind = ERRORKIND_TYPEMISMATCH,
             .offending_token = expression->conditional.condition->starting_token,
             .type_mismatch = {
-                .expected = *bool_type.type.info,
+                .expected = *context->bool_type.type.info,
                 .found = condition_type
             },
         };
-        report_error( error );
+        report_error( context->source_code, error );
+        return false;
+    }
+
+    if( expression->attributes != NULL && !expression->conditional.is_loop )
+    {
+        report_invalid_attribute( context, expression->attributes[ 0 ], "can only be used on functions and loops" );
+        return false;
+    }
+
+    if( !check_loop_attributes( context, expression, false, &expression->conditional.loop_attributes ) )
+    {
         return false;
     }
 
@@ -2233,7 +2660,7 @@ static bool check_conditional( SemanticContext* context, Expression* expression
             .kind = ERRORKIND_WHILEWITHELSE,
             .offending_token = expression->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2252,6 +2679,11 @@ static bool check_conditional( SemanticContext* context, Expression* expression
 
 static bool check_for_loop( SemanticContext* context, Expression* expression )
 {
+    if( !check_loop_attributes( context, expression, true, &expression->for_loop.loop_attributes ) )
+    {
+        return false;
+    }
+
     // no symbol redeclarations!
     Token iterator_token = expression->for_loop.iterator_token;
     Symbol* iterator_symbol = symbol_table_lookup( context->symbol_table, iterator_token.identifier );
@@ -2262,7 +2694,7 @@ static bool check_for_loop( SemanticContext* context, Expression* expression )
             .offending_token = iterator_token,
             .symbol_redeclaration.original_declaration_token = iterator_token
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2280,7 +2712,7 @@ static bool check_for_loop( SemanticContext* context, Expression* expression )
             .kind = ERRORKIND_NOTANITERATOR,
             .offending_token = iterable_rvalue->starting_token
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2346,7 +2778,7 @@ static bool check_compound_definition( SemanticContext* context, Expression* typ
                 .kind = ERRORKIND_VOIDVARIABLE,
                 .offending_token = member_type_rvalue.type_identifier.token,
             };
-            report_error( error );
+            report_error( context->source_code, error );
             return false;
         }
 
@@ -2360,7 +2792,7 @@ static bool check_compound_definition( SemanticContext* context, Expression* typ
                 .offending_token = member_identifier_token,
                 .symbol_redeclaration.original_declaration_token = lookup_result->token,
             };
-            report_error( error );
+            report_error( context->source_code, error );
             return false;
         }
 
@@ -2400,7 +2832,7 @@ static bool check_type_identifier( SemanticContext* context, Expression* express
             .kind = ERRORKIND_UNDECLAREDSYMBOL,
             .offending_token = identifier_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
     Type type = lookup_result->type;
@@ -2410,7 +2842,7 @@ static bool check_type_identifier( SemanticContext* context, Expression* express
             .kind = ERRORKIND_NOTATYPE,
             .offending_token = identifier_token
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2434,7 +2866,7 @@ static bool check_pointer_type( SemanticContext* context, Expression* type_rvalu
             .kind = ERRORKIND_NOTATYPE,
             .offending_token = base_type_rvalue->starting_token
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2445,7 +2877,7 @@ static bool check_pointer_type( SemanticContext* context, Expression* type_rvalu
     /*         .kind = ERRORKIND_INVALIDANONYMOUSTYPE, */
     /*         .offending_token = base_type_rvalue->starting_token */
     /*     }; */
-    /*     report_error( error ); */
+    /*     report_error( context->source_code, error ); */
     /*     return false; */
     /* } */
 
@@ -2481,7 +2913,7 @@ static bool check_array_type( SemanticContext* context, Expression* type_rvalue,
     /*         .kind = ERRORKIND_INVALIDANONYMOUSTYPE, */
     /*         .offending_token = base_type_rvalue->starting_token */
     /*     }; */
-    /*     report_error( error ); */
+    /*     report_error( context->source_code, error ); */
     /*     return false; */
     /* } */
     base_type_definition = base_type_definition->type.info;
@@ -2493,7 +2925,7 @@ static bool check_array_type( SemanticContext* context, Expression* type_rvalue,
             .kind = ERRORKIND_VOIDVARIABLE,
             .offending_token = type_rvalue->starting_token
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2505,7 +2937,7 @@ static bool check_array_type( SemanticContext* context, Expression* type_rvalue,
             .kind = ERRORKIND_ZEROLENGTHARRAY,
             .offending_token = type_rvalue->starting_token,
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2571,7 +3003,7 @@ static bool check_type_declaration( SemanticContext* context, Expression* expres
             .offending_token = identifier_token,
             .symbol_redeclaration.original_declaration_token = identifier_token
         };
-        report_error( error );
+        report_error( context->source_code, error );
         return false;
     }
 
@@ -2619,6 +3051,16 @@ bool check_semantics( SemanticContext* context, Expression* expression )
 {
     bool is_valid;
 
+    // the statements that take attributes check them themselves
+    if( expression->attributes != NULL &&
+        expression->kind != EXPRESSIONKIND_FUNCTIONDECLARATION &&
+        expression->kind != EXPRESSIONKIND_CONDITIONAL &&
+        expression->kind != EXPRESSIONKIND_FORLOOP )
+    {
+        report_invalid_attribute( context, expression->attributes[ 0 ], "can only be used on functions and loops" );
+        return false;
+    }
+
     switch( expression->kind )
     {
         case EXPRESSIONKIND_VARIABLEDECLARATION:
@@ -2681,6 +3123,19 @@ bool check_semantics( SemanticContext* context, Expression* expression )
             break;
         }
 
+        // the ones at the top level are resolved before the program is checked
+        case EXPRESSIONKIND_MODULE:
+        case EXPRESSIONKIND_IMPORT:
+        {
+            Error error = {
+                .kind = ERRORKIND_MODULENOTATTOPLEVEL,
+                .offending_token = expression->starting_token,
+            };
+            report_error( context->source_code, error );
+            is_valid = false;
+            break;
+        }
+
         default:
         {
             UNREACHABLE();
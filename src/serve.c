@@ -0,0 +1,529 @@
+// for struct ucred, F_DUPFD_CLOEXEC, O_CLOEXEC and fchdir
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "codebuffer.h"
+#include "debug.h"
+#include "serve.h"
+
+#if !defined( _WIN32 )
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define REQUEST_MAGIC 0x6f63746f // "octo"
+
+// anything longer is not a command line
+#define MAX_REQUEST_LENGTH ( 1 << 20 )
+
+// what a client of another version gets instead of an exit code
+#define EXIT_CODE_REFUSED INT32_MIN
+
+// how long a client may take to send its request before it is dropped, so
+// that one that stalls does not hold up the others
+#define REQUEST_TIMEOUT_SECONDS 10
+
+// sent with the stdout and stderr of the client attached, followed by the
+// working directory and the arguments, each terminated by a zero
+typedef struct RequestHeader
+{
+    uint32_t magic;
+    uint32_t argument_count;
+    uint64_t version;
+    uint64_t length;
+} RequestHeader;
+
+struct ServeRequest
+{
+    int listen_socket;
+    bool is_child;
+    bool is_detached;
+};
+
+static bool write_all( int file, const void* data, size_t length )
+{
+    const char* bytes = data;
+    while( length > 0 )
+    {
+        ssize_t written = write( file, bytes, length );
+        if( written < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        if( written <= 0 )
+        {
+            return false;
+        }
+
+        bytes += written;
+        length -= written;
+    }
+
+    return true;
+}
+
+static bool read_all( int file, void* data, size_t length )
+{
+    char* bytes = data;
+    while( length > 0 )
+    {
+        ssize_t was_read = read( file, bytes, length );
+        if( was_read < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        if( was_read <= 0 )
+        {
+            return false;
+        }
+
+        bytes += was_read;
+        length -= was_read;
+    }
+
+    return true;
+}
+
+static bool make_address( struct sockaddr_un* address, char* socket_path )
+{
+    if( strlen( socket_path ) >= sizeof( address->sun_path ) )
+    {
+        return false;
+    }
+
+    memset( address, 0, sizeof( *address ) );
+    address->sun_family = AF_UNIX;
+    strcpy( address->sun_path, socket_path );
+    return true;
+}
+
+// returns -1 if nothing listens on the socket
+static int connect_to( char* socket_path )
+{
+    struct sockaddr_un address;
+    if( !make_address( &address, socket_path ) )
+    {
+        return -1;
+    }
+
+    int connection = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( connection < 0 )
+    {
+        return -1;
+    }
+
+    if( connect( connection, ( struct sockaddr* )&address, sizeof( address ) ) != 0 )
+    {
+        close( connection );
+        return -1;
+    }
+
+    return connection;
+}
+
+// builds run with the permissions of the server, so only the user that
+// started it may request them
+static bool is_same_user( int connection )
+{
+#if defined( __linux__ )
+    struct ucred credentials;
+    socklen_t credentials_length = sizeof( credentials );
+    return getsockopt( connection, SOL_SOCKET, SO_PEERCRED, &credentials, &credentials_length ) == 0 &&
+           credentials.uid == getuid();
+#else
+    uid_t user_id;
+    gid_t group_id;
+    return getpeereid( connection, &user_id, &group_id ) == 0 && user_id == getuid();
+#endif
+}
+
+// a control message with room for the two descriptors, aligned like one
+typedef union OutputMessage
+{
+    char buffer[ CMSG_SPACE( 2 * sizeof( int ) ) ];
+    struct cmsghdr header;
+} OutputMessage;
+
+static bool send_header( int connection, RequestHeader* header )
+{
+    int outputs[ 2 ] = { STDOUT_FILENO, STDERR_FILENO };
+    OutputMessage control;
+    memset( &control, 0, sizeof( control ) );
+
+    struct iovec data = { .iov_base = header, .iov_len = sizeof( *header ) };
+    struct msghdr message = {
+        .msg_iov = &data,
+        .msg_iovlen = 1,
+        .msg_control = control.buffer,
+        .msg_controllen = sizeof( control.buffer ),
+    };
+
+    struct cmsghdr* outputs_message = CMSG_FIRSTHDR( &message );
+    outputs_message->cmsg_level = SOL_SOCKET;
+    outputs_message->cmsg_type = SCM_RIGHTS;
+    outputs_message->cmsg_len = CMSG_LEN( sizeof( outputs ) );
+    memcpy( CMSG_DATA( outputs_message ), outputs, sizeof( outputs ) );
+
+    return sendmsg( connection, &message, 0 ) == ( ssize_t )sizeof( *header );
+}
+
+// `out_outputs` gets the stdout and stderr of the client
+static bool receive_header( int connection, RequestHeader* header, int* out_outputs )
+{
+    OutputMessage control;
+    struct iovec data = { .iov_base = header, .iov_len = sizeof( *header ) };
+    struct msghdr message = {
+        .msg_iov = &data,
+        .msg_iovlen = 1,
+        .msg_control = control.buffer,
+        .msg_controllen = sizeof( control.buffer ),
+    };
+
+    ssize_t received = recvmsg( connection, &message, 0 );
+    if( received <= 0 )
+    {
+        return false;
+    }
+
+    struct cmsghdr* outputs_message = CMSG_FIRSTHDR( &message );
+    if( outputs_message == NULL || outputs_message->cmsg_type != SCM_RIGHTS ||
+        outputs_message->cmsg_len != CMSG_LEN( 2 * sizeof( int ) ) )
+    {
+        return false;
+    }
+    memcpy( out_outputs, CMSG_DATA( outputs_message ), 2 * sizeof( int ) );
+
+    // the header can arrive in pieces, the descriptors come with the first
+    bool is_complete = read_all( connection, ( char* )header + received, sizeof( *header ) - received );
+    if( !is_complete || header->magic != REQUEST_MAGIC || header->length > MAX_REQUEST_LENGTH )
+    {
+        close( out_outputs[ 0 ] );
+        close( out_outputs[ 1 ] );
+        return false;
+    }
+
+    return true;
+}
+
+// splits the working directory and the arguments of a request, returns null
+// if they do not match the header
+static char** parse_arguments( char* payload, RequestHeader* header, char** out_working_directory )
+{
+    // every string takes at least its terminator, which also bounds the
+    // allocation below by the length of the request
+    if( ( size_t )header->argument_count + 1 > header->length )
+    {
+        return NULL;
+    }
+
+    char* end = payload + header->length;
+    char** arguments = calloc( ( size_t )header->argument_count + 1, sizeof( char* ) );
+    if( arguments == NULL ) ALLOC_ERROR();
+
+    char* cursor = payload;
+    for( uint32_t i = 0; i <= header->argument_count; i++ )
+    {
+        char* terminator = memchr( cursor, '\0', end - cursor );
+        if( cursor >= end || terminator == NULL )
+        {
+            free( arguments );
+            return NULL;
+        }
+
+        if( i == 0 )
+        {
+            *out_working_directory = cursor;
+        }
+        else
+        {
+            arguments[ i - 1 ] = cursor;
+        }
+        cursor = terminator + 1;
+    }
+
+    return arguments;
+}
+
+// runs one request. returns false if the client is another version of octo,
+// then the server stops so that the new version can take over
+static bool handle_connection( int listen_socket, int connection, uint64_t version, ServeHandler handler,
+                               void* data )
+{
+    RequestHeader header;
+    int outputs[ 2 ];
+    if( !receive_header( connection, &header, outputs ) )
+    {
+        return true;
+    }
+
+    if( header.version != version )
+    {
+        int32_t refused = EXIT_CODE_REFUSED;
+        write_all( connection, &refused, sizeof( refused ) );
+        close( outputs[ 0 ] );
+        close( outputs[ 1 ] );
+        printf( "A different version of octo connected, stopping.\n" );
+        return false;
+    }
+
+    char* payload = malloc( header.length + 1 );
+    if( payload == NULL ) ALLOC_ERROR();
+    char* working_directory = NULL;
+    char** arguments = NULL;
+    if( read_all( connection, payload, header.length ) )
+    {
+        arguments = parse_arguments( payload, &header, &working_directory );
+    }
+
+    if( arguments == NULL )
+    {
+        close( outputs[ 0 ] );
+        close( outputs[ 1 ] );
+        free( payload );
+        return true;
+    }
+
+    // the request runs as if it was started by the client
+    fflush( stdout );
+    fflush( stderr );
+    int server_stdout = fcntl( STDOUT_FILENO, F_DUPFD_CLOEXEC, 0 );
+    int server_stderr = fcntl( STDERR_FILENO, F_DUPFD_CLOEXEC, 0 );
+    int server_directory = open( ".", O_RDONLY | O_CLOEXEC );
+    dup2( outputs[ 0 ], STDOUT_FILENO );
+    dup2( outputs[ 1 ], STDERR_FILENO );
+    close( outputs[ 0 ] );
+    close( outputs[ 1 ] );
+
+    ServeRequest request = { .listen_socket = listen_socket };
+    int32_t exit_code;
+    if( chdir( working_directory ) != 0 )
+    {
+        printf( "Could not change to '%s'.\n", working_directory );
+        exit_code = 1;
+    }
+    else
+    {
+        exit_code = handler( ( int )header.argument_count, arguments, &request, data );
+    }
+    fflush( stdout );
+    fflush( stderr );
+
+    if( !request.is_detached )
+    {
+        write_all( connection, &exit_code, sizeof( exit_code ) );
+    }
+
+    if( request.is_child )
+    {
+        _exit( 0 );
+    }
+
+    dup2( server_stdout, STDOUT_FILENO );
+    dup2( server_stderr, STDERR_FILENO );
+    close( server_stdout );
+    close( server_stderr );
+    if( server_directory >= 0 )
+    {
+        if( fchdir( server_directory ) != 0 )
+        {
+            printf( "Could not change back to the directory the server was started in.\n" );
+        }
+        close( server_directory );
+    }
+
+    free( arguments );
+    free( payload );
+    return true;
+}
+
+bool serve_requests( char* socket_path, uint64_t version, ServeHandler handler, void* data )
+{
+    struct sockaddr_un address;
+    if( !make_address( &address, socket_path ) )
+    {
+        printf( "The socket path '%s' is too long.\n", socket_path );
+        return false;
+    }
+
+    // a socket that nothing listens on is left over from a server that did not
+    // stop cleanly
+    int existing_server = connect_to( socket_path );
+    if( existing_server >= 0 )
+    {
+        close( existing_server );
+        printf( "A server is already listening on '%s'.\n", socket_path );
+        return false;
+    }
+    unlink( socket_path );
+
+    int listen_socket = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( listen_socket < 0 || fcntl( listen_socket, F_SETFD, FD_CLOEXEC ) != 0 ||
+        bind( listen_socket, ( struct sockaddr* )&address, sizeof( address ) ) != 0 ||
+        listen( listen_socket, SOMAXCONN ) != 0 )
+    {
+        printf( "Could not listen on '%s'.\n", socket_path );
+        return false;
+    }
+
+    // a client that goes away must not take the server with it
+    signal( SIGPIPE, SIG_IGN );
+
+    printf( "serving on %s\n", socket_path );
+    fflush( stdout );
+
+    bool is_current = true;
+    while( is_current )
+    {
+        int connection = accept( listen_socket, NULL, NULL );
+        if( connection < 0 )
+        {
+            if( errno == EINTR || errno == ECONNABORTED )
+            {
+                continue;
+            }
+
+            printf( "Could not accept a connection on '%s'.\n", socket_path );
+            break;
+        }
+        fcntl( connection, F_SETFD, FD_CLOEXEC );
+
+        struct timeval timeout = { .tv_sec = REQUEST_TIMEOUT_SECONDS };
+        setsockopt( connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof( timeout ) );
+
+        if( is_same_user( connection ) )
+        {
+            is_current = handle_connection( listen_socket, connection, version, handler, data );
+        }
+        close( connection );
+
+        // the builds that finished in the background
+        while( waitpid( -1, NULL, WNOHANG ) > 0 )
+        {
+        }
+    }
+
+    close( listen_socket );
+    unlink( socket_path );
+    return true;
+}
+
+bool serve_detach( ServeRequest* request )
+{
+    if( request == NULL )
+    {
+        return true;
+    }
+
+    // anything still buffered would be printed by both processes
+    fflush( stdout );
+    fflush( stderr );
+
+    // without a child the server finishes the build itself
+    pid_t process_id = fork();
+    if( process_id < 0 )
+    {
+        return true;
+    }
+
+    if( process_id == 0 )
+    {
+        close( request->listen_socket );
+        request->is_child = true;
+        return true;
+    }
+
+    request->is_detached = true;
+    return false;
+}
+
+bool serve_forward( char* socket_path, uint64_t version, int argc, char** argv, int* out_exit_code )
+{
+    int connection = connect_to( socket_path );
+    if( connection < 0 )
+    {
+        return false;
+    }
+
+    char* working_directory = getcwd( NULL, 0 );
+    if( working_directory == NULL )
+    {
+        close( connection );
+        return false;
+    }
+
+    CodeBuffer payload;
+    code_buffer_initialize( &payload );
+    code_buffer_append_data( &payload, working_directory, strlen( working_directory ) + 1 );
+    for( int i = 0; i < argc; i++ )
+    {
+        code_buffer_append_data( &payload, argv[ i ], strlen( argv[ i ] ) + 1 );
+    }
+
+    RequestHeader header = {
+        .magic = REQUEST_MAGIC,
+        .argument_count = ( uint32_t )argc,
+        .version = version,
+        .length = payload.length,
+    };
+
+    bool is_sent = send_header( connection, &header ) && write_all( connection, payload.data, payload.length );
+    int32_t exit_code = 0;
+    bool is_answered = is_sent && read_all( connection, &exit_code, sizeof( exit_code ) );
+
+    close( connection );
+    code_buffer_free( &payload );
+    arena_free_system( working_directory );
+
+    if( !is_sent || ( is_answered && exit_code == EXIT_CODE_REFUSED ) )
+    {
+        return false;
+    }
+
+    if( !is_answered )
+    {
+        printf( "The server stopped before the build finished.\n" );
+        exit_code = 1;
+    }
+
+    *out_exit_code = exit_code;
+    return true;
+}
+
+#else
+
+bool serve_requests( char* socket_path, uint64_t version, ServeHandler handler, void* data )
+{
+    ( void )socket_path;
+    ( void )version;
+    ( void )handler;
+    ( void )data;
+    printf( "'octo serve' needs unix domain sockets, which this build does not support on windows.\n" );
+    return false;
+}
+
+bool serve_detach( ServeRequest* request )
+{
+    ( void )request;
+    return true;
+}
+
+bool serve_forward( char* socket_path, uint64_t version, int argc, char** argv, int* out_exit_code )
+{
+    ( void )socket_path;
+    ( void )version;
+    ( void )argc;
+    ( void )argv;
+    ( void )out_exit_code;
+    return false;
+}
+
+#endif
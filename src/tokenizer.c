@@ -6,7 +6,6 @@
 #include "tokenizer.h"
 #include "error.h"
 #include "lvec.h"
-#include "globals.h"
 
 #define MAX_SYMBOL_LENGTH 512
 
@@ -47,7 +46,7 @@ static char* valid_special_symbols[] = {
     "(", ")",
     "{", "}",
     "[", "]",
-    "&", "..",
+    "&", "..", "#",
 };
 
 // temporary function
@@ -86,6 +85,7 @@ static TokenKind special_symbol_to_token_kind( const char* special_symbol )
     if( strcmp( special_symbol, "]" ) == 0 )  return TOKENKIND_RIGHTBRACKET;
     if( strcmp( special_symbol, "&" ) == 0 )  return TOKENKIND_AMPERSAND;
     if( strcmp( special_symbol, ".." ) == 0 ) return TOKENKIND_DOUBLEPERIOD;
+    if( strcmp( special_symbol, "#" ) == 0 )  return TOKENKIND_HASH;
 
     UNREACHABLE();
 }
@@ -108,6 +108,8 @@ static TokenKind word_symbol_to_token_kind( const char* word_symbol )
     if( strcmp( word_symbol, "type" ) == 0 )   return TOKENKIND_TYPE;
     if( strcmp( word_symbol, "struct" ) == 0 ) return TOKENKIND_STRUCT;
     if( strcmp( word_symbol, "union" ) == 0 )  return TOKENKIND_UNION;
+    if( strcmp( word_symbol, "module" ) == 0 ) return TOKENKIND_MODULE;
+    if( strcmp( word_symbol, "import" ) == 0 ) return TOKENKIND_IMPORT;
     if( strcmp( word_symbol, "and" ) == 0 )    return TOKENKIND_AND;
     if( strcmp( word_symbol, "or" ) == 0 )     return TOKENKIND_OR;
 
@@ -118,8 +120,8 @@ static TokenKind word_symbol_to_token_kind( const char* word_symbol )
 
 static bool advance( Tokenizer* tokenizer )
 {
-    tokenizer->character = g_source_code.code[ tokenizer->current_character_index ];
-    tokenizer->next_character = g_source_code.code[ tokenizer->current_character_index + 1 ];
+    tokenizer->character = tokenizer->source_code->code[ tokenizer->current_character_index ];
+    tokenizer->next_character = tokenizer->source_code->code[ tokenizer->current_character_index + 1 ];
     tokenizer->current_character_index++;
     tokenizer->column++;
     if( tokenizer->character == '\n' )
@@ -128,7 +130,7 @@ static bool advance( Tokenizer* tokenizer )
         tokenizer->column = 0;
     }
 
-    return tokenizer->current_character_index <= g_source_code.length;
+    return tokenizer->current_character_index <= tokenizer->source_code->length;
 }
 
 static void append_to_symbol( Tokenizer* tokenizer )
@@ -145,6 +147,7 @@ static void finalize_symbol( Tokenizer* tokenizer, Token** tokens )
         .line = tokenizer->line,
         .column = symbol_start_column,
         .as_string = malloc( strlen( tokenizer->symbol ) + 1 ),
+        .source_code = tokenizer->source_code,
     };
     strcpy( token.as_string, tokenizer->symbol );
 
@@ -170,7 +173,7 @@ static void finalize_symbol( Tokenizer* tokenizer, Token** tokens )
                     .offending_token = token,
                 };
 
-                report_error( error );
+                report_error( tokenizer->source_code, error );
                 tokenizer->error_found = true;
             }
             else
@@ -228,7 +231,7 @@ static void finalize_symbol( Tokenizer* tokenizer, Token** tokens )
                             .offending_token = token
                         };
 
-                        report_error( error );
+                        report_error( tokenizer->source_code, error );
                         tokenizer->error_found = true;
                     }
 
@@ -273,10 +276,11 @@ static void finalize_symbol( Tokenizer* tokenizer, Token** tokens )
     }
 }
 
-Token* tokenize()
+Token* tokenize( SourceCode* source_code )
 {
     // initialize tokenizer
     Tokenizer tokenizer = { 0 };
+    tokenizer.source_code = source_code;
     tokenizer.line = 1;
     tokenizer.column = 0;
     tokenizer.state = TOKENIZERSTATE_START;
@@ -572,6 +576,7 @@ Token* tokenize()
         .kind = TOKENKIND_EOF,
         .line = tokenizer.line,
         .column = tokenizer.column,
+        .source_code = source_code,
     };
 
     lvec_append_aggregate( tokens, eof );
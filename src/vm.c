@@ -0,0 +1,1813 @@
+// for RTLD_DEFAULT
+#define _GNU_SOURCE
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codebuffer.h"
+#include "debug.h"
+#include "driver.h"
+#include "error.h"
+#include "ir.h"
+#include "lvec.h"
+#include "parser.h"
+#include "vm.h"
+
+// extern functions are called through a prototype that takes six integers and
+// then up to eight doubles as variadic arguments. where integers and floats are
+// passed in separate registers whether a function is variadic or not, this
+// calls any function whose arguments fit into those registers
+#if ( defined( __x86_64__ ) || defined( __aarch64__ ) ) && !defined( _WIN32 ) && !defined( __APPLE__ )
+#define VM_HAS_TRAMPOLINES
+#include <dlfcn.h>
+#endif
+
+#define VM_INTEGER_ARGUMENT_COUNT 6
+#define VM_FLOAT_ARGUMENT_COUNT 8
+
+#define VM_REGISTER_STACK_SIZE ( 1 << 20 ) // in words
+#define VM_MEMORY_STACK_SIZE ( 8 << 20 ) // in bytes
+#define VM_FRAME_COUNT ( 1 << 18 )
+
+// the operands of every instruction follow it as words, registers are indices
+// into the registers of the frame and 64-bit immediates are two words, the low
+// one first
+typedef enum VmOpcode
+{
+    VMOPCODE_CONST,          // destination, immediate
+    VMOPCODE_MOVE,           // destination, source
+    VMOPCODE_MOVE2,          // destination, source, both arrays
+    VMOPCODE_FRAMEADDRESS,   // destination, offset into the memory of the frame
+
+    // destination, left, right
+    VMOPCODE_ADD,
+    VMOPCODE_SUBTRACT,
+    VMOPCODE_MULTIPLY,
+    VMOPCODE_DIVIDES,
+    VMOPCODE_DIVIDEU,
+    VMOPCODE_MODULOS,
+    VMOPCODE_MODULOU,
+    VMOPCODE_EQUAL,
+    VMOPCODE_NOTEQUAL,
+    VMOPCODE_LESSS,
+    VMOPCODE_LESSU,
+    VMOPCODE_LESSEQUALS,
+    VMOPCODE_LESSEQUALU,
+    VMOPCODE_ADDF64,
+    VMOPCODE_SUBTRACTF64,
+    VMOPCODE_MULTIPLYF64,
+    VMOPCODE_DIVIDEF64,
+    VMOPCODE_EQUALF64,
+    VMOPCODE_NOTEQUALF64,
+    VMOPCODE_LESSF64,
+    VMOPCODE_LESSEQUALF64,
+    VMOPCODE_ADDF32,
+    VMOPCODE_SUBTRACTF32,
+    VMOPCODE_MULTIPLYF32,
+    VMOPCODE_DIVIDEF32,
+    VMOPCODE_EQUALF32,
+    VMOPCODE_NOTEQUALF32,
+    VMOPCODE_LESSF32,
+    VMOPCODE_LESSEQUALF32,
+
+    // destination, operand
+    VMOPCODE_NEGATE,
+    VMOPCODE_NEGATEF64,
+    VMOPCODE_NEGATEF32,
+    VMOPCODE_NOT,
+    VMOPCODE_EXTENDS8,
+    VMOPCODE_EXTENDS16,
+    VMOPCODE_EXTENDS32,
+    VMOPCODE_EXTENDU8,
+    VMOPCODE_EXTENDU16,
+    VMOPCODE_EXTENDU32,
+    VMOPCODE_TOBOOL,
+    VMOPCODE_F64TOBOOL,
+    VMOPCODE_F32TOBOOL,
+    VMOPCODE_F32TOF64,
+    VMOPCODE_F64TOF32,
+    VMOPCODE_S64TOF64,
+    VMOPCODE_U64TOF64,
+    VMOPCODE_S64TOF32,
+    VMOPCODE_U64TOF32,
+    VMOPCODE_F64TOS64,
+    VMOPCODE_F64TOU64,
+    VMOPCODE_F32TOS64,
+    VMOPCODE_F32TOU64,
+
+    // destination, address
+    VMOPCODE_LOADS8,
+    VMOPCODE_LOADU8,
+    VMOPCODE_LOADS16,
+    VMOPCODE_LOADU16,
+    VMOPCODE_LOADS32,
+    VMOPCODE_LOADU32,
+    VMOPCODE_LOAD64,
+    VMOPCODE_LOAD128,
+
+    // address, offset, value
+    VMOPCODE_STORE8,
+    VMOPCODE_STORE16,
+    VMOPCODE_STORE32,
+    VMOPCODE_STORE64,
+    VMOPCODE_STORE128,
+
+    VMOPCODE_ARRAYAUTOMATIC, // destination, offset into the memory of the frame, length, element size
+    VMOPCODE_ARRAYHEAP,      // destination, length, element size
+    VMOPCODE_ELEMENT,        // destination, array, index, element size
+    VMOPCODE_ELEMENTCHECKED, // destination, array, index, element size, location
+
+    VMOPCODE_JUMP,           // target
+    VMOPCODE_BRANCH,         // condition, true target, false target
+    VMOPCODE_CALL,           // destination, function, argument count, arguments
+    VMOPCODE_TAILCALL,       // function, argument count, arguments
+    VMOPCODE_CALLEXTERN,     // destination, extern call, argument count, arguments
+    VMOPCODE_RETURN,         // value
+    VMOPCODE_RETURN2,        // value, an array
+    VMOPCODE_RETURNVOID,
+
+    VMOPCODE_COUNT,
+} VmOpcode;
+
+typedef struct VmFunction
+{
+    Expression* declaration;
+    uint32_t entry; // offset in the code
+    uint32_t register_count;
+    uint32_t memory_size; // for slots and arrays, a multiple of 16
+} VmFunction;
+
+typedef enum VmArgumentClass
+{
+    VMARGUMENTCLASS_INTEGER,
+    VMARGUMENTCLASS_FLOAT,
+} VmArgumentClass;
+
+typedef enum VmResultKind
+{
+    VMRESULTKIND_VOID,
+    VMRESULTKIND_INTEGER,
+    VMRESULTKIND_F64,
+    VMRESULTKIND_F32,
+    VMRESULTKIND_PAIR,
+} VmResultKind;
+
+// a call of an extern function, which depends on the call for variadic ones
+typedef struct VmExternCall
+{
+    void ( *address )( void );
+    VmArgumentClass* classes; // one per argument word
+    VmResultKind result_kind;
+} VmExternCall;
+
+typedef struct VmGlobal
+{
+    char* identifier;
+    uint64_t* address;
+} VmGlobal;
+
+typedef struct VmFrame
+{
+    const uint32_t* return_ip; // null when returning to vm_call()
+    uint64_t* registers;
+    uint8_t* memory;
+    VmFunction* function;
+    uint32_t result;
+} VmFrame;
+
+struct Vm
+{
+    CheckMode check_mode;
+    char* source_path; // where failed bounds checks say they are, unless their token knows
+    uint32_t* code;
+    VmFunction* functions;
+    VmExternCall* extern_calls;
+    VmGlobal* globals;
+    char** locations; // of bounds checks
+    void** allocations; // strings and static data, freed with the vm
+
+    // allocated on the first call
+    uint64_t* register_stack;
+    uint8_t* memory_stack;
+    VmFrame* frames;
+};
+
+typedef struct VmFixup
+{
+    size_t position;
+    IrBlock* target;
+} VmFixup;
+
+typedef struct VmCompiler
+{
+    Vm* vm;
+    Expression* program;
+    IrFunction* function;
+    uint32_t* registers; // by instruction index
+    uint32_t* phi_inputs; // by instruction index, where predecessors put the values of phis
+    uint32_t* memory_offsets; // by instruction index, of slots and arrays on the stack
+    uint32_t register_count;
+    uint32_t memory_size;
+    uint32_t* block_offsets; // by block index
+    VmFixup* fixups;
+} VmCompiler;
+
+static bool is_array( Type type )
+{
+    return type.kind == TYPEKIND_ARRAY;
+}
+
+static bool is_double( Type type )
+{
+    return ir_type_is_float( type ) && ir_type_get_bit_count( type ) == 64;
+}
+
+static bool is_void( Type type )
+{
+    return ir_get_type_definition( type ).kind == TYPEKIND_VOID;
+}
+
+static bool is_bool( Type type )
+{
+    return ir_get_type_definition( type ).kind == TYPEKIND_BOOLEAN;
+}
+
+static uint32_t get_type_size( Type type )
+{
+    if( is_array( type ) )
+    {
+        return 16;
+    }
+
+    if( ir_type_is_integer( type ) || ir_type_is_float( type ) )
+    {
+        return ir_type_get_bit_count( type ) / 8;
+    }
+
+    return 8; // pointers and references
+}
+
+static uint32_t align( uint32_t value, uint32_t alignment )
+{
+    return ( value + alignment - 1 ) & ~( alignment - 1 );
+}
+
+static char* get_function_name( Expression* function )
+{
+    return function->function_declaration.identifier_token.as_string;
+}
+
+static void* allocate( Vm* vm, size_t size )
+{
+    void* memory = calloc( 1, size > 0 ? size : 1 );
+    if( memory == NULL ) ALLOC_ERROR();
+    lvec_append( vm->allocations, memory );
+    return memory;
+}
+
+// compiling
+
+static void emit_word( VmCompiler* compiler, uint32_t word )
+{
+    lvec_append( compiler->vm->code, word );
+}
+
+static void emit( VmCompiler* compiler, VmOpcode opcode, int operand_count, ... )
+{
+    emit_word( compiler, opcode );
+
+    va_list operands;
+    va_start( operands, operand_count );
+    for( int i = 0; i < operand_count; i++ )
+    {
+        emit_word( compiler, va_arg( operands, uint32_t ) );
+    }
+    va_end( operands );
+}
+
+static void emit_constant( VmCompiler* compiler, uint32_t destination, uint64_t value )
+{
+    emit( compiler, VMOPCODE_CONST, 3, destination, ( uint32_t )value, ( uint32_t )( value >> 32 ) );
+}
+
+static void emit_target( VmCompiler* compiler, IrBlock* target )
+{
+    VmFixup fixup = { .position = lvec_get_length( compiler->vm->code ), .target = target };
+    lvec_append_aggregate( compiler->fixups, fixup );
+    emit_word( compiler, 0 );
+}
+
+static uint32_t get_register( VmCompiler* compiler, IrInstruction* value )
+{
+    return compiler->registers[ value->index ];
+}
+
+static void emit_move( VmCompiler* compiler, Type type, uint32_t destination, uint32_t source )
+{
+    emit( compiler, is_array( type ) ? VMOPCODE_MOVE2 : VMOPCODE_MOVE, 2, destination, source );
+}
+
+// sign- or zero-extends the low bits of a register that hold a value of `type`
+static void emit_normalize( VmCompiler* compiler, Type type, uint32_t destination, uint32_t source )
+{
+    if( !ir_type_is_integer( type ) || ir_type_get_bit_count( type ) == 64 )
+    {
+        if( destination != source )
+        {
+            emit( compiler, VMOPCODE_MOVE, 2, destination, source );
+        }
+        return;
+    }
+
+    bool is_signed = ir_type_is_signed( type );
+    switch( ir_type_get_bit_count( type ) )
+    {
+        case 8:  emit( compiler, is_signed ? VMOPCODE_EXTENDS8 : VMOPCODE_EXTENDU8, 2, destination, source ); break;
+        case 16: emit( compiler, is_signed ? VMOPCODE_EXTENDS16 : VMOPCODE_EXTENDU16, 2, destination, source ); break;
+        case 32: emit( compiler, is_signed ? VMOPCODE_EXTENDS32 : VMOPCODE_EXTENDU32, 2, destination, source ); break;
+        default: UNREACHABLE();
+    }
+}
+
+static char* add_string( Vm* vm, char* escaped )
+{
+    CodeBuffer buffer;
+    code_buffer_initialize( &buffer );
+    code_buffer_append_unescaped( &buffer, escaped );
+    char* string = allocate( vm, buffer.length + 1 );
+    memcpy( string, buffer.data, buffer.length );
+    code_buffer_free( &buffer );
+    return string;
+}
+
+static uint64_t get_global_address( Vm* vm, char* identifier )
+{
+    size_t global_count = lvec_get_length( vm->globals );
+    for( size_t i = 0; i < global_count; i++ )
+    {
+        if( strcmp( vm->globals[ i ].identifier, identifier ) == 0 )
+        {
+            return ( uint64_t )( uintptr_t )vm->globals[ i ].address;
+        }
+    }
+
+    UNREACHABLE();
+    return 0;
+}
+
+static int find_function( Vm* vm, Expression* declaration )
+{
+    size_t function_count = lvec_get_length( vm->functions );
+    for( size_t i = 0; i < function_count; i++ )
+    {
+        if( vm->functions[ i ].declaration == declaration )
+        {
+            return ( int )i;
+        }
+    }
+
+    return -1;
+}
+
+// every word of the arguments, which is two for arrays
+static void emit_arguments( VmCompiler* compiler, IrInstruction* call )
+{
+    uint32_t word_count = 0;
+    size_t argument_count = lvec_get_length( call->operands );
+    for( size_t i = 0; i < argument_count; i++ )
+    {
+        word_count += is_array( call->operands[ i ]->type ) ? 2 : 1;
+    }
+
+    emit_word( compiler, word_count );
+    for( size_t i = 0; i < argument_count; i++ )
+    {
+        IrInstruction* argument = call->operands[ i ];
+        emit_word( compiler, get_register( compiler, argument ) );
+        if( is_array( argument->type ) )
+        {
+            emit_word( compiler, get_register( compiler, argument ) + 1 );
+        }
+    }
+}
+
+// returns false after printing why if the extern function cannot be called
+static bool add_extern_call( Vm* vm, IrInstruction* call, uint32_t* out_index )
+{
+    char* identifier = get_function_name( call->call.function );
+
+#if defined( VM_HAS_TRAMPOLINES )
+    void* symbol = dlsym( RTLD_DEFAULT, identifier );
+    if( symbol == NULL )
+    {
+        printf( "The interpreter cannot find the extern function '%s'.\n", identifier );
+        return false;
+    }
+
+    // iso c cannot cast between data and function pointers, posix can
+    VmExternCall extern_call = { .classes = lvec_new( VmArgumentClass ) };
+    memcpy( &extern_call.address, &symbol, sizeof( extern_call.address ) );
+
+    int integer_count = 0;
+    int float_count = 0;
+    size_t argument_count = lvec_get_length( call->operands );
+    for( size_t i = 0; i < argument_count; i++ )
+    {
+        Type type = call->operands[ i ]->type;
+        int word_count = is_array( type ) ? 2 : 1;
+        VmArgumentClass argument_class = ir_type_is_float( type ) ? VMARGUMENTCLASS_FLOAT : VMARGUMENTCLASS_INTEGER;
+        for( int word = 0; word < word_count; word++ )
+        {
+            lvec_append( extern_call.classes, argument_class );
+        }
+
+        if( argument_class == VMARGUMENTCLASS_FLOAT )
+        {
+            float_count++;
+        }
+        else
+        {
+            integer_count += word_count;
+        }
+    }
+
+    if( integer_count > VM_INTEGER_ARGUMENT_COUNT || float_count > VM_FLOAT_ARGUMENT_COUNT )
+    {
+        printf( "The interpreter cannot call '%s' with more than %d integer or %d float arguments.\n",
+                identifier, VM_INTEGER_ARGUMENT_COUNT, VM_FLOAT_ARGUMENT_COUNT );
+        lvec_free( extern_call.classes );
+        return false;
+    }
+
+    Type result_type = call->type;
+    if( is_void( result_type ) )
+    {
+        extern_call.result_kind = VMRESULTKIND_VOID;
+    }
+    else if( is_array( result_type ) )
+    {
+        extern_call.result_kind = VMRESULTKIND_PAIR;
+    }
+    else if( ir_type_is_float( result_type ) )
+    {
+        extern_call.result_kind = is_double( result_type ) ? VMRESULTKIND_F64 : VMRESULTKIND_F32;
+    }
+    else
+    {
+        extern_call.result_kind = VMRESULTKIND_INTEGER;
+    }
+
+    *out_index = ( uint32_t )lvec_get_length( vm->extern_calls );
+    lvec_append_aggregate( vm->extern_calls, extern_call );
+    return true;
+#else
+    ( void )vm;
+    ( void )out_index;
+    printf( "The interpreter cannot call the extern function '%s' on this platform.\n", identifier );
+    return false;
+#endif
+}
+
+static void emit_binary( VmCompiler* compiler, IrInstruction* instruction )
+{
+    IrInstruction* left = instruction->operands[ 0 ];
+    IrInstruction* right = instruction->operands[ 1 ];
+    uint32_t destination = get_register( compiler, instruction );
+    uint32_t left_register = get_register( compiler, left );
+    uint32_t right_register = get_register( compiler, right );
+
+    // `a > b` is `b < a`
+    bool is_swapped = instruction->opcode == IROPCODE_GREATER || instruction->opcode == IROPCODE_GREATEREQUAL;
+    if( is_swapped )
+    {
+        uint32_t swapped = left_register;
+        left_register = right_register;
+        right_register = swapped;
+    }
+
+    VmOpcode opcode;
+    if( ir_type_is_float( left->type ) )
+    {
+        bool is_f64 = is_double( left->type );
+        switch( instruction->opcode )
+        {
+            case IROPCODE_ADD:          opcode = is_f64 ? VMOPCODE_ADDF64 : VMOPCODE_ADDF32; break;
+            case IROPCODE_SUBTRACT:     opcode = is_f64 ? VMOPCODE_SUBTRACTF64 : VMOPCODE_SUBTRACTF32; break;
+            case IROPCODE_MULTIPLY:     opcode = is_f64 ? VMOPCODE_MULTIPLYF64 : VMOPCODE_MULTIPLYF32; break;
+            case IROPCODE_DIVIDE:       opcode = is_f64 ? VMOPCODE_DIVIDEF64 : VMOPCODE_DIVIDEF32; break;
+            case IROPCODE_EQUAL:        opcode = is_f64 ? VMOPCODE_EQUALF64 : VMOPCODE_EQUALF32; break;
+            case IROPCODE_NOTEQUAL:     opcode = is_f64 ? VMOPCODE_NOTEQUALF64 : VMOPCODE_NOTEQUALF32; break;
+            case IROPCODE_LESS:
+            case IROPCODE_GREATER:      opcode = is_f64 ? VMOPCODE_LESSF64 : VMOPCODE_LESSF32; break;
+            case IROPCODE_LESSEQUAL:
+            case IROPCODE_GREATEREQUAL: opcode = is_f64 ? VMOPCODE_LESSEQUALF64 : VMOPCODE_LESSEQUALF32; break;
+            default:                    UNREACHABLE();
+        }
+
+        emit( compiler, opcode, 3, destination, left_register, right_register );
+        return;
+    }
+
+    // pointers compare like unsigned integers
+    bool is_signed = ir_type_is_signed( left->type );
+    bool is_comparison = false;
+    switch( instruction->opcode )
+    {
+        case IROPCODE_ADD:      opcode = VMOPCODE_ADD; break;
+        case IROPCODE_SUBTRACT: opcode = VMOPCODE_SUBTRACT; break;
+        case IROPCODE_MULTIPLY: opcode = VMOPCODE_MULTIPLY; break;
+        case IROPCODE_DIVIDE:   opcode = is_signed ? VMOPCODE_DIVIDES : VMOPCODE_DIVIDEU; break;
+        case IROPCODE_MODULO:   opcode = is_signed ? VMOPCODE_MODULOS : VMOPCODE_MODULOU; break;
+
+        case IROPCODE_EQUAL:        opcode = VMOPCODE_EQUAL; is_comparison = true; break;
+        case IROPCODE_NOTEQUAL:     opcode = VMOPCODE_NOTEQUAL; is_comparison = true; break;
+        case IROPCODE_LESS:
+        case IROPCODE_GREATER:      opcode = is_signed ? VMOPCODE_LESSS : VMOPCODE_LESSU; is_comparison = true; break;
+        case IROPCODE_LESSEQUAL:
+        case IROPCODE_GREATEREQUAL: opcode = is_signed ? VMOPCODE_LESSEQUALS : VMOPCODE_LESSEQUALU; is_comparison = true; break;
+        default:                    UNREACHABLE();
+    }
+
+    emit( compiler, opcode, 3, destination, left_register, right_register );
+    if( !is_comparison )
+    {
+        emit_normalize( compiler, instruction->type, destination, destination );
+    }
+}
+
+static void emit_convert( VmCompiler* compiler, IrInstruction* instruction )
+{
+    IrInstruction* operand = instruction->operands[ 0 ];
+    Type from = operand->type;
+    Type to = instruction->type;
+    uint32_t destination = get_register( compiler, instruction );
+    uint32_t source = get_register( compiler, operand );
+
+    if( ir_type_is_float( from ) && ir_type_is_float( to ) )
+    {
+        if( is_double( from ) == is_double( to ) )
+        {
+            emit( compiler, VMOPCODE_MOVE, 2, destination, source );
+        }
+        else
+        {
+            emit( compiler, is_double( from ) ? VMOPCODE_F64TOF32 : VMOPCODE_F32TOF64, 2, destination, source );
+        }
+    }
+    else if( ir_type_is_float( from ) && is_bool( to ) )
+    {
+        emit( compiler, is_double( from ) ? VMOPCODE_F64TOBOOL : VMOPCODE_F32TOBOOL, 2, destination, source );
+    }
+    else if( ir_type_is_float( from ) && ir_type_is_integer( to ) )
+    {
+        bool is_unsigned = !ir_type_is_signed( to ) && ir_type_get_bit_count( to ) == 64;
+        VmOpcode opcode = is_double( from ) ? ( is_unsigned ? VMOPCODE_F64TOU64 : VMOPCODE_F64TOS64 )
+                                            : ( is_unsigned ? VMOPCODE_F32TOU64 : VMOPCODE_F32TOS64 );
+        emit( compiler, opcode, 2, destination, source );
+        emit_normalize( compiler, to, destination, destination );
+    }
+    else if( ir_type_is_integer( from ) && ir_type_is_float( to ) )
+    {
+        bool is_unsigned = !ir_type_is_signed( from ) && ir_type_get_bit_count( from ) == 64;
+        VmOpcode opcode = is_double( to ) ? ( is_unsigned ? VMOPCODE_U64TOF64 : VMOPCODE_S64TOF64 )
+                                          : ( is_unsigned ? VMOPCODE_U64TOF32 : VMOPCODE_S64TOF32 );
+        emit( compiler, opcode, 2, destination, source );
+    }
+    else if( ir_type_is_integer( from ) && is_bool( to ) )
+    {
+        emit( compiler, VMOPCODE_TOBOOL, 2, destination, source );
+    }
+    else if( ir_type_is_integer( to ) )
+    {
+        emit_normalize( compiler, to, destination, source );
+    }
+    else
+    {
+        // between pointers and references
+        emit_move( compiler, to, destination, source );
+    }
+}
+
+static void emit_load( VmCompiler* compiler, IrInstruction* instruction )
+{
+    Type type = instruction->type;
+    uint32_t destination = get_register( compiler, instruction );
+    uint32_t address = get_register( compiler, instruction->operands[ 0 ] );
+
+    VmOpcode opcode;
+    bool is_signed = ir_type_is_signed( type ) && !ir_type_is_float( type );
+    switch( get_type_size( type ) )
+    {
+        case 1:  opcode = is_signed ? VMOPCODE_LOADS8 : VMOPCODE_LOADU8; break;
+        case 2:  opcode = is_signed ? VMOPCODE_LOADS16 : VMOPCODE_LOADU16; break;
+        case 4:  opcode = is_signed ? VMOPCODE_LOADS32 : VMOPCODE_LOADU32; break;
+        case 8:  opcode = VMOPCODE_LOAD64; break;
+        default: opcode = VMOPCODE_LOAD128; break;
+    }
+
+    emit( compiler, opcode, 2, destination, address );
+}
+
+static void emit_store( VmCompiler* compiler, uint32_t address, uint32_t offset, IrInstruction* value )
+{
+    VmOpcode opcode;
+    switch( get_type_size( value->type ) )
+    {
+        case 1:  opcode = VMOPCODE_STORE8; break;
+        case 2:  opcode = VMOPCODE_STORE16; break;
+        case 4:  opcode = VMOPCODE_STORE32; break;
+        case 8:  opcode = VMOPCODE_STORE64; break;
+        default: opcode = VMOPCODE_STORE128; break;
+    }
+
+    emit( compiler, opcode, 3, address, offset, get_register( compiler, value ) );
+}
+
+// the data of static arrays is built once, when the program is compiled
+static uint64_t add_static_array( Vm* vm, IrInstruction* instruction )
+{
+    Type array_type = instruction->array_literal.type;
+    uint32_t element_size = get_type_size( *array_type.array.base_type );
+    uint8_t* data = allocate( vm, ( size_t )array_type.array.length * element_size );
+
+    size_t operand_count = lvec_get_length( instruction->operands );
+    for( size_t i = 0; i < operand_count; i++ )
+    {
+        IrInstruction* element = instruction->operands[ i ];
+        uint64_t bits = element->opcode == IROPCODE_STRING ? ( uint64_t )( uintptr_t )add_string( vm, element->string )
+                                                           : ir_get_constant_bits( element );
+        memcpy( data + i * element_size, &bits, element_size ); // little-endian
+    }
+
+    return ( uint64_t )( uintptr_t )data;
+}
+
+static void emit_array_literal( VmCompiler* compiler, IrInstruction* instruction )
+{
+    Type array_type = instruction->array_literal.type;
+    uint32_t length = ( uint32_t )array_type.array.length;
+    uint32_t element_size = get_type_size( *array_type.array.base_type );
+    uint32_t destination = get_register( compiler, instruction );
+
+    switch( instruction->array_literal.storage )
+    {
+        case ARRAYSTORAGE_STATIC:
+        {
+            emit_constant( compiler, destination, length );
+            emit_constant( compiler, destination + 1, add_static_array( compiler->vm, instruction ) );
+            return;
+        }
+
+        case ARRAYSTORAGE_AUTOMATIC:
+        {
+            emit( compiler, VMOPCODE_ARRAYAUTOMATIC, 4, destination, compiler->memory_offsets[ instruction->index ],
+                  length, element_size );
+            break;
+        }
+
+        case ARRAYSTORAGE_HEAP:
+        case ARRAYSTORAGE_SCOPEDHEAP:
+        {
+            emit( compiler, VMOPCODE_ARRAYHEAP, 3, destination, length, element_size );
+            break;
+        }
+    }
+
+    size_t operand_count = lvec_get_length( instruction->operands );
+    for( size_t i = 0; i < operand_count; i++ )
+    {
+        emit_store( compiler, destination + 1, ( uint32_t )i * element_size, instruction->operands[ i ] );
+    }
+}
+
+static void emit_element( VmCompiler* compiler, IrInstruction* instruction )
+{
+    uint32_t destination = get_register( compiler, instruction );
+    uint32_t array = get_register( compiler, instruction->operands[ 0 ] );
+    uint32_t index = get_register( compiler, instruction->operands[ 1 ] );
+    uint32_t element_size = get_type_size( *instruction->type.reference.base_type );
+    if( !instruction->element.is_bounds_checked )
+    {
+        emit( compiler, VMOPCODE_ELEMENT, 4, destination, array, index, element_size );
+        return;
+    }
+
+    // "path:line:column", like the generated c
+    Token token = instruction->element.location_token;
+    char suffix[ 32 ];
+    snprintf( suffix, sizeof( suffix ), ":%d:%d", token.line, token.column );
+    char* source_path = token.source_code != NULL ? token.source_code->path : compiler->vm->source_path;
+    char* location = allocate( compiler->vm, strlen( source_path ) + strlen( suffix ) + 1 );
+    sprintf( location, "%s%s", source_path, suffix );
+
+    uint32_t location_index = ( uint32_t )lvec_get_length( compiler->vm->locations );
+    lvec_append( compiler->vm->locations, location );
+    emit( compiler, VMOPCODE_ELEMENTCHECKED, 5, destination, array, index, element_size, location_index );
+}
+
+// returns true if the call became a jump, which also returns from the function
+static bool emit_call( VmCompiler* compiler, IrInstruction* call )
+{
+    Expression* function = call->call.function;
+    uint32_t destination = get_register( compiler, call );
+
+    if( function->function_declaration.body == NULL )
+    {
+        uint32_t extern_call;
+        if( !add_extern_call( compiler->vm, call, &extern_call ) )
+        {
+            UNREACHABLE(); // checked by vm_compile()
+        }
+
+        emit( compiler, VMOPCODE_CALLEXTERN, 2, destination, extern_call );
+        emit_arguments( compiler, call );
+        if( ir_type_is_integer( call->type ) )
+        {
+            // only the bits of the type are guaranteed to be set
+            emit_normalize( compiler, call->type, destination, destination );
+        }
+        return false;
+    }
+
+    uint32_t index = ( uint32_t )find_function( compiler->vm, function );
+    if( call->call.is_tail_call )
+    {
+        emit( compiler, VMOPCODE_TAILCALL, 1, index );
+        emit_arguments( compiler, call );
+        return true;
+    }
+
+    emit( compiler, VMOPCODE_CALL, 2, destination, index );
+    emit_arguments( compiler, call );
+    return false;
+}
+
+// the values of the phis of `successor` are put where the phis read them from
+static void emit_phi_inputs( VmCompiler* compiler, IrBlock* block, IrBlock* successor )
+{
+    size_t predecessor_index = 0;
+    while( successor->predecessors[ predecessor_index ] != block )
+    {
+        predecessor_index++;
+    }
+
+    size_t length = lvec_get_length( successor->instructions );
+    for( size_t i = 0; i < length && successor->instructions[ i ]->opcode == IROPCODE_PHI; i++ )
+    {
+        IrInstruction* phi = successor->instructions[ i ];
+        IrInstruction* operand = phi->operands[ predecessor_index ];
+        emit_move( compiler, phi->type, compiler->phi_inputs[ phi->index ], get_register( compiler, operand ) );
+    }
+}
+
+static void emit_terminator( VmCompiler* compiler, IrBlock* block, IrBlock* next_block, IrInstruction* terminator )
+{
+    switch( terminator->opcode )
+    {
+        case IROPCODE_JUMP:
+        {
+            emit_phi_inputs( compiler, block, terminator->targets[ 0 ] );
+            if( terminator->targets[ 0 ] != next_block )
+            {
+                emit_word( compiler, VMOPCODE_JUMP );
+                emit_target( compiler, terminator->targets[ 0 ] );
+            }
+            break;
+        }
+
+        case IROPCODE_BRANCH:
+        {
+            emit_phi_inputs( compiler, block, terminator->targets[ 0 ] );
+            emit_phi_inputs( compiler, block, terminator->targets[ 1 ] );
+            emit( compiler, VMOPCODE_BRANCH, 1, get_register( compiler, terminator->operands[ 0 ] ) );
+            emit_target( compiler, terminator->targets[ 0 ] );
+            emit_target( compiler, terminator->targets[ 1 ] );
+            break;
+        }
+
+        case IROPCODE_RETURN:
+        {
+            if( lvec_get_length( terminator->operands ) == 0 )
+            {
+                emit( compiler, VMOPCODE_RETURNVOID, 0 );
+                break;
+            }
+
+            IrInstruction* value = terminator->operands[ 0 ];
+            emit( compiler, is_array( value->type ) ? VMOPCODE_RETURN2 : VMOPCODE_RETURN, 1,
+                  get_register( compiler, value ) );
+            break;
+        }
+
+        default:
+        {
+            UNREACHABLE();
+        }
+    }
+}
+
+static void emit_instruction( VmCompiler* compiler, IrInstruction* instruction )
+{
+    uint32_t destination = get_register( compiler, instruction );
+    switch( instruction->opcode )
+    {
+        case IROPCODE_CONSTANT:
+        {
+            emit_constant( compiler, destination, ir_get_constant_bits( instruction ) );
+            if( is_array( instruction->type ) )
+            {
+                emit_constant( compiler, destination + 1, 0 );
+            }
+            break;
+        }
+
+        case IROPCODE_STRING:
+        {
+            emit_constant( compiler, destination, ( uint64_t )( uintptr_t )add_string( compiler->vm, instruction->string ) );
+            break;
+        }
+
+        case IROPCODE_PARAM:
+        {
+            break;
+        }
+
+        case IROPCODE_PHI:
+        {
+            emit_move( compiler, instruction->type, destination, compiler->phi_inputs[ instruction->index ] );
+            break;
+        }
+
+        case IROPCODE_COPY:
+        {
+            emit_move( compiler, instruction->type, destination, get_register( compiler, instruction->operands[ 0 ] ) );
+            break;
+        }
+
+        case IROPCODE_CONVERT:
+        {
+            emit_convert( compiler, instruction );
+            break;
+        }
+
+        case IROPCODE_NEGATE:
+        {
+            Type type = instruction->type;
+            uint32_t operand = get_register( compiler, instruction->operands[ 0 ] );
+            if( ir_type_is_float( type ) )
+            {
+                emit( compiler, is_double( type ) ? VMOPCODE_NEGATEF64 : VMOPCODE_NEGATEF32, 2, destination, operand );
+                break;
+            }
+
+            emit( compiler, VMOPCODE_NEGATE, 2, destination, operand );
+            emit_normalize( compiler, type, destination, destination );
+            break;
+        }
+
+        case IROPCODE_NOT:
+        {
+            emit( compiler, VMOPCODE_NOT, 2, destination, get_register( compiler, instruction->operands[ 0 ] ) );
+            break;
+        }
+
+        case IROPCODE_SLOT:
+        {
+            emit( compiler, VMOPCODE_FRAMEADDRESS, 2, destination, compiler->memory_offsets[ instruction->index ] );
+            break;
+        }
+
+        case IROPCODE_GLOBAL:
+        {
+            emit_constant( compiler, destination, get_global_address( compiler->vm, instruction->identifier ) );
+            break;
+        }
+
+        case IROPCODE_LOAD:
+        {
+            emit_load( compiler, instruction );
+            break;
+        }
+
+        case IROPCODE_STORE:
+        {
+            emit_store( compiler, get_register( compiler, instruction->operands[ 0 ] ), 0, instruction->operands[ 1 ] );
+            break;
+        }
+
+        case IROPCODE_ARRAYLITERAL:
+        {
+            emit_array_literal( compiler, instruction );
+            break;
+        }
+
+        case IROPCODE_ARRAYLENGTH:
+        {
+            emit( compiler, VMOPCODE_MOVE, 2, destination, get_register( compiler, instruction->operands[ 0 ] ) );
+            break;
+        }
+
+        case IROPCODE_ELEMENT:
+        {
+            emit_element( compiler, instruction );
+            break;
+        }
+
+        default:
+        {
+            emit_binary( compiler, instruction );
+            break;
+        }
+    }
+}
+
+// the parameters take the first registers, in the order the arguments are
+// passed in. then every other value gets one register and arrays two
+static void assign_registers( VmCompiler* compiler, Expression* declaration )
+{
+    IrFunction* function = compiler->function;
+    int param_count = declaration->function_declaration.param_count;
+    uint32_t* param_registers = calloc( param_count + 1, sizeof( uint32_t ) );
+    if( param_registers == NULL ) ALLOC_ERROR();
+    for( int i = 0; i < param_count; i++ )
+    {
+        param_registers[ i ] = compiler->register_count;
+        compiler->register_count += is_array( declaration->function_declaration.param_types[ i ] ) ? 2 : 1;
+    }
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            uint32_t word_count = is_array( instruction->type ) ? 2 : 1;
+            if( instruction->opcode == IROPCODE_PARAM )
+            {
+                compiler->registers[ instruction->index ] = param_registers[ instruction->param_index ];
+                continue;
+            }
+
+            compiler->registers[ instruction->index ] = compiler->register_count;
+            compiler->register_count += word_count;
+
+            if( instruction->opcode == IROPCODE_PHI )
+            {
+                compiler->phi_inputs[ instruction->index ] = compiler->register_count;
+                compiler->register_count += word_count;
+            }
+            else if( instruction->opcode == IROPCODE_SLOT )
+            {
+                compiler->memory_offsets[ instruction->index ] = compiler->memory_size;
+                compiler->memory_size += align( get_type_size( *instruction->type.reference.base_type ), 8 );
+            }
+            else if( instruction->opcode == IROPCODE_ARRAYLITERAL &&
+                     instruction->array_literal.storage == ARRAYSTORAGE_AUTOMATIC )
+            {
+                Type array_type = instruction->array_literal.type;
+                compiler->memory_size = align( compiler->memory_size, 16 );
+                compiler->memory_offsets[ instruction->index ] = compiler->memory_size;
+                compiler->memory_size += array_type.array.length * get_type_size( *array_type.array.base_type );
+            }
+        }
+    }
+
+    compiler->memory_size = align( compiler->memory_size, 16 );
+    free( param_registers );
+}
+
+static void compile_function( Vm* vm, Expression* program, VmFunction* vm_function )
+{
+    IrFunction* function = vm_function->declaration->function_declaration.ir;
+    VmCompiler compiler = {
+        .vm = vm,
+        .program = program,
+        .function = function,
+        .registers = calloc( function->instruction_count + 1, sizeof( uint32_t ) ),
+        .phi_inputs = calloc( function->instruction_count + 1, sizeof( uint32_t ) ),
+        .memory_offsets = calloc( function->instruction_count + 1, sizeof( uint32_t ) ),
+        .block_offsets = calloc( function->block_count + 1, sizeof( uint32_t ) ),
+        .fixups = lvec_new( VmFixup ),
+    };
+    if( compiler.registers == NULL || compiler.phi_inputs == NULL || compiler.memory_offsets == NULL ||
+        compiler.block_offsets == NULL )
+    {
+        ALLOC_ERROR();
+    }
+
+    assign_registers( &compiler, vm_function->declaration );
+    vm_function->entry = ( uint32_t )lvec_get_length( vm->code );
+
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        IrBlock* next_block = i + 1 < block_count ? function->blocks[ i + 1 ] : NULL;
+        compiler.block_offsets[ block->index ] = ( uint32_t )lvec_get_length( vm->code );
+
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            if( ir_is_terminator( instruction ) )
+            {
+                emit_terminator( &compiler, block, next_block, instruction );
+            }
+            else if( instruction->opcode == IROPCODE_CALL )
+            {
+                // the return that follows a tail call is part of it
+                if( emit_call( &compiler, instruction ) )
+                {
+                    break;
+                }
+            }
+            else
+            {
+                emit_instruction( &compiler, instruction );
+            }
+        }
+    }
+
+    size_t fixup_count = lvec_get_length( compiler.fixups );
+    for( size_t i = 0; i < fixup_count; i++ )
+    {
+        VmFixup fixup = compiler.fixups[ i ];
+        vm->code[ fixup.position ] = compiler.block_offsets[ fixup.target->index ];
+    }
+
+    vm_function->register_count = compiler.register_count;
+    vm_function->memory_size = compiler.memory_size;
+
+    lvec_free( compiler.fixups );
+    free( compiler.block_offsets );
+    free( compiler.memory_offsets );
+    free( compiler.phi_inputs );
+    free( compiler.registers );
+}
+
+static void add_global( Vm* vm, Expression* declaration )
+{
+    Type type = declaration->variable_declaration.variable_type;
+    Expression* rvalue = declaration->variable_declaration.rvalue;
+    VmGlobal global = {
+        .identifier = declaration->variable_declaration.identifier_token.as_string,
+        .address = allocate( vm, sizeof( uint64_t ) ),
+    };
+
+    if( rvalue != NULL )
+    {
+        uint64_t bits = rvalue->kind == EXPRESSIONKIND_STRING ? ( uint64_t )( uintptr_t )add_string( vm, rvalue->string )
+                                                             : ir_get_literal_bits( rvalue, type );
+        memcpy( global.address, &bits, get_type_size( type ) ); // little-endian
+    }
+
+    lvec_append_aggregate( vm->globals, global );
+}
+
+// the checks
+
+static bool is_supported_function( Vm* vm, IrFunction* function )
+{
+    size_t block_count = lvec_get_length( function->blocks );
+    for( size_t i = 0; i < block_count; i++ )
+    {
+        IrBlock* block = function->blocks[ i ];
+        size_t length = lvec_get_length( block->instructions );
+        for( size_t j = 0; j < length; j++ )
+        {
+            IrInstruction* instruction = block->instructions[ j ];
+            if( instruction->opcode == IROPCODE_CALL && instruction->call.function->function_declaration.body == NULL )
+            {
+                // the call is added again when the function is compiled
+                uint32_t extern_call;
+                if( !add_extern_call( vm, instruction, &extern_call ) )
+                {
+                    return false;
+                }
+                lvec_free( vm->extern_calls[ extern_call ].classes );
+                lvec_remove_last( vm->extern_calls );
+            }
+            else if( instruction->opcode == IROPCODE_ARRAYLITERAL &&
+                     instruction->array_literal.storage == ARRAYSTORAGE_STATIC )
+            {
+                size_t operand_count = lvec_get_length( instruction->operands );
+                for( size_t k = 0; k < operand_count; k++ )
+                {
+                    IrOpcode opcode = instruction->operands[ k ]->opcode;
+                    if( opcode != IROPCODE_CONSTANT && opcode != IROPCODE_STRING )
+                    {
+                        printf( "The interpreter cannot build a static array of '%s'.\n",
+                                get_function_name( function->declaration ) );
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool is_supported_global( Expression* declaration )
+{
+    Type type = declaration->variable_declaration.variable_type;
+    Expression* rvalue = declaration->variable_declaration.rvalue;
+    bool is_supported_type = ir_type_is_integer( type ) || ir_type_is_float( type ) || type.kind == TYPEKIND_POINTER;
+    if( !is_supported_type || ( rvalue != NULL && !ir_is_literal_initializer( rvalue ) ) )
+    {
+        printf( "The interpreter cannot initialize '%s'.\n", declaration->variable_declaration.identifier_token.as_string );
+        return false;
+    }
+
+    return true;
+}
+
+Vm* vm_compile( Expression* program, CheckMode check_mode, char* source_path )
+{
+    Vm* vm = calloc( 1, sizeof( Vm ) );
+    if( vm == NULL ) ALLOC_ERROR();
+    vm->check_mode = check_mode;
+    vm->source_path = source_path;
+    vm->code = lvec_new( uint32_t );
+    vm->functions = lvec_new( VmFunction );
+    vm->extern_calls = lvec_new( VmExternCall );
+    vm->globals = lvec_new( VmGlobal );
+    vm->locations = lvec_new( char* );
+    vm->allocations = lvec_new( void* );
+
+    // functions are numbered first, so that calls can refer to any of them
+    bool is_supported = true;
+    size_t statement_count = lvec_get_length( program->compound.expressions );
+    for( size_t i = 0; i < statement_count && is_supported; i++ )
+    {
+        Expression* statement = program->compound.expressions[ i ];
+        if( statement->kind == EXPRESSIONKIND_FUNCTIONDECLARATION && statement->function_declaration.is_reachable )
+        {
+            IrFunction* function = statement->function_declaration.ir;
+            if( function == NULL || statement->function_declaration.is_variadic )
+            {
+                printf( "The interpreter cannot run '%s'.\n", get_function_name( statement ) );
+                is_supported = false;
+                break;
+            }
+
+            is_supported = is_supported_function( vm, function );
+            VmFunction vm_function = { .declaration = statement };
+            lvec_append_aggregate( vm->functions, vm_function );
+        }
+        else if( statement->kind == EXPRESSIONKIND_VARIABLEDECLARATION )
+        {
+            is_supported = is_supported_global( statement );
+            if( is_supported )
+            {
+                add_global( vm, statement );
+            }
+        }
+    }
+
+    if( !is_supported )
+    {
+        vm_free( vm );
+        return NULL;
+    }
+
+    size_t function_count = lvec_get_length( vm->functions );
+    for( size_t i = 0; i < function_count; i++ )
+    {
+        compile_function( vm, program, &vm->functions[ i ] );
+    }
+
+    return vm;
+}
+
+void vm_free( Vm* vm )
+{
+    size_t extern_call_count = lvec_get_length( vm->extern_calls );
+    for( size_t i = 0; i < extern_call_count; i++ )
+    {
+        lvec_free( vm->extern_calls[ i ].classes );
+    }
+
+    size_t allocation_count = lvec_get_length( vm->allocations );
+    for( size_t i = 0; i < allocation_count; i++ )
+    {
+        free( vm->allocations[ i ] );
+    }
+
+    lvec_free( vm->code );
+    lvec_free( vm->functions );
+    lvec_free( vm->extern_calls );
+    lvec_free( vm->globals );
+    lvec_free( vm->locations );
+    lvec_free( vm->allocations );
+    free( vm->register_stack );
+    free( vm->memory_stack );
+    free( vm->frames );
+    free( vm );
+}
+
+int vm_find_function( Vm* vm, char* identifier )
+{
+    size_t function_count = lvec_get_length( vm->functions );
+    for( size_t i = 0; i < function_count; i++ )
+    {
+        if( strcmp( get_function_name( vm->functions[ i ].declaration ), identifier ) == 0 )
+        {
+            return ( int )i;
+        }
+    }
+
+    return -1;
+}
+
+// running
+
+static double as_f64( uint64_t bits )
+{
+    double value;
+    memcpy( &value, &bits, sizeof( value ) );
+    return value;
+}
+
+static float as_f32( uint64_t bits )
+{
+    uint32_t low = ( uint32_t )bits;
+    float value;
+    memcpy( &value, &low, sizeof( value ) );
+    return value;
+}
+
+static uint64_t from_f64( double value )
+{
+    uint64_t bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    return bits;
+}
+
+static uint64_t from_f32( float value )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    return bits;
+}
+
+static void fail( char* message )
+{
+    fprintf( stderr, "%s\n", message );
+    abort();
+}
+
+static void fail_bounds_check( Vm* vm, uint32_t location, uint64_t index, uint64_t length )
+{
+    if( vm->check_mode == CHECKMODE_TRAP )
+    {
+#if defined( __GNUC__ )
+        __builtin_trap();
+#else
+        abort();
+#endif
+    }
+
+    fprintf( stderr, "%s: index %llu is out of bounds for array of length %llu\n", vm->locations[ location ],
+             ( unsigned long long )index, ( unsigned long long )length );
+    abort();
+}
+
+#if defined( VM_HAS_TRAMPOLINES )
+typedef struct VmPair
+{
+    uint64_t first;
+    uint64_t second;
+} VmPair;
+
+#define VM_TRAMPOLINE_PARAMS uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, ...
+typedef uint64_t ( *VmIntegerFunction )( VM_TRAMPOLINE_PARAMS );
+typedef double ( *VmF64Function )( VM_TRAMPOLINE_PARAMS );
+typedef float ( *VmF32Function )( VM_TRAMPOLINE_PARAMS );
+typedef VmPair ( *VmPairFunction )( VM_TRAMPOLINE_PARAMS );
+
+#define VM_TRAMPOLINE_ARGUMENTS \
+    integers[ 0 ], integers[ 1 ], integers[ 2 ], integers[ 3 ], integers[ 4 ], integers[ 5 ], \
+    floats[ 0 ], floats[ 1 ], floats[ 2 ], floats[ 3 ], floats[ 4 ], floats[ 5 ], floats[ 6 ], floats[ 7 ]
+
+// `arguments` are the argument count followed by the registers
+static void call_extern( VmExternCall* call, uint64_t* registers, const uint32_t* arguments, uint64_t* result )
+{
+    uint64_t integers[ VM_INTEGER_ARGUMENT_COUNT ] = { 0 };
+    double floats[ VM_FLOAT_ARGUMENT_COUNT ] = { 0 };
+    int integer_count = 0;
+    int float_count = 0;
+
+    // f32s are passed in the low half of a vector register, the doubles only
+    // carry their bits
+    uint32_t word_count = arguments[ 0 ];
+    for( uint32_t i = 0; i < word_count; i++ )
+    {
+        uint64_t word = registers[ arguments[ 1 + i ] ];
+        if( call->classes[ i ] == VMARGUMENTCLASS_FLOAT )
+        {
+            floats[ float_count++ ] = as_f64( word );
+        }
+        else
+        {
+            integers[ integer_count++ ] = word;
+        }
+    }
+
+    switch( call->result_kind )
+    {
+        case VMRESULTKIND_VOID:
+        case VMRESULTKIND_INTEGER:
+        {
+            result[ 0 ] = ( ( VmIntegerFunction )call->address )( VM_TRAMPOLINE_ARGUMENTS );
+            break;
+        }
+
+        case VMRESULTKIND_F64:
+        {
+            result[ 0 ] = from_f64( ( ( VmF64Function )call->address )( VM_TRAMPOLINE_ARGUMENTS ) );
+            break;
+        }
+
+        case VMRESULTKIND_F32:
+        {
+            result[ 0 ] = from_f32( ( ( VmF32Function )call->address )( VM_TRAMPOLINE_ARGUMENTS ) );
+            break;
+        }
+
+        case VMRESULTKIND_PAIR:
+        {
+            VmPair pair = ( ( VmPairFunction )call->address )( VM_TRAMPOLINE_ARGUMENTS );
+            result[ 0 ] = pair.first;
+            result[ 1 ] = pair.second;
+            break;
+        }
+    }
+}
+#else
+static void call_extern( VmExternCall* call, uint64_t* registers, const uint32_t* arguments, uint64_t* result )
+{
+    ( void )call;
+    ( void )registers;
+    ( void )arguments;
+    ( void )result;
+    UNREACHABLE(); // vm_compile() does not accept extern calls
+}
+#endif
+
+// the instructions jump straight to the code of the next one through a table
+// of label addresses, which gcc and clang support. other compilers dispatch
+// with a switch
+#if defined( __GNUC__ )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#define VM_CASE( opcode ) label_##opcode:
+#define VM_LABEL( opcode ) [ opcode ] = &&label_##opcode
+#define VM_DISPATCH() goto *dispatch_table[ *ip ]
+#else
+#define VM_CASE( opcode ) case opcode:
+#define VM_DISPATCH() continue
+#endif
+
+#define VM_NEXT( size ) ip += ( size ); VM_DISPATCH()
+#define R( i ) registers[ ip[ i ] ]
+
+#define VM_BINARY( opcode, expression ) \
+    VM_CASE( opcode ) { uint64_t a = R( 2 ); uint64_t b = R( 3 ); ( void )a; ( void )b; R( 1 ) = ( expression ); VM_NEXT( 4 ); }
+#define VM_UNARY( opcode, expression ) \
+    VM_CASE( opcode ) { uint64_t a = R( 2 ); R( 1 ) = ( expression ); VM_NEXT( 3 ); }
+
+uint64_t vm_call( Vm* vm, int function_index, uint64_t* arguments )
+{
+    if( vm->register_stack == NULL )
+    {
+        vm->register_stack = malloc( VM_REGISTER_STACK_SIZE * sizeof( uint64_t ) );
+        vm->memory_stack = malloc( VM_MEMORY_STACK_SIZE );
+        vm->frames = malloc( VM_FRAME_COUNT * sizeof( VmFrame ) );
+        if( vm->register_stack == NULL || vm->memory_stack == NULL || vm->frames == NULL ) ALLOC_ERROR();
+    }
+
+    uint64_t* const register_end = vm->register_stack + VM_REGISTER_STACK_SIZE;
+    uint8_t* const memory_end = vm->memory_stack + VM_MEMORY_STACK_SIZE;
+
+    VmFunction* function = &vm->functions[ function_index ];
+    uint64_t* registers = vm->register_stack;
+    uint8_t* memory = vm->memory_stack;
+    if( function->register_count > VM_REGISTER_STACK_SIZE || function->memory_size > VM_MEMORY_STACK_SIZE )
+    {
+        fail( "stack overflow in the interpreter" );
+    }
+
+    Expression* declaration = function->declaration;
+    uint32_t argument_count = 0;
+    for( int i = 0; i < declaration->function_declaration.param_count; i++ )
+    {
+        argument_count += is_array( declaration->function_declaration.param_types[ i ] ) ? 2 : 1;
+    }
+    memcpy( registers, arguments, argument_count * sizeof( uint64_t ) );
+
+    VmFrame* frames = vm->frames;
+    frames[ 0 ] = ( VmFrame ){ .return_ip = NULL };
+    int frame_count = 1;
+    uint64_t result[ 2 ] = { 0 };
+
+    const uint32_t* code = vm->code;
+    const uint32_t* ip = code + function->entry;
+
+#if defined( __GNUC__ )
+    static void* const dispatch_table[ VMOPCODE_COUNT ] = {
+        VM_LABEL( VMOPCODE_CONST ),
+        VM_LABEL( VMOPCODE_MOVE ),
+        VM_LABEL( VMOPCODE_MOVE2 ),
+        VM_LABEL( VMOPCODE_FRAMEADDRESS ),
+        VM_LABEL( VMOPCODE_ADD ),
+        VM_LABEL( VMOPCODE_SUBTRACT ),
+        VM_LABEL( VMOPCODE_MULTIPLY ),
+        VM_LABEL( VMOPCODE_DIVIDES ),
+        VM_LABEL( VMOPCODE_DIVIDEU ),
+        VM_LABEL( VMOPCODE_MODULOS ),
+        VM_LABEL( VMOPCODE_MODULOU ),
+        VM_LABEL( VMOPCODE_EQUAL ),
+        VM_LABEL( VMOPCODE_NOTEQUAL ),
+        VM_LABEL( VMOPCODE_LESSS ),
+        VM_LABEL( VMOPCODE_LESSU ),
+        VM_LABEL( VMOPCODE_LESSEQUALS ),
+        VM_LABEL( VMOPCODE_LESSEQUALU ),
+        VM_LABEL( VMOPCODE_ADDF64 ),
+        VM_LABEL( VMOPCODE_SUBTRACTF64 ),
+        VM_LABEL( VMOPCODE_MULTIPLYF64 ),
+        VM_LABEL( VMOPCODE_DIVIDEF64 ),
+        VM_LABEL( VMOPCODE_EQUALF64 ),
+        VM_LABEL( VMOPCODE_NOTEQUALF64 ),
+        VM_LABEL( VMOPCODE_LESSF64 ),
+        VM_LABEL( VMOPCODE_LESSEQUALF64 ),
+        VM_LABEL( VMOPCODE_ADDF32 ),
+        VM_LABEL( VMOPCODE_SUBTRACTF32 ),
+        VM_LABEL( VMOPCODE_MULTIPLYF32 ),
+        VM_LABEL( VMOPCODE_DIVIDEF32 ),
+        VM_LABEL( VMOPCODE_EQUALF32 ),
+        VM_LABEL( VMOPCODE_NOTEQUALF32 ),
+        VM_LABEL( VMOPCODE_LESSF32 ),
+        VM_LABEL( VMOPCODE_LESSEQUALF32 ),
+        VM_LABEL( VMOPCODE_NEGATE ),
+        VM_LABEL( VMOPCODE_NEGATEF64 ),
+        VM_LABEL( VMOPCODE_NEGATEF32 ),
+        VM_LABEL( VMOPCODE_NOT ),
+        VM_LABEL( VMOPCODE_EXTENDS8 ),
+        VM_LABEL( VMOPCODE_EXTENDS16 ),
+        VM_LABEL( VMOPCODE_EXTENDS32 ),
+        VM_LABEL( VMOPCODE_EXTENDU8 ),
+        VM_LABEL( VMOPCODE_EXTENDU16 ),
+        VM_LABEL( VMOPCODE_EXTENDU32 ),
+        VM_LABEL( VMOPCODE_TOBOOL ),
+        VM_LABEL( VMOPCODE_F64TOBOOL ),
+        VM_LABEL( VMOPCODE_F32TOBOOL ),
+        VM_LABEL( VMOPCODE_F32TOF64 ),
+        VM_LABEL( VMOPCODE_F64TOF32 ),
+        VM_LABEL( VMOPCODE_S64TOF64 ),
+        VM_LABEL( VMOPCODE_U64TOF64 ),
+        VM_LABEL( VMOPCODE_S64TOF32 ),
+        VM_LABEL( VMOPCODE_U64TOF32 ),
+        VM_LABEL( VMOPCODE_F64TOS64 ),
+        VM_LABEL( VMOPCODE_F64TOU64 ),
+        VM_LABEL( VMOPCODE_F32TOS64 ),
+        VM_LABEL( VMOPCODE_F32TOU64 ),
+        VM_LABEL( VMOPCODE_LOADS8 ),
+        VM_LABEL( VMOPCODE_LOADU8 ),
+        VM_LABEL( VMOPCODE_LOADS16 ),
+        VM_LABEL( VMOPCODE_LOADU16 ),
+        VM_LABEL( VMOPCODE_LOADS32 ),
+        VM_LABEL( VMOPCODE_LOADU32 ),
+        VM_LABEL( VMOPCODE_LOAD64 ),
+        VM_LABEL( VMOPCODE_LOAD128 ),
+        VM_LABEL( VMOPCODE_STORE8 ),
+        VM_LABEL( VMOPCODE_STORE16 ),
+        VM_LABEL( VMOPCODE_STORE32 ),
+        VM_LABEL( VMOPCODE_STORE64 ),
+        VM_LABEL( VMOPCODE_STORE128 ),
+        VM_LABEL( VMOPCODE_ARRAYAUTOMATIC ),
+        VM_LABEL( VMOPCODE_ARRAYHEAP ),
+        VM_LABEL( VMOPCODE_ELEMENT ),
+        VM_LABEL( VMOPCODE_ELEMENTCHECKED ),
+        VM_LABEL( VMOPCODE_JUMP ),
+        VM_LABEL( VMOPCODE_BRANCH ),
+        VM_LABEL( VMOPCODE_CALL ),
+        VM_LABEL( VMOPCODE_TAILCALL ),
+        VM_LABEL( VMOPCODE_CALLEXTERN ),
+        VM_LABEL( VMOPCODE_RETURN ),
+        VM_LABEL( VMOPCODE_RETURN2 ),
+        VM_LABEL( VMOPCODE_RETURNVOID ),
+    };
+
+    VM_DISPATCH();
+#else
+    for( ;; ) switch( *ip )
+    {
+#endif
+
+    VM_CASE( VMOPCODE_CONST )
+    {
+        R( 1 ) = ( uint64_t )ip[ 2 ] | ( uint64_t )ip[ 3 ] << 32;
+        VM_NEXT( 4 );
+    }
+
+    VM_CASE( VMOPCODE_MOVE )
+    {
+        R( 1 ) = R( 2 );
+        VM_NEXT( 3 );
+    }
+
+    VM_CASE( VMOPCODE_MOVE2 )
+    {
+        registers[ ip[ 1 ] ] = registers[ ip[ 2 ] ];
+        registers[ ip[ 1 ] + 1 ] = registers[ ip[ 2 ] + 1 ];
+        VM_NEXT( 3 );
+    }
+
+    VM_CASE( VMOPCODE_FRAMEADDRESS )
+    {
+        R( 1 ) = ( uint64_t )( uintptr_t )( memory + ip[ 2 ] );
+        VM_NEXT( 3 );
+    }
+
+    // integers are kept extended to 64 bits, so the 64-bit operations give
+    // the same results once they are extended again
+    VM_BINARY( VMOPCODE_ADD, a + b )
+    VM_BINARY( VMOPCODE_SUBTRACT, a - b )
+    VM_BINARY( VMOPCODE_MULTIPLY, a * b )
+    VM_BINARY( VMOPCODE_DIVIDES, ( uint64_t )( ( int64_t )a / ( int64_t )b ) )
+    VM_BINARY( VMOPCODE_DIVIDEU, a / b )
+    VM_BINARY( VMOPCODE_MODULOS, ( uint64_t )( ( int64_t )a % ( int64_t )b ) )
+    VM_BINARY( VMOPCODE_MODULOU, a % b )
+    VM_BINARY( VMOPCODE_EQUAL, a == b )
+    VM_BINARY( VMOPCODE_NOTEQUAL, a != b )
+    VM_BINARY( VMOPCODE_LESSS, ( int64_t )a < ( int64_t )b )
+    VM_BINARY( VMOPCODE_LESSU, a < b )
+    VM_BINARY( VMOPCODE_LESSEQUALS, ( int64_t )a <= ( int64_t )b )
+    VM_BINARY( VMOPCODE_LESSEQUALU, a <= b )
+    VM_BINARY( VMOPCODE_ADDF64, from_f64( as_f64( a ) + as_f64( b ) ) )
+    VM_BINARY( VMOPCODE_SUBTRACTF64, from_f64( as_f64( a ) - as_f64( b ) ) )
+    VM_BINARY( VMOPCODE_MULTIPLYF64, from_f64( as_f64( a ) * as_f64( b ) ) )
+    VM_BINARY( VMOPCODE_DIVIDEF64, from_f64( as_f64( a ) / as_f64( b ) ) )
+    VM_BINARY( VMOPCODE_EQUALF64, as_f64( a ) == as_f64( b ) )
+    VM_BINARY( VMOPCODE_NOTEQUALF64, as_f64( a ) != as_f64( b ) )
+    VM_BINARY( VMOPCODE_LESSF64, as_f64( a ) < as_f64( b ) )
+    VM_BINARY( VMOPCODE_LESSEQUALF64, as_f64( a ) <= as_f64( b ) )
+    VM_BINARY( VMOPCODE_ADDF32, from_f32( as_f32( a ) + as_f32( b ) ) )
+    VM_BINARY( VMOPCODE_SUBTRACTF32, from_f32( as_f32( a ) - as_f32( b ) ) )
+    VM_BINARY( VMOPCODE_MULTIPLYF32, from_f32( as_f32( a ) * as_f32( b ) ) )
+    VM_BINARY( VMOPCODE_DIVIDEF32, from_f32( as_f32( a ) / as_f32( b ) ) )
+    VM_BINARY( VMOPCODE_EQUALF32, as_f32( a ) == as_f32( b ) )
+    VM_BINARY( VMOPCODE_NOTEQUALF32, as_f32( a ) != as_f32( b ) )
+    VM_BINARY( VMOPCODE_LESSF32, as_f32( a ) < as_f32( b ) )
+    VM_BINARY( VMOPCODE_LESSEQUALF32, as_f32( a ) <= as_f32( b ) )
+
+    VM_UNARY( VMOPCODE_NEGATE, 0 - a )
+    VM_UNARY( VMOPCODE_NEGATEF64, a ^ ( 1ull << 63 ) )
+    VM_UNARY( VMOPCODE_NEGATEF32, a ^ ( 1ull << 31 ) )
+    VM_UNARY( VMOPCODE_NOT, a == 0 )
+    VM_UNARY( VMOPCODE_EXTENDS8, ( uint64_t )( int64_t )( int8_t )a )
+    VM_UNARY( VMOPCODE_EXTENDS16, ( uint64_t )( int64_t )( int16_t )a )
+    VM_UNARY( VMOPCODE_EXTENDS32, ( uint64_t )( int64_t )( int32_t )a )
+    VM_UNARY( VMOPCODE_EXTENDU8, ( uint8_t )a )
+    VM_UNARY( VMOPCODE_EXTENDU16, ( uint16_t )a )
+    VM_UNARY( VMOPCODE_EXTENDU32, ( uint32_t )a )
+    VM_UNARY( VMOPCODE_TOBOOL, a != 0 )
+    VM_UNARY( VMOPCODE_F64TOBOOL, as_f64( a ) != 0.0 )
+    VM_UNARY( VMOPCODE_F32TOBOOL, as_f32( a ) != 0.0f )
+    VM_UNARY( VMOPCODE_F32TOF64, from_f64( as_f32( a ) ) )
+    VM_UNARY( VMOPCODE_F64TOF32, from_f32( ( float )as_f64( a ) ) )
+    VM_UNARY( VMOPCODE_S64TOF64, from_f64( ( double )( int64_t )a ) )
+    VM_UNARY( VMOPCODE_U64TOF64, from_f64( ( double )a ) )
+    VM_UNARY( VMOPCODE_S64TOF32, from_f32( ( float )( int64_t )a ) )
+    VM_UNARY( VMOPCODE_U64TOF32, from_f32( ( float )a ) )
+    VM_UNARY( VMOPCODE_F64TOS64, ( uint64_t )( int64_t )as_f64( a ) )
+    VM_UNARY( VMOPCODE_F64TOU64, ( uint64_t )as_f64( a ) )
+    VM_UNARY( VMOPCODE_F32TOS64, ( uint64_t )( int64_t )as_f32( a ) )
+    VM_UNARY( VMOPCODE_F32TOU64, ( uint64_t )as_f32( a ) )
+
+    VM_UNARY( VMOPCODE_LOADS8, ( uint64_t )( int64_t )*( int8_t* )( uintptr_t )a )
+    VM_UNARY( VMOPCODE_LOADU8, *( uint8_t* )( uintptr_t )a )
+    VM_UNARY( VMOPCODE_LOADS16, ( uint64_t )( int64_t )*( int16_t* )( uintptr_t )a )
+    VM_UNARY( VMOPCODE_LOADU16, *( uint16_t* )( uintptr_t )a )
+    VM_UNARY( VMOPCODE_LOADS32, ( uint64_t )( int64_t )*( int32_t* )( uintptr_t )a )
+    VM_UNARY( VMOPCODE_LOADU32, *( uint32_t* )( uintptr_t )a )
+    VM_UNARY( VMOPCODE_LOAD64, *( uint64_t* )( uintptr_t )a )
+
+    VM_CASE( VMOPCODE_LOAD128 )
+    {
+        uint64_t* address = ( uint64_t* )( uintptr_t )R( 2 );
+        registers[ ip[ 1 ] ] = address[ 0 ];
+        registers[ ip[ 1 ] + 1 ] = address[ 1 ];
+        VM_NEXT( 3 );
+    }
+
+    VM_CASE( VMOPCODE_STORE8 )
+    {
+        *( uint8_t* )( uintptr_t )( R( 1 ) + ip[ 2 ] ) = ( uint8_t )R( 3 );
+        VM_NEXT( 4 );
+    }
+
+    VM_CASE( VMOPCODE_STORE16 )
+    {
+        *( uint16_t* )( uintptr_t )( R( 1 ) + ip[ 2 ] ) = ( uint16_t )R( 3 );
+        VM_NEXT( 4 );
+    }
+
+    VM_CASE( VMOPCODE_STORE32 )
+    {
+        *( uint32_t* )( uintptr_t )( R( 1 ) + ip[ 2 ] ) = ( uint32_t )R( 3 );
+        VM_NEXT( 4 );
+    }
+
+    VM_CASE( VMOPCODE_STORE64 )
+    {
+        *( uint64_t* )( uintptr_t )( R( 1 ) + ip[ 2 ] ) = R( 3 );
+        VM_NEXT( 4 );
+    }
+
+    VM_CASE( VMOPCODE_STORE128 )
+    {
+        uint64_t* address = ( uint64_t* )( uintptr_t )( R( 1 ) + ip[ 2 ] );
+        address[ 0 ] = registers[ ip[ 3 ] ];
+        address[ 1 ] = registers[ ip[ 3 ] + 1 ];
+        VM_NEXT( 4 );
+    }
+
+    VM_CASE( VMOPCODE_ARRAYAUTOMATIC )
+    {
+        // zeroed every time, like a compound literal
+        uint8_t* data = memory + ip[ 2 ];
+        memset( data, 0, ( size_t )ip[ 3 ] * ip[ 4 ] );
+        registers[ ip[ 1 ] ] = ip[ 3 ];
+        registers[ ip[ 1 ] + 1 ] = ( uint64_t )( uintptr_t )data;
+        VM_NEXT( 5 );
+    }
+
+    VM_CASE( VMOPCODE_ARRAYHEAP )
+    {
+        void* data = calloc( ip[ 2 ], ip[ 3 ] );
+        if( data == NULL )
+        {
+            fprintf( stderr, "out of memory allocating an array of length %llu\n", ( unsigned long long )ip[ 2 ] );
+            abort();
+        }
+        registers[ ip[ 1 ] ] = ip[ 2 ];
+        registers[ ip[ 1 ] + 1 ] = ( uint64_t )( uintptr_t )data;
+        VM_NEXT( 4 );
+    }
+
+    VM_CASE( VMOPCODE_ELEMENT )
+    {
+        R( 1 ) = registers[ ip[ 2 ] + 1 ] + R( 3 ) * ip[ 4 ];
+        VM_NEXT( 5 );
+    }
+
+    VM_CASE( VMOPCODE_ELEMENTCHECKED )
+    {
+        uint64_t length = registers[ ip[ 2 ] ];
+        uint64_t index = R( 3 );
+        if( index >= length )
+        {
+            fail_bounds_check( vm, ip[ 5 ], index, length );
+        }
+        R( 1 ) = registers[ ip[ 2 ] + 1 ] + index * ip[ 4 ];
+        VM_NEXT( 6 );
+    }
+
+    VM_CASE( VMOPCODE_JUMP )
+    {
+        ip = code + ip[ 1 ];
+        VM_DISPATCH();
+    }
+
+    VM_CASE( VMOPCODE_BRANCH )
+    {
+        ip = code + ( R( 1 ) != 0 ? ip[ 2 ] : ip[ 3 ] );
+        VM_DISPATCH();
+    }
+
+    VM_CASE( VMOPCODE_CALL )
+    {
+        VmFunction* callee = &vm->functions[ ip[ 2 ] ];
+        uint64_t* callee_registers = registers + function->register_count;
+        uint8_t* callee_memory = memory + function->memory_size;
+        if( frame_count == VM_FRAME_COUNT || callee_registers + callee->register_count > register_end ||
+            callee_memory + callee->memory_size > memory_end )
+        {
+            fail( "stack overflow in the interpreter" );
+        }
+
+        uint32_t word_count = ip[ 3 ];
+        for( uint32_t i = 0; i < word_count; i++ )
+        {
+            callee_registers[ i ] = registers[ ip[ 4 + i ] ];
+        }
+
+        frames[ frame_count++ ] = ( VmFrame ){
+            .return_ip = ip + 4 + word_count,
+            .registers = registers,
+            .memory = memory,
+            .function = function,
+            .result = ip[ 1 ],
+        };
+        registers = callee_registers;
+        memory = callee_memory;
+        function = callee;
+        ip = code + callee->entry;
+        VM_DISPATCH();
+    }
+
+    VM_CASE( VMOPCODE_TAILCALL )
+    {
+        // the arguments can point into the memory of the frame, which is only
+        // reused when there is none
+        VmFunction* callee = &vm->functions[ ip[ 1 ] ];
+        uint64_t* scratch = registers + function->register_count;
+        uint8_t* callee_memory = memory + function->memory_size;
+        uint32_t word_count = ip[ 2 ];
+        if( scratch + word_count > register_end || registers + callee->register_count > register_end ||
+            callee_memory + callee->memory_size > memory_end )
+        {
+            fail( "stack overflow in the interpreter" );
+        }
+
+        for( uint32_t i = 0; i < word_count; i++ )
+        {
+            scratch[ i ] = registers[ ip[ 3 + i ] ];
+        }
+        memcpy( registers, scratch, word_count * sizeof( uint64_t ) );
+
+        memory = callee_memory;
+        function = callee;
+        ip = code + callee->entry;
+        VM_DISPATCH();
+    }
+
+    VM_CASE( VMOPCODE_CALLEXTERN )
+    {
+        uint64_t extern_result[ 2 ];
+        call_extern( &vm->extern_calls[ ip[ 2 ] ], registers, ip + 3, extern_result );
+        registers[ ip[ 1 ] ] = extern_result[ 0 ];
+        if( vm->extern_calls[ ip[ 2 ] ].result_kind == VMRESULTKIND_PAIR )
+        {
+            registers[ ip[ 1 ] + 1 ] = extern_result[ 1 ];
+        }
+        VM_NEXT( 4 + ip[ 3 ] );
+    }
+
+    VM_CASE( VMOPCODE_RETURN )
+    VM_CASE( VMOPCODE_RETURN2 )
+    VM_CASE( VMOPCODE_RETURNVOID )
+    {
+        VmOpcode opcode = ( VmOpcode )ip[ 0 ];
+        uint64_t value[ 2 ] = { 0 };
+        if( opcode != VMOPCODE_RETURNVOID )
+        {
+            value[ 0 ] = registers[ ip[ 1 ] ];
+        }
+        if( opcode == VMOPCODE_RETURN2 )
+        {
+            value[ 1 ] = registers[ ip[ 1 ] + 1 ];
+        }
+
+        VmFrame* frame = &frames[ --frame_count ];
+        if( frame->return_ip == NULL )
+        {
+            result[ 0 ] = value[ 0 ];
+            result[ 1 ] = value[ 1 ];
+            goto finished;
+        }
+
+        registers = frame->registers;
+        memory = frame->memory;
+        function = frame->function;
+        ip = frame->return_ip;
+        if( opcode != VMOPCODE_RETURNVOID )
+        {
+            registers[ frame->result ] = value[ 0 ];
+        }
+        if( opcode == VMOPCODE_RETURN2 )
+        {
+            registers[ frame->result + 1 ] = value[ 1 ];
+        }
+        VM_DISPATCH();
+    }
+
+#if defined( __GNUC__ )
+#pragma GCC diagnostic pop
+#else
+    default:
+    {
+        UNREACHABLE();
+    }
+    }
+#endif
+
+finished:
+    return result[ 0 ];
+}
@@ -0,0 +1,162 @@
+// for nanosleep
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "debug.h"
+#include "hash.h"
+#include "watch.h"
+
+#if defined( __linux__ )
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined( _WIN32 )
+#include <windows.h>
+#endif
+
+struct SourceWatcher
+{
+    char* path;
+    uint64_t source_hash; // 0 if the file could not be read
+#if defined( __linux__ )
+    int inotify_fd; // -1 if the file is polled
+    char* name; // the file name in the watched directory
+#endif
+};
+
+static uint64_t hash_source_file( char* path )
+{
+    FILE* file = fopen( path, "rb" );
+    if( file == NULL )
+    {
+        return 0;
+    }
+
+    uint64_t hash = HASH_INITIAL;
+    char chunk[ 4096 ];
+    size_t length;
+    while( ( length = fread( chunk, 1, sizeof( chunk ), file ) ) > 0 )
+    {
+        hash = hash_bytes( hash, chunk, length );
+    }
+    fclose( file );
+
+    return hash;
+}
+
+static void sleep_poll_interval( void )
+{
+#if defined( _WIN32 )
+    Sleep( 200 );
+#else
+    struct timespec interval = { .tv_sec = 0, .tv_nsec = 200 * 1000 * 1000 };
+    nanosleep( &interval, NULL );
+#endif
+}
+
+#if defined( __linux__ )
+// blocks until something was written to or moved onto the file. returns
+// false if inotify stopped working
+static bool wait_for_event( SourceWatcher* watcher )
+{
+    _Alignas( struct inotify_event ) char events[ 4096 ];
+    for( ;; )
+    {
+        ssize_t length = read( watcher->inotify_fd, events, sizeof( events ) );
+        if( length <= 0 )
+        {
+            return false;
+        }
+
+        for( char* event_data = events; event_data < events + length; )
+        {
+            struct inotify_event* event = ( struct inotify_event* )event_data;
+
+            // when events were dropped, the file could be one of them
+            if( ( event->mask & IN_Q_OVERFLOW ) || ( event->len > 0 && strcmp( event->name, watcher->name ) == 0 ) )
+            {
+                return true;
+            }
+            event_data += sizeof( struct inotify_event ) + event->len;
+        }
+    }
+}
+#endif
+
+SourceWatcher* source_watcher_open( char* path )
+{
+    SourceWatcher* watcher = calloc( 1, sizeof( SourceWatcher ) );
+    if( watcher == NULL ) ALLOC_ERROR();
+    watcher->path = path;
+    watcher->source_hash = hash_source_file( path );
+
+#if defined( __linux__ )
+    char* name = strrchr( path, '/' );
+    size_t directory_length = name == NULL ? 0 : ( size_t )( name - path );
+    watcher->name = name == NULL ? path : name + 1;
+
+    char* directory = calloc( 1, directory_length + sizeof( "." ) );
+    if( directory == NULL ) ALLOC_ERROR();
+    if( name == NULL )
+    {
+        strcpy( directory, "." );
+    }
+    else
+    {
+        // the root directory keeps its slash
+        memcpy( directory, path, directory_length == 0 ? 1 : directory_length );
+    }
+
+    watcher->inotify_fd = inotify_init1( IN_CLOEXEC );
+    if( watcher->inotify_fd < 0 || inotify_add_watch( watcher->inotify_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO ) < 0 )
+    {
+        printf( "Could not watch '%s', checking it a few times a second instead.\n", directory );
+        if( watcher->inotify_fd >= 0 )
+        {
+            close( watcher->inotify_fd );
+        }
+        watcher->inotify_fd = -1;
+    }
+    free( directory );
+#endif
+
+    return watcher;
+}
+
+void source_watcher_close( SourceWatcher* watcher )
+{
+#if defined( __linux__ )
+    if( watcher->inotify_fd >= 0 )
+    {
+        close( watcher->inotify_fd );
+    }
+#endif
+    free( watcher );
+}
+
+void source_watcher_wait( SourceWatcher* watcher )
+{
+    for( ;; )
+    {
+#if defined( __linux__ )
+        if( watcher->inotify_fd < 0 || !wait_for_event( watcher ) )
+        {
+            sleep_poll_interval();
+        }
+#else
+        sleep_poll_interval();
+#endif
+
+        // a file that is being replaced can be missing for a moment
+        uint64_t source_hash = hash_source_file( watcher->path );
+        if( source_hash != 0 && source_hash != watcher->source_hash )
+        {
+            watcher->source_hash = source_hash;
+            return;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+# runs one program of the corpus with `octo run` in one mode and compares what
+# it prints with its .expected file. called by ctest with
+#   -DOCTO=<octo executable> -DPROGRAM=<.octo file> -DMODE=<mode>
+#   -DWORK_DIRECTORY=<directory for the executables and the object cache>
+#
+# a program can start with comments that change how it is run:
+#   // flags: <options>          passed to `octo run` in every mode
+#   // fails with: <message>     the program has to fail and print `message`
+#                                to stderr
+
+if(MODE STREQUAL "no-ir")
+    set(mode_flags --no-ir)
+elseif(MODE STREQUAL "ir")
+    set(mode_flags)
+elseif(MODE STREQUAL "native")
+    set(mode_flags --native)
+elseif(MODE STREQUAL "interp")
+    set(mode_flags --interp)
+elseif(MODE STREQUAL "no-inline")
+    set(mode_flags --inline-threshold 0)
+else()
+    message(FATAL_ERROR "Unknown mode '${MODE}'.")
+endif()
+
+file(STRINGS ${PROGRAM} flag_lines REGEX "^// flags: ")
+set(program_flags)
+foreach(line ${flag_lines})
+    string(REGEX REPLACE "^// flags: " "" line "${line}")
+    separate_arguments(line UNIX_COMMAND "${line}")
+    list(APPEND program_flags ${line})
+endforeach()
+
+file(STRINGS ${PROGRAM} failure_lines REGEX "^// fails with: ")
+set(failure_message)
+if(failure_lines)
+    string(REGEX REPLACE "^// fails with: " "" failure_message "${failure_lines}")
+endif()
+
+# the executables are written next to the program, so every mode gets a copy
+get_filename_component(name ${PROGRAM} NAME_WE)
+get_filename_component(program_directory ${PROGRAM} DIRECTORY)
+file(MAKE_DIRECTORY ${WORK_DIRECTORY})
+file(COPY ${PROGRAM} DESTINATION ${WORK_DIRECTORY})
+
+execute_process(
+    COMMAND ${OCTO} run ${mode_flags} ${program_flags} --cache-dir ${WORK_DIRECTORY}/cache ${name}.octo
+    WORKING_DIRECTORY ${WORK_DIRECTORY}
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors
+    RESULT_VARIABLE result)
+
+if(failure_message)
+    if(result EQUAL 0)
+        message(FATAL_ERROR "'${name}' succeeded but should have failed with '${failure_message}'.")
+    endif()
+
+    string(FIND "${errors}" "${failure_message}" message_index)
+    if(message_index EQUAL -1)
+        message(FATAL_ERROR "'${name}' did not fail with '${failure_message}':\n${errors}")
+    endif()
+elseif(NOT result EQUAL 0)
+    message(FATAL_ERROR "'${name}' failed with '${result}':\n${output}${errors}")
+endif()
+
+# the compiler says before the program runs when a mode falls back to gcc, so
+# only the end of the output is the program's
+file(READ ${program_directory}/${name}.expected expected_output)
+string(LENGTH "${output}" output_length)
+string(LENGTH "${expected_output}" expected_length)
+set(program_output "${output}")
+if(output_length GREATER expected_length)
+    math(EXPR output_start "${output_length} - ${expected_length}")
+    string(SUBSTRING "${output}" ${output_start} -1 program_output)
+endif()
+
+if(NOT program_output STREQUAL expected_output)
+    message(FATAL_ERROR "'${name}' printed\n${output}\ninstead of\n${expected_output}")
+endif()